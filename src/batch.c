@@ -0,0 +1,328 @@
+#include "batch.h"
+#include "budget.h"
+#include "cache.h"
+#include "smt_lang.h"
+#include "interval_solver.h"
+#include "output.h"
+#include "portfolio.h"
+#include "smtbin.h"
+#include "stats.h"
+#include "stream.h"
+#include "trace.h"
+
+#include <dirent.h>
+#include <glob.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BATCH_ERROR (-1)
+
+// --- Input Collection ---
+
+static void add_path(char*** paths, int* count, int* cap, const char* path) {
+    if (*count == *cap) {
+        *cap = *cap ? *cap * 2 : 64;
+        *paths = (char**)realloc(*paths, sizeof(char*) * *cap);
+    }
+    (*paths)[(*count)++] = strdup(path);
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static int collect_directory(const char* dir, char*** paths, int* count, int* cap) {
+    DIR* d = opendir(dir);
+    if (d == NULL) {
+        perror(dir);
+        return -1;
+    }
+    size_t dir_len = strlen(dir);
+    struct dirent* ent;
+    while ((ent = readdir(d)) != NULL) {
+        char* path = (char*)malloc(dir_len + strlen(ent->d_name) + 2);
+        sprintf(path, "%s/%s", dir, ent->d_name);
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) add_path(paths, count, cap, path);
+        free(path);
+    }
+    closedir(d);
+    qsort(*paths, *count, sizeof(char*), compare_paths);
+    return *count;
+}
+
+static int collect_list_file(const char* list, char*** paths, int* count, int* cap) {
+    FILE* fp = fopen(list, "r");
+    if (fp == NULL) {
+        perror(list);
+        return -1;
+    }
+    char* line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &line_cap, fp)) != -1) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        if (len > 0) add_path(paths, count, cap, line);
+    }
+    free(line);
+    fclose(fp);
+    return *count;
+}
+
+static int collect_glob(const char* pattern, char*** paths, int* count, int* cap) {
+    glob_t g;
+    int res = glob(pattern, 0, NULL, &g);
+    if (res == GLOB_NOMATCH) {
+        fprintf(stderr, "Error: no input matches %s\n", pattern);
+        return -1;
+    }
+    if (res != 0) {
+        fprintf(stderr, "Error: cannot expand %s\n", pattern);
+        return -1;
+    }
+    for (size_t i = 0; i < g.gl_pathc; ++i) add_path(paths, count, cap, g.gl_pathv[i]);
+    globfree(&g);
+    return *count;
+}
+
+int batch_collect_inputs(const char* spec, char*** paths) {
+    int count = 0, cap = 0;
+    *paths = NULL;
+    struct stat st;
+    int res;
+    if (spec[0] == '@') res = collect_list_file(spec + 1, paths, &count, &cap);
+    else if (stat(spec, &st) == 0 && S_ISDIR(st.st_mode)) res = collect_directory(spec, paths, &count, &cap);
+    else res = collect_glob(spec, paths, &count, &cap);
+    if (res < 0) {
+        batch_free_inputs(*paths, count);
+        *paths = NULL;
+    }
+    return res;
+}
+
+void batch_free_inputs(char** paths, int count) {
+    for (int i = 0; i < count; ++i) free(paths[i]);
+    free(paths);
+}
+
+// --- Worker Pool ---
+
+typedef struct {
+    char** paths;
+    int count;
+    bool ordered;
+    int portfolio;
+    bool stream;
+    ResultCache* cache; // NULL unless opts->cache > 0 or opts->cache_file is set
+    OutputFormat format;
+    double timeout_ms;  // Budget of each file, see BatchOptions
+    long long max_propagations;
+    size_t max_memory;
+    OutBuf writer;      // All output, under out_lock
+    SolverStats* totals; // Statistics of every file, under out_lock; NULL when not collected
+
+    atomic_int next;   // Next file to hand out
+    pthread_mutex_t out_lock;
+    // Ordered mode only: records waiting for every earlier file to be printed
+    char** records;
+    bool* done;
+    int next_to_print;
+    int failed;
+} BatchState;
+
+static int solve_props(SolverContext* ctx, int portfolio) {
+    return portfolio > 1 ? portfolio_solve(ctx, portfolio, NULL) : interval_solver(ctx);
+}
+
+// Answers from the cache when an equivalent problem was solved before
+static int solve_cached(SolverContext* ctx, int portfolio, ResultCache* cache) {
+    CanonForm form;
+    canonicalize(ctx->props, &form);
+    int res;
+    bool truncated;
+    if (result_cache_lookup(cache, &form, &res, &truncated)) {
+        // Final intervals as the original solve left them, for the result record
+        for (int i = 0; i < form.count; ++i) get_or_add_var_entry(ctx, form.names[i])->interval = form.intervals[i];
+        ctx->truncated = truncated;
+    } else {
+        res = solve_props(ctx, portfolio);
+        canon_capture_intervals(&form, ctx);
+        // An answer cut short by the budget depends on the machine's load, not on the problem
+        if (res == 1 || budget_exhausted(ctx) == BUDGET_NONE) result_cache_store(cache, &form, res, ctx->truncated);
+    }
+    canon_form_free(&form);
+    return res;
+}
+
+static double elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Same convention as interval_solver, or BATCH_ERROR if the file cannot be read or parsed.
+// The result record, timed from the start of reading, is written to rec, and the file's
+// statistics are added to acc when they are collected.
+static int solve_file(const BatchState* st, const char* path, OutBuf* rec, SolverStats* acc) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    SolverBudget budget;
+    bool bounded = st->timeout_ms > 0 || st->max_propagations > 0 || st->max_memory > 0;
+    if (bounded) budget_init(&budget, st->timeout_ms, st->max_propagations, st->max_memory);
+    int res = BATCH_ERROR;
+    SolverContext* ctx = NULL;
+    SmtBinImage image = { NULL, 0, NULL, NULL, 0 };
+    if (smtbin_is_image(path)) {
+        if (smtbin_load(path, &image) == 0) {
+            ctx = solver_context_new();
+            ctx->threads = 1;
+            ctx->props = image.list;
+            if (bounded) ctx->budget = &budget;
+            if (acc != NULL) solver_stats_enable(ctx);
+            res = st->cache != NULL ? solve_cached(ctx, st->portfolio, st->cache) : solve_props(ctx, st->portfolio);
+        }
+    } else if (st->stream) {
+        ctx = solver_context_new();
+        ctx->threads = 1; // Files already keep every core busy, also when the stream falls back to interval_solver
+        if (bounded) ctx->budget = &budget;
+        if (acc != NULL) solver_stats_enable(ctx);
+        if (stream_solve_path(ctx, path, &res) != 0) res = BATCH_ERROR;
+    } else {
+        SmtParseContext pctx = { NULL };
+        if (parseSmtPath(path, &pctx) != 0) {
+            freeSmtProplist(pctx.root);
+        } else {
+            ctx = solver_context_new();
+            ctx->threads = 1; // Files already keep every core busy
+            ctx->props = reverseList(pctx.root);
+            if (bounded) ctx->budget = &budget;
+            if (acc != NULL) solver_stats_enable(ctx);
+            res = st->cache != NULL ? solve_cached(ctx, st->portfolio, st->cache) : solve_props(ctx, st->portfolio);
+        }
+    }
+
+    output_record(rec, st->format, path, res, res == BATCH_ERROR ? NULL : ctx, elapsed_ms(&start));
+    if (acc != NULL && ctx != NULL) solver_stats_merge(acc, ctx->stats);
+    if (image.base != NULL) {
+        ctx->props = NULL; // Owned by the mapping
+        smtbin_unload(&image);
+    }
+    solver_context_free(ctx);
+    return res;
+}
+
+static void report(BatchState* st, int i, int status, const OutBuf* rec) {
+    pthread_mutex_lock(&st->out_lock);
+    if (status == BATCH_ERROR) st->failed++;
+    if (!st->ordered) {
+        out_bytes(&st->writer, rec->data, rec->len);
+    } else {
+        // Kept until every earlier file has been written
+        st->records[i] = (char*)malloc(rec->len + 1);
+        memcpy(st->records[i], rec->data, rec->len);
+        st->records[i][rec->len] = '\0';
+        st->done[i] = true;
+        while (st->next_to_print < st->count && st->done[st->next_to_print]) {
+            out_str(&st->writer, st->records[st->next_to_print]);
+            free(st->records[st->next_to_print]);
+            st->next_to_print++;
+        }
+    }
+    // Text results stream as they become available; the others are written a buffer at a time
+    if (st->format == OUTPUT_TEXT) outbuf_flush(&st->writer);
+    pthread_mutex_unlock(&st->out_lock);
+}
+
+static void* batch_worker(void* arg) {
+    BatchState* st = (BatchState*)arg;
+    int i;
+    OutBuf rec;
+    outbuf_init(&rec, NULL);
+    SolverStats acc; // This worker's share, added to the totals once at the end
+    solver_stats_clear(&acc);
+    while ((i = atomic_fetch_add(&st->next, 1)) < st->count) {
+        rec.len = 0;
+        int status = solve_file(st, st->paths[i], &rec, st->totals != NULL ? &acc : NULL);
+        report(st, i, status, &rec);
+    }
+    outbuf_free(&rec);
+    if (st->totals != NULL) {
+        pthread_mutex_lock(&st->out_lock);
+        solver_stats_merge(st->totals, &acc);
+        pthread_mutex_unlock(&st->out_lock);
+    }
+    return NULL;
+}
+
+int batch_solve(char** paths, int count, const BatchOptions* opts, FILE* out) {
+    int threads = opts->threads;
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    if (threads > count) threads = count;
+    if (count == 0) return 0;
+
+    BatchState st;
+    st.paths = paths;
+    st.count = count;
+    st.ordered = opts->ordered;
+    st.portfolio = opts->portfolio;
+    st.stream = opts->stream;
+    st.cache = opts->cache > 0 || opts->cache_file != NULL ? result_cache_new(opts->cache > 0 ? opts->cache : RESULT_CACHE_DEFAULT) : NULL;
+    if (opts->cache_file != NULL) {
+        DiskCache* disk = disk_cache_open(opts->cache_file);
+        if (disk == NULL) {
+            result_cache_free(st.cache);
+            return count;
+        }
+        result_cache_attach(st.cache, disk);
+    }
+    st.format = opts->format;
+    st.timeout_ms = opts->timeout_ms;
+    st.max_propagations = opts->max_propagations;
+    st.max_memory = opts->max_memory;
+    st.totals = NULL;
+    if (opts->stats) {
+        st.totals = (SolverStats*)malloc(sizeof(SolverStats));
+        solver_stats_clear(st.totals);
+    }
+    outbuf_init(&st.writer, out);
+    output_header(&st.writer, st.format);
+    atomic_init(&st.next, 0);
+    pthread_mutex_init(&st.out_lock, NULL);
+    st.records = st.ordered ? (char**)malloc(sizeof(char*) * count) : NULL;
+    st.done = st.ordered ? (bool*)calloc(count, sizeof(bool)) : NULL;
+    st.next_to_print = 0;
+    st.failed = 0;
+
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    int started = 0;
+    for (; started < threads; ++started) {
+        if (pthread_create(&workers[started], NULL, batch_worker, &st) != 0) break;
+    }
+    if (started == 0) batch_worker(&st); // Could not start any thread, solve on the caller's
+    for (int t = 0; t < started; ++t) pthread_join(workers[t], NULL);
+
+    if (st.cache != NULL) {
+        long hits, misses;
+        result_cache_stats(st.cache, &hits, &misses);
+        TRACE(TRACE_INFO, "Result cache: %ld hits, %ld misses.\n", hits, misses);
+        result_cache_free(st.cache);
+    }
+    free(workers);
+    outbuf_free(&st.writer);
+    if (st.totals != NULL) {
+        fprintf(stderr, "Solver statistics over %d files:\n", count);
+        solver_stats_print(st.totals, stderr);
+        free(st.totals);
+    }
+    free(st.records);
+    free(st.done);
+    pthread_mutex_destroy(&st.out_lock);
+    return st.failed;
+}
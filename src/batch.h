@@ -0,0 +1,35 @@
+#ifndef BATCH_H
+#define BATCH_H 1
+#include "output.h"
+#include <stdio.h>
+#include <stdbool.h>
+
+// --- Batch Solving ---
+// Solves many input files in one process on a fixed pool of worker threads.
+// Workers take the next unsolved file from a shared counter, so long and short
+// problems balance across threads. Each file gets its own parse and solver context.
+
+typedef struct {
+    int threads;  // Worker count, <= 0 for one per online core
+    bool ordered; // Print results in input order instead of completion order
+    int portfolio; // Strategies raced per file (see portfolio.h), <= 1 for the default one alone
+    bool stream;   // Solve while parsing and stop reading a file at its first empty interval (see stream.h)
+    int cache;     // Answers kept for equivalent problems (see cache.h), 0 for no cache; not used with stream
+    const char* cache_file; // Persistent cache behind it (see diskcache.h), NULL for none
+    OutputFormat format;    // Result lines (see output.h)
+    bool stats;             // Collect solver statistics (see stats.h): in jsonl records, totals on stderr
+    // Budget of each file's solve (see budget.h), timed from the start of reading it; 0 for no limit
+    double timeout_ms;
+    long long max_propagations;
+    size_t max_memory;
+} BatchOptions;
+
+// Expands spec into a list of input paths: a directory (its regular files, sorted),
+// @file (one path per line) or a glob pattern. Returns the count, -1 on error.
+int batch_collect_inputs(const char* spec, char*** paths);
+void batch_free_inputs(char** paths, int count);
+// Solves every path and writes one result per file to out: a `path<TAB>result` line in text
+// format, where result is inconsistent, consistent, unknown (out of budget) or error, else a
+// record as described in output.h. Returns the number of files that could not be solved.
+int batch_solve(char** paths, int count, const BatchOptions* opts, FILE* out);
+#endif
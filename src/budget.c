@@ -0,0 +1,44 @@
+#include "budget.h"
+#include "stats.h"
+
+void budget_init(SolverBudget* b, double ms, long long propagations, size_t memory) {
+    b->deadline_ns = ms > 0 ? stats_now_ns() + (long long)(ms * 1e6) : 0;
+    b->max_propagations = propagations > 0 ? propagations : 0;
+    b->max_memory = memory;
+    atomic_init(&b->propagations, 0);
+    atomic_init(&b->exhausted, BUDGET_NONE);
+}
+
+// The first limit reached wins, so the reason does not change under later checks
+static bool exhaust(SolverBudget* b, BudgetLimit limit) {
+    int expected = BUDGET_NONE;
+    atomic_compare_exchange_strong(&b->exhausted, &expected, limit);
+    return true;
+}
+
+bool budget_charge(SolverContext* ctx, long long revisions, size_t extra_bytes) {
+    SolverBudget* b = ctx->budget;
+    if (b == NULL) return false;
+    if (atomic_load_explicit(&b->exhausted, memory_order_relaxed) != BUDGET_NONE) return true;
+    if (b->max_propagations > 0) {
+        long long used = atomic_fetch_add_explicit(&b->propagations, revisions, memory_order_relaxed) + revisions;
+        if (used > b->max_propagations) return exhaust(b, BUDGET_PROPAGATIONS);
+    }
+    if (b->max_memory > 0 && solver_context_bytes(ctx) + extra_bytes > b->max_memory) return exhaust(b, BUDGET_MEMORY);
+    if (b->deadline_ns > 0 && stats_now_ns() >= b->deadline_ns) return exhaust(b, BUDGET_TIME);
+    return false;
+}
+
+BudgetLimit budget_exhausted(const SolverContext* ctx) {
+    if (ctx->budget == NULL) return BUDGET_NONE;
+    return (BudgetLimit)atomic_load_explicit(&ctx->budget->exhausted, memory_order_relaxed);
+}
+
+const char* budget_limit_name(BudgetLimit limit) {
+    switch (limit) {
+        case BUDGET_TIME: return "time";
+        case BUDGET_PROPAGATIONS: return "propagations";
+        case BUDGET_MEMORY: return "memory";
+        default: return "none";
+    }
+}
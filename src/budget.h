@@ -0,0 +1,44 @@
+#ifndef BUDGET_H
+#define BUDGET_H 1
+#include "interval_solver.h"
+
+// --- Solve Budgets ---
+// Optional limits on one solve: a wall-clock deadline, a number of propagations (constraint
+// revisions, one per constraint and phase) and a cap on the bytes of solver state one context
+// holds. Propagation phases charge their revisions to ctx->budget every few dozen constraints
+// and at their end, and the CDCL search checks it between steps, so a check costs an atomic
+// add, a clock read and a few multiplications.
+// The first limit reached is recorded, and every context sharing the budget (component and
+// portfolio sub-contexts) stops at its next check.
+//
+// A solve that ran out answers consistent with ctx->truncated set, reported as unknown,
+// and leaves the intervals reached so far: propagation only ever narrows by sound rules,
+// so they still enclose every solution. An empty interval found before the budget ran out
+// is a definitive inconsistency. A Boolean search that runs out backs up to decision level
+// 0 and reports the bounds implied by the atoms assigned there.
+
+typedef enum {
+    BUDGET_NONE,         // Not exhausted
+    BUDGET_TIME,
+    BUDGET_PROPAGATIONS,
+    BUDGET_MEMORY
+} BudgetLimit;
+
+struct SolverBudget {
+    long long deadline_ns;      // On the stats_now_ns clock, 0 for none
+    long long max_propagations; // 0 for none
+    size_t max_memory;          // Bytes per context, 0 for none
+    atomic_llong propagations;
+    atomic_int exhausted;       // The BudgetLimit reached first
+};
+
+// Starts the clock; a limit of 0 (ms <= 0 for the time) is left off
+void budget_init(SolverBudget* b, double ms, long long propagations, size_t memory);
+// Charges revisions to ctx's budget, extra_bytes being state held for ctx outside of it,
+// and checks every limit; true once the budget is exhausted
+bool budget_charge(SolverContext* ctx, long long revisions, size_t extra_bytes);
+// The limit reached, BUDGET_NONE if ctx has no budget or it lasted
+BudgetLimit budget_exhausted(const SolverContext* ctx);
+// time, propagations or memory
+const char* budget_limit_name(BudgetLimit limit);
+#endif
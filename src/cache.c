@@ -0,0 +1,156 @@
+#include "cache.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct CacheEntry {
+    CanonHash key;
+    int result;
+    bool truncated;
+    int count;
+    Interval* intervals;
+    struct CacheEntry* bucket_next;
+    struct CacheEntry* prev; // Recency list, most recent first
+    struct CacheEntry* next;
+} CacheEntry;
+
+struct ResultCache {
+    pthread_mutex_t lock;
+    CacheEntry** buckets;
+    int bucket_count; // Power of two
+    int size;
+    int capacity;
+    CacheEntry* head;
+    CacheEntry* tail;
+    long hits;
+    long misses;
+    DiskCache* disk; // NULL if none
+};
+
+ResultCache* result_cache_new(int capacity) {
+    ResultCache* cache = (ResultCache*)calloc(1, sizeof(ResultCache));
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->capacity = capacity > 0 ? capacity : 1;
+    cache->bucket_count = 16;
+    while (cache->bucket_count < cache->capacity) cache->bucket_count *= 2;
+    cache->buckets = (CacheEntry**)calloc(cache->bucket_count, sizeof(CacheEntry*));
+    return cache;
+}
+
+void result_cache_free(ResultCache* cache) {
+    if (cache == NULL) return;
+    CacheEntry* e = cache->head;
+    while (e != NULL) {
+        CacheEntry* next = e->next;
+        free(e->intervals);
+        free(e);
+        e = next;
+    }
+    free(cache->buckets);
+    disk_cache_close(cache->disk);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+void result_cache_attach(ResultCache* cache, DiskCache* disk) {
+    cache->disk = disk;
+}
+
+static CacheEntry** bucket_of(ResultCache* cache, CanonHash key) {
+    return &cache->buckets[key.lo & (unsigned long long)(cache->bucket_count - 1)];
+}
+
+static void unlink_recent(ResultCache* cache, CacheEntry* e) {
+    if (e->prev) e->prev->next = e->next;
+    else cache->head = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else cache->tail = e->prev;
+}
+
+static void push_recent(ResultCache* cache, CacheEntry* e) {
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head) cache->head->prev = e;
+    cache->head = e;
+    if (cache->tail == NULL) cache->tail = e;
+}
+
+static CacheEntry* find(ResultCache* cache, CanonHash key) {
+    for (CacheEntry* e = *bucket_of(cache, key); e != NULL; e = e->bucket_next) {
+        if (canon_hash_equals(e->key, key)) return e;
+    }
+    return NULL;
+}
+
+static void evict_oldest(ResultCache* cache) {
+    CacheEntry* e = cache->tail;
+    unlink_recent(cache, e);
+    CacheEntry** link = bucket_of(cache, e->key);
+    while (*link != e) link = &(*link)->bucket_next;
+    *link = e->bucket_next;
+    free(e->intervals);
+    free(e);
+    cache->size--;
+}
+
+// Adds an answer unless the key is present already; false if it was
+static bool insert(ResultCache* cache, const CanonForm* form, int result, bool truncated) {
+    pthread_mutex_lock(&cache->lock);
+    CacheEntry* e = find(cache, form->hash);
+    if (e != NULL) { // Solved concurrently by another thread
+        pthread_mutex_unlock(&cache->lock);
+        return false;
+    }
+    if (cache->size == cache->capacity) evict_oldest(cache);
+    e = (CacheEntry*)malloc(sizeof(CacheEntry));
+    e->key = form->hash;
+    e->result = result;
+    e->truncated = truncated;
+    e->count = form->count;
+    e->intervals = (Interval*)malloc(sizeof(Interval) * (form->count > 0 ? form->count : 1));
+    memcpy(e->intervals, form->intervals, sizeof(Interval) * form->count);
+    CacheEntry** bucket = bucket_of(cache, e->key);
+    e->bucket_next = *bucket;
+    *bucket = e;
+    push_recent(cache, e);
+    cache->size++;
+    pthread_mutex_unlock(&cache->lock);
+    return true;
+}
+
+bool result_cache_lookup(ResultCache* cache, CanonForm* form, int* result, bool* truncated) {
+    pthread_mutex_lock(&cache->lock);
+    CacheEntry* e = find(cache, form->hash);
+    if (e == NULL || e->count != form->count) {
+        pthread_mutex_unlock(&cache->lock);
+        bool hit = cache->disk != NULL && disk_cache_lookup(cache->disk, form, result, truncated);
+        if (hit) insert(cache, form, *result, *truncated); // Kept in memory from now on
+        pthread_mutex_lock(&cache->lock);
+        if (hit) cache->hits++;
+        else cache->misses++;
+        pthread_mutex_unlock(&cache->lock);
+        return hit;
+    }
+    cache->hits++;
+    unlink_recent(cache, e);
+    push_recent(cache, e);
+    *result = e->result;
+    *truncated = e->truncated;
+    free(form->intervals);
+    form->intervals = (Interval*)malloc(sizeof(Interval) * (e->count > 0 ? e->count : 1));
+    memcpy(form->intervals, e->intervals, sizeof(Interval) * e->count);
+    pthread_mutex_unlock(&cache->lock);
+    return true;
+}
+
+void result_cache_store(ResultCache* cache, const CanonForm* form, int result, bool truncated) {
+    if (insert(cache, form, result, truncated) && cache->disk != NULL) disk_cache_append(cache->disk, form, result, truncated);
+}
+
+void result_cache_stats(ResultCache* cache, long* hits, long* misses) {
+    pthread_mutex_lock(&cache->lock);
+    *hits = cache->hits;
+    *misses = cache->misses;
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,31 @@
+#ifndef CACHE_H
+#define CACHE_H 1
+#include "canon.h"
+#include "diskcache.h"
+
+// --- Result Cache ---
+// An in-process LRU of solver answers keyed by the structural hash of the canonical form
+// (canon.h): the verdict, whether it was truncated at an iteration limit, and the final
+// interval of every canonical variable. A problem whose canonical form was solved before
+// is answered without solving it again. Lookups and stores lock the cache, so one cache
+// can serve many solver threads. A persistent cache (diskcache.h) can be attached behind
+// it: memory misses are looked up there, and new answers are appended to it.
+
+// Capacity used when only a persistent cache is asked for
+#define RESULT_CACHE_DEFAULT 1024
+
+typedef struct ResultCache ResultCache;
+
+// Holds up to capacity answers
+ResultCache* result_cache_new(int capacity);
+// Also closes the attached persistent cache
+void result_cache_free(ResultCache* cache);
+// Puts disk behind the cache, which then owns it
+void result_cache_attach(ResultCache* cache, DiskCache* disk);
+// On a hit stores the verdict in *result and *truncated, fills form->intervals and returns true
+bool result_cache_lookup(ResultCache* cache, CanonForm* form, int* result, bool* truncated);
+// Records the answer of a solved problem; form->intervals must have been captured
+void result_cache_store(ResultCache* cache, const CanonForm* form, int result, bool truncated);
+// Lookups answered from the cache and lookups that missed so far
+void result_cache_stats(ResultCache* cache, long* hits, long* misses);
+#endif
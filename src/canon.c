@@ -0,0 +1,613 @@
+#include "canon.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned long long mix(unsigned long long h, unsigned long long w) {
+    h ^= w + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h * 0xff51afd7ed558ccdULL;
+}
+
+static unsigned long long hash_string(const char* s) {
+    unsigned long long h = 1469598103934665603ULL; // FNV-1a
+    for (; *s; ++s) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// --- Name Table ---
+// Open addressing from a variable name to its canonical number
+
+typedef struct {
+    int* slots; // Canonical number, -1 for an empty slot
+    int cap;
+} NameTable;
+
+static void table_init(NameTable* t, int expected) {
+    t->cap = 64;
+    while (t->cap < 2 * expected) t->cap *= 2;
+    t->slots = (int*)malloc(sizeof(int) * t->cap);
+    for (int i = 0; i < t->cap; ++i) t->slots[i] = -1;
+}
+
+// Slot holding name, or the empty slot where it belongs
+static int table_find(const NameTable* t, char** names, const char* name) {
+    int slot = (int)(hash_string(name) & (unsigned long long)(t->cap - 1));
+    while (t->slots[slot] >= 0 && strcmp(names[t->slots[slot]], name) != 0) slot = (slot + 1) & (t->cap - 1);
+    return slot;
+}
+
+static void table_grow(NameTable* t, char** names) {
+    int old_cap = t->cap;
+    int* old = t->slots;
+    t->cap *= 2;
+    t->slots = (int*)malloc(sizeof(int) * t->cap);
+    for (int i = 0; i < t->cap; ++i) t->slots[i] = -1;
+    for (int i = 0; i < old_cap; ++i) {
+        if (old[i] >= 0) t->slots[table_find(t, names, names[old[i]])] = old[i];
+    }
+    free(old);
+}
+
+// --- Variable Colors ---
+// Shapes cannot tell variables apart by their names, only by where they occur. All
+// variables start with one color; each round of refinement hashes a variable's color
+// with every occurrence of it: the shape of the proposition it occurs in and the path
+// down to it, which records the operand side only where the operator is not commutative.
+// Rounds stop once the number of distinct colors stops growing, so shapes computed with
+// the final colors tie only where no occurrence tells the variables apart.
+
+#define COLOR_ROUNDS 8  // Each round is a pass over the problem
+#define COLOR_SPLITS 16 // Most tied variables given a color of their own, see sort_props
+
+typedef struct {
+    NameTable table;
+    char** names;             // Borrowed from the AST
+    unsigned long long* color;
+    unsigned long long* next; // Occurrence hashes summed in the current round
+    int count;
+    int cap;
+} Colors;
+
+static int color_index(Colors* c, char* name) {
+    int slot = table_find(&c->table, c->names, name);
+    if (c->table.slots[slot] >= 0) return c->table.slots[slot];
+    if (c->count == c->cap) {
+        c->cap = c->cap ? c->cap * 2 : 64;
+        c->names = (char**)realloc(c->names, sizeof(char*) * c->cap);
+        c->color = (unsigned long long*)realloc(c->color, sizeof(unsigned long long) * c->cap);
+        c->next = (unsigned long long*)realloc(c->next, sizeof(unsigned long long) * c->cap);
+    }
+    int idx = c->count++;
+    c->names[idx] = name;
+    c->color[idx] = 0;
+    c->next[idx] = 0;
+    c->table.slots[slot] = idx;
+    if (2 * c->count > c->table.cap) table_grow(&c->table, c->names);
+    return idx;
+}
+
+static void colors_free(Colors* c) {
+    free(c->table.slots);
+    free(c->names);
+    free(c->color);
+    free(c->next);
+}
+
+// --- Sorting ---
+// Each function sorts the operands below it and returns a hash of the shape, in which
+// a variable is known only by its color. Terms and propositions may nest deeper than the C stack
+// allows, so both walk post-order on an explicit stack: a node is finished once the
+// hashes of its operands, left to right, are on top of a HashStack.
+
+typedef struct {
+    unsigned long long* v;
+    int size;
+    int cap;
+} HashStack;
+
+static void hash_push(HashStack* s, unsigned long long h) {
+    if (s->size == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 64;
+        s->v = (unsigned long long*)realloc(s->v, sizeof(unsigned long long) * s->cap);
+    }
+    s->v[s->size++] = h;
+}
+
+// Sorts the operands of t, whose hashes are sub[0..arity)
+static unsigned long long sort_term_node(Colors* c, SmtTerm* t, unsigned long long* sub) {
+    unsigned long long h = mix(0, t->type);
+    switch (t->type) {
+        case SMT_LiaBTerm:
+        case SMT_NiaBTerm: {
+            unsigned long long h1 = sub[0];
+            unsigned long long h2 = sub[1];
+            if ((t->term.BTerm.op == LIA_ADD || t->term.BTerm.op == LIA_MULT) && h2 < h1) {
+                SmtTerm* tmp = t->term.BTerm.t1;
+                t->term.BTerm.t1 = t->term.BTerm.t2;
+                t->term.BTerm.t2 = tmp;
+                unsigned long long th = h1;
+                h1 = h2;
+                h2 = th;
+            }
+            return mix(mix(mix(h, t->term.BTerm.op), h1), h2);
+        }
+        case SMT_LiaUTerm:
+            return mix(mix(h, t->term.UTerm.op), sub[0]);
+        case SMT_UFTerm: {
+            UFunction* uf = t->term.UFTerm;
+            h = mix(mix(h, hash_string(uf->name)), uf->numArgs);
+            for (int i = 0; i < uf->numArgs; ++i) h = mix(h, sub[i]);
+            return h;
+        }
+        case SMT_ConstNum:
+        case SMT_VarNum:
+            return mix(h, (unsigned long long)(long long)t->term.ConstNum);
+        case SMT_VarName: {
+            int idx = color_index(c, t->term.Variable); // May grow c->color
+            return mix(h, c->color[idx]);
+        }
+        default:
+            return h;
+    }
+}
+
+static unsigned long long sort_term(Colors* c, SmtTerm* t) {
+    if (t == NULL) return 0;
+    HashStack done = { NULL, 0, 0 };
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, t, NULL);
+    while (walk.size > 0) {
+        SmtWalkItem* it = &walk.items[walk.size - 1];
+        t = (SmtTerm*)it->node;
+        int n = SmtTerm_arity(t);
+        if (it->next < n) {
+            SmtTerm* child = SmtTerm_child(t, it->next++);
+            if (child != NULL) smt_walk_push(&walk, 0, child, NULL);
+            else hash_push(&done, 0);
+            continue;
+        }
+        walk.size--;
+        done.size -= n;
+        unsigned long long h = sort_term_node(c, t, done.v + done.size);
+        hash_push(&done, h);
+    }
+    unsigned long long h = done.v[0];
+    free(done.v);
+    smt_walk_free(&walk);
+    return h;
+}
+
+// Sorts the operands of p, whose subproposition hashes are sub[0..arity)
+static unsigned long long sort_prop_node(Colors* c, SmtProp* p, unsigned long long* sub) {
+    unsigned long long h = mix(0, p->type);
+    switch (p->type) {
+        case SMTB_PROP: {
+            SmtPropBop op = p->prop.Binary_prop.op;
+            unsigned long long h1 = sub[0];
+            unsigned long long h2 = sub[1];
+            if (op != SMTPROP_IMPLY && h2 < h1) {
+                SmtProp* tmp = p->prop.Binary_prop.prop1;
+                p->prop.Binary_prop.prop1 = p->prop.Binary_prop.prop2;
+                p->prop.Binary_prop.prop2 = tmp;
+                unsigned long long th = h1;
+                h1 = h2;
+                h2 = th;
+            }
+            return mix(mix(mix(h, op), h1), h2);
+        }
+        case SMTU_PROP:
+            return mix(mix(h, p->prop.Unary_prop.op), sub[0]);
+        case SMT_QUANT_PROP:
+            return mix(mix(h, p->prop.Quant_prop.type), sub[0]);
+        case SMTAT_PROP_EQ:
+        case SMTAT_PROP_LIA: {
+            unsigned long long h1 = sort_term(c, p->prop.Atomic_prop.term1);
+            unsigned long long h2 = sort_term(c, p->prop.Atomic_prop.term2);
+            SmtBinPred op = p->prop.Atomic_prop.op;
+            bool swap = op == SMT_GT || op == SMT_GE || (op == SMT_EQ && h2 < h1);
+            if (op == SMT_GT) op = SMT_LT;
+            if (op == SMT_GE) op = SMT_LE;
+            if (swap) {
+                SmtTerm* tmp = p->prop.Atomic_prop.term1;
+                p->prop.Atomic_prop.term1 = p->prop.Atomic_prop.term2;
+                p->prop.Atomic_prop.term2 = tmp;
+                unsigned long long th = h1;
+                h1 = h2;
+                h2 = th;
+            }
+            p->prop.Atomic_prop.op = op;
+            return mix(mix(mix(h, op), h1), h2);
+        }
+        case SMTAT_PROP_UF_EQ:
+        case SMTAT_PROP_LIA_EQ:
+        case SMTAT_PROP_NIA_EQ: {
+            unsigned long long h1 = sort_term(c, p->prop.Atomic_prop.term1);
+            return mix(mix(mix(h, p->prop.Atomic_prop.op), h1), sort_term(c, p->prop.Atomic_prop.term2));
+        }
+        case SMT_PROPVAR:
+            return mix(h, (unsigned long long)(long long)p->prop.Propvar);
+        case SMTTF_PROP:
+            return mix(h, p->prop.TF);
+        default:
+            return h;
+    }
+}
+
+static unsigned long long sort_prop(Colors* c, SmtProp* p) {
+    if (p == NULL) return 0;
+    HashStack done = { NULL, 0, 0 };
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, p, NULL);
+    while (walk.size > 0) {
+        SmtWalkItem* it = &walk.items[walk.size - 1];
+        p = (SmtProp*)it->node;
+        int n = SmtProp_arity(p);
+        if (it->next < n) {
+            SmtProp* child = SmtProp_child(p, it->next++);
+            if (child != NULL) smt_walk_push(&walk, 0, child, NULL);
+            else hash_push(&done, 0);
+            continue;
+        }
+        walk.size--;
+        done.size -= n;
+        unsigned long long h = sort_prop_node(c, p, done.v + done.size);
+        hash_push(&done, h);
+    }
+    unsigned long long h = done.v[0];
+    free(done.v);
+    smt_walk_free(&walk);
+    return h;
+}
+
+// Adds every variable occurrence in p, a proposition of the given shape, to c->next. A walk
+// item's h is the hash of the path down to its node.
+static void add_occurrences(Colors* c, SmtProp* p, unsigned long long shape) {
+    enum { PROP, TERM };
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, PROP, p, NULL)->h = shape;
+    while (walk.size > 0) {
+        SmtWalkItem it = smt_walk_pop(&walk);
+        if (it.node == NULL) continue;
+        if (it.tag == PROP) {
+            SmtProp* q = (SmtProp*)it.node;
+            unsigned long long h = mix(it.h, q->type);
+            if (q->type == SMTB_PROP) {
+                bool ordered = q->prop.Binary_prop.op == SMTPROP_IMPLY;
+                h = mix(h, q->prop.Binary_prop.op);
+                smt_walk_push(&walk, PROP, q->prop.Binary_prop.prop1, NULL)->h = mix(h, ordered ? 1 : 0);
+                smt_walk_push(&walk, PROP, q->prop.Binary_prop.prop2, NULL)->h = mix(h, ordered ? 2 : 0);
+            } else if (q->type == SMTU_PROP || q->type == SMT_QUANT_PROP) {
+                smt_walk_push(&walk, PROP, SmtProp_child(q, 0), NULL)->h = h;
+            } else if (q->type == SMTAT_PROP_EQ || q->type == SMTAT_PROP_LIA || q->type == SMTAT_PROP_UF_EQ || q->type == SMTAT_PROP_LIA_EQ || q->type == SMTAT_PROP_NIA_EQ) {
+                bool ordered = q->prop.Atomic_prop.op != SMT_EQ;
+                h = mix(h, q->prop.Atomic_prop.op);
+                smt_walk_push(&walk, TERM, q->prop.Atomic_prop.term1, NULL)->h = mix(h, ordered ? 1 : 0);
+                smt_walk_push(&walk, TERM, q->prop.Atomic_prop.term2, NULL)->h = mix(h, ordered ? 2 : 0);
+            }
+            continue;
+        }
+        SmtTerm* t = (SmtTerm*)it.node;
+        if (t->type == SMT_VarName) {
+            int idx = color_index(c, t->term.Variable);
+            c->next[idx] += mix(it.h, 0x5bd1e995ULL); // A sum, so the order of occurrences does not matter
+            continue;
+        }
+        unsigned long long h = mix(it.h, t->type);
+        bool ordered = true;
+        if (t->type == SMT_LiaBTerm || t->type == SMT_NiaBTerm) {
+            h = mix(h, t->term.BTerm.op);
+            ordered = t->term.BTerm.op != LIA_ADD && t->term.BTerm.op != LIA_MULT;
+        } else if (t->type == SMT_LiaUTerm) {
+            h = mix(h, t->term.UTerm.op);
+        } else if (t->type == SMT_UFTerm) {
+            h = mix(h, hash_string(t->term.UFTerm->name));
+        }
+        for (int i = 0; i < SmtTerm_arity(t); ++i) smt_walk_push(&walk, TERM, SmtTerm_child(t, i), NULL)->h = mix(h, ordered ? (unsigned long long)i + 1 : 0);
+    }
+    smt_walk_free(&walk);
+}
+
+typedef struct {
+    unsigned long long color;
+    int var;
+} ColorEntry;
+
+static int compare_color(const void* a, const void* b) {
+    const ColorEntry* x = (const ColorEntry*)a;
+    const ColorEntry* y = (const ColorEntry*)b;
+    if (x->color != y->color) return x->color < y->color ? -1 : 1;
+    return x->var - y->var;
+}
+
+// The number of distinct colors; *tied is the first variable of the lowest color that
+// several variables share, -1 if there is none, and *tied_count the variables sharing one
+static int distinct_colors(const Colors* c, int* tied, int* tied_count) {
+    *tied = -1;
+    *tied_count = 0;
+    if (c->count == 0) return 0;
+    ColorEntry* sorted = (ColorEntry*)malloc(sizeof(ColorEntry) * c->count);
+    for (int v = 0; v < c->count; ++v) {
+        sorted[v].color = c->color[v];
+        sorted[v].var = v;
+    }
+    qsort(sorted, c->count, sizeof(ColorEntry), compare_color);
+    int n = 1;
+    for (int i = 1; i < c->count; ++i) {
+        if (sorted[i].color != sorted[i - 1].color) {
+            n++;
+            continue;
+        }
+        if (*tied < 0) *tied = sorted[i - 1].var;
+        *tied_count += i == 1 || sorted[i - 1].color != sorted[i - 2].color ? 2 : 1;
+    }
+    free(sorted);
+    return n;
+}
+
+// Sorts the operands of props[0..count) and leaves their shapes in shapes, refining the
+// colors until they stop telling more variables apart; returns a variable still tied, or -1
+// when there is none or too many to split
+static int refine_colors(Colors* c, SmtProp** props, unsigned long long* shapes, int count) {
+    int distinct = -1, tied = -1, tied_count = 0;
+    for (int round = 0; ; ++round) {
+        for (int i = 0; i < count; ++i) shapes[i] = sort_prop(c, props[i]);
+        int now = distinct_colors(c, &tied, &tied_count);
+        if (now <= distinct || round == COLOR_ROUNDS) break;
+        distinct = now;
+        for (int v = 0; v < c->count; ++v) c->next[v] = 0;
+        for (int i = 0; i < count; ++i) add_occurrences(c, props[i], shapes[i]);
+        for (int v = 0; v < c->count; ++v) c->color[v] = mix(c->color[v], c->next[v]);
+    }
+    return tied_count <= COLOR_SPLITS ? tied : -1;
+}
+
+// Variables that refinement leaves tied usually are symmetric, like m and n in a = m * n
+// with m > 1 and n > 1, and any of them may be told apart from the others: one of them gets
+// a color of its own and refinement runs again. Every choice gives the same form when the
+// tied variables are truly interchangeable. Large problems with many ties, such as long
+// chains of one relation, keep them rather than pay a pass per split.
+static void sort_props(Colors* c, SmtProp** props, unsigned long long* shapes, int count) {
+    int tied = refine_colors(c, props, shapes, count);
+    for (int k = 0; tied >= 0 && k < COLOR_SPLITS; ++k) {
+        c->color[tied] = mix(c->color[tied], 0x2545f4914f6cdd1dULL);
+        tied = refine_colors(c, props, shapes, count);
+    }
+}
+
+typedef struct {
+    unsigned long long shape;
+    int index; // Input position, so that equal shapes keep their order
+    SmtProp* prop;
+} ShapedProp;
+
+static int compare_shaped(const void* a, const void* b) {
+    const ShapedProp* x = (const ShapedProp*)a;
+    const ShapedProp* y = (const ShapedProp*)b;
+    if (x->shape != y->shape) return x->shape < y->shape ? -1 : 1;
+    return x->index - y->index;
+}
+
+// --- Structural Hash ---
+
+typedef struct {
+    CanonHash hash;
+    CanonForm* form;
+    NameTable table;
+} Hasher;
+
+static void hash_word(Hasher* hs, unsigned long long w) {
+    hs->hash.lo = (hs->hash.lo ^ w) * 0x100000001b3ULL;
+    hs->hash.lo ^= hs->hash.lo >> 29;
+    hs->hash.hi = (hs->hash.hi ^ (w + 0x9e3779b97f4a7c15ULL)) * 0xc4ceb9fe1a85ec53ULL;
+    hs->hash.hi ^= hs->hash.hi >> 32;
+}
+
+// Canonical number of name, assigning the next one on first occurrence
+static int canonical_var(Hasher* hs, char* name) {
+    CanonForm* form = hs->form;
+    int slot = table_find(&hs->table, form->names, name);
+    if (hs->table.slots[slot] >= 0) return hs->table.slots[slot];
+    if (form->count == form->cap) {
+        form->cap = form->cap ? form->cap * 2 : 64;
+        form->names = (char**)realloc(form->names, sizeof(char*) * form->cap);
+    }
+    int idx = form->count++;
+    form->names[idx] = name;
+    hs->table.slots[slot] = idx;
+    if (2 * form->count > hs->table.cap) table_grow(&hs->table, form->names);
+    return idx;
+}
+
+// Both hash in pre-order, children pushed last to first so that they are hashed left to right
+static void hash_term(Hasher* hs, SmtTerm* t) {
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, t, NULL);
+    while (walk.size > 0) {
+        t = (SmtTerm*)smt_walk_pop(&walk).node;
+        if (t == NULL) {
+            hash_word(hs, 0);
+            continue;
+        }
+        hash_word(hs, t->type);
+        switch (t->type) {
+            case SMT_LiaBTerm:
+            case SMT_NiaBTerm:
+                hash_word(hs, t->term.BTerm.op);
+                break;
+            case SMT_LiaUTerm:
+                hash_word(hs, t->term.UTerm.op);
+                break;
+            case SMT_UFTerm:
+                hash_word(hs, hash_string(t->term.UFTerm->name));
+                hash_word(hs, t->term.UFTerm->numArgs);
+                break;
+            case SMT_ConstNum:
+            case SMT_VarNum:
+                hash_word(hs, (unsigned long long)(long long)t->term.ConstNum);
+                break;
+            case SMT_VarName:
+                hash_word(hs, canonical_var(hs, t->term.Variable));
+                break;
+            default:
+                break;
+        }
+        for (int i = SmtTerm_arity(t) - 1; i >= 0; --i) smt_walk_push(&walk, 0, SmtTerm_child(t, i), NULL);
+    }
+    smt_walk_free(&walk);
+}
+
+static void hash_prop(Hasher* hs, SmtProp* p) {
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, p, NULL);
+    while (walk.size > 0) {
+        p = (SmtProp*)smt_walk_pop(&walk).node;
+        if (p == NULL) {
+            hash_word(hs, 0);
+            continue;
+        }
+        hash_word(hs, p->type);
+        switch (p->type) {
+            case SMTB_PROP:
+                hash_word(hs, p->prop.Binary_prop.op);
+                break;
+            case SMTU_PROP:
+                hash_word(hs, p->prop.Unary_prop.op);
+                break;
+            case SMT_QUANT_PROP:
+                hash_word(hs, p->prop.Quant_prop.type);
+                hash_word(hs, canonical_var(hs, p->prop.Quant_prop.quant_var));
+                break;
+            case SMTAT_PROP_EQ:
+            case SMTAT_PROP_LIA:
+            case SMTAT_PROP_UF_EQ:
+            case SMTAT_PROP_LIA_EQ:
+            case SMTAT_PROP_NIA_EQ:
+                hash_word(hs, p->prop.Atomic_prop.op);
+                hash_term(hs, p->prop.Atomic_prop.term1);
+                hash_term(hs, p->prop.Atomic_prop.term2);
+                break;
+            case SMT_PROPVAR:
+                hash_word(hs, (unsigned long long)(long long)p->prop.Propvar);
+                break;
+            case SMTTF_PROP:
+                hash_word(hs, p->prop.TF);
+                break;
+            default:
+                break;
+        }
+        for (int i = SmtProp_arity(p) - 1; i >= 0; --i) smt_walk_push(&walk, 0, SmtProp_child(p, i), NULL);
+    }
+    smt_walk_free(&walk);
+}
+
+// --- Canonical Form ---
+
+// Points form->names at the strings of list, which the copy that was hashed shared by value
+static void rebind_names(CanonForm* form, NameTable* table, const SmtProplist* list) {
+    enum { PROP, TERM };
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    for (const SmtProplist* cur = list; cur != NULL; cur = cur->next) {
+        smt_walk_push(&walk, PROP, cur->prop, NULL);
+        while (walk.size > 0) {
+            SmtWalkItem it = smt_walk_pop(&walk);
+            if (it.node == NULL) continue;
+            char* name = NULL;
+            if (it.tag == PROP) {
+                SmtProp* p = (SmtProp*)it.node;
+                for (int i = 0; i < SmtProp_arity(p); ++i) smt_walk_push(&walk, PROP, SmtProp_child(p, i), NULL);
+                if (p->type == SMT_QUANT_PROP) name = p->prop.Quant_prop.quant_var;
+                if (p->type == SMTAT_PROP_EQ || p->type == SMTAT_PROP_LIA || p->type == SMTAT_PROP_UF_EQ || p->type == SMTAT_PROP_LIA_EQ || p->type == SMTAT_PROP_NIA_EQ) {
+                    smt_walk_push(&walk, TERM, p->prop.Atomic_prop.term1, NULL);
+                    smt_walk_push(&walk, TERM, p->prop.Atomic_prop.term2, NULL);
+                }
+            } else {
+                SmtTerm* t = (SmtTerm*)it.node;
+                for (int i = 0; i < SmtTerm_arity(t); ++i) smt_walk_push(&walk, TERM, SmtTerm_child(t, i), NULL);
+                if (t->type == SMT_VarName) name = t->term.Variable;
+            }
+            if (name == NULL) continue;
+            int idx = table->slots[table_find(table, form->names, name)];
+            if (idx >= 0) form->names[idx] = name; // Same string, so the table stays valid
+        }
+    }
+    smt_walk_free(&walk);
+}
+
+void canonicalize(const SmtProplist* list, CanonForm* form) {
+    memset(form, 0, sizeof(*form));
+    // Sorting swaps operands, so it works on a copy and the solver sees the input order
+    int count = 0;
+    for (const SmtProplist* cur = list; cur != NULL; cur = cur->next) count++;
+    SmtProp** props = (SmtProp**)malloc(sizeof(SmtProp*) * (count > 0 ? count : 1));
+    unsigned long long* shapes = (unsigned long long*)malloc(sizeof(unsigned long long) * (count > 0 ? count : 1));
+    int i = 0;
+    for (const SmtProplist* cur = list; cur != NULL; cur = cur->next) props[i++] = copy_SmtProp(cur->prop);
+
+    Colors colors;
+    memset(&colors, 0, sizeof(colors));
+    table_init(&colors.table, 64);
+    sort_props(&colors, props, shapes, count);
+    colors_free(&colors);
+    ShapedProp* shaped = (ShapedProp*)malloc(sizeof(ShapedProp) * (count > 0 ? count : 1));
+    for (i = 0; i < count; ++i) {
+        shaped[i].shape = shapes[i];
+        shaped[i].index = i;
+        shaped[i].prop = props[i];
+    }
+    qsort(shaped, count, sizeof(ShapedProp), compare_shaped);
+
+    Hasher hs;
+    hs.hash.lo = 0xcbf29ce484222325ULL;
+    hs.hash.hi = 0x84222325cbf29ce4ULL;
+    hs.form = form;
+    table_init(&hs.table, 64);
+    for (i = 0; i < count; ++i) {
+        hash_word(&hs, 1); // Proposition separator
+        hash_prop(&hs, shaped[i].prop);
+    }
+    hash_word(&hs, (unsigned long long)form->count);
+    form->hash = hs.hash;
+    rebind_names(form, &hs.table, list);
+    free(hs.table.slots);
+    for (i = 0; i < count; ++i) freeSmtProp(props[i]);
+    free(shaped);
+    free(shapes);
+    free(props);
+}
+
+void canon_capture_intervals(CanonForm* form, SolverContext* ctx) {
+    free(form->intervals);
+    form->intervals = (Interval*)malloc(sizeof(Interval) * (form->count > 0 ? form->count : 1));
+    NameTable table;
+    table_init(&table, form->count);
+    for (int i = 0; i < form->count; ++i) {
+        form->intervals[i] = INF_INTERVAL; // A variable the solver never reached
+        table.slots[table_find(&table, form->names, form->names[i])] = i;
+    }
+    for (int i = 0; i < ctx->var_map_count; ++i) {
+        VarIntervalEntry* v = &ctx->var_map[i];
+        if (!v->active) continue;
+        int idx = table.slots[table_find(&table, form->names, v->name)];
+        if (idx >= 0) form->intervals[idx] = v->interval;
+    }
+    free(table.slots);
+}
+
+void canon_form_free(CanonForm* form) {
+    free(form->names);
+    free(form->intervals);
+    memset(form, 0, sizeof(*form));
+}
+
+bool canon_hash_equals(CanonHash a, CanonHash b) {
+    return a.lo == b.lo && a.hi == b.hi;
+}
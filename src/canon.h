@@ -0,0 +1,40 @@
+#ifndef CANON_H
+#define CANON_H 1
+#include "interval_solver.h"
+
+// --- Canonical Form ---
+// Brings a proplist into a form shared by problems that differ only in variable names,
+// line order or the order of commutative operands, and hashes that form to 128 bits.
+// Operands of + and * and of AND / OR / IFF, the sides of =, and the propositions of
+// the list are sorted by a shape hash; > and >= are turned into < and <= by swapping
+// sides. Shapes ignore variable names and know a variable only by a color refined from
+// where it occurs (canon.c), so the order does not depend on the names either.
+// Variables are then numbered in order of first occurrence and the structural hash is
+// taken over those numbers. Operands whose shapes still tie keep their input order, so
+// problems with such symmetric-looking parts can hash apart; equal hashes always mean
+// the same problem up to renaming.
+
+// Changes whenever the canonical form or its hash does, invalidating persisted keys
+#define CANON_VERSION 2
+
+typedef struct {
+    unsigned long long lo;
+    unsigned long long hi;
+} CanonHash;
+
+typedef struct {
+    CanonHash hash;
+    char** names;        // Canonical variable i is names[i] in this problem (borrowed from the AST)
+    int count;
+    int cap;
+    Interval* intervals; // Final interval of each canonical variable, filled by the caller
+} CanonForm;
+
+// Fills form for list, which must be zeroed or freed before; the sorting is done on a copy,
+// so list is left in its input order and the solver answers exactly as without a cache
+void canonicalize(const SmtProplist* list, CanonForm* form);
+// Copies the final variable intervals of a solved ctx into form->intervals
+void canon_capture_intervals(CanonForm* form, SolverContext* ctx);
+void canon_form_free(CanonForm* form);
+bool canon_hash_equals(CanonHash a, CanonHash b);
+#endif
@@ -0,0 +1,588 @@
+#include "cdcl.h"
+#include "budget.h"
+#include "incremental.h"
+#include "interval_solver.h"
+#include "tseitin.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VAR_DECAY 0.95
+#define RESTART_BASE 100 // Conflicts per restart, scaled by the Luby sequence
+
+#define CREF_UNDEF -1
+
+typedef struct {
+    CRef* data;
+    int size;
+    int cap;
+} WatchList;
+
+struct SatSolver {
+    SolverContext* ctx; // Maps used by the theory checks
+    SolverContext* explain; // Incremental context the explanations are minimized on, created on first use
+    int num_vars;
+    int cap_vars;
+
+    int* arena; // Original and learnt clauses laid out back to back, addressed by CRef
+    int arena_size;
+    int arena_cap;
+
+    WatchList* watches;  // Indexed by literal: clauses watching that literal
+    signed char* assigns; // lbool per variable
+    int* level;
+    CRef* reason;        // CREF_UNDEF for decisions and level-0 units
+    bool* polarity;      // Saved phase, true means the variable was last assigned false
+    double* activity;
+    bool* seen;
+    SmtProp** atom;      // Interval atom behind a variable, NULL for Boolean-only variables
+
+    Lit* trail;
+    int trail_size;
+    int* trail_lim;
+    int decision_level;
+    int qhead;
+
+    int* heap;     // VSIDS decision order, highest activity at heap[0]
+    int heap_size;
+    int* heap_pos; // -1 when the variable is not in the heap
+    double var_inc;
+
+    Lit* learnt_buf;
+    bool unsat;        // Top-level conflict found while adding clauses
+    bool theory_dirty; // Atoms were assigned since the last consistent theory check
+    long conflicts;
+};
+
+// --- Clause Arena & Watch Lists ---
+
+static inline Clause* clause_at(SatSolver* S, CRef r) {
+    return (Clause*)(S->arena + r);
+}
+
+static CRef alloc_clause(SatSolver* S, const Lit* lits, int n, bool learnt) {
+    int words = (int)(sizeof(Clause) / sizeof(int)) + n;
+    if (S->arena_size + words > S->arena_cap) {
+        while (S->arena_size + words > S->arena_cap) S->arena_cap = S->arena_cap ? S->arena_cap * 2 : 1024;
+        S->arena = (int*)realloc(S->arena, sizeof(int) * S->arena_cap);
+    }
+    CRef r = S->arena_size;
+    S->arena_size += words;
+    Clause* c = clause_at(S, r);
+    c->size = n;
+    c->learnt = learnt;
+    memcpy(c->lits, lits, sizeof(Lit) * n);
+    return r;
+}
+
+static void watch_push(WatchList* ws, CRef c) {
+    if (ws->size == ws->cap) {
+        ws->cap = ws->cap ? ws->cap * 2 : 4;
+        ws->data = (CRef*)realloc(ws->data, sizeof(CRef) * ws->cap);
+    }
+    ws->data[ws->size++] = c;
+}
+
+static void attach_clause(SatSolver* S, CRef r) {
+    Clause* c = clause_at(S, r);
+    watch_push(&S->watches[c->lits[0]], r);
+    watch_push(&S->watches[c->lits[1]], r);
+}
+
+// --- VSIDS Heap ---
+
+static void heap_swap(SatSolver* S, int i, int j) {
+    int vi = S->heap[i], vj = S->heap[j];
+    S->heap[i] = vj; S->heap_pos[vj] = i;
+    S->heap[j] = vi; S->heap_pos[vi] = j;
+}
+
+static void heap_up(SatSolver* S, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (S->activity[S->heap[parent]] >= S->activity[S->heap[i]]) break;
+        heap_swap(S, i, parent);
+        i = parent;
+    }
+}
+
+static void heap_down(SatSolver* S, int i) {
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, best = i;
+        if (l < S->heap_size && S->activity[S->heap[l]] > S->activity[S->heap[best]]) best = l;
+        if (r < S->heap_size && S->activity[S->heap[r]] > S->activity[S->heap[best]]) best = r;
+        if (best == i) return;
+        heap_swap(S, i, best);
+        i = best;
+    }
+}
+
+static void heap_insert(SatSolver* S, int v) {
+    S->heap[S->heap_size] = v;
+    S->heap_pos[v] = S->heap_size++;
+    heap_up(S, S->heap_pos[v]);
+}
+
+static int heap_remove_max(SatSolver* S) {
+    int v = S->heap[0];
+    S->heap_size--;
+    if (S->heap_size > 0) {
+        S->heap[0] = S->heap[S->heap_size];
+        S->heap_pos[S->heap[0]] = 0;
+        heap_down(S, 0);
+    }
+    S->heap_pos[v] = -1;
+    return v;
+}
+
+static void bump_var(SatSolver* S, int v) {
+    if ((S->activity[v] += S->var_inc) > 1e100) { // Rescale all activities to avoid overflow
+        for (int i = 0; i < S->num_vars; ++i) S->activity[i] *= 1e-100;
+        S->var_inc *= 1e-100;
+    }
+    if (S->heap_pos[v] >= 0) heap_up(S, S->heap_pos[v]);
+}
+
+// --- Solver Construction ---
+
+SatSolver* sat_new(SolverContext* ctx) {
+    SatSolver* S = (SatSolver*)malloc(sizeof(SatSolver));
+    memset(S, 0, sizeof(SatSolver));
+    S->ctx = ctx;
+    S->var_inc = 1.0;
+    return S;
+}
+
+void sat_free(SatSolver* S) {
+    if (S == NULL) return;
+    if (S->explain) solver_context_free(S->explain);
+    free(S->arena);
+    for (int i = 0; i < 2 * S->num_vars; ++i) free(S->watches[i].data);
+    free(S->watches);
+    free(S->assigns);
+    free(S->level);
+    free(S->reason);
+    free(S->polarity);
+    free(S->activity);
+    free(S->seen);
+    free(S->atom);
+    free(S->trail);
+    free(S->trail_lim);
+    free(S->heap);
+    free(S->heap_pos);
+    free(S->learnt_buf);
+    free(S);
+}
+
+int sat_new_var(SatSolver* S) {
+    if (S->num_vars == S->cap_vars) {
+        int cap = S->cap_vars ? S->cap_vars * 2 : 16;
+        S->watches = (WatchList*)realloc(S->watches, sizeof(WatchList) * 2 * cap);
+        memset(S->watches + 2 * S->cap_vars, 0, sizeof(WatchList) * 2 * (cap - S->cap_vars));
+        S->assigns = (signed char*)realloc(S->assigns, sizeof(signed char) * cap);
+        S->level = (int*)realloc(S->level, sizeof(int) * cap);
+        S->reason = (CRef*)realloc(S->reason, sizeof(CRef) * cap);
+        S->polarity = (bool*)realloc(S->polarity, sizeof(bool) * cap);
+        S->activity = (double*)realloc(S->activity, sizeof(double) * cap);
+        S->seen = (bool*)realloc(S->seen, sizeof(bool) * cap);
+        S->atom = (SmtProp**)realloc(S->atom, sizeof(SmtProp*) * cap);
+        S->trail = (Lit*)realloc(S->trail, sizeof(Lit) * cap);
+        S->trail_lim = (int*)realloc(S->trail_lim, sizeof(int) * (cap + 1));
+        S->heap = (int*)realloc(S->heap, sizeof(int) * cap);
+        S->heap_pos = (int*)realloc(S->heap_pos, sizeof(int) * cap);
+        S->learnt_buf = (Lit*)realloc(S->learnt_buf, sizeof(Lit) * (cap + 1));
+        S->cap_vars = cap;
+    }
+    int v = S->num_vars++;
+    S->assigns[v] = L_UNDEF;
+    S->level[v] = 0;
+    S->reason[v] = CREF_UNDEF;
+    S->polarity[v] = true;
+    S->activity[v] = 0.0;
+    S->seen[v] = false;
+    S->atom[v] = NULL;
+    heap_insert(S, v);
+    return v;
+}
+
+void sat_set_atom(SatSolver* S, int var, SmtProp* atom) {
+    S->atom[var] = atom;
+}
+
+lbool sat_value(SatSolver* S, Lit l) {
+    signed char a = S->assigns[LIT_VAR(l)];
+    if (a == L_UNDEF) return L_UNDEF;
+    return (lbool)(a ^ LIT_SIGN(l));
+}
+
+static void enqueue(SatSolver* S, Lit l, CRef from) {
+    int v = LIT_VAR(l);
+    S->assigns[v] = (signed char)!LIT_SIGN(l);
+    S->level[v] = S->decision_level;
+    S->reason[v] = from;
+    S->trail[S->trail_size++] = l;
+    if (S->atom[v] != NULL) S->theory_dirty = true;
+}
+
+static int compare_lits(const void* a, const void* b) {
+    return *(const Lit*)a - *(const Lit*)b;
+}
+
+bool sat_add_clause(SatSolver* S, const Lit* lits, int n) {
+    if (S->unsat) return false;
+    Lit* tmp = (Lit*)malloc(sizeof(Lit) * (n > 0 ? n : 1));
+    memcpy(tmp, lits, sizeof(Lit) * n);
+    qsort(tmp, n, sizeof(Lit), compare_lits);
+
+    // Drop duplicates and level-0 false literals, skip tautologies and satisfied clauses
+    int k = 0;
+    for (int i = 0; i < n; ++i) {
+        lbool val = sat_value(S, tmp[i]);
+        if (val == L_TRUE || (k > 0 && tmp[i] == LIT_NEG(tmp[k - 1]))) { free(tmp); return true; }
+        if (val == L_FALSE || (k > 0 && tmp[i] == tmp[k - 1])) continue;
+        tmp[k++] = tmp[i];
+    }
+
+    if (k == 0) {
+        S->unsat = true;
+    } else if (k == 1) {
+        enqueue(S, tmp[0], CREF_UNDEF);
+    } else {
+        attach_clause(S, alloc_clause(S, tmp, k, false));
+    }
+    free(tmp);
+    return !S->unsat;
+}
+
+// --- Unit Propagation ---
+
+static CRef propagate(SatSolver* S) {
+    while (S->qhead < S->trail_size) {
+        Lit false_lit = LIT_NEG(S->trail[S->qhead++]);
+        WatchList* ws = &S->watches[false_lit];
+        int i = 0, j = 0;
+        while (i < ws->size) {
+            CRef r = ws->data[i++];
+            Clause* c = clause_at(S, r);
+            if (c->lits[0] == false_lit) { c->lits[0] = c->lits[1]; c->lits[1] = false_lit; }
+            if (sat_value(S, c->lits[0]) == L_TRUE) { ws->data[j++] = r; continue; }
+
+            // Look for a new literal to watch
+            bool moved = false;
+            for (int k = 2; k < c->size; ++k) {
+                if (sat_value(S, c->lits[k]) != L_FALSE) {
+                    c->lits[1] = c->lits[k];
+                    c->lits[k] = false_lit;
+                    watch_push(&S->watches[c->lits[1]], r);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) continue;
+
+            ws->data[j++] = r;
+            if (sat_value(S, c->lits[0]) == L_FALSE) { // Conflict: keep the remaining watchers
+                while (i < ws->size) ws->data[j++] = ws->data[i++];
+                ws->size = j;
+                S->qhead = S->trail_size;
+                return r;
+            }
+            enqueue(S, c->lits[0], r);
+        }
+        ws->size = j;
+    }
+    return CREF_UNDEF;
+}
+
+static void cancel_until(SatSolver* S, int level) {
+    if (S->decision_level <= level) return;
+    for (int i = S->trail_size - 1; i >= S->trail_lim[level]; --i) {
+        int v = LIT_VAR(S->trail[i]);
+        S->assigns[v] = L_UNDEF;
+        S->reason[v] = CREF_UNDEF;
+        S->polarity[v] = LIT_SIGN(S->trail[i]);
+        if (S->heap_pos[v] < 0) heap_insert(S, v);
+    }
+    S->trail_size = S->trail_lim[level];
+    S->qhead = S->trail_size;
+    S->decision_level = level;
+}
+
+// --- Conflict Analysis (first UIP) ---
+
+// Fills learnt_buf with the learnt clause, asserting literal first; returns its size
+static int analyze(SatSolver* S, Clause* confl, int* out_btlevel) {
+    int path_count = 0;
+    int size = 1; // learnt_buf[0] is reserved for the asserting literal
+    Lit p = -1;
+    int index = S->trail_size - 1;
+
+    do {
+        for (int i = 0; i < confl->size; ++i) {
+            Lit q = confl->lits[i];
+            int v = LIT_VAR(q);
+            if (p >= 0 && v == LIT_VAR(p)) continue;
+            if (S->seen[v] || S->level[v] == 0) continue;
+            S->seen[v] = true;
+            bump_var(S, v);
+            if (S->level[v] >= S->decision_level) path_count++;
+            else S->learnt_buf[size++] = q;
+        }
+        while (!S->seen[LIT_VAR(S->trail[index])]) index--;
+        p = S->trail[index--];
+        if (path_count > 1) confl = clause_at(S, S->reason[LIT_VAR(p)]);
+        S->seen[LIT_VAR(p)] = false;
+        path_count--;
+    } while (path_count > 0);
+    S->learnt_buf[0] = LIT_NEG(p);
+
+    // Backjump to the second highest level, whose literal becomes the second watch
+    *out_btlevel = 0;
+    int max_i = 1;
+    for (int i = 1; i < size; ++i) {
+        S->seen[LIT_VAR(S->learnt_buf[i])] = false;
+        if (S->level[LIT_VAR(S->learnt_buf[i])] > *out_btlevel) {
+            *out_btlevel = S->level[LIT_VAR(S->learnt_buf[i])];
+            max_i = i;
+        }
+    }
+    if (size > 1) {
+        Lit tmp = S->learnt_buf[1];
+        S->learnt_buf[1] = S->learnt_buf[max_i];
+        S->learnt_buf[max_i] = tmp;
+    }
+    return size;
+}
+
+// Learns from a clause that is false under the current assignment; returns 1 if the problem is UNSAT
+static int handle_conflict(SatSolver* S, Clause* confl) {
+    int max_level = 0;
+    for (int i = 0; i < confl->size; ++i) {
+        int l = S->level[LIT_VAR(confl->lits[i])];
+        if (l > max_level) max_level = l;
+    }
+    if (max_level == 0) return 1;
+    cancel_until(S, max_level); // Theory conflicts may not involve the current level
+
+    int btlevel;
+    int size = analyze(S, confl, &btlevel);
+    cancel_until(S, btlevel);
+    if (size == 1) {
+        enqueue(S, S->learnt_buf[0], CREF_UNDEF);
+    } else {
+        CRef r = alloc_clause(S, S->learnt_buf, size, true);
+        attach_clause(S, r);
+        enqueue(S, S->learnt_buf[0], r);
+    }
+    S->var_inc /= VAR_DECAY;
+    S->conflicts++;
+    return 0;
+}
+
+// --- Theory Solver (interval propagation) ---
+
+// Collects the asserted atoms on the trail; lits receives their literals, returns the count
+static int collect_asserted_atoms(SatSolver* S, Lit* lits, AtomConstraint* cons) {
+    int n = 0;
+    for (int i = 0; i < S->trail_size; ++i) {
+        Lit l = S->trail[i];
+        SmtProp* atom = S->atom[LIT_VAR(l)];
+        if (atom == NULL) continue;
+        lits[n] = l;
+        cons[n] = make_atom_constraint(atom, !LIT_SIGN(l));
+        n++;
+    }
+    return n;
+}
+
+static void assert_lit(SatSolver* S, Lit l) {
+    solver_assert_constraint(S->explain, make_atom_constraint(S->atom[LIT_VAR(l)], !LIT_SIGN(l)));
+}
+
+// Reorders lits[0..n), whose atoms propagate to an empty interval, so that a prefix still does; returns its length.
+// The explanation found so far, lits[0..e), stays asserted while a binary search over nested scopes finds the
+// shortest run of the remaining candidates that completes the conflict. The last atom of that run joins the
+// explanation and the atoms before it are the next candidates, so each atom kept costs a logarithmic number
+// of incremental checks rather than one fixpoint from empty maps per atom tried.
+static int minimize_explanation(SatSolver* S, Lit* lits, int n) {
+    if (S->explain == NULL) {
+        S->explain = solver_context_new();
+        S->explain->stop_parent = S->ctx;
+        S->explain->budget = S->ctx->budget;
+        S->explain->strategy = S->ctx->strategy;
+    }
+    SolverContext* X = S->explain;
+    solver_init(X);
+    int e = 0, m = n; // Candidates are lits[e..m), and lits[0..m) is inconsistent
+    while (e < m) {
+        int lo = e, hi = m - 1, scopes = 0;
+        while (lo < hi) {
+            // lits[e..lo) are asserted and consistent with the explanation, lits[e..hi] are not
+            int mid = lo + (hi - lo) / 2;
+            solver_push(X);
+            scopes++;
+            for (int i = lo; i <= mid; ++i) assert_lit(S, lits[i]);
+            if (solver_check(X)) {
+                solver_pop(X);
+                scopes--;
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        while (scopes-- > 0) solver_pop(X);
+
+        Lit t = lits[e]; lits[e] = lits[lo]; lits[lo] = t;
+        assert_lit(S, lits[e++]);
+        m = lo + 1;
+        if (solver_check(X)) return e;
+    }
+    // Propagation from another order may stop short of the conflict; the whole set still explains it
+    return n;
+}
+
+// Returns a conflict clause explaining an empty interval, or NULL if the asserted atoms are consistent
+static Clause* theory_check(SatSolver* S) {
+    Lit* lits = (Lit*)malloc(sizeof(Lit) * (S->trail_size + 1));
+    AtomConstraint* cons = (AtomConstraint*)malloc(sizeof(AtomConstraint) * (S->trail_size + 1));
+    int n = collect_asserted_atoms(S, lits, cons);
+    if (!check_constraints(S->ctx, cons, n)) { free(lits); free(cons); return NULL; }
+
+    n = minimize_explanation(S, lits, n);
+
+    Clause* c = (Clause*)malloc(sizeof(Clause) + sizeof(Lit) * n);
+    c->size = n;
+    c->learnt = true;
+    for (int i = 0; i < n; ++i) c->lits[i] = LIT_NEG(lits[i]);
+    free(lits);
+    free(cons);
+    return c;
+}
+
+// --- Search ---
+
+// Luby restart sequence 1 1 2 1 1 2 4 1 1 2 ...
+static long luby(int x) {
+    int size = 1, seq = 0;
+    while (size < x + 1) { seq++; size = 2 * size + 1; }
+    while (size - 1 != x) {
+        size = (size - 1) >> 1;
+        seq--;
+        x = x % size;
+    }
+    return 1L << seq;
+}
+
+static Lit pick_branch_lit(SatSolver* S) {
+    while (S->heap_size > 0) {
+        int v = heap_remove_max(S);
+        if (S->assigns[v] == L_UNDEF) return MK_LIT(v, S->polarity[v]);
+    }
+    return -1;
+}
+
+// Clause arena and per-variable arrays, charged to the budget with the context's own state
+static size_t sat_bytes(const SatSolver* S) {
+    size_t per_var = 2 * sizeof(WatchList) + sizeof(signed char) + sizeof(int) * 4 + sizeof(CRef) + sizeof(bool) * 2
+        + sizeof(double) + sizeof(SmtProp*) + sizeof(Lit);
+    size_t watched = 0;
+    for (int l = 0; l < 2 * S->num_vars; ++l) watched += sizeof(CRef) * (size_t)S->watches[l].cap;
+    return sizeof(int) * (size_t)S->arena_cap + per_var * (size_t)S->cap_vars + watched;
+}
+
+// Out of budget: the atoms assigned at level 0 are implied by the formula, so the bounds
+// they propagate to enclose every model. That last check runs without the budget, bounded
+// by the iteration limit alone.
+static int sat_give_up(SatSolver* S) {
+    cancel_until(S, 0);
+    Lit* lits = (Lit*)malloc(sizeof(Lit) * (S->trail_size + 1));
+    AtomConstraint* cons = (AtomConstraint*)malloc(sizeof(AtomConstraint) * (S->trail_size + 1));
+    int n = collect_asserted_atoms(S, lits, cons);
+    SolverBudget* budget = S->ctx->budget;
+    S->ctx->budget = NULL;
+    int res = check_constraints(S->ctx, cons, n);
+    S->ctx->budget = budget;
+    if (res == 0) S->ctx->truncated = true;
+    free(lits);
+    free(cons);
+    return res;
+}
+
+// Clock and memory checks between search steps that call no theory check
+#define BUDGET_STEPS 256
+
+int sat_solve(SatSolver* S) {
+    if (S->unsat) return 1;
+    int restarts = 0;
+    long restart_limit = RESTART_BASE * luby(restarts);
+    long conflicts_since_restart = 0;
+    long steps = 0;
+
+    for (;;) {
+        // Theory checks return early once the solve is abandoned, so their answers can no longer be trusted
+        if (solver_stopped(S->ctx)) return 0;
+        if (S->ctx->budget != NULL && (budget_exhausted(S->ctx) || (++steps % BUDGET_STEPS == 0 && budget_charge(S->ctx, 0, sat_bytes(S))))) {
+            return sat_give_up(S);
+        }
+        CRef confl = propagate(S);
+        if (confl != CREF_UNDEF) {
+            if (handle_conflict(S, clause_at(S, confl))) return 1;
+            conflicts_since_restart++;
+            continue;
+        }
+        if (S->theory_dirty) {
+            Clause* explanation = theory_check(S);
+            if (explanation != NULL) {
+                int res = handle_conflict(S, explanation);
+                free(explanation);
+                if (res) return 1;
+                conflicts_since_restart++;
+                continue;
+            }
+            S->theory_dirty = false;
+        }
+
+        if (conflicts_since_restart >= restart_limit) {
+            cancel_until(S, 0);
+            restart_limit = RESTART_BASE * luby(++restarts);
+            conflicts_since_restart = 0;
+            continue;
+        }
+
+        Lit next = pick_branch_lit(S);
+        if (next < 0) break; // Every variable assigned and the theory agrees
+        S->trail_lim[S->decision_level++] = S->trail_size;
+        enqueue(S, next, CREF_UNDEF);
+    }
+
+    // Leave the interval maps describing the model that was found
+    Lit* lits = (Lit*)malloc(sizeof(Lit) * (S->trail_size + 1));
+    AtomConstraint* cons = (AtomConstraint*)malloc(sizeof(AtomConstraint) * (S->trail_size + 1));
+    int n = collect_asserted_atoms(S, lits, cons);
+    int res = check_constraints(S->ctx, cons, n);
+    free(lits);
+    free(cons);
+    // A model check cut short describes that model only
+    if (res == 0 && budget_exhausted(S->ctx)) return sat_give_up(S);
+    return res;
+}
+
+// --- CDCL(T) Entry Point ---
+
+int cdcl_solve(SolverContext* ctx, SmtProplist* list) {
+    CnfFormula* cnf = tseitin_encode(list);
+    SatSolver* S = sat_new(ctx);
+    for (int v = 0; v < cnf->num_vars; ++v) {
+        sat_new_var(S);
+        // Only interval atoms reach the theory; other Propvars (quantifiers, ...) stay free Booleans
+        if (cnf->atoms[v] != NULL && is_interval_atom(cnf->atoms[v])) sat_set_atom(S, v, cnf->atoms[v]);
+    }
+    for (int i = 0; i < cnf->num_clauses; ++i) {
+        if (!sat_add_clause(S, CNF_CLAUSE(cnf, i), CNF_CLAUSE_SIZE(cnf, i))) break;
+    }
+    int res = sat_solve(S);
+    sat_free(S);
+    freeCnfFormula(cnf);
+    return res;
+}
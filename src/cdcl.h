@@ -0,0 +1,41 @@
+#ifndef CDCL_H
+#define CDCL_H 1
+#include "interval_solver.h"
+
+// --- Literals ---
+// A literal is 2 * var + sign, sign 1 meaning the negated variable.
+typedef int Lit;
+#define MK_LIT(v, neg) (((v) << 1) | (neg))
+#define LIT_VAR(l) ((l) >> 1)
+#define LIT_SIGN(l) ((l) & 1)
+#define LIT_NEG(l) ((l) ^ 1)
+
+typedef enum { L_FALSE = 0, L_TRUE = 1, L_UNDEF = 2 } lbool;
+
+typedef struct {
+    int size;
+    bool learnt;
+    Lit lits[]; // lits[0] and lits[1] are the watched literals
+} Clause;
+
+// Clauses live contiguously in the solver's arena and are referred to by offset
+typedef int CRef;
+
+typedef struct SatSolver SatSolver;
+
+// --- SAT Core (watched literals, VSIDS, restarts, 1UIP learning) ---
+// The solver runs its theory checks on ctx's maps
+SatSolver* sat_new(SolverContext* ctx);
+void sat_free(SatSolver* S);
+int sat_new_var(SatSolver* S);
+// Attaches an interval atom to a variable; its truth value is then checked by the theory solver
+void sat_set_atom(SatSolver* S, int var, SmtProp* atom);
+// Adds a clause at decision level 0, returns false once the clause set is trivially UNSAT
+bool sat_add_clause(SatSolver* S, const Lit* lits, int n);
+lbool sat_value(SatSolver* S, Lit l);
+// Returns 1 if UNSAT modulo interval propagation, 0 if a consistent assignment was found
+int sat_solve(SatSolver* S);
+
+// CDCL(T) entry point for proplists with Boolean structure, same result convention as interval_solver
+int cdcl_solve(SolverContext* ctx, SmtProplist* list);
+#endif
@@ -0,0 +1,388 @@
+#include "codegen.h"
+#include "trace.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// --- Source ---
+// The prelude repeats the engine's interval steps as the tape runner applies them to a
+// live lane: a live instance never holds an empty interval, and the step that would
+// write one ends the run instead.
+
+static const char* prelude =
+    "#include <limits.h>\n"
+    "\n"
+    "typedef struct { long long lower, upper; } Interval;\n"
+    "typedef struct { Interval (*forward)(int op, Interval i1, Interval i2); } CodegenHost;\n"
+    "\n"
+    "static const Interval INF = { LLONG_MIN, LLONG_MAX };\n"
+    "static const Interval EMPTY = { 1, 0 };\n"
+    "\n"
+    "static inline long long sat_add(long long a, long long b) {\n"
+    "    long long r;\n"
+    "    if (__builtin_add_overflow(a, b, &r)) return a > 0 ? LLONG_MAX : LLONG_MIN;\n"
+    "    return r;\n"
+    "}\n"
+    "static inline long long sat_sub(long long a, long long b) {\n"
+    "    long long r;\n"
+    "    if (__builtin_sub_overflow(a, b, &r)) return a >= 0 ? LLONG_MAX : LLONG_MIN;\n"
+    "    return r;\n"
+    "}\n"
+    "static inline Interval isect(Interval a, Interval b) {\n"
+    "    Interval r = { a.lower > b.lower ? a.lower : b.lower, a.upper < b.upper ? a.upper : b.upper };\n"
+    "    return r.lower > r.upper ? EMPTY : r;\n"
+    "}\n"
+    "static inline Interval add(Interval a, Interval b) {\n"
+    "    Interval r;\n"
+    "    r.lower = (a.lower == LLONG_MIN || b.lower == LLONG_MIN) ? LLONG_MIN : sat_add(a.lower, b.lower);\n"
+    "    r.upper = (a.upper == LLONG_MAX || b.upper == LLONG_MAX) ? LLONG_MAX : sat_add(a.upper, b.upper);\n"
+    "    return r;\n"
+    "}\n"
+    "static inline Interval sub(Interval a, Interval b) {\n"
+    "    Interval r;\n"
+    "    r.lower = (a.lower == LLONG_MIN || b.upper == LLONG_MAX) ? LLONG_MIN : sat_sub(a.lower, b.upper);\n"
+    "    r.upper = (a.upper == LLONG_MAX || b.lower == LLONG_MIN) ? LLONG_MAX : sat_sub(a.upper, b.lower);\n"
+    "    return r;\n"
+    "}\n"
+    "static inline long long neg_bound(long long b) {\n"
+    "    return b == LLONG_MIN ? LLONG_MAX : b == LLONG_MAX ? LLONG_MIN : -b;\n"
+    "}\n"
+    "static inline Interval neg(Interval i) {\n"
+    "    Interval r = { neg_bound(i.upper), neg_bound(i.lower) };\n"
+    "    return r;\n"
+    "}\n"
+    "/* An evaluation: the saved bounds intersected with x, always written */\n"
+    "static inline int ev(Interval* slot, Interval saved, Interval x, int* ch) {\n"
+    "    if (x.lower < saved.lower) x.lower = saved.lower;\n"
+    "    if (x.upper > saved.upper) x.upper = saved.upper;\n"
+    "    if (x.lower > x.upper) { *slot = EMPTY; return 1; }\n"
+    "    *ch |= x.lower != saved.lower || x.upper != saved.upper;\n"
+    "    *slot = x;\n"
+    "    return 0;\n"
+    "}\n"
+    "/* A refinement: written only when it differs from the bounds it started from */\n"
+    "static inline int rf(Interval* slot, Interval cur, Interval n, int* ch) {\n"
+    "    if (n.lower > n.upper) { *slot = EMPTY; return 1; }\n"
+    "    if (n.lower == cur.lower && n.upper == cur.upper) return 0;\n"
+    "    *slot = n;\n"
+    "    *ch = 1;\n"
+    "    return 0;\n"
+    "}\n"
+    "static inline int merge(Interval* root, Interval other, int* ch) {\n"
+    "    Interval m = isect(other, *root);\n"
+    "    *ch = 1;\n"
+    "    if (m.lower > m.upper) { *root = EMPTY; return 1; }\n"
+    "    *root = m;\n"
+    "    return 0;\n"
+    "}\n"
+    "static inline int rel_eq(Interval* x, Interval* y, int* ch) {\n"
+    "    Interval i1 = *x, i2 = *y, c = isect(i1, i2);\n"
+    "    return rf(x, i1, isect(i1, c), ch) || rf(y, i2, isect(i2, c), ch);\n"
+    "}\n"
+    "static inline int rel_le(Interval* x, Interval* y, int* ch) {\n"
+    "    Interval i1 = *x, i2 = *y, n1 = i1, n2 = i2;\n"
+    "    if (i2.upper != LLONG_MAX && i2.upper < n1.upper) n1.upper = i2.upper;\n"
+    "    if (i1.lower != LLONG_MIN && i1.lower > n2.lower) n2.lower = i1.lower;\n"
+    "    return rf(x, i1, isect(i1, n1), ch) || rf(y, i2, isect(i2, n2), ch);\n"
+    "}\n"
+    "static inline int rel_lt(Interval* x, Interval* y, int* ch) {\n"
+    "    Interval i1 = *x, i2 = *y, n1 = i1, n2 = i2;\n"
+    "    if (i2.upper != LLONG_MAX && sat_sub(i2.upper, 1) < n1.upper) n1.upper = sat_sub(i2.upper, 1);\n"
+    "    if (i1.lower != LLONG_MIN && sat_add(i1.lower, 1) > n2.lower) n2.lower = sat_add(i1.lower, 1);\n"
+    "    return rf(x, i1, isect(i1, n1), ch) || rf(y, i2, isect(i2, n2), ch);\n"
+    "}\n"
+    "static inline int rel_ge(Interval* x, Interval* y, int* ch) {\n"
+    "    Interval i1 = *x, i2 = *y, n1 = i1, n2 = i2;\n"
+    "    if (i1.upper != LLONG_MAX && i1.upper < n2.upper) n2.upper = i1.upper;\n"
+    "    if (i2.lower != LLONG_MIN && i2.lower > n1.lower) n1.lower = i2.lower;\n"
+    "    return rf(x, i1, isect(i1, n1), ch) || rf(y, i2, isect(i2, n2), ch);\n"
+    "}\n"
+    "static inline int rel_gt(Interval* x, Interval* y, int* ch) {\n"
+    "    Interval i1 = *x, i2 = *y, n1 = i1, n2 = i2;\n"
+    "    if (i1.upper != LLONG_MAX && sat_sub(i1.upper, 1) < n2.upper) n2.upper = sat_sub(i1.upper, 1);\n"
+    "    if (i2.lower != LLONG_MIN && sat_add(i2.lower, 1) > n1.lower) n1.lower = sat_add(i2.lower, 1);\n"
+    "    return rf(x, i1, isect(i1, n1), ch) || rf(y, i2, isect(i2, n2), ch);\n"
+    "}\n"
+    "static inline Interval exclude(Interval i, Interval fixed) {\n"
+    "    if (fixed.lower != fixed.upper) return i;\n"
+    "    if (i.lower == fixed.lower) {\n"
+    "        if (i.lower == LLONG_MAX) return EMPTY;\n"
+    "        i.lower++;\n"
+    "    } else if (i.upper == fixed.lower) {\n"
+    "        if (i.upper == LLONG_MIN) return EMPTY;\n"
+    "        i.upper--;\n"
+    "    }\n"
+    "    return i.lower > i.upper ? EMPTY : i;\n"
+    "}\n"
+    "static inline int rel_ne(Interval* x, Interval* y, int* ch) {\n"
+    "    Interval i1 = *x, i2 = *y;\n"
+    "    return rf(x, i1, isect(i1, exclude(i1, i2)), ch) || rf(y, i2, isect(i2, exclude(i2, i1)), ch);\n"
+    "}\n"
+    "\n";
+
+static void emit_ll(FILE* out, long long v) {
+    if (v == LLONG_MIN) fputs("LLONG_MIN", out); // Its magnitude is no literal
+    else fprintf(out, "%lldLL", v);
+}
+
+// The bounds an evaluation saved: scratch[d], or the slot itself for a leaf
+static void emit_saved(FILE* out, const TapeOp* op) {
+    if (op->d < 0) fprintf(out, "t[%d]", op->a);
+    else fprintf(out, "s[%d]", op->d);
+}
+
+static void emit_op(FILE* out, const TapeOp* op) {
+    switch (op->kind) {
+        case TAPE_SAVE:
+            fprintf(out, "    s[%d] = t[%d];\n", op->d, op->a);
+            return;
+        case TAPE_EVAL_CONST:
+        case TAPE_EVAL_PARAM:
+        case TAPE_EVAL_VAR:
+        case TAPE_EVAL_NEG:
+        case TAPE_EVAL_BOP:
+        case TAPE_EVAL_INF:
+            fprintf(out, "    if (ev(&t[%d], ", op->a);
+            emit_saved(out, op);
+            fputs(", ", out);
+            if (op->kind == TAPE_EVAL_CONST) {
+                fputs("(Interval){ ", out);
+                emit_ll(out, op->imm);
+                fputs(", ", out);
+                emit_ll(out, op->imm);
+                fputs(" }", out);
+            }
+            else if (op->kind == TAPE_EVAL_PARAM) fprintf(out, "(Interval){ p[%d], p[%d] }", op->b, op->b);
+            else if (op->kind == TAPE_EVAL_VAR) fprintf(out, "v[%d]", op->b);
+            else if (op->kind == TAPE_EVAL_NEG) fprintf(out, "neg(t[%d])", op->b);
+            else if (op->kind == TAPE_EVAL_INF) fputs("INF", out);
+            else if (op->op == LIA_ADD) fprintf(out, "add(t[%d], t[%d])", op->b, op->c);
+            else if (op->op == LIA_MINUS) fprintf(out, "sub(t[%d], t[%d])", op->b, op->c);
+            else fprintf(out, "host->forward(%d, t[%d], t[%d])", op->op, op->b, op->c);
+            fputs(", ch)) return 1;\n", out);
+            return;
+        case TAPE_REFINE_BOP:
+            // calculate_backward_op_intervals has rules for + and - only
+            if (op->op == LIA_ADD || op->op == LIA_MINUS) {
+                bool plus = op->op == LIA_ADD;
+                fprintf(out, "    { Interval r1 = %s(t[%d], t[%d]); s[%d] = t[%d]; ", plus ? "sub" : "add", op->a, op->c, op->d, op->c);
+                if (plus) fprintf(out, "r[%d] = sub(t[%d], t[%d]);", op->d, op->a, op->b);
+                else fprintf(out, "r[%d] = sub(t[%d], t[%d]);", op->d, op->b, op->a);
+                fprintf(out, " if (rf(&t[%d], t[%d], isect(t[%d], r1), ch)) return 1; }\n", op->b, op->b, op->b);
+            } else {
+                fprintf(out, "    s[%d] = t[%d]; r[%d] = INF;\n", op->d, op->c, op->d);
+            }
+            return;
+        case TAPE_REFINE_T2:
+            fprintf(out, "    if (rf(&t[%d], s[%d], isect(s[%d], r[%d]), ch)) return 1;\n", op->c, op->d, op->d, op->d);
+            return;
+        case TAPE_REFINE_NEG:
+            if (op->imm == LIA_NEG) fprintf(out, "    if (rf(&t[%d], t[%d], isect(t[%d], neg(t[%d])), ch)) return 1;\n", op->b, op->b, op->b, op->a);
+            return;
+        case TAPE_REFINE_VAR:
+            fprintf(out, "    if (rf(&v[%d], v[%d], isect(v[%d], t[%d]), ch)) return 1;\n", op->b, op->b, op->b, op->a);
+            return;
+        case TAPE_MERGE:
+            fprintf(out, "    if (merge(&t[%d], t[%d], ch)) return 1;\n", op->b, op->a);
+            return;
+        case TAPE_RELATE: {
+            const char* fn = NULL;
+            if (op->imm) fn = "rel_ne";
+            else if (op->op == SMT_EQ) fn = "rel_eq";
+            else if (op->op == SMT_LE) fn = "rel_le";
+            else if (op->op == SMT_LT) fn = "rel_lt";
+            else if (op->op == SMT_GE) fn = "rel_ge";
+            else if (op->op == SMT_GT) fn = "rel_gt";
+            if (fn != NULL) fprintf(out, "    if (%s(&t[%d], &t[%d], ch)) return 1;\n", fn, op->a, op->b);
+            return;
+        }
+        case TAPE_FAIL:
+            fputs("    return 1;\n", out);
+            return;
+    }
+}
+
+// Rounds are split into functions of this many operations, which compilers optimize in
+// a fraction of the time one function of the whole round takes
+#define CODEGEN_BLOCK 16
+
+// Emits ops[from..to) as blocks numbered from *blocks on
+static void emit_blocks(FILE* out, const Tape* t, int from, int to, int* blocks) {
+    for (int i = from; i < to; i += CODEGEN_BLOCK) {
+        fprintf(out, "static int b%d(Interval* t, Interval* v, Interval* s, Interval* r, const long long* p, const CodegenHost* host, int* ch) {\n", (*blocks)++);
+        fputs("    (void)v; (void)s; (void)r; (void)p; (void)host; (void)ch;\n", out);
+        for (int k = i; k < to && k < i + CODEGEN_BLOCK; ++k) emit_op(out, &t->ops[k]);
+        fputs("    return 0;\n}\n\n", out);
+    }
+}
+
+static void emit_calls(FILE* out, int from, int to) {
+    for (int i = from; i < to; ++i) fprintf(out, "            if (b%d(t, v, s, r, p, host, &ch)) goto dead;\n", i);
+}
+
+void codegen_emit(const Tape* t, FILE* out) {
+    fprintf(out, "/* Generated propagator, codegen version %d: %d operations, %d term slots, %d variables */\n",
+            CODEGEN_VERSION, t->count, t->term_slots, t->var_slots);
+    fputs(prelude, out);
+    fputs("static const int roots[] = {", out);
+    for (int i = 0; i < t->root_count; ++i) fprintf(out, "%s%d,", i % 16 == 0 ? "\n    " : " ", t->roots[i]);
+    fputs("\n    -1\n};\n\n", out);
+    int blocks = 0;
+    emit_blocks(out, t, 0, t->first_count, &blocks);
+    int first_blocks = blocks;
+    emit_blocks(out, t, t->first_count, t->count, &blocks);
+
+    fputs("int smt_propagate(Interval* t, Interval* v, const long long* p, const CodegenHost* host, long* rounds, int* truncated) {\n", out);
+    fprintf(out, "    Interval s[%d], r[%d];\n", t->depth > 0 ? t->depth : 1, t->depth > 0 ? t->depth : 1);
+    fputs("    long n = 0;\n"
+          "    int ch;\n"
+          "    *truncated = 0;\n"
+          "    for (;;) {\n"
+          "        ++n;\n"
+          "        ch = 0;\n"
+          "        if (n == 1) {\n", out);
+    emit_calls(out, 0, first_blocks);
+    fputs("        } else {\n", out);
+    emit_calls(out, first_blocks, blocks);
+    fputs("        }\n", out);
+    fprintf(out, "        if (n >= %d) { *truncated = 1; break; }\n", t->iteration_limit);
+    fputs("        if (!ch) break;\n"
+          "    }\n"
+          "    *rounds = n;\n", out);
+    fprintf(out, "    for (int i = 0; i < %d; ++i) if (v[i].lower > v[i].upper) return 1;\n", t->var_slots);
+    fputs("    for (int i = 0; roots[i] >= 0; ++i) if (t[roots[i]].lower > t[roots[i]].upper) return 1;\n"
+          "    return 0;\n"
+          "dead:\n"
+          "    *rounds = n;\n"
+          "    return 1;\n"
+          "}\n", out);
+}
+
+// --- Cache ---
+
+static void hash_bytes(unsigned long long h[2], const char* s, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)s[i];
+        h[0] = (h[0] ^ c) * 0x100000001b3ULL;
+        h[1] = (h[1] ^ c) * 0xc4ceb9fe1a85ec53ULL;
+    }
+    h[1] ^= h[1] >> 32;
+}
+
+static Interval host_forward(int op, Interval i1, Interval i2) {
+    return calculate_forward_op_interval((SmtTermBop)op, i1, i2);
+}
+
+static const CodegenHost host = { host_forward };
+
+// Writes the source to <base>.<pid>.c, compiles it next to it and renames the object to
+// so_path, so that a concurrent build of the same tape never exposes half an object
+static bool build_object(const char* cc, const char* flags, const char* base, const char* so_path, const char* src, size_t len) {
+    char* c_path = (char*)malloc(strlen(base) + 64);
+    char* tmp_so = (char*)malloc(strlen(base) + 64);
+    sprintf(c_path, "%s.%ld.c", base, (long)getpid());
+    sprintf(tmp_so, "%s.%ld.so", base, (long)getpid());
+    bool ok = false;
+    FILE* f = fopen(c_path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Warning: cannot write %s: %s.\n", c_path, strerror(errno));
+    } else {
+        bool written = fwrite(src, 1, len, f) == len;
+        written = fclose(f) == 0 && written;
+        char* cmd = (char*)malloc(strlen(cc) + strlen(flags) + strlen(c_path) + strlen(tmp_so) + 32);
+        sprintf(cmd, "%s %s -o '%s' '%s'", cc, flags, tmp_so, c_path);
+        TRACE(TRACE_INFO, "Compiling propagator: %s\n", cmd);
+        if (!written) fprintf(stderr, "Warning: cannot write %s.\n", c_path);
+        else if (system(cmd) != 0) fprintf(stderr, "Warning: compiling %s failed.\n", c_path);
+        else if (rename(tmp_so, so_path) != 0) fprintf(stderr, "Warning: cannot create %s: %s.\n", so_path, strerror(errno));
+        else ok = true;
+        free(cmd);
+        unlink(tmp_so);
+        unlink(c_path);
+    }
+    free(c_path);
+    free(tmp_so);
+    return ok;
+}
+
+CompiledTape* codegen_load(const Tape* t, const char* cache_dir) {
+    if (strchr(cache_dir, '\'') != NULL) {
+        fprintf(stderr, "Warning: the propagator cache path %s contains a quote.\n", cache_dir);
+        return NULL;
+    }
+    if (mkdir(cache_dir, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: cannot create %s: %s.\n", cache_dir, strerror(errno));
+        return NULL;
+    }
+    char* src = NULL;
+    size_t len = 0;
+    FILE* mem = open_memstream(&src, &len);
+    codegen_emit(t, mem);
+    fclose(mem);
+
+    const char* cc = getenv("CC");
+    if (cc == NULL || *cc == '\0') cc = "cc";
+    const char* flags = "-O2 -shared -fPIC -w";
+    unsigned long long h[2] = { 0xcbf29ce484222325ULL, 0x9e3779b97f4a7c15ULL };
+    hash_bytes(h, src, len);
+    hash_bytes(h, cc, strlen(cc));
+    hash_bytes(h, flags, strlen(flags));
+    char* base = (char*)malloc(strlen(cache_dir) + 40);
+    char* so_path = (char*)malloc(strlen(cache_dir) + 48);
+    sprintf(base, "%s/%016llx%016llx", cache_dir, h[0], h[1]);
+    sprintf(so_path, "%s.so", base);
+
+    CompiledTape* ct = NULL;
+    bool ready = access(so_path, R_OK) == 0;
+    if (ready) TRACE(TRACE_INFO, "Reusing cached propagator %s\n", so_path);
+    else ready = build_object(cc, flags, base, so_path, src, len);
+    void* handle = ready ? dlopen(so_path, RTLD_NOW | RTLD_LOCAL) : NULL;
+    if (ready && handle == NULL) fprintf(stderr, "Warning: cannot load %s: %s.\n", so_path, dlerror());
+    CodegenFn run = handle != NULL ? (CodegenFn)dlsym(handle, "smt_propagate") : NULL;
+    if (handle != NULL && run == NULL) {
+        fprintf(stderr, "Warning: %s has no propagator.\n", so_path);
+        dlclose(handle);
+    }
+    if (run != NULL) {
+        ct = (CompiledTape*)calloc(1, sizeof(CompiledTape));
+        ct->handle = handle;
+        ct->run = run;
+        ct->terms = (Interval*)malloc(sizeof(Interval) * (t->term_slots > 0 ? t->term_slots : 1));
+        ct->vars = (Interval*)malloc(sizeof(Interval) * (t->var_slots > 0 ? t->var_slots : 1));
+        ct->values = (long long*)malloc(sizeof(long long) * (t->param_count > 0 ? t->param_count : 1));
+    }
+    free(src);
+    free(base);
+    free(so_path);
+    return ct;
+}
+
+void codegen_free(CompiledTape* ct) {
+    if (ct == NULL) return;
+    dlclose(ct->handle);
+    free(ct->terms);
+    free(ct->vars);
+    free(ct->values);
+    free(ct);
+}
+
+// --- Running ---
+
+int codegen_run(CompiledTape* ct, const Tape* t, const int* values, long* rounds, bool* truncated) {
+    memcpy(ct->terms, t->term_base, sizeof(Interval) * t->term_slots);
+    memcpy(ct->vars, t->var_base, sizeof(Interval) * t->var_slots);
+    for (int p = 0; p < t->param_count; ++p) ct->values[p] = values[p];
+    for (int i = 0; i < t->param_leaves; ++i) {
+        long long v = ct->values[t->params[i].param];
+        ct->terms[t->params[i].slot] = (Interval){ v, v };
+    }
+    int cut = 0;
+    int res = ct->run(ct->terms, ct->vars, ct->values, &host, rounds, &cut);
+    if (cut) fprintf(stderr, "Warning: Max iterations reached, potential non-convergence or slow convergence.\n");
+    *truncated = cut != 0;
+    return res;
+}
@@ -0,0 +1,44 @@
+#ifndef CODEGEN_H
+#define CODEGEN_H 1
+#include "tape.h"
+#include <stdio.h>
+
+// --- Generated Propagators ---
+// A propagation tape (tape.h) written out as C: one function running the whole fixpoint
+// loop for one instance, each operation of the first and the steady round an inline
+// statement with its slots, constants, operator and relation fixed, and the iteration
+// limit and the closing emptiness check spelled out. The system C compiler ($CC, cc by
+// default) turns it into a shared object that is loaded with dlopen. Objects are cached
+// in a directory as <hash>.so, the hash taken over the generated source and the compiler
+// command, so a skeleton with the same tape reuses the object in later runs and other
+// processes. The generated function narrows exactly as the tape and the engine do; forward
+// operators other than + and - call back into calculate_forward_op_interval.
+
+// Changes whenever the generated code does, invalidating cached objects
+#define CODEGEN_VERSION 2
+
+// The entry point of a generated object
+typedef struct {
+    Interval (*forward)(int op, Interval i1, Interval i2);
+} CodegenHost;
+
+typedef int (*CodegenFn)(Interval* terms, Interval* vars, const long long* values, const CodegenHost* host, long* rounds, int* truncated);
+
+typedef struct {
+    void* handle;
+    CodegenFn run;
+    Interval* terms;     // Bounds left by the last run
+    Interval* vars;
+    long long* values;
+} CompiledTape;
+
+// Writes the propagator source of tape to out
+void codegen_emit(const Tape* tape, FILE* out);
+// Loads tape's propagator from cache_dir, generating and compiling it first if it is not
+// there yet. NULL, with the reason on stderr, if it cannot be built or loaded.
+CompiledTape* codegen_load(const Tape* tape, const char* cache_dir);
+void codegen_free(CompiledTape* ct);
+// Solves one instance with values[i] for parameter i, leaving its bounds in ct->terms and
+// ct->vars. Same result convention as interval_solver.
+int codegen_run(CompiledTape* ct, const Tape* tape, const int* values, long* rounds, bool* truncated);
+#endif
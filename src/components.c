@@ -0,0 +1,219 @@
+#include "components.h"
+#include "interval_solver.h"
+#include "budget.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// --- Partition (union-find over variables, then UF symbols) ---
+// Node i < var_count is ctx->var_map[i], node var_count + j is symbols[j].
+typedef struct {
+    int* parent;
+    int var_count;
+    const char** symbols;
+    int symbol_count;
+    int symbol_cap;
+} Partition;
+
+static int find_node(Partition* p, int x) {
+    while (p->parent[x] != x) {
+        p->parent[x] = p->parent[p->parent[x]]; // Path halving
+        x = p->parent[x];
+    }
+    return x;
+}
+
+static void unite_nodes(Partition* p, int a, int b) {
+    a = find_node(p, a);
+    b = find_node(p, b);
+    if (a != b) p->parent[a] = b;
+}
+
+// Every variable of a populated atom is in the map already, so this only looks it up
+static int var_node(SolverContext* ctx, const char* name) {
+    return (int)(get_or_add_var_entry(ctx, name) - ctx->var_map);
+}
+
+static int symbol_node(Partition* p, const char* name) {
+    for (int j = 0; j < p->symbol_count; ++j) {
+        if (strcmp(p->symbols[j], name) == 0) return p->var_count + j;
+    }
+    if (p->symbol_count == p->symbol_cap) {
+        p->symbol_cap = p->symbol_cap ? p->symbol_cap * 2 : 16;
+        p->symbols = (const char**)realloc(p->symbols, sizeof(char*) * p->symbol_cap);
+        p->parent = (int*)realloc(p->parent, sizeof(int) * (p->var_count + p->symbol_cap));
+    }
+    int node = p->var_count + p->symbol_count;
+    p->symbols[p->symbol_count++] = name;
+    p->parent[node] = node;
+    return node;
+}
+
+static void link_node(Partition* p, int node, int* anchor) {
+    if (node < 0) return;
+    if (*anchor < 0) *anchor = node;
+    else unite_nodes(p, *anchor, node);
+}
+
+// Unites every variable and UF symbol under term with *anchor (-1 until the first one is met),
+// walking the term on an explicit stack since it may be nested deeper than the C stack allows
+static void link_term(SolverContext* ctx, Partition* p, SmtTerm* term, int* anchor) {
+    if (term == NULL) return;
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, term, NULL);
+    while (walk.size > 0) {
+        term = (SmtTerm*)smt_walk_pop(&walk).node;
+        if (term == NULL) continue;
+        if (term->type == SMT_VarName) {
+            link_node(p, var_node(ctx, term->term.Variable), anchor);
+        } else if (term->type == SMT_UFTerm && term->term.UFTerm) {
+            // Applications of one symbol become congruent once their arguments are equal,
+            // which may happen across components (e.g. two variables fixed to one value)
+            link_node(p, symbol_node(p, term->term.UFTerm->name), anchor);
+        }
+        for (int i = SmtTerm_arity(term) - 1; i >= 0; --i) {
+            smt_walk_push(&walk, 0, SmtTerm_child(term, i), NULL);
+        }
+    }
+    smt_walk_free(&walk);
+}
+
+int split_components(SolverContext* ctx, const AtomConstraint* cons, int count, int* comp) {
+    Partition p = { NULL, ctx->var_map_count, NULL, 0, 0 };
+    p.parent = (int*)malloc(sizeof(int) * (p.var_count > 0 ? p.var_count : 1));
+    for (int i = 0; i < p.var_count; ++i) p.parent[i] = i;
+
+    int* anchor = (int*)malloc(sizeof(int) * (count > 0 ? count : 1));
+    for (int c = 0; c < count; ++c) {
+        anchor[c] = -1;
+        link_term(ctx, &p, cons[c].term1, &anchor[c]);
+        link_term(ctx, &p, cons[c].term2, &anchor[c]);
+    }
+
+    // Number the components in order of first appearance; ground atoms share one
+    int nodes = p.var_count + p.symbol_count;
+    int* root_comp = (int*)malloc(sizeof(int) * (nodes > 0 ? nodes : 1));
+    for (int i = 0; i < nodes; ++i) root_comp[i] = -1;
+    int num_comps = 0;
+    int ground_comp = -1;
+    for (int c = 0; c < count; ++c) {
+        if (anchor[c] < 0) {
+            if (ground_comp < 0) ground_comp = num_comps++;
+            comp[c] = ground_comp;
+            continue;
+        }
+        int root = find_node(&p, anchor[c]);
+        if (root_comp[root] < 0) root_comp[root] = num_comps++;
+        comp[c] = root_comp[root];
+    }
+
+    free(root_comp);
+    free(anchor);
+    free(p.parent);
+    free(p.symbols);
+    return num_comps;
+}
+
+// --- Concurrent Component Solving ---
+
+typedef struct {
+    const AtomConstraint* cons; // Grouped by component
+    const int* start;           // Component k is cons[start[k] .. start[k + 1])
+    int num_comps;
+    SolverContext* parent;
+    SolverContext** subs;
+
+    atomic_int next;            // Next component to hand out
+    atomic_bool inconsistent;   // Also the stop flag of every component context, besides the parent's
+} ComponentJob;
+
+static void* component_worker(void* arg) {
+    ComponentJob* job = (ComponentJob*)arg;
+    int k;
+    while (!atomic_load(&job->inconsistent) && (k = atomic_fetch_add(&job->next, 1)) < job->num_comps) {
+        if (solver_stopped(job->parent)) break;
+        if (budget_exhausted(job->parent)) break;
+        SolverContext* sub = solver_context_new();
+        sub->stop = &job->inconsistent;
+        sub->stop_parent = job->parent; // A cancelled parent stops the component's rounds as well
+        sub->budget = job->parent->budget;
+        sub->strategy = job->parent->strategy;
+        if (job->parent->stats) solver_stats_enable(sub);
+        sub->narrow_log = job->parent->narrow_log;
+        job->subs[k] = sub;
+        if (check_constraints(sub, job->cons + job->start[k], job->start[k + 1] - job->start[k])) {
+            atomic_store(&job->inconsistent, true);
+        }
+    }
+    return NULL;
+}
+
+int solve_components(SolverContext* ctx, const AtomConstraint* cons, int count, const int* comp, int num_comps) {
+    // Counting sort of the constraints by component
+    int* start = (int*)calloc(num_comps + 1, sizeof(int));
+    for (int c = 0; c < count; ++c) start[comp[c] + 1]++;
+    for (int k = 0; k < num_comps; ++k) start[k + 1] += start[k];
+    int* fill = (int*)malloc(sizeof(int) * num_comps);
+    memcpy(fill, start, sizeof(int) * num_comps);
+    AtomConstraint* grouped = (AtomConstraint*)malloc(sizeof(AtomConstraint) * (count > 0 ? count : 1));
+    for (int c = 0; c < count; ++c) grouped[fill[comp[c]]++] = cons[c];
+    free(fill);
+
+    ComponentJob job;
+    job.cons = grouped;
+    job.start = start;
+    job.num_comps = num_comps;
+    job.parent = ctx;
+    job.subs = (SolverContext**)calloc(num_comps, sizeof(SolverContext*));
+    atomic_init(&job.next, 0);
+    atomic_init(&job.inconsistent, false);
+
+    int threads = ctx->threads;
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (ctx->narrow_log != NULL) threads = 1; // One writer, so events stay in order
+    if (threads > num_comps) threads = num_comps;
+    pthread_t* workers = NULL;
+    int started = 0;
+    if (threads > 1) {
+        workers = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+        for (; started < threads; ++started) {
+            if (pthread_create(&workers[started], NULL, component_worker, &job) != 0) break;
+        }
+    }
+    if (started == 0) component_worker(&job);
+    for (int t = 0; t < started; ++t) pthread_join(workers[t], NULL);
+    free(workers);
+
+    int res = atomic_load(&job.inconsistent) ? 1 : 0;
+
+    // Report the final variable intervals on the caller's context; copying them is no narrowing to log
+    NarrowLog* log = ctx->narrow_log;
+    ctx->narrow_log = NULL;
+    for (int k = 0; k < num_comps; ++k) {
+        SolverContext* sub = job.subs[k];
+        if (sub == NULL) {
+            // Never started: only a budget that ran out skips a component of a consistent problem
+            if (res == 0) ctx->truncated = true;
+            continue;
+        }
+        if (sub->truncated) ctx->truncated = true;
+        ctx->rounds += sub->rounds;
+        if (ctx->stats) solver_stats_merge(ctx->stats, sub->stats);
+        for (int i = 0; i < sub->var_map_count; ++i) {
+            if (!sub->var_map[i].active) continue;
+            set_var_interval(ctx, get_or_add_var_entry(ctx, sub->var_map[i].name), sub->var_map[i].interval);
+        }
+        solver_context_free(sub);
+    }
+    ctx->narrow_log = log;
+    free(job.subs);
+    free(grouped);
+    free(start);
+    return res;
+}
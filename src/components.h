@@ -0,0 +1,16 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H 1
+#include "interval_solver.h"
+
+// --- Component Decomposition ---
+// Atoms that share no variable and no UF symbol cannot narrow each other's intervals,
+// so each group of connected atoms is solved in a context of its own. Components run
+// concurrently on up to ctx->threads workers; the first inconsistent one stops the rest.
+
+// Assigns comp[c] for every constraint from the variables populated in ctx's maps;
+// returns the number of components
+int split_components(SolverContext* ctx, const AtomConstraint* cons, int count, int* comp);
+// Same result convention as interval_solver. Final intervals stay in the per-component
+// contexts, only variable intervals are copied back to ctx.
+int solve_components(SolverContext* ctx, const AtomConstraint* cons, int count, const int* comp, int num_comps);
+#endif
@@ -0,0 +1,366 @@
+#include "congruence.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    unsigned long long hash;
+    int node; // -1 when free
+} SigEntry;
+
+struct CcState {
+    int cap; // Entries of the per-term arrays, follows the term map capacity
+    int* size;
+
+    // Class member lists, linked from the representative
+    int* class_next;
+    int* class_tail;
+
+    // Use lists: the UF applications having an argument in a class
+    int* use_head;
+    int* use_tail;
+    int* use_node;
+    int* use_next;
+    int use_count;
+    int use_cap;
+
+    // Argument entries of each UF application, uf_args[uf_arg_start[idx] + i]
+    int* uf_arg_start;
+    int* uf_args;
+    int uf_args_count;
+    int uf_args_cap;
+    int uf_count;
+
+    // Signature table (open addressing). Entries are never removed: a node whose
+    // signature changed is re-inserted, and lookups re-check congruence on the
+    // current classes, so stale entries simply fail to match. This also covers
+    // entries left behind by a pop, whose slot may be gone or hold another term.
+    SigEntry* sig;
+    int sig_count;
+    int sig_cap; // Power of two
+
+    // Pending merges
+    int* pending;
+    int pending_count;
+    int pending_cap;
+};
+
+CcState* cc_new(void) {
+    return (CcState*)calloc(1, sizeof(CcState));
+}
+
+void cc_free(CcState* cc) {
+    if (cc == NULL) return;
+    free(cc->size);
+    free(cc->class_next);
+    free(cc->class_tail);
+    free(cc->use_head);
+    free(cc->use_tail);
+    free(cc->use_node);
+    free(cc->use_next);
+    free(cc->uf_arg_start);
+    free(cc->uf_args);
+    free(cc->sig);
+    free(cc->pending);
+    free(cc);
+}
+
+size_t cc_bytes(const SolverContext* ctx) {
+    const CcState* cc = ctx->cc;
+    if (cc == NULL) return 0;
+    return sizeof(CcState) + sizeof(int) * ((size_t)cc->cap * 6 + (size_t)cc->use_cap * 2 + cc->uf_args_cap + cc->pending_cap)
+        + sizeof(SigEntry) * (size_t)cc->sig_cap;
+}
+
+void cc_reserve(SolverContext* ctx, int cap) {
+    CcState* cc = ctx->cc;
+    if (cap <= cc->cap) return;
+    cc->size = (int*)realloc(cc->size, sizeof(int) * cap);
+    cc->class_next = (int*)realloc(cc->class_next, sizeof(int) * cap);
+    cc->class_tail = (int*)realloc(cc->class_tail, sizeof(int) * cap);
+    cc->use_head = (int*)realloc(cc->use_head, sizeof(int) * cap);
+    cc->use_tail = (int*)realloc(cc->use_tail, sizeof(int) * cap);
+    cc->uf_arg_start = (int*)realloc(cc->uf_arg_start, sizeof(int) * cap);
+    cc->cap = cap;
+}
+
+void cc_reset(SolverContext* ctx) {
+    CcState* cc = ctx->cc;
+    cc->use_count = 0;
+    cc->uf_args_count = 0;
+    cc->uf_count = 0;
+    cc->pending_count = 0;
+    cc->sig_count = 0;
+    for (int i = 0; i < cc->sig_cap; ++i) cc->sig[i].node = -1;
+}
+
+void cc_mark(SolverContext* ctx, CcMark* mark) {
+    CcState* cc = ctx->cc;
+    mark->use_count = cc->use_count;
+    mark->uf_args_count = cc->uf_args_count;
+    mark->uf_count = cc->uf_count;
+}
+
+void cc_restore(SolverContext* ctx, const CcMark* mark) {
+    CcState* cc = ctx->cc;
+    cc->use_count = mark->use_count;
+    cc->uf_args_count = mark->uf_args_count;
+    cc->uf_count = mark->uf_count;
+}
+
+void cc_undo(SolverContext* ctx, TrailKind kind, int idx, int old_value) {
+    CcState* cc = ctx->cc;
+    switch (kind) {
+        case TRAIL_CC_SIZE: cc->size[idx] = old_value; break;
+        case TRAIL_USE_HEAD: cc->use_head[idx] = old_value; break;
+        case TRAIL_USE_TAIL: cc->use_tail[idx] = old_value; break;
+        case TRAIL_USE_NEXT: cc->use_next[idx] = old_value; break;
+        case TRAIL_CLASS_NEXT: cc->class_next[idx] = old_value; break;
+        case TRAIL_CLASS_TAIL: cc->class_tail[idx] = old_value; break;
+        default: break;
+    }
+}
+
+// No path compression: union by size keeps finds logarithmic and every merge undoable by one parent write
+int cc_find(SolverContext* ctx, int idx) {
+    while (ctx->term_map[idx].parent != idx) idx = ctx->term_map[idx].parent;
+    return idx;
+}
+
+int cc_class_next(SolverContext* ctx, int idx) {
+    CcState* cc = ctx->cc;
+    return cc->class_next[idx];
+}
+
+bool cc_has_uf(SolverContext* ctx) {
+    CcState* cc = ctx->cc;
+    return cc->uf_count > 0;
+}
+
+static void use_list_add(SolverContext* ctx, int cls, int node) {
+    CcState* cc = ctx->cc;
+    if (cc->use_count == cc->use_cap) {
+        cc->use_cap = cc->use_cap ? cc->use_cap * 2 : 64;
+        cc->use_node = (int*)realloc(cc->use_node, sizeof(int) * cc->use_cap);
+        cc->use_next = (int*)realloc(cc->use_next, sizeof(int) * cc->use_cap);
+    }
+    int u = cc->use_count++;
+    cc->use_node[u] = node;
+    cc->use_next[u] = -1;
+    if (cc->use_head[cls] < 0) {
+        trail_int(ctx, TRAIL_USE_HEAD, cls, cc->use_head[cls]);
+        cc->use_head[cls] = u;
+    } else {
+        trail_int(ctx, TRAIL_USE_NEXT, cc->use_tail[cls], cc->use_next[cc->use_tail[cls]]);
+        cc->use_next[cc->use_tail[cls]] = u;
+    }
+    trail_int(ctx, TRAIL_USE_TAIL, cls, cc->use_tail[cls]);
+    cc->use_tail[cls] = u;
+}
+
+static void push_pending(SolverContext* ctx, int a, int b) {
+    CcState* cc = ctx->cc;
+    if (cc->pending_count + 2 > cc->pending_cap) {
+        cc->pending_cap = cc->pending_cap ? cc->pending_cap * 2 : 32;
+        cc->pending = (int*)realloc(cc->pending, sizeof(int) * cc->pending_cap);
+    }
+    cc->pending[cc->pending_count++] = a;
+    cc->pending[cc->pending_count++] = b;
+}
+
+// --- Signatures ---
+
+static UFunction* uf_of(SolverContext* ctx, int node) {
+    return ctx->term_map[node].term_ptr->term.UFTerm;
+}
+
+static unsigned long long signature_hash(SolverContext* ctx, int node) {
+    CcState* cc = ctx->cc;
+    UFunction* uf = uf_of(ctx, node);
+    unsigned long long h = 1469598103934665603ULL; // FNV-1a over the name, then the argument classes
+    for (const char* s = uf->name; *s; ++s) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    for (int i = 0; i < uf->numArgs; ++i) {
+        h ^= (unsigned long long)cc_find(ctx, cc->uf_args[cc->uf_arg_start[node] + i]) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+static bool congruent(SolverContext* ctx, int p, int q) {
+    CcState* cc = ctx->cc;
+    UFunction* fp = uf_of(ctx, p);
+    UFunction* fq = uf_of(ctx, q);
+    if (fp->numArgs != fq->numArgs || strcmp(fp->name, fq->name) != 0) return false;
+    for (int i = 0; i < fp->numArgs; ++i) {
+        if (cc_find(ctx, cc->uf_args[cc->uf_arg_start[p] + i]) != cc_find(ctx, cc->uf_args[cc->uf_arg_start[q] + i])) return false;
+    }
+    return true;
+}
+
+static void sig_rebuild(SolverContext* ctx, int cap);
+
+// Returns an application congruent to node, inserting node if there is none
+static int sig_insert_or_find(SolverContext* ctx, int node) {
+    CcState* cc = ctx->cc;
+    if (2 * (cc->sig_count + 1) > cc->sig_cap) sig_rebuild(ctx, cc->sig_cap ? cc->sig_cap * 2 : 64);
+    unsigned long long h = signature_hash(ctx, node);
+    int j = (int)(h & (cc->sig_cap - 1));
+    while (cc->sig[j].node >= 0) {
+        int other = cc->sig[j].node;
+        bool live = other < ctx->term_map_count && ctx->term_map[other].term_ptr->type == SMT_UFTerm && cc->use_head[other] != -2;
+        if (live && cc->sig[j].hash == h && (other == node || congruent(ctx, other, node))) return other;
+        j = (j + 1) & (cc->sig_cap - 1);
+    }
+    cc->sig[j].hash = h;
+    cc->sig[j].node = node;
+    cc->sig_count++;
+    return node;
+}
+
+// Drops stale entries by re-inserting every application under its current signature
+static void sig_rebuild(SolverContext* ctx, int cap) {
+    CcState* cc = ctx->cc;
+    if (cap > cc->sig_cap) {
+        cc->sig = (SigEntry*)realloc(cc->sig, sizeof(SigEntry) * cap);
+        cc->sig_cap = cap;
+    }
+    for (int i = 0; i < cc->sig_cap; ++i) cc->sig[i].node = -1;
+    cc->sig_count = 0;
+    for (int i = 0; i < ctx->term_map_count; ++i) {
+        if (!ctx->term_map[i].active || ctx->term_map[i].term_ptr->type != SMT_UFTerm) continue;
+        if (ctx->term_map[i].parent == i && cc->use_head[i] == -2) continue; // Not registered yet
+        int q = sig_insert_or_find(ctx, i);
+        if (q != i && cc_find(ctx, q) != cc_find(ctx, i)) push_pending(ctx, i, q);
+    }
+}
+
+// --- Merging ---
+
+static bool process_pending(SolverContext* ctx, bool* changed_overall) {
+    CcState* cc = ctx->cc;
+    bool empty_found = false;
+    while (cc->pending_count > 0) {
+        int y = cc->pending[--cc->pending_count];
+        int x = cc->pending[--cc->pending_count];
+        int rx = cc_find(ctx, x), ry = cc_find(ctx, y);
+        if (rx == ry) continue;
+        if (cc->size[rx] > cc->size[ry]) { int t = rx; rx = ry; ry = t; }
+
+        // rx joins ry; the class keeps the intersection of both intervals. A merge is
+        // progress even when no bound moves, since distinct constraints may now fail.
+        Interval merged = intersect_intervals(ctx->term_map[rx].interval, ctx->term_map[ry].interval);
+        *changed_overall = true;
+        trail_int(ctx, TRAIL_TERM_PARENT, rx, rx);
+        ctx->term_map[rx].parent = ry;
+        trail_int(ctx, TRAIL_CC_SIZE, ry, cc->size[ry]);
+        cc->size[ry] += cc->size[rx];
+        trail_int(ctx, TRAIL_CLASS_NEXT, cc->class_tail[ry], cc->class_next[cc->class_tail[ry]]);
+        cc->class_next[cc->class_tail[ry]] = rx;
+        trail_int(ctx, TRAIL_CLASS_TAIL, ry, cc->class_tail[ry]);
+        cc->class_tail[ry] = cc->class_tail[rx];
+        set_term_interval(ctx, &ctx->term_map[ry], merged);
+        mark_class_dirty(ctx, ry); // Members of rx now see the class interval
+        if (is_empty_interval(merged)) empty_found = true;
+
+        // Applications over rx now have a new signature and may meet a congruent partner
+        for (int u = cc->use_head[rx]; u >= 0; u = cc->use_next[u]) {
+            int p = cc->use_node[u];
+            int q = sig_insert_or_find(ctx, p);
+            if (q != p && cc_find(ctx, q) != cc_find(ctx, p)) push_pending(ctx, p, q);
+        }
+        if (cc->use_head[rx] >= 0) {
+            if (cc->use_head[ry] < 0) {
+                trail_int(ctx, TRAIL_USE_HEAD, ry, cc->use_head[ry]);
+                cc->use_head[ry] = cc->use_head[rx];
+            } else {
+                trail_int(ctx, TRAIL_USE_NEXT, cc->use_tail[ry], cc->use_next[cc->use_tail[ry]]);
+                cc->use_next[cc->use_tail[ry]] = cc->use_head[rx];
+            }
+            trail_int(ctx, TRAIL_USE_TAIL, ry, cc->use_tail[ry]);
+            cc->use_tail[ry] = cc->use_tail[rx];
+            trail_int(ctx, TRAIL_USE_HEAD, rx, cc->use_head[rx]);
+            cc->use_head[rx] = -1;
+        }
+    }
+    return empty_found;
+}
+
+bool cc_merge(SolverContext* ctx, int a, int b, bool* changed_overall) {
+    push_pending(ctx, a, b);
+    return process_pending(ctx, changed_overall);
+}
+
+bool cc_register_term(SolverContext* ctx, int idx) {
+    CcState* cc = ctx->cc;
+    ctx->term_map[idx].parent = idx;
+    cc->size[idx] = 1;
+    cc->class_next[idx] = -1;
+    cc->class_tail[idx] = idx;
+    cc->use_head[idx] = -2; // Marks an entry still being registered
+    cc->use_tail[idx] = -1;
+
+    SmtTerm* term = ctx->term_map[idx].term_ptr;
+    if (term->type == SMT_UFTerm && term->term.UFTerm != NULL) return true;
+    cc->use_head[idx] = -1;
+    if (term->type == SMT_VarName) {
+        bool ignored = false;
+        VarIntervalEntry* var_entry = get_or_add_var_entry(ctx, term->term.Variable);
+        if (var_entry->term_index < 0) {
+            trail_int(ctx, TRAIL_VAR_TERM_INDEX, (int)(var_entry - ctx->var_map), -1);
+            var_entry->term_index = idx;
+        } else cc_merge(ctx, idx, var_entry->term_index, &ignored); // Every occurrence of a variable is one class
+    }
+    return false;
+}
+
+void cc_register_application(SolverContext* ctx, int idx) {
+    CcState* cc = ctx->cc;
+    UFunction* uf = ctx->term_map[idx].term_ptr->term.UFTerm;
+    if (cc->uf_args_count + uf->numArgs > cc->uf_args_cap) {
+        while (cc->uf_args_count + uf->numArgs > cc->uf_args_cap) cc->uf_args_cap = cc->uf_args_cap ? cc->uf_args_cap * 2 : 64;
+        cc->uf_args = (int*)realloc(cc->uf_args, sizeof(int) * cc->uf_args_cap);
+    }
+    int start = cc->uf_args_count;
+    cc->uf_args_count += uf->numArgs;
+    for (int i = 0; i < uf->numArgs; ++i) {
+        cc->uf_args[start + i] = get_or_add_term_index(ctx, uf->args[i]); // Only a lookup by now
+    }
+    cc->uf_arg_start[idx] = start;
+    cc->use_head[idx] = -1;
+    for (int i = 0; i < uf->numArgs; ++i) use_list_add(ctx, cc_find(ctx, cc->uf_args[start + i]), idx);
+    cc->uf_count++;
+    bool ignored = false;
+    int q = sig_insert_or_find(ctx, idx);
+    if (q != idx) cc_merge(ctx, idx, q, &ignored);
+}
+
+// --- Equalities Entailed by Intervals ---
+
+bool cc_merge_equal_singletons(SolverContext* ctx, bool* changed_overall) {
+    // Small open-addressing table from fixed value to the class holding it
+    int cap = 16;
+    while (cap < 2 * ctx->term_map_count) cap *= 2;
+    int* table = (int*)malloc(sizeof(int) * cap);
+    for (int i = 0; i < cap; ++i) table[i] = -1;
+
+    bool empty_found = false;
+    for (int i = 0; i < ctx->term_map_count && !empty_found; ++i) {
+        if (!ctx->term_map[i].active || cc_find(ctx, i) != i) continue;
+        Interval iv = ctx->term_map[i].interval;
+        if (iv.lower != iv.upper) continue;
+        unsigned long long h = (unsigned long long)iv.lower * 0x9e3779b97f4a7c15ULL;
+        int j = (int)((h ^ (h >> 29)) & (cap - 1));
+        while (table[j] >= 0) {
+            Interval other = ctx->term_map[cc_find(ctx, table[j])].interval;
+            if (other.lower == iv.lower && other.upper == iv.upper) break;
+            j = (j + 1) & (cap - 1);
+        }
+        if (table[j] < 0) table[j] = i;
+        else if (cc_find(ctx, table[j]) != i) empty_found = cc_merge(ctx, i, table[j], changed_overall);
+    }
+    free(table);
+    return empty_found;
+}
@@ -0,0 +1,42 @@
+#ifndef CONGRUENCE_H
+#define CONGRUENCE_H 1
+#include "interval_solver.h"
+
+// --- Congruence Closure over the Term Map ---
+// Term map entries are grouped into classes (union-find through TermIntervalEntry.parent);
+// a class shares the interval of its representative. Occurrences of the same variable
+// start in one class, and UF applications whose arguments are pairwise in the same
+// classes are merged through a signature table.
+
+// Counters of the append-only congruence storage, restored on pop
+typedef struct {
+    int use_count;
+    int uf_args_count;
+    int uf_count;
+} CcMark;
+
+CcState* cc_new(void);
+void cc_free(CcState* cc);
+// Bytes held by the congruence tables
+size_t cc_bytes(const SolverContext* ctx);
+// Grows the per-term arrays to cap entries, called as the term map grows
+void cc_reserve(SolverContext* ctx, int cap);
+void cc_reset(SolverContext* ctx);
+void cc_mark(SolverContext* ctx, CcMark* mark);
+void cc_restore(SolverContext* ctx, const CcMark* mark);
+// Reverts one trailed congruence write (see TrailKind)
+void cc_undo(SolverContext* ctx, TrailKind kind, int idx, int old_value);
+// Called once for every new term map entry. Returns true for a UF application, whose
+// registration cc_register_application completes once its arguments are in the map
+bool cc_register_term(SolverContext* ctx, int idx);
+void cc_register_application(SolverContext* ctx, int idx);
+int cc_find(SolverContext* ctx, int idx);
+// Walks the members of a class: start from the representative, -1 ends the list
+int cc_class_next(SolverContext* ctx, int idx);
+bool cc_has_uf(SolverContext* ctx);
+// Merges the classes of two entries and every application that becomes congruent;
+// returns true if a merged class interval became empty
+bool cc_merge(SolverContext* ctx, int a, int b, bool* changed_overall);
+// Merges classes whose intervals are fixed to the same value
+bool cc_merge_equal_singletons(SolverContext* ctx, bool* changed_overall);
+#endif
@@ -0,0 +1,356 @@
+#include "diskcache.h"
+
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DISK_CACHE_MAGIC "SMTC"
+#define DISK_CACHE_VERSION 1
+#define HEADER_SIZE 16 // Magic, version, CANON_VERSION, reserved
+#define RECORD_FIXED 32 // Length, checksum, key, verdict, truncated, reserved, count
+
+// Record layout, little-endian as written by this host:
+//   u32 length (a multiple of 8), u32 checksum of bytes [8, length),
+//   u64 key.lo, u64 key.hi, u8 result, u8 truncated, u16 reserved, u32 count,
+//   count pairs of varint bounds, zero padding.
+
+typedef struct {
+    CanonHash key;
+    uint64_t off; // 0 for an empty slot (offset 0 is the header)
+} DiskSlot;
+
+struct DiskCache {
+    char* path;
+    int fd;       // O_APPEND
+    int lock_fd;  // <path>.lock, for appends (shared) and compaction (exclusive)
+    dev_t dev;
+    ino_t ino;
+    pthread_mutex_t lock; // Threads of this process share the mapping and the index
+
+    const char* map;
+    size_t map_size;
+    size_t indexed; // Records in [HEADER_SIZE, indexed) are in the index
+
+    DiskSlot* slots;
+    int slot_cap;
+    int slot_count;
+};
+
+static uint32_t checksum(const unsigned char* p, size_t n) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// --- Bound Encoding ---
+// zigzag(v) + 2 wraps LLONG_MAX to 0 and LLONG_MIN to 1, so infinite bounds take one byte
+
+static size_t put_bound(unsigned char* p, long long v) {
+    uint64_t u = (((uint64_t)v << 1) ^ (uint64_t)(v >> 63)) + 2;
+    size_t n = 0;
+    while (u >= 0x80) {
+        p[n++] = (unsigned char)(u | 0x80);
+        u >>= 7;
+    }
+    p[n++] = (unsigned char)u;
+    return n;
+}
+
+// Decodes one bound from p[0..end); 0 if it is cut off
+static size_t get_bound(const unsigned char* p, size_t end, long long* v) {
+    uint64_t u = 0;
+    for (size_t n = 0; n < end && n < 10; ++n) {
+        u |= (uint64_t)(p[n] & 0x7f) << (7 * n);
+        if (!(p[n] & 0x80)) {
+            u -= 2;
+            *v = (long long)((u >> 1) ^ (~(u & 1) + 1));
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+// --- Index ---
+
+static void index_put(DiskCache* c, CanonHash key, uint64_t off);
+
+static void index_grow(DiskCache* c) {
+    DiskSlot* old = c->slots;
+    int old_cap = c->slot_cap;
+    c->slot_cap = old_cap ? old_cap * 2 : 1024;
+    c->slots = (DiskSlot*)calloc(c->slot_cap, sizeof(DiskSlot));
+    c->slot_count = 0;
+    for (int i = 0; i < old_cap; ++i) {
+        if (old[i].off != 0) index_put(c, old[i].key, old[i].off);
+    }
+    free(old);
+}
+
+static DiskSlot* index_find(DiskCache* c, CanonHash key) {
+    if (c->slot_cap == 0) return NULL;
+    int slot = (int)(key.lo & (uint64_t)(c->slot_cap - 1));
+    while (c->slots[slot].off != 0) {
+        if (canon_hash_equals(c->slots[slot].key, key)) return &c->slots[slot];
+        slot = (slot + 1) & (c->slot_cap - 1);
+    }
+    return NULL;
+}
+
+// A later record for the same key replaces the earlier one
+static void index_put(DiskCache* c, CanonHash key, uint64_t off) {
+    if (2 * (c->slot_count + 1) > c->slot_cap) index_grow(c);
+    int slot = (int)(key.lo & (uint64_t)(c->slot_cap - 1));
+    while (c->slots[slot].off != 0 && !canon_hash_equals(c->slots[slot].key, key)) slot = (slot + 1) & (c->slot_cap - 1);
+    if (c->slots[slot].off == 0) c->slot_count++;
+    c->slots[slot].key = key;
+    c->slots[slot].off = off;
+}
+
+// --- File ---
+
+static bool header_valid(const unsigned char* h) {
+    uint32_t version, key_version;
+    memcpy(&version, h + 4, 4);
+    memcpy(&key_version, h + 8, 4);
+    return memcmp(h, DISK_CACHE_MAGIC, 4) == 0 && version == DISK_CACHE_VERSION && key_version == CANON_VERSION;
+}
+
+static void make_header(unsigned char* h) {
+    uint32_t version = DISK_CACHE_VERSION, key_version = CANON_VERSION, reserved = 0;
+    memcpy(h, DISK_CACHE_MAGIC, 4);
+    memcpy(h + 4, &version, 4);
+    memcpy(h + 8, &key_version, 4);
+    memcpy(h + 12, &reserved, 4);
+}
+
+// Length of the valid record at off in the current mapping, 0 if there is none (yet)
+static size_t record_at(const DiskCache* c, size_t off, size_t size) {
+    if (off + RECORD_FIXED > size) return 0;
+    const unsigned char* r = (const unsigned char*)c->map + off;
+    uint32_t length, check;
+    memcpy(&length, r, 4);
+    memcpy(&check, r + 4, 4);
+    if (length < RECORD_FIXED || length % 8 != 0 || off + length > size) return 0;
+    if (checksum(r + 8, length - 8) != check) return 0;
+    return length;
+}
+
+static void unmap(DiskCache* c) {
+    if (c->map != NULL) munmap((void*)c->map, c->map_size);
+    c->map = NULL;
+    c->map_size = 0;
+}
+
+// (Re)opens the file descriptor on path, creating and initialising the file if needed
+static int open_file(DiskCache* c) {
+    int fd = open(c->path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        flock(c->lock_fd, LOCK_EX); // Only one process writes the header
+        unsigned char h[HEADER_SIZE];
+        make_header(h);
+        if (fstat(fd, &st) == 0 && st.st_size == 0 && write(fd, h, HEADER_SIZE) != HEADER_SIZE) perror(c->path);
+        flock(c->lock_fd, LOCK_UN);
+    }
+    unsigned char h[HEADER_SIZE];
+    if (pread(fd, h, HEADER_SIZE, 0) != HEADER_SIZE || !header_valid(h)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    if (c->fd >= 0) close(c->fd);
+    c->fd = fd;
+    c->dev = st.st_dev;
+    c->ino = st.st_ino;
+    unmap(c);
+    c->indexed = HEADER_SIZE;
+    if (c->slot_cap > 0) memset(c->slots, 0, sizeof(DiskSlot) * c->slot_cap);
+    c->slot_count = 0;
+    return 0;
+}
+
+// Follows a compaction that replaced the file and indexes records appended since the last call
+static void refresh(DiskCache* c) {
+    struct stat st;
+    if (stat(c->path, &st) == 0 && (st.st_dev != c->dev || st.st_ino != c->ino)) {
+        if (open_file(c) != 0) return; // Keep serving the old file
+    }
+    if (fstat(c->fd, &st) != 0) return;
+    size_t size = (size_t)st.st_size;
+    if (size <= c->indexed) return;
+    if (size > c->map_size) {
+        void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, c->fd, 0);
+        if (map == MAP_FAILED) return;
+        unmap(c);
+        c->map = (const char*)map;
+        c->map_size = size;
+    }
+    size_t length;
+    while ((length = record_at(c, c->indexed, c->map_size)) > 0) {
+        CanonHash key;
+        memcpy(&key.lo, c->map + c->indexed + 8, 8);
+        memcpy(&key.hi, c->map + c->indexed + 16, 8);
+        index_put(c, key, c->indexed);
+        c->indexed += length;
+    }
+}
+
+DiskCache* disk_cache_open(const char* path) {
+    DiskCache* c = (DiskCache*)calloc(1, sizeof(DiskCache));
+    c->path = strdup(path);
+    c->fd = -1;
+    char* lock_path = (char*)malloc(strlen(path) + 6);
+    sprintf(lock_path, "%s.lock", path);
+    c->lock_fd = open(lock_path, O_RDWR | O_CREAT, 0644);
+    free(lock_path);
+    if (c->lock_fd < 0 || open_file(c) != 0) {
+        fprintf(stderr, "Error: cache file %s: %s\n", path, errno == EINVAL ? "not a cache file of this version" : strerror(errno));
+        if (c->lock_fd >= 0) close(c->lock_fd);
+        free(c->path);
+        free(c);
+        return NULL;
+    }
+    pthread_mutex_init(&c->lock, NULL);
+    refresh(c);
+    return c;
+}
+
+void disk_cache_close(DiskCache* c) {
+    if (c == NULL) return;
+    unmap(c);
+    close(c->fd);
+    close(c->lock_fd);
+    pthread_mutex_destroy(&c->lock);
+    free(c->slots);
+    free(c->path);
+    free(c);
+}
+
+bool disk_cache_lookup(DiskCache* c, CanonForm* form, int* result, bool* truncated) {
+    pthread_mutex_lock(&c->lock);
+    refresh(c);
+    DiskSlot* slot = index_find(c, form->hash);
+    bool hit = false;
+    if (slot != NULL) {
+        const unsigned char* r = (const unsigned char*)c->map + slot->off;
+        uint32_t length, count;
+        memcpy(&length, r, 4);
+        memcpy(&count, r + 28, 4);
+        if ((int)count == form->count) {
+            Interval* intervals = (Interval*)malloc(sizeof(Interval) * (count > 0 ? count : 1));
+            size_t pos = RECORD_FIXED;
+            hit = true;
+            for (uint32_t i = 0; i < count && hit; ++i) {
+                size_t n = get_bound(r + pos, length - pos, &intervals[i].lower);
+                size_t m = n ? get_bound(r + pos + n, length - pos - n, &intervals[i].upper) : 0;
+                hit = m > 0;
+                pos += n + m;
+            }
+            if (hit) {
+                *result = r[24];
+                *truncated = r[25] != 0;
+                free(form->intervals);
+                form->intervals = intervals;
+            } else {
+                free(intervals);
+            }
+        }
+    }
+    pthread_mutex_unlock(&c->lock);
+    return hit;
+}
+
+void disk_cache_append(DiskCache* c, const CanonForm* form, int result, bool truncated) {
+    size_t cap = RECORD_FIXED + 20 * (size_t)form->count + 8;
+    unsigned char* r = (unsigned char*)calloc(1, cap);
+    uint32_t count = (uint32_t)form->count;
+    memcpy(r + 8, &form->hash.lo, 8);
+    memcpy(r + 16, &form->hash.hi, 8);
+    r[24] = (unsigned char)result;
+    r[25] = truncated;
+    memcpy(r + 28, &count, 4);
+    size_t pos = RECORD_FIXED;
+    for (int i = 0; i < form->count; ++i) {
+        pos += put_bound(r + pos, form->intervals[i].lower);
+        pos += put_bound(r + pos, form->intervals[i].upper);
+    }
+    uint32_t length = (uint32_t)((pos + 7) & ~(size_t)7);
+    uint32_t check = checksum(r + 8, length - 8);
+    memcpy(r, &length, 4);
+    memcpy(r + 4, &check, 4);
+
+    pthread_mutex_lock(&c->lock);
+    refresh(c); // Follows a compaction
+    flock(c->lock_fd, LOCK_SH);
+    // A compaction between the refresh and the lock would drop this record; it is only a cache
+    struct stat st;
+    if (stat(c->path, &st) == 0 && st.st_dev == c->dev && st.st_ino == c->ino) {
+        if (write(c->fd, r, length) != (ssize_t)length) perror(c->path);
+    }
+    flock(c->lock_fd, LOCK_UN);
+    pthread_mutex_unlock(&c->lock);
+    free(r);
+}
+
+static int compare_offsets(const void* a, const void* b) {
+    uint64_t x = ((const DiskSlot*)a)->off, y = ((const DiskSlot*)b)->off;
+    return x < y ? -1 : x > y;
+}
+
+int disk_cache_compact(DiskCache* c, int keep) {
+    pthread_mutex_lock(&c->lock);
+    flock(c->lock_fd, LOCK_EX); // No append is in flight while the live records are copied
+    refresh(c);
+
+    // Live records in file order, so that the newest ones are kept
+    DiskSlot* live = (DiskSlot*)malloc(sizeof(DiskSlot) * (c->slot_count > 0 ? c->slot_count : 1));
+    int n = 0;
+    for (int i = 0; i < c->slot_cap; ++i) {
+        if (c->slots[i].off != 0) live[n++] = c->slots[i];
+    }
+    qsort(live, n, sizeof(DiskSlot), compare_offsets);
+    int first = keep > 0 && n > keep ? n - keep : 0;
+
+    char* tmp = (char*)malloc(strlen(c->path) + 32);
+    sprintf(tmp, "%s.tmp.%ld", c->path, (long)getpid());
+    int res = -1;
+    FILE* fp = fopen(tmp, "wb");
+    if (fp != NULL) {
+        unsigned char h[HEADER_SIZE];
+        make_header(h);
+        bool ok = fwrite(h, 1, HEADER_SIZE, fp) == HEADER_SIZE;
+        for (int i = first; i < n && ok; ++i) {
+            uint32_t length;
+            memcpy(&length, c->map + live[i].off, 4);
+            ok = fwrite(c->map + live[i].off, 1, length, fp) == length;
+        }
+        ok = fflush(fp) == 0 && fsync(fileno(fp)) == 0 && ok;
+        ok = fclose(fp) == 0 && ok;
+        if (ok && rename(tmp, c->path) == 0) res = n - first;
+        else unlink(tmp);
+    }
+    if (res < 0) perror(c->path);
+    else open_file(c);
+    refresh(c);
+    flock(c->lock_fd, LOCK_UN);
+    pthread_mutex_unlock(&c->lock);
+    free(tmp);
+    free(live);
+    return res;
+}
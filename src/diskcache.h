@@ -0,0 +1,30 @@
+#ifndef DISKCACHE_H
+#define DISKCACHE_H 1
+#include "canon.h"
+
+// --- Persistent Result Cache ---
+// An append-only file of solver answers keyed by the canonical hash (canon.h), shared by
+// every process on the host that opens it and kept across restarts. A record holds the
+// key, the verdict, the truncation flag and the final interval of every canonical
+// variable as zigzag varints, in which an infinite bound takes one byte.
+//
+// Readers map the file and index the records appended since their last look, without
+// taking any file lock; a record only counts once its checksum matches, so a reader
+// never sees half of an append. Appends are single O_APPEND writes under a shared lock
+// on `<file>.lock`. Compaction takes that lock exclusively, writes the newest record of
+// every key to a new file and renames it over the old one; open caches notice the new
+// inode on their next lookup and map it instead.
+
+typedef struct DiskCache DiskCache;
+
+// Opens or creates the cache file; NULL (reported on stderr) if it cannot be used
+DiskCache* disk_cache_open(const char* path);
+void disk_cache_close(DiskCache* cache);
+// On a hit stores the verdict in *result and *truncated, fills form->intervals and returns true
+bool disk_cache_lookup(DiskCache* cache, CanonForm* form, int* result, bool* truncated);
+// Appends the answer of a solved problem; form->intervals must have been captured
+void disk_cache_append(DiskCache* cache, const CanonForm* form, int result, bool truncated);
+// Rewrites the file with the newest record of each key, only the newest keep keys when
+// keep > 0; returns the number of records kept, -1 on error
+int disk_cache_compact(DiskCache* cache, int keep);
+#endif
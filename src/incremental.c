@@ -0,0 +1,273 @@
+#include "incremental.h"
+#include "interval_solver.h"
+#include "budget.h"
+#include "congruence.h"
+#include "narrowlog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int trail_size;
+    int cons_count;
+    int var_count;
+    int term_count;
+    CcMark cc;
+    bool inconsistent;
+    // Constraints still queued at the push, when the check before it stopped at a limit
+    int* queue;
+    int queue_count;
+    int queue_cap;
+} ScopeFrame;
+
+struct IncState {
+    // Asserted constraints, in assertion order
+    AtomConstraint* cons;
+    int cons_count;
+    int cons_cap;
+
+    // Constraints waiting to be propagated
+    int* queue;
+    int queue_count;
+    bool* in_queue;
+
+    ScopeFrame* frames;
+    int frame_cap;
+
+    bool inconsistent;
+    NarrowMarks described; // What the narrowing log knows of this context's maps
+};
+
+static void enqueue(SolverContext* ctx, int c) {
+    IncState* inc = ctx->inc;
+    if (inc->in_queue[c]) return;
+    inc->in_queue[c] = true;
+    inc->queue[inc->queue_count++] = c;
+}
+
+static void clear_queue(SolverContext* ctx) {
+    IncState* inc = ctx->inc;
+    for (int i = 0; i < inc->queue_count; ++i) inc->in_queue[inc->queue[i]] = false;
+    inc->queue_count = 0;
+}
+
+void solver_init(SolverContext* ctx) {
+    if (ctx->inc == NULL) ctx->inc = (IncState*)calloc(1, sizeof(IncState));
+    IncState* inc = ctx->inc;
+    while (ctx->scope_depth > 0) solver_pop(ctx);
+    init_maps(ctx);
+    clear_queue(ctx);
+    inc->cons_count = 0;
+    inc->inconsistent = false;
+}
+
+void solver_release(SolverContext* ctx) {
+    IncState* inc = ctx->inc;
+    if (inc == NULL) return;
+    free(inc->cons);
+    free(inc->queue);
+    free(inc->in_queue);
+    for (int i = 0; i < inc->frame_cap; ++i) free(inc->frames[i].queue);
+    free(inc->frames);
+    free(inc);
+    ctx->inc = NULL;
+}
+
+void solver_assert_constraint(SolverContext* ctx, AtomConstraint con) {
+    IncState* inc = ctx->inc;
+    if (inc->cons_count == inc->cons_cap) {
+        inc->cons_cap = inc->cons_cap ? inc->cons_cap * 2 : 64;
+        inc->cons = (AtomConstraint*)realloc(inc->cons, sizeof(AtomConstraint) * inc->cons_cap);
+        inc->queue = (int*)realloc(inc->queue, sizeof(int) * inc->cons_cap);
+        inc->in_queue = (bool*)realloc(inc->in_queue, sizeof(bool) * inc->cons_cap);
+    }
+    int c = inc->cons_count++;
+    inc->cons[c] = con;
+    inc->in_queue[c] = false;
+
+    // New term entries belong to this constraint: a change to their class wakes it up
+    int first_new = ctx->term_map_count;
+    collect_terms_and_vars(ctx, con.term1);
+    collect_terms_and_vars(ctx, con.term2);
+    for (int i = first_new; i < ctx->term_map_count; ++i) ctx->term_map[i].owner = c;
+    enqueue(ctx, c);
+}
+
+// Both walk the conjunction on an explicit stack, conjuncts left to right, since a long
+// conjunction nests as deep as it is long
+bool solver_supports(SmtProp* prop) {
+    bool ok = true;
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, prop, NULL);
+    while (ok && walk.size > 0) {
+        prop = (SmtProp*)smt_walk_pop(&walk).node;
+        switch (prop->type) {
+            case SMTB_PROP:
+                ok = prop->prop.Binary_prop.op == SMTPROP_AND;
+                smt_walk_push(&walk, 0, prop->prop.Binary_prop.prop2, NULL);
+                smt_walk_push(&walk, 0, prop->prop.Binary_prop.prop1, NULL);
+                break;
+            case SMTU_PROP:
+                ok = is_interval_atom(prop->prop.Unary_prop.prop1);
+                break;
+            case SMTTF_PROP:
+                break;
+            default:
+                ok = is_interval_atom(prop);
+                break;
+        }
+    }
+    smt_walk_free(&walk);
+    return ok;
+}
+
+// Asserts the conjuncts of one conjunction in turn, stopping at the first unsupported one
+bool solver_assert(SolverContext* ctx, SmtProp* prop) {
+    IncState* inc = ctx->inc;
+    bool ok = true;
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, prop, NULL);
+    while (ok && walk.size > 0) {
+        prop = (SmtProp*)smt_walk_pop(&walk).node;
+        switch (prop->type) {
+            case SMTB_PROP:
+                if (prop->prop.Binary_prop.op == SMTPROP_AND) {
+                    smt_walk_push(&walk, 0, prop->prop.Binary_prop.prop2, NULL);
+                    smt_walk_push(&walk, 0, prop->prop.Binary_prop.prop1, NULL);
+                    continue;
+                }
+                ok = false;
+                break;
+            case SMTU_PROP:
+                if (is_interval_atom(prop->prop.Unary_prop.prop1)) {
+                    solver_assert_constraint(ctx, make_atom_constraint(prop->prop.Unary_prop.prop1, false));
+                    continue;
+                }
+                ok = false;
+                break;
+            case SMTTF_PROP:
+                if (!prop->prop.TF) inc->inconsistent = true;
+                break;
+            default:
+                if (is_interval_atom(prop)) {
+                    solver_assert_constraint(ctx, make_atom_constraint(prop, true));
+                    continue;
+                }
+                ok = false;
+                break;
+        }
+    }
+    smt_walk_free(&walk);
+    if (!ok) fprintf(stderr, "Warning: solver_assert only supports conjunctions of atoms, proposition ignored.\n");
+    return ok;
+}
+
+void solver_push(SolverContext* ctx) {
+    IncState* inc = ctx->inc;
+    solver_check(ctx); // Scopes start from a fixpoint unless a limit cut the check short; the pop restores what it left queued
+    if (ctx->scope_depth == inc->frame_cap) {
+        int old_cap = inc->frame_cap;
+        inc->frame_cap = inc->frame_cap ? inc->frame_cap * 2 : 16;
+        inc->frames = (ScopeFrame*)realloc(inc->frames, sizeof(ScopeFrame) * inc->frame_cap);
+        memset(inc->frames + old_cap, 0, sizeof(ScopeFrame) * (inc->frame_cap - old_cap));
+    }
+    ScopeFrame* frame = &inc->frames[ctx->scope_depth++];
+    frame->trail_size = ctx->trail_size;
+    frame->cons_count = inc->cons_count;
+    frame->var_count = ctx->var_map_count;
+    frame->term_count = ctx->term_map_count;
+    cc_mark(ctx, &frame->cc);
+    frame->inconsistent = inc->inconsistent;
+    frame->queue_count = inc->queue_count;
+    if (inc->queue_count > 0) {
+        if (inc->queue_count > frame->queue_cap) {
+            frame->queue_cap = inc->queue_count;
+            frame->queue = (int*)realloc(frame->queue, sizeof(int) * frame->queue_cap);
+        }
+        memcpy(frame->queue, inc->queue, sizeof(int) * inc->queue_count);
+    }
+}
+
+void solver_pop(SolverContext* ctx) {
+    IncState* inc = ctx->inc;
+    if (ctx->scope_depth == 0) {
+        fprintf(stderr, "Error: solver_pop without a matching solver_push.\n");
+        exit(1);
+    }
+    ScopeFrame* frame = &inc->frames[--ctx->scope_depth];
+    undo_trail(ctx, frame->trail_size);
+    clear_queue(ctx);
+    truncate_maps(ctx, frame->var_count, frame->term_count);
+    inc->cons_count = frame->cons_count;
+    // Slots past the frame will be reused by later assertions
+    if (inc->described.vars > frame->var_count) inc->described.vars = frame->var_count;
+    if (inc->described.terms > frame->term_count) inc->described.terms = frame->term_count;
+    if (inc->described.cons > frame->cons_count) inc->described.cons = frame->cons_count;
+    cc_restore(ctx, &frame->cc);
+    inc->inconsistent = frame->inconsistent;
+    for (int i = 0; i < frame->queue_count; ++i) enqueue(ctx, frame->queue[i]);
+}
+
+int solver_check(SolverContext* ctx) {
+    IncState* inc = ctx->inc;
+    if (inc->inconsistent) return 1;
+
+    int iterations = 0;
+    const int MAX_ITERATIONS = strategy_iteration_limit(ctx); // Same heuristic limit as propagate_to_fixpoint
+    int* batch = (int*)malloc(sizeof(int) * (inc->cons_count > 0 ? inc->cons_count : 1));
+    int res = 0;
+    int* dirty;
+    take_dirty_classes(ctx, &dirty); // Drop marks left by assertions
+    if (NLOG_ON(ctx)) narrow_log_begin_run(ctx->narrow_log);
+    ctx->dirty_tracking = true;
+
+    while (inc->queue_count > 0) {
+        // Propagate the current batch, then wake up the constraints over every class it moved
+        int n = inc->queue_count;
+        for (int i = 0; i < n; ++i) {
+            batch[i] = inc->queue[i];
+            inc->in_queue[batch[i]] = false;
+        }
+        inc->queue_count = 0;
+
+        bool changed = false;
+        if (propagate_round(ctx, inc->cons, batch, n, &changed)) { res = 1; break; }
+
+        int num_dirty = take_dirty_classes(ctx, &dirty);
+        for (int i = 0; i < num_dirty; ++i) {
+            for (int m = cc_find(ctx, dirty[i]); m >= 0; m = cc_class_next(ctx, m)) {
+                if (ctx->term_map[m].owner >= 0) enqueue(ctx, ctx->term_map[m].owner);
+            }
+        }
+
+        if (++iterations >= MAX_ITERATIONS) {
+            fprintf(stderr, "Warning: Max iterations reached, potential non-convergence or slow convergence.\n");
+            ctx->truncated = true;
+            break;
+        }
+        if (budget_exhausted(ctx) && (changed || inc->queue_count > 0)) {
+            // The round may have been cut short, so its batch goes back to the queue
+            for (int i = 0; i < n; ++i) enqueue(ctx, batch[i]);
+            ctx->truncated = true;
+            break;
+        }
+    }
+
+    ctx->dirty_tracking = false;
+    take_dirty_classes(ctx, &dirty);
+    free(batch);
+    if (NLOG_ON(ctx)) narrow_log_end_run(ctx->narrow_log, ctx, inc->cons, inc->cons_count, &inc->described);
+
+    if (res == 0) {
+        for (int i = 0; i < ctx->var_map_count; ++i) if (ctx->var_map[i].active && is_empty_interval(ctx->var_map[i].interval)) res = 1;
+        for (int i = 0; i < ctx->term_map_count; ++i) if (ctx->term_map[i].active && cc_find(ctx, i) == i && is_empty_interval(ctx->term_map[i].interval)) res = 1;
+    }
+    if (res == 1) {
+        inc->inconsistent = true; // Sticky until the scope that caused it is popped
+        clear_queue(ctx);
+    }
+    return res;
+}
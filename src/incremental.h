@@ -0,0 +1,29 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H 1
+#include "interval_solver.h"
+
+// --- Incremental Solving (assert / push / pop / check) ---
+// The solver keeps its maps between calls: solver_check only propagates the
+// constraints asserted since the last check, plus those whose terms were narrowed
+// since. Writes made inside a scope are recorded on the undo trail, so solver_pop
+// costs time proportional to what the scope changed.
+// The incremental state shares the context's maps with interval_solver; do not mix the two on one context.
+// Asserted propositions are referenced, not copied, and must outlive their scope.
+
+// Starts an empty incremental problem on the context
+void solver_init(SolverContext* ctx);
+// Frees the incremental state, called by solver_context_free
+void solver_release(SolverContext* ctx);
+// Adds a proposition to the current scope. Conjunctions of (negated) atoms, TT and FF
+// are supported; returns false for other Boolean structure, which is left unasserted.
+bool solver_assert(SolverContext* ctx, SmtProp* prop);
+// Adds one relation to the current scope
+void solver_assert_constraint(SolverContext* ctx, AtomConstraint con);
+// Whether solver_assert accepts the whole proposition
+bool solver_supports(SmtProp* prop);
+void solver_push(SolverContext* ctx);
+// Discards everything asserted and derived since the matching solver_push
+void solver_pop(SolverContext* ctx);
+// Same result convention as interval_solver: 1 if inconsistent, 0 otherwise
+int solver_check(SolverContext* ctx);
+#endif
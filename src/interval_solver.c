@@ -0,0 +1,1075 @@
+#include "interval_solver.h"
+#include "cdcl.h"
+#include "congruence.h"
+#include "incremental.h"
+#include "components.h"
+#include "stats.h"
+#include "budget.h"
+#include "narrowlog.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global constants for intervals
+const Interval INF_INTERVAL = {LLONG_MIN, LLONG_MAX};
+const Interval EMPTY_INTERVAL = {1, 0}; // Canonical empty: lower > upper
+
+// --- Helper Functions for Intervals & Maps ---
+
+long long safe_multiply(long long a, long long b) {
+    if (a == 0 || b == 0) return 0;
+    if (a == 1) return b;
+    if (b == 1) return a;
+
+    // Handing case -1
+    if (a == -1) {
+        if (b == LLONG_MIN) return LLONG_MAX; // -1 * LLONG_MIN --> LLONG_MAX
+        return -b;
+    }
+    if (b == -1) {
+        if (a == LLONG_MIN) return LLONG_MAX; // -1 * LLONG_MIN --> LLONG_MAX
+        return -a;
+    }
+
+    // Handling cases where an operand is an extreme value
+    if (a == LLONG_MAX) {
+        if (b > 0) return LLONG_MAX;
+        if (b < 0) return LLONG_MIN; // LLONG_MAX * negative
+    }
+    if (a == LLONG_MIN) {
+        if (b > 0) return LLONG_MIN; // LLONG_MIN * positive (b!=1, b!=-1)
+        if (b < 0) return LLONG_MAX; // LLONG_MIN * negative
+    }
+    // Symmetric treatment b is the extreme value
+    if (b == LLONG_MAX) {
+        if (a > 0) return LLONG_MAX;
+        if (a < 0) return LLONG_MIN;
+    }
+    if (b == LLONG_MIN) {
+        if (a > 0) return LLONG_MIN;
+        if (a < 0) return LLONG_MAX;
+    }
+
+    // Overflow checking in normal circumstances
+    // a > 0, b > 0:  a * b > LLONG_MAX  iff  a > LLONG_MAX / b
+    if (a > 0 && b > 0) {
+        if (a > LLONG_MAX / b) return LLONG_MAX;
+    }
+    // a < 0, b < 0:  a * b > LLONG_MAX  iff  (-a) * (-b) > LLONG_MAX
+    // Need to be careful as a or b could be LLONG_MIN, then -a or -b overflows.
+    else if (a < 0 && b < 0) {
+        if (a == LLONG_MIN || b == LLONG_MIN) { // If one is LLONG_MIN, the other negative non -1
+             // LLONG_MIN * (negative other than -1) => results in value > LLONG_MAX
+            return LLONG_MAX;
+        }
+        // Now a and b are negative, but not LLONG_MIN
+        if ((-a) > LLONG_MAX / (-b)) return LLONG_MAX;
+    }
+    // a > 0, b < 0 (or vice versa): a * b < LLONG_MIN
+    // a > 0, b < 0: a * b < LLONG_MIN iff b < LLONG_MIN / a
+    else if (a > 0 && b < 0) { // mixed signs, result negative
+        if (b < LLONG_MIN / a) return LLONG_MIN;
+    }
+    // a < 0, b > 0: a * b < LLONG_MIN iff a < LLONG_MIN / b
+    else if (a < 0 && b > 0) { // mixed signs, result negative
+        if (a < LLONG_MIN / b) return LLONG_MIN;
+    }
+    
+    return a * b;
+}
+
+// Saturate instead of wrapping, which -ftrapv would turn into an abort
+long long safe_add(long long a, long long b) {
+    long long res;
+    if (__builtin_add_overflow(a, b, &res)) return a > 0 ? LLONG_MAX : LLONG_MIN;
+    return res;
+}
+
+long long safe_subtract(long long a, long long b) {
+    long long res;
+    if (__builtin_sub_overflow(a, b, &res)) return a >= 0 ? LLONG_MAX : LLONG_MIN;
+    return res;
+}
+
+// LLONG_MIN / -1 is the one quotient that does not fit; b must not be 0
+long long safe_divide(long long a, long long b) {
+    if (a == LLONG_MIN && b == -1) return LLONG_MAX;
+    return a / b;
+}
+
+void init_maps(SolverContext* ctx) {
+    truncate_maps(ctx, 0, 0);
+    cc_reset(ctx);
+}
+
+Interval intersect_intervals(Interval i1, Interval i2) {
+    Interval res;
+    res.lower = (i1.lower > i2.lower) ? i1.lower : i2.lower;
+    res.upper = (i1.upper < i2.upper) ? i1.upper : i2.upper;
+    if (res.lower > res.upper) return EMPTY_INTERVAL;
+    return res;
+}
+
+bool is_empty_interval(Interval i) {
+    return i.lower > i.upper;
+}
+
+bool interval_equals(Interval i1, Interval i2) {
+    return i1.lower == i2.lower && i1.upper == i2.upper;
+}
+
+// --- Solver Context ---
+
+SolverContext* solver_context_new(void) {
+    SolverContext* ctx = (SolverContext*)calloc(1, sizeof(SolverContext));
+    ctx->cc = cc_new();
+    return ctx;
+}
+
+void solver_context_free(SolverContext* ctx) {
+    if (ctx == NULL) return;
+    if (ctx->props) freeSmtProplist(ctx->props);
+    solver_release(ctx);
+    cc_free(ctx->cc);
+    free(ctx->var_map);
+    free(ctx->term_map);
+    free(ctx->var_slots);
+    free(ctx->term_slots);
+    free(ctx->trail);
+    free(ctx->dirty);
+    free(ctx->dirty_flag);
+    free(ctx->stats);
+    free(ctx->walk);
+    free(ctx);
+}
+
+void solver_context_reset(SolverContext* ctx) {
+    if (ctx->props) freeSmtProplist(ctx->props);
+    ctx->props = NULL;
+    solver_release(ctx);
+    init_maps(ctx);
+    int* roots;
+    take_dirty_classes(ctx, &roots);
+    ctx->dirty_tracking = false;
+    ctx->scope_depth = 0;
+    ctx->trail_size = 0;
+    ctx->strategy = (SolverStrategy){ false, PHASES_FORWARD_FIRST, 0 };
+    ctx->truncated = false;
+    ctx->rounds = 0;
+    if (ctx->stats) solver_stats_clear(ctx->stats);
+}
+
+bool solver_stopped(const SolverContext* ctx) {
+    for (; ctx != NULL; ctx = ctx->stop_parent) {
+        if (ctx->stop != NULL && atomic_load_explicit(ctx->stop, memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+int strategy_iteration_limit(const SolverContext* ctx) {
+    int scale = ctx->strategy.iteration_scale > 1 ? ctx->strategy.iteration_scale : 1;
+    return scale * (2 * (ctx->var_map_count + ctx->term_map_count) + 10);
+}
+
+// --- Undo Trail ---
+
+static TrailEntry* trail_push(SolverContext* ctx, TrailKind kind, int idx) {
+    if (ctx->trail_size == ctx->trail_cap) {
+        ctx->trail_cap = ctx->trail_cap ? ctx->trail_cap * 2 : 256;
+        ctx->trail = (TrailEntry*)realloc(ctx->trail, sizeof(TrailEntry) * ctx->trail_cap);
+    }
+    TrailEntry* e = &ctx->trail[ctx->trail_size++];
+    e->kind = kind;
+    e->idx = idx;
+    return e;
+}
+
+void trail_int(SolverContext* ctx, TrailKind kind, int idx, int old_value) {
+    if (ctx->scope_depth == 0) return; // Nothing can be popped at the base level
+    trail_push(ctx, kind, idx)->old_value = old_value;
+}
+
+void undo_trail(SolverContext* ctx, int size) {
+    while (ctx->trail_size > size) {
+        TrailEntry* e = &ctx->trail[--ctx->trail_size];
+        switch (e->kind) {
+            case TRAIL_VAR_INTERVAL: ctx->var_map[e->idx].interval = e->old_interval; break;
+            case TRAIL_TERM_INTERVAL: ctx->term_map[e->idx].interval = e->old_interval; break;
+            case TRAIL_VAR_TERM_INDEX: ctx->var_map[e->idx].term_index = e->old_value; break;
+            case TRAIL_TERM_PARENT: ctx->term_map[e->idx].parent = e->old_value; break;
+            default: cc_undo(ctx, e->kind, e->idx, e->old_value); break;
+        }
+    }
+}
+
+void mark_class_dirty(SolverContext* ctx, int root) {
+    if (!ctx->dirty_tracking || ctx->dirty_flag[root]) return;
+    ctx->dirty_flag[root] = true;
+    ctx->dirty[ctx->dirty_count++] = root;
+}
+
+int take_dirty_classes(SolverContext* ctx, int** roots) {
+    int n = ctx->dirty_count;
+    for (int i = 0; i < n; ++i) ctx->dirty_flag[ctx->dirty[i]] = false;
+    ctx->dirty_count = 0;
+    *roots = ctx->dirty;
+    return n;
+}
+
+void set_term_interval(SolverContext* ctx, TermIntervalEntry* entry, Interval iv) {
+    if (interval_equals(entry->interval, iv)) return;
+    int idx = (int)(entry - ctx->term_map);
+    if (ctx->scope_depth > 0) trail_push(ctx, TRAIL_TERM_INTERVAL, idx)->old_interval = entry->interval;
+    mark_class_dirty(ctx, idx);
+    STAT_ADD(ctx, narrowings[ctx->stats->phase], 1);
+    if (NLOG_ON(ctx)) narrow_log_record(ctx->narrow_log, NARROW_TERM, idx, entry->interval, iv);
+    entry->interval = iv;
+}
+
+void set_var_interval(SolverContext* ctx, VarIntervalEntry* entry, Interval iv) {
+    if (interval_equals(entry->interval, iv)) return;
+    if (ctx->scope_depth > 0) trail_push(ctx, TRAIL_VAR_INTERVAL, (int)(entry - ctx->var_map))->old_interval = entry->interval;
+    if (entry->term_index >= 0) mark_class_dirty(ctx, cc_find(ctx, entry->term_index));
+    STAT_ADD(ctx, narrowings[ctx->stats->phase], 1);
+    if (NLOG_ON(ctx)) narrow_log_record(ctx->narrow_log, NARROW_VAR, (int)(entry - ctx->var_map), entry->interval, iv);
+    entry->interval = iv;
+}
+
+// --- Map Indexes ---
+// Open addressing from a variable name or a term pointer to its map entry + 1, 0 marking a
+// free slot. Entries leave the maps newest first (truncate_maps), so the probe path of an
+// entry only crosses older entries and removing it just clears its slot.
+
+static unsigned long long name_hash(const char* s) {
+    unsigned long long h = 1469598103934665603ULL; // FNV-1a
+    for (; *s; ++s) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static unsigned long long term_hash(const SmtTerm* term) {
+    unsigned long long h = (unsigned long long)(uintptr_t)term * 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 29); // The low bits of an aligned pointer are always zero
+}
+
+// Rebuilds the index with room for count + 1 entries at half load
+static int* index_reserve(int* slots, int* cap, int count, unsigned long long (*hash)(const void*, int), const void* map) {
+    if (2 * (count + 1) <= *cap) return slots;
+    int new_cap = *cap ? *cap : 128;
+    while (2 * (count + 1) > new_cap) new_cap *= 2;
+    slots = (int*)realloc(slots, sizeof(int) * new_cap);
+    memset(slots, 0, sizeof(int) * new_cap);
+    *cap = new_cap;
+    for (int i = 0; i < count; ++i) { // Oldest first, as truncate_maps expects
+        int j = (int)(hash(map, i) & (new_cap - 1));
+        while (slots[j] != 0) j = (j + 1) & (new_cap - 1);
+        slots[j] = i + 1;
+    }
+    return slots;
+}
+
+static void index_remove(int* slots, int cap, unsigned long long h, int idx) {
+    int j = (int)(h & (cap - 1));
+    while (slots[j] != idx + 1) j = (j + 1) & (cap - 1);
+    slots[j] = 0;
+}
+
+static unsigned long long var_entry_hash(const void* map, int i) {
+    return name_hash(((const VarIntervalEntry*)map)[i].name);
+}
+
+static unsigned long long term_entry_hash(const void* map, int i) {
+    return term_hash(((const TermIntervalEntry*)map)[i].term_ptr);
+}
+
+void truncate_maps(SolverContext* ctx, int var_count, int term_count) {
+    for (int i = ctx->var_map_count - 1; i >= var_count; --i) {
+        index_remove(ctx->var_slots, ctx->var_slots_cap, name_hash(ctx->var_map[i].name), i);
+        ctx->var_map[i].active = false;
+    }
+    for (int i = ctx->term_map_count - 1; i >= term_count; --i) {
+        index_remove(ctx->term_slots, ctx->term_slots_cap, term_hash(ctx->term_map[i].term_ptr), i);
+        ctx->term_map[i].active = false;
+    }
+    if (ctx->var_map_count > var_count) ctx->var_map_count = var_count;
+    if (ctx->term_map_count > term_count) ctx->term_map_count = term_count;
+}
+
+// --- Map Access Functions (Growable Arrays) ---
+
+// Get or Add for Variables
+VarIntervalEntry* get_or_add_var_entry(SolverContext* ctx, const char* name) {
+    STAT_ADD(ctx, var_lookups, 1);
+    ctx->var_slots = index_reserve(ctx->var_slots, &ctx->var_slots_cap, ctx->var_map_count, var_entry_hash, ctx->var_map);
+    int mask = ctx->var_slots_cap - 1;
+    int j = (int)(name_hash(name) & mask);
+    for (; ctx->var_slots[j] != 0; j = (j + 1) & mask) {
+        STAT_ADD(ctx, lookup_probes, 1);
+        VarIntervalEntry* entry = &ctx->var_map[ctx->var_slots[j] - 1];
+        if (strcmp(entry->name, name) == 0) return entry;
+    }
+    if (ctx->var_map_count == ctx->var_map_cap) {
+        ctx->var_map_cap = ctx->var_map_cap ? ctx->var_map_cap * 2 : 64;
+        ctx->var_map = (VarIntervalEntry*)realloc(ctx->var_map, sizeof(VarIntervalEntry) * ctx->var_map_cap);
+    }
+    ctx->var_slots[j] = ctx->var_map_count + 1;
+    VarIntervalEntry* new_entry = &ctx->var_map[ctx->var_map_count++];
+    new_entry->name = (char*)name; // Assumes parser manages string lifetime
+    new_entry->interval = INF_INTERVAL;
+    new_entry->active = true;
+    new_entry->term_index = -1;
+    return new_entry;
+}
+
+// Adds an entry for term, which the index does not hold, at index slot j
+static int add_term_entry(SolverContext* ctx, SmtTerm* term, int j) {
+    if (ctx->term_map_count == ctx->term_map_cap) {
+        // Per-entry side tables grow with the map
+        int cap = ctx->term_map_cap ? ctx->term_map_cap * 2 : 256;
+        ctx->term_map = (TermIntervalEntry*)realloc(ctx->term_map, sizeof(TermIntervalEntry) * cap);
+        ctx->dirty = (int*)realloc(ctx->dirty, sizeof(int) * cap);
+        ctx->dirty_flag = (bool*)realloc(ctx->dirty_flag, sizeof(bool) * cap);
+        memset(ctx->dirty_flag + ctx->term_map_cap, 0, sizeof(bool) * (cap - ctx->term_map_cap));
+        cc_reserve(ctx, cap);
+        ctx->term_map_cap = cap;
+    }
+    int idx = ctx->term_map_count++;
+    ctx->term_slots[j] = idx + 1;
+    TermIntervalEntry* new_entry = &ctx->term_map[idx];
+    new_entry->term_ptr = term;
+    if (term->type == SMT_ConstNum) {
+        new_entry->interval = (Interval){term->term.ConstNum, term->term.ConstNum};
+    } else {
+        new_entry->interval = INF_INTERVAL;
+    }
+    new_entry->active = true;
+    new_entry->owner = -1;
+    return idx;
+}
+
+// Index slot of term, or the free slot where it would go
+static int term_slot(SolverContext* ctx, SmtTerm* term) {
+    STAT_ADD(ctx, term_lookups, 1);
+    ctx->term_slots = index_reserve(ctx->term_slots, &ctx->term_slots_cap, ctx->term_map_count, term_entry_hash, ctx->term_map);
+    int mask = ctx->term_slots_cap - 1;
+    int j = (int)(term_hash(term) & mask);
+    for (; ctx->term_slots[j] != 0; j = (j + 1) & mask) {
+        STAT_ADD(ctx, lookup_probes, 1);
+        if (ctx->term_map[ctx->term_slots[j] - 1].term_ptr == term) break;
+    }
+    return j;
+}
+
+// Get or Add for Terms
+int get_or_add_term_index(SolverContext* ctx, SmtTerm* term) {
+    int j = term_slot(ctx, term);
+    if (ctx->term_slots[j] != 0) return ctx->term_slots[j] - 1;
+    if (term->type == SMT_UFTerm) {
+        // An application needs its arguments in the map first, which the collection walk does
+        int idx = ctx->term_map_count;
+        collect_terms_and_vars(ctx, term);
+        return idx;
+    }
+    int idx = add_term_entry(ctx, term, j);
+    cc_register_term(ctx, idx);
+    return idx;
+}
+
+TermIntervalEntry* get_or_add_term_entry(SolverContext* ctx, SmtTerm* term) {
+    if (term == NULL) return NULL;
+    return &ctx->term_map[cc_find(ctx, get_or_add_term_index(ctx, term))];
+}
+
+// --- Term Walks ---
+// Terms nest as deep as the input makes them (a sum of n variables parses into a chain n
+// deep), so the walks keep their pending nodes on ctx->walk instead of the C stack. Each
+// visits the nodes in the order of the recursive definition it replaces, and a walk only
+// touches the frames above those it found, so walks can nest.
+struct TermFrame {
+    SmtTerm* term;
+    int next;                 // Children visited (evaluation), or stage (refinement)
+    TermIntervalEntry* entry; // Slot written when the frame is done
+    Interval saved;           // Interval of entry when the frame was pushed
+    Interval refined;         // Refinement: bounds of t2 implied by the parent and t1
+};
+
+size_t solver_context_bytes(const SolverContext* ctx) {
+    return sizeof(SolverContext) + sizeof(VarIntervalEntry) * (size_t)ctx->var_map_cap
+        + (sizeof(TermIntervalEntry) + sizeof(int) + sizeof(bool)) * (size_t)ctx->term_map_cap
+        + sizeof(int) * ((size_t)ctx->var_slots_cap + ctx->term_slots_cap)
+        + sizeof(TrailEntry) * (size_t)ctx->trail_cap + sizeof(TermFrame) * (size_t)ctx->walk_cap + cc_bytes(ctx);
+}
+
+static TermFrame* walk_push(SolverContext* ctx, SmtTerm* term) {
+    if (ctx->walk_size == ctx->walk_cap) {
+        ctx->walk_cap = ctx->walk_cap ? ctx->walk_cap * 2 : 64;
+        ctx->walk = (TermFrame*)realloc(ctx->walk, sizeof(TermFrame) * ctx->walk_cap);
+    }
+    TermFrame* frame = &ctx->walk[ctx->walk_size++];
+    frame->term = term;
+    frame->next = 0;
+    return frame;
+}
+
+// Drops the frames of a walk that found an empty interval
+static bool walk_abandon(SolverContext* ctx, int base) {
+    ctx->walk_size = base;
+    return true;
+}
+
+// A UF application gets its entry before its arguments, as in pre-order, and a second frame
+// (next = 1) below theirs completes its registration once they are in the map
+void collect_terms_and_vars(SolverContext* ctx, SmtTerm* term) {
+    if (term == NULL) return;
+    int base = ctx->walk_size;
+    walk_push(ctx, term);
+    while (ctx->walk_size > base) {
+        TermFrame frame = ctx->walk[--ctx->walk_size];
+        term = frame.term;
+        int j = term_slot(ctx, term);
+        if (frame.next == 1) {
+            cc_register_application(ctx, ctx->term_slots[j] - 1);
+            continue;
+        }
+        if (ctx->term_slots[j] == 0) {
+            int idx = add_term_entry(ctx, term, j);
+            if (cc_register_term(ctx, idx)) walk_push(ctx, term)->next = 1;
+        }
+        if (term->type == SMT_VarName) {
+            get_or_add_var_entry(ctx, term->term.Variable);
+        }
+        // Pushed last to first so that the children are added left to right
+        for (int i = SmtTerm_arity(term) - 1; i >= 0; --i) {
+            SmtTerm* child = SmtTerm_child(term, i);
+            if (child != NULL) walk_push(ctx, child);
+        }
+    }
+}
+
+void populate_maps_from_proplist(SolverContext* ctx, SmtProplist* list) {
+    init_maps(ctx);
+    for (SmtProplist* current = list; current != NULL; current = current->next) {
+        SmtProp* prop = current->prop;
+        // We are interested in atomic propositions for interval solving
+        if (prop->type == SMTAT_PROP_EQ || prop->type == SMTAT_PROP_LIA) {
+            collect_terms_and_vars(ctx, prop->prop.Atomic_prop.term1);
+            collect_terms_and_vars(ctx, prop->prop.Atomic_prop.term2);
+        }
+        // Extend if other prop types become relevant for interval constraints
+    }
+}
+
+
+// --- Forward Interval Calculation for Expressions f(e1, e2) ---
+Interval calculate_forward_op_interval(SmtTermBop op, Interval i1, Interval i2) {
+    if (is_empty_interval(i1) || is_empty_interval(i2)) return EMPTY_INTERVAL;
+
+    // Handle cases where one operand is fully infinite (can lead to INF_INTERVAL for many ops)
+    bool i1_inf = (i1.lower == LLONG_MIN && i1.upper == LLONG_MAX);
+    bool i2_inf = (i2.lower == LLONG_MIN && i2.upper == LLONG_MAX);
+
+    Interval res = INF_INTERVAL; // Default
+    long long v[4]; // For multiplication/division products
+
+    switch (op) {
+        case LIA_ADD:
+            if (i1.lower == LLONG_MIN || i2.lower == LLONG_MIN) res.lower = LLONG_MIN;
+            else res.lower = safe_add(i1.lower, i2.lower);
+            if (i1.upper == LLONG_MAX || i2.upper == LLONG_MAX) res.upper = LLONG_MAX;
+            else res.upper = safe_add(i1.upper, i2.upper);
+            break;
+        case LIA_MINUS:
+            if (i1.lower == LLONG_MIN || i2.upper == LLONG_MAX) res.lower = LLONG_MIN;
+            else res.lower = safe_subtract(i1.lower, i2.upper);
+            if (i1.upper == LLONG_MAX || i2.lower == LLONG_MIN) res.upper = LLONG_MAX;
+            else res.upper = safe_subtract(i1.upper, i2.lower);
+            break;
+        case LIA_MULT:
+            // bool i1_inf and i2_inf are defined before the switch
+            if ((i1.lower == 0 && i1.upper == 0) || (i2.lower == 0 && i2.upper == 0)) {
+                res = (Interval){0,0};
+                break;
+            }
+
+            // Handling cases where at least one operand is (-inf, +inf)
+    		if (i1_inf && i2_inf) { // (-inf,+inf) * (-inf,+inf)
+        		res = INF_INTERVAL;
+        		break;
+    		}
+    		if (i1_inf) { // i1 is (-inf,+inf), i2 is not [0,0] and not (-inf,+inf)
+        		if (i2.lower > 0 || i2.upper < 0) {
+            		res = INF_INTERVAL; // e.g. [-inf, +inf] * [2,3] -> [-inf, +inf]
+        		} else {
+            		res = INF_INTERVAL; // [-inf, +inf] * [-2,3] is still [-inf, +inf]
+        		}
+        		break;
+    		}
+    		if (i2_inf) { // i2 is (-inf,+inf), i1 is not [0,0] and not (-inf,+inf)
+         		if (i1.lower > 0 || i1.upper < 0) {
+            		res = INF_INTERVAL;
+        		} else {
+            		res = INF_INTERVAL;
+        		}
+        		break;
+    		}
+
+    		// Neither operand is (-inf, +inf) nor [0,0]
+    		v[0] = safe_multiply(i1.lower, i2.lower);
+    		v[1] = safe_multiply(i1.lower, i2.upper);
+    		v[2] = safe_multiply(i1.upper, i2.lower);
+    		v[3] = safe_multiply(i1.upper, i2.upper);
+
+    		res.lower = v[0];
+    		res.upper = v[0];
+    		for (int i = 1; i < 4; ++i) {
+        		if (v[i] < res.lower) res.lower = v[i];
+        		if (v[i] > res.upper) res.upper = v[i];
+    		}
+			break;
+        case LIA_DIV:
+            if (i2.lower == 0 && i2.upper == 0) return EMPTY_INTERVAL; // Division by exactly zero
+            if (i2.lower <= 0 && i2.upper >= 0) return INF_INTERVAL; // Divisor interval contains 0 (but isn't [0,0])
+            if (i1.lower == 0 && i1.upper == 0) return (Interval){0,0}; // 0 / x = 0 (if x!=0)
+            if (i1_inf && !i2_inf) return INF_INTERVAL; // INF / finite_non_zero = INF
+            if (i1_inf && i2_inf) return INF_INTERVAL; // INF/INF indeterminate, for intervals often wide
+
+            // Assuming i2 does not contain 0 and is not [0,0]
+            v[0] = safe_divide(i1.lower, i2.lower); v[1] = safe_divide(i1.lower, i2.upper);
+            v[2] = safe_divide(i1.upper, i2.lower); v[3] = safe_divide(i1.upper, i2.upper);
+            res.lower = v[0]; res.upper = v[0];
+            for (int i = 1; i < 4; ++i) { // Min/max of the four resulting points
+                if (v[i] < res.lower) res.lower = v[i];
+                if (v[i] > res.upper) res.upper = v[i];
+            }
+            break;
+        case LIA_LSHIFT:
+        case LIA_RSHIFT:
+            if (i2.lower != i2.upper || i2.lower < 0 || i2.lower >= 63) { // Treat as complex/undefined if shift is not a small positive constant
+                return (i1_inf || i2_inf) ? INF_INTERVAL : EMPTY_INTERVAL; // Or wide interval
+            }
+            long long shift_val = i2.lower;
+            if (i1_inf) return INF_INTERVAL; // Shifting full infinity results in full infinity
+
+            if (op == LIA_LSHIFT) {
+                // Check for overflow before shifting
+                if (i1.lower > (LLONG_MIN >> shift_val) && i1.lower < (LLONG_MAX >> shift_val)) res.lower = i1.lower << shift_val; else res.lower = (i1.lower > 0) ? LLONG_MAX : LLONG_MIN;
+                if (i1.upper > (LLONG_MIN >> shift_val) && i1.upper < (LLONG_MAX >> shift_val)) res.upper = i1.upper << shift_val; else res.upper = (i1.upper > 0) ? LLONG_MAX : LLONG_MIN;
+                 if (i1.lower > 0 && (LLONG_MAX >> shift_val) < i1.lower ) res.lower = LLONG_MAX;
+                 if (i1.upper > 0 && (LLONG_MAX >> shift_val) < i1.upper ) res.upper = LLONG_MAX;
+            } else { // LIA_RSHIFT
+                res.lower = i1.lower >> shift_val;
+                res.upper = i1.upper >> shift_val;
+            }
+            break;
+        default:
+            return INF_INTERVAL;
+    }
+    if (res.lower > res.upper && !(res.lower == 1 && res.upper ==0)) return EMPTY_INTERVAL;
+    return res;
+}
+
+void calculate_backward_op_intervals(SmtTermBop op, Interval parent, Interval i1, Interval i2, Interval* r1, Interval* r2) {
+    *r1 = INF_INTERVAL;
+    *r2 = INF_INTERVAL;
+    // Example: parent = t1 + t2  => t1 = parent - t2, t2 = parent - t1
+    if (op == LIA_ADD) {
+        *r1 = calculate_forward_op_interval(LIA_MINUS, parent, i2);
+        *r2 = calculate_forward_op_interval(LIA_MINUS, parent, i1);
+    } else if (op == LIA_MINUS) { // parent = t1 - t2 => t1 = parent + t2, t2 = t1 - parent
+        *r1 = calculate_forward_op_interval(LIA_ADD, parent, i2);
+        *r2 = calculate_forward_op_interval(LIA_MINUS, i1, parent);
+    }
+    // TODO: Add backward rules for MULT, DIV, SHIFT (these are more complex)
+    // For MULT: If parent = t1 * t2, then t1 = parent / t2. Division rules apply.
+    // For DIV: If parent = t1 / t2, then t1 = parent * t2.
+}
+
+// The infinities swap; a bound saturated at LLONG_MIN has no negation, so it goes to LLONG_MAX
+static long long negate_bound(long long b) {
+    if (b == LLONG_MIN) return LLONG_MAX;
+    if (b == LLONG_MAX) return LLONG_MIN;
+    return -b;
+}
+
+Interval negate_interval(Interval i) {
+    Interval res;
+    res.lower = negate_bound(i.upper);
+    res.upper = negate_bound(i.lower);
+    return res;
+}
+
+// --- Evaluation & Refinement ---
+
+// Interval of term computed from its children, which have been evaluated
+static Interval forward_interval(SolverContext* ctx, SmtTerm* term) {
+    Interval computed_interval = INF_INTERVAL;
+    switch (term->type) {
+        case SMT_ConstNum:
+            computed_interval = (Interval){term->term.ConstNum, term->term.ConstNum};
+            break;
+        case SMT_VarName: {
+            VarIntervalEntry* var_entry = get_or_add_var_entry(ctx, term->term.Variable);
+            computed_interval = var_entry->interval; // A variable's interval is taken directly
+            break;
+        }
+        case SMT_LiaUTerm: {
+            TermIntervalEntry* child_u_entry = get_or_add_term_entry(ctx, term->term.UTerm.t);
+            if (term->term.UTerm.op == LIA_NEG) {
+                Interval child_i = child_u_entry->interval;
+                computed_interval = is_empty_interval(child_i) ? EMPTY_INTERVAL : negate_interval(child_i);
+            } else { // Unknown Unary Op
+                computed_interval = INF_INTERVAL;
+            }
+            break;
+        }
+        case SMT_LiaBTerm:
+        case SMT_NiaBTerm: { // NiaBTerm covers MULT, DIV, SHIFT here as per problem description on f(e1,e2)
+            TermIntervalEntry* t1_entry = get_or_add_term_entry(ctx, term->term.BTerm.t1);
+            TermIntervalEntry* t2_entry = get_or_add_term_entry(ctx, term->term.BTerm.t2);
+            computed_interval = calculate_forward_op_interval(term->term.BTerm.op, t1_entry->interval, t2_entry->interval);
+            break;
+        }
+        case SMT_UFTerm: // Uninterpreted functions - no interpretation, bounds come from the shared congruence class slot
+        default: // SMT_VarNum etc.
+            computed_interval = INF_INTERVAL;
+    }
+    return computed_interval;
+}
+
+// Re-evaluates term alone: the refinement below it has already re-evaluated its children
+static bool reevaluate_term(SolverContext* ctx, SmtTerm* term, bool* changed_overall) {
+    TermIntervalEntry* entry = get_or_add_term_entry(ctx, term);
+    Interval current = entry->interval;
+    Interval final_new_interval = intersect_intervals(current, forward_interval(ctx, term));
+    if (is_empty_interval(final_new_interval)) { set_term_interval(ctx, entry, EMPTY_INTERVAL); *changed_overall = true; return true; }
+    if (!interval_equals(current, final_new_interval)) { set_term_interval(ctx, entry, final_new_interval); *changed_overall = true; }
+    return false;
+}
+
+// Backward propagation: term_val = t1 op t2. Refine t1 and t2, each followed by its own
+// subterms and a re-evaluation. Stage 0 narrows t1 and keeps t2's bounds for stage 1,
+// which narrows t2 once t1's subterms are done; stage 2 re-evaluates t2. A child is
+// re-evaluated from the intervals its own frame left on its children, so every node of
+// the term is visited a constant number of times.
+bool refine_children_intervals(SolverContext* ctx, SmtTerm* term, bool* changed_overall) {
+    if (term == NULL) return false;
+    int base = ctx->walk_size;
+    walk_push(ctx, term);
+    while (ctx->walk_size > base) {
+        int top = ctx->walk_size - 1;
+        TermFrame* frame = &ctx->walk[top];
+        term = frame->term;
+        SmtTerm* next = NULL; // Child to refine before this frame resumes
+
+        if (frame->next == 0) {
+            TermIntervalEntry* parent_entry = term ? get_or_add_term_entry(ctx, term) : NULL;
+            Interval parent_interval = parent_entry ? parent_entry->interval : EMPTY_INTERVAL;
+            if (is_empty_interval(parent_interval)) { ctx->walk_size--; continue; } // Cannot refine from empty
+
+            if (term->type == SMT_LiaBTerm || term->type == SMT_NiaBTerm) {
+                SmtTerm* t1 = term->term.BTerm.t1;
+                SmtTerm* t2 = term->term.BTerm.t2;
+                SmtTermBop op = term->term.BTerm.op;
+
+                TermIntervalEntry* t1_entry = get_or_add_term_entry(ctx, t1);
+                TermIntervalEntry* t2_entry = get_or_add_term_entry(ctx, t2);
+                Interval i1_current = t1_entry->interval;
+                Interval i2_current = t2_entry->interval;
+
+                Interval i1_refined_by_t2, i2_refined_by_t1;
+                calculate_backward_op_intervals(op, parent_interval, i1_current, i2_current, &i1_refined_by_t2, &i2_refined_by_t1);
+
+                Interval final_i1 = intersect_intervals(i1_current, i1_refined_by_t2);
+                if (is_empty_interval(final_i1)) { set_term_interval(ctx, t1_entry, EMPTY_INTERVAL); *changed_overall = true; return walk_abandon(ctx, base); }
+                if (!interval_equals(i1_current, final_i1)) { set_term_interval(ctx, t1_entry, final_i1); *changed_overall = true; }
+                frame->entry = t2_entry;
+                frame->saved = i2_current;
+                frame->refined = i2_refined_by_t1;
+                next = t1;
+
+            } else if (term->type == SMT_LiaUTerm) {
+                SmtTerm* child_u = term->term.UTerm.t;
+                TermIntervalEntry* child_u_entry = get_or_add_term_entry(ctx, child_u);
+                Interval child_u_current = child_u_entry->interval;
+                Interval child_u_refined = INF_INTERVAL;
+                if (term->term.UTerm.op == LIA_NEG) child_u_refined = negate_interval(parent_interval); // parent = -child => child = -parent
+                Interval final_child_u = intersect_intervals(child_u_current, child_u_refined);
+                if (is_empty_interval(final_child_u)) { set_term_interval(ctx, child_u_entry, EMPTY_INTERVAL); *changed_overall = true; return walk_abandon(ctx, base); }
+                if (!interval_equals(child_u_current, final_child_u)) { set_term_interval(ctx, child_u_entry, final_child_u); *changed_overall = true;}
+                next = child_u;
+
+            } else if (term->type == SMT_VarName) { // If a term is a variable, its interval is directly updated by map_update_var_interval
+                VarIntervalEntry* var_entry = get_or_add_var_entry(ctx, term->term.Variable);
+                Interval old_var_interval = var_entry->interval;
+                Interval new_var_interval = intersect_intervals(old_var_interval, parent_interval); // parent_interval is I(term)
+                if(is_empty_interval(new_var_interval)) { set_var_interval(ctx, var_entry, EMPTY_INTERVAL); *changed_overall = true; return walk_abandon(ctx, base); }
+                if(!interval_equals(old_var_interval, new_var_interval)) { set_var_interval(ctx, var_entry, new_var_interval); *changed_overall = true; }
+            }
+            if (next == NULL) { ctx->walk_size--; continue; }
+            frame->next = 1;
+
+        } else if (frame->next == 1) {
+            // Re-evaluate the first child if its children changed
+            SmtTerm* done = term->type == SMT_LiaUTerm ? term->term.UTerm.t : term->term.BTerm.t1;
+            if (reevaluate_term(ctx, done, changed_overall)) return walk_abandon(ctx, base);
+            if (term->type == SMT_LiaUTerm) { ctx->walk_size--; continue; }
+
+            Interval final_i2 = intersect_intervals(frame->saved, frame->refined);
+            if (is_empty_interval(final_i2)) { set_term_interval(ctx, frame->entry, EMPTY_INTERVAL); *changed_overall = true; return walk_abandon(ctx, base); }
+            if (!interval_equals(frame->saved, final_i2)) { set_term_interval(ctx, frame->entry, final_i2); *changed_overall = true; }
+            next = term->term.BTerm.t2;
+            frame->next = 2;
+
+        } else {
+            if (reevaluate_term(ctx, term->term.BTerm.t2, changed_overall)) return walk_abandon(ctx, base);
+            ctx->walk_size--;
+            continue;
+        }
+        walk_push(ctx, next);
+    }
+    return false; // No empty interval found in this path
+}
+
+// Pushes term for evaluation, keeping its slot and interval as they are before its children are evaluated
+static void eval_push(SolverContext* ctx, SmtTerm* term) {
+    TermIntervalEntry* entry = get_or_add_term_entry(ctx, term);
+    TermFrame* frame = walk_push(ctx, term);
+    frame->entry = entry;
+    frame->saved = entry->interval;
+}
+
+// Forward evaluation, children first
+bool eval_and_update_term_interval(SolverContext* ctx, SmtTerm* term, bool* changed_overall) {
+    if (term == NULL) return false;
+    int base = ctx->walk_size;
+    eval_push(ctx, term);
+    while (ctx->walk_size > base) {
+        TermFrame* frame = &ctx->walk[ctx->walk_size - 1];
+        if (frame->next < SmtTerm_arity(frame->term)) {
+            SmtTerm* child = SmtTerm_child(frame->term, frame->next++);
+            if (child != NULL) eval_push(ctx, child);
+            continue;
+        }
+
+        Interval final_new_interval = intersect_intervals(frame->saved, forward_interval(ctx, frame->term));
+        if (is_empty_interval(final_new_interval)) {
+            set_term_interval(ctx, frame->entry, EMPTY_INTERVAL);
+            *changed_overall = true; // Emptiness is a change
+            return walk_abandon(ctx, base); // Empty interval detected for this term
+        }
+        if (!interval_equals(frame->saved, final_new_interval)) {
+            *changed_overall = true;
+        }
+        set_term_interval(ctx, frame->entry, final_new_interval);
+        ctx->walk_size--;
+    }
+    return false; // Not empty at this node
+}
+
+
+// --- Relational Constraints ---
+
+bool is_interval_atom(SmtProp* prop) {
+    return prop->type == SMTAT_PROP_EQ || prop->type == SMTAT_PROP_LIA;
+}
+
+AtomConstraint make_atom_constraint(SmtProp* atom, bool polarity) {
+    AtomConstraint c;
+    c.term1 = atom->prop.Atomic_prop.term1;
+    c.term2 = atom->prop.Atomic_prop.term2;
+    c.op = atom->prop.Atomic_prop.op;
+    c.distinct = false;
+    if (!polarity) { // NOT (t1 op t2) flips the relation
+        switch (c.op) {
+            case SMT_LT: c.op = SMT_GE; break;
+            case SMT_LE: c.op = SMT_GT; break;
+            case SMT_GT: c.op = SMT_LE; break;
+            case SMT_GE: c.op = SMT_LT; break;
+            case SMT_EQ: c.distinct = true; break;
+            default: break;
+        }
+    }
+    return c;
+}
+
+// t1 != t2 can only remove a fixed value sitting exactly on the other side's bound
+static Interval exclude_value(Interval i, Interval fixed) {
+    if (fixed.lower != fixed.upper) return i;
+    if (i.lower == fixed.lower) {
+        if (i.lower == LLONG_MAX) return EMPTY_INTERVAL;
+        i.lower++;
+    } else if (i.upper == fixed.lower) {
+        if (i.upper == LLONG_MIN) return EMPTY_INTERVAL;
+        i.upper--;
+    }
+    if (i.lower > i.upper) return EMPTY_INTERVAL;
+    return i;
+}
+
+void relate_intervals(SmtBinPred op, bool distinct, Interval i1_current, Interval i2_current, Interval* out1, Interval* out2) {
+    Interval i1_after_relation = i1_current;
+    Interval i2_after_relation = i2_current;
+
+    if (distinct) {
+        i1_after_relation = exclude_value(i1_current, i2_current);
+        i2_after_relation = exclude_value(i2_current, i1_current);
+    } else switch (op) {
+        case SMT_EQ:
+            Interval common = intersect_intervals(i1_current, i2_current);
+            i1_after_relation = common;
+            i2_after_relation = common;
+            break;
+        case SMT_LT: // t1 < t2  => t1.upper <= t2.upper-1, t2.lower >= t1.lower+1
+            if (i2_current.upper != LLONG_MAX) i1_after_relation.upper = (i1_after_relation.upper < safe_subtract(i2_current.upper, 1)) ? i1_after_relation.upper : safe_subtract(i2_current.upper, 1);
+            if (i1_current.lower != LLONG_MIN) i2_after_relation.lower = (i2_after_relation.lower > safe_add(i1_current.lower, 1)) ? i2_after_relation.lower : safe_add(i1_current.lower, 1);
+            break;
+        case SMT_LE: // t1 <= t2 => t1.upper <= t2.upper, t2.lower >= t1.lower
+            if (i2_current.upper != LLONG_MAX) i1_after_relation.upper = (i1_after_relation.upper < i2_current.upper) ? i1_after_relation.upper : i2_current.upper;
+            if (i1_current.lower != LLONG_MIN) i2_after_relation.lower = (i2_after_relation.lower > i1_current.lower) ? i2_after_relation.lower : i1_current.lower;
+            break;
+        case SMT_GT: // t1 > t2 (equiv. t2 < t1)
+            if (i1_current.upper != LLONG_MAX) i2_after_relation.upper = (i2_after_relation.upper < safe_subtract(i1_current.upper, 1)) ? i2_after_relation.upper : safe_subtract(i1_current.upper, 1);
+            if (i2_current.lower != LLONG_MIN) i1_after_relation.lower = (i1_after_relation.lower > safe_add(i2_current.lower, 1)) ? i1_after_relation.lower : safe_add(i2_current.lower, 1);
+            break;
+        case SMT_GE: // t1 >= t2 (equiv. t2 <= t1)
+            if (i1_current.upper != LLONG_MAX) i2_after_relation.upper = (i2_after_relation.upper < i1_current.upper) ? i2_after_relation.upper : i1_current.upper;
+            if (i2_current.lower != LLONG_MIN) i1_after_relation.lower = (i1_after_relation.lower > i2_current.lower) ? i1_after_relation.lower : i2_current.lower;
+            break;
+        default: break;
+    }
+
+    i1_after_relation = intersect_intervals(i1_current, i1_after_relation); // Ensure it only narrows
+    i2_after_relation = intersect_intervals(i2_current, i2_after_relation); // Ensure it only narrows
+    *out1 = i1_after_relation;
+    *out2 = i2_after_relation;
+}
+
+// Constraint visited k-th in a round, following the strategy's order
+static inline int constraint_at(const SolverContext* ctx, const int* ids, int n, int k) {
+    if (ctx->strategy.reverse_order) k = n - 1 - k;
+    return ids ? ids[k] : k;
+}
+
+// Revisions between two budget and stop checks inside a phase, so that one long round cannot
+// run far past the deadline or a cancellation; the check itself is an atomic add and a clock read
+#define BUDGET_POLL 64
+
+// Charges revision k of a phase, every BUDGET_POLL of them at once, and checks the stop flags
+// then; true once the solve should end
+static inline bool budget_poll(SolverContext* ctx, int k) {
+    if ((k + 1) % BUDGET_POLL != 0) return false;
+    return solver_stopped(ctx) || (ctx->budget != NULL && budget_charge(ctx, BUDGET_POLL, 0));
+}
+
+// Charges the revisions of an n-constraint phase that budget_poll has not
+static inline void budget_settle(SolverContext* ctx, int n) {
+    if (ctx->budget != NULL) budget_charge(ctx, n % BUDGET_POLL, 0);
+}
+
+// Phase 1: Forward evaluation for all terms involved in propositions
+static int forward_phase(SolverContext* ctx, const AtomConstraint* cons, const int* ids, int n, bool* changed_overall) {
+    for (int k = 0; k < n; ++k) {
+        int c = constraint_at(ctx, ids, n, k);
+        long mark = STAT_REVISION(ctx);
+        NLOG_CONSTRAINT(ctx, c);
+        if (eval_and_update_term_interval(ctx, cons[c].term1, changed_overall)) return 1;
+        if (eval_and_update_term_interval(ctx, cons[c].term2, changed_overall)) return 1;
+        STAT_NOOP(ctx, mark);
+        if (budget_poll(ctx, k)) return 0;
+    }
+    budget_settle(ctx, n);
+    return 0;
+}
+
+// Phase 2: Apply relational constraints from propositions
+static int relation_phase(SolverContext* ctx, const AtomConstraint* cons, const int* ids, int n, bool* changed_overall) {
+    for (int k = 0; k < n; ++k) {
+        int c = constraint_at(ctx, ids, n, k);
+        long mark = STAT_REVISION(ctx);
+        NLOG_CONSTRAINT(ctx, c);
+        SmtTerm* t1_term = cons[c].term1;
+        SmtTerm* t2_term = cons[c].term2;
+        SmtBinPred rel_op = cons[c].op;
+
+        int t1_index = get_or_add_term_index(ctx, t1_term);
+        int t2_index = get_or_add_term_index(ctx, t2_term);
+        if (cons[c].distinct) {
+            if (cc_find(ctx, t1_index) == cc_find(ctx, t2_index)) return 1; // t1 != t2 but they are congruent
+        } else if (rel_op == SMT_EQ) {
+            if (cc_merge(ctx, t1_index, t2_index, changed_overall)) return 1;
+        }
+
+        TermIntervalEntry* t1_entry = &ctx->term_map[cc_find(ctx, t1_index)];
+        TermIntervalEntry* t2_entry = &ctx->term_map[cc_find(ctx, t2_index)];
+
+        Interval i1_current = t1_entry->interval;
+        Interval i2_current = t2_entry->interval;
+
+        Interval i1_after_relation, i2_after_relation;
+        relate_intervals(rel_op, cons[c].distinct, i1_current, i2_current, &i1_after_relation, &i2_after_relation);
+
+        if (is_empty_interval(i1_after_relation)) { set_term_interval(ctx, t1_entry, EMPTY_INTERVAL); *changed_overall = true; return 1; }
+        if (!interval_equals(i1_current, i1_after_relation)) { set_term_interval(ctx, t1_entry, i1_after_relation); *changed_overall = true; }
+
+        if (is_empty_interval(i2_after_relation)) { set_term_interval(ctx, t2_entry, EMPTY_INTERVAL); *changed_overall = true; return 1; }
+        if (!interval_equals(i2_current, i2_after_relation)) { set_term_interval(ctx, t2_entry, i2_after_relation); *changed_overall = true; }
+        STAT_NOOP(ctx, mark);
+        if (budget_poll(ctx, k)) return 0;
+    }
+    budget_settle(ctx, n);
+    return 0;
+}
+
+// Phase 3: Backward propagation from terms to their children/variables
+static int backward_phase(SolverContext* ctx, const AtomConstraint* cons, const int* ids, int n, bool* changed_overall) {
+    for (int k = 0; k < n; ++k) {
+        int c = constraint_at(ctx, ids, n, k);
+        long mark = STAT_REVISION(ctx);
+        NLOG_CONSTRAINT(ctx, c);
+        if (refine_children_intervals(ctx, cons[c].term1, changed_overall)) return 1;
+        if (refine_children_intervals(ctx, cons[c].term2, changed_overall)) return 1;
+        STAT_NOOP(ctx, mark);
+        if (budget_poll(ctx, k)) return 0;
+    }
+    budget_settle(ctx, n);
+
+    // After backward propagation, variables might have changed, which could affect terms containing them.
+    // So, one more forward pass can be beneficial or simply rely on the next full iteration.
+    // For simplicity, the next iteration's Phase 1 will handle this.
+    return 0;
+}
+
+typedef int (*PhaseFn)(SolverContext* ctx, const AtomConstraint* cons, const int* ids, int n, bool* changed_overall);
+
+// Runs one phase, timed and with its narrowings attributed to it when statistics or the narrowing log are on
+static inline int run_phase(SolverContext* ctx, SolverPhase phase, PhaseFn fn, const AtomConstraint* cons, const int* ids, int n, bool* changed_overall) {
+    if (!STATS_ON(ctx) && !NLOG_ON(ctx)) return fn(ctx, cons, ids, n, changed_overall);
+    SolverStats* s = STATS_ON(ctx) ? ctx->stats : NULL;
+    if (NLOG_ON(ctx)) narrow_log_set_phase(ctx->narrow_log, phase);
+    long long start = s ? stats_now_ns() : 0;
+    if (s) s->phase = phase;
+    int res = fn(ctx, cons, ids, n, changed_overall);
+    if (s) {
+        s->phase = PHASE_OTHER;
+        s->phase_ns[phase] += stats_now_ns() - start;
+        if (res) s->empties++;
+    }
+    if (NLOG_ON(ctx)) narrow_log_set_phase(ctx->narrow_log, PHASE_OTHER);
+    return res;
+}
+
+// 1 if an empty interval was found, -1 if the budget is exhausted or the solve stopped. A phase
+// stops early then and the rest of the round is skipped, which leaves work behind and so counts
+// as a change.
+static inline int run_budgeted_phase(SolverContext* ctx, SolverPhase phase, PhaseFn fn, const AtomConstraint* cons, const int* ids, int n, bool* changed_overall) {
+    if (run_phase(ctx, phase, fn, cons, ids, n, changed_overall)) return 1;
+    if (budget_exhausted(ctx) == BUDGET_NONE && !solver_stopped(ctx)) return 0;
+    *changed_overall = true;
+    return -1;
+}
+
+int propagate_round(SolverContext* ctx, const AtomConstraint* cons, const int* ids, int n, bool* changed_overall) {
+    ctx->rounds++;
+    int res;
+    if (ctx->strategy.phase_order == PHASES_RELATION_FIRST) {
+        // Narrow with the relations and push the result down before re-evaluating terms
+        if ((res = run_budgeted_phase(ctx, PHASE_RELATION, relation_phase, cons, ids, n, changed_overall))) return res > 0;
+        if ((res = run_budgeted_phase(ctx, PHASE_BACKWARD, backward_phase, cons, ids, n, changed_overall))) return res > 0;
+        if ((res = run_budgeted_phase(ctx, PHASE_FORWARD, forward_phase, cons, ids, n, changed_overall))) return res > 0;
+    } else {
+        if ((res = run_budgeted_phase(ctx, PHASE_FORWARD, forward_phase, cons, ids, n, changed_overall))) return res > 0;
+        if ((res = run_budgeted_phase(ctx, PHASE_RELATION, relation_phase, cons, ids, n, changed_overall))) return res > 0;
+        if ((res = run_budgeted_phase(ctx, PHASE_BACKWARD, backward_phase, cons, ids, n, changed_overall))) return res > 0;
+    }
+
+    // Terms fixed to the same value are equal, which may make UF applications congruent
+    if (cc_has_uf(ctx) && cc_merge_equal_singletons(ctx, changed_overall)) {
+        STAT_ADD(ctx, empties, 1);
+        return 1;
+    }
+    return 0;
+}
+
+static int fixpoint_loop(SolverContext* ctx, const AtomConstraint* cons, int count) {
+    bool changed_in_iteration;
+    int iterations = 0;
+    const int MAX_ITERATIONS = strategy_iteration_limit(ctx); // Heuristic limit, at most #vars * range_size updates
+
+    do {
+        changed_in_iteration = false;
+        iterations++;
+
+        if (propagate_round(ctx, cons, NULL, count, &changed_in_iteration)) return 1;
+        if (solver_stopped(ctx)) return 0;
+
+        if (iterations >= MAX_ITERATIONS) {
+            fprintf(stderr, "Warning: Max iterations reached, potential non-convergence or slow convergence.\n");
+            ctx->truncated = true;
+            break;
+        }
+        // Out of budget with work left: the intervals so far still enclose every solution
+        if (budget_exhausted(ctx) && changed_in_iteration) {
+            ctx->truncated = true;
+            break;
+        }
+
+    } while (changed_in_iteration);
+
+    // One final check on all known variables and terms
+    for(int i=0; i < ctx->var_map_count; ++i) if(ctx->var_map[i].active && is_empty_interval(ctx->var_map[i].interval)) return 1;
+    for(int i=0; i < ctx->term_map_count; ++i) if(ctx->term_map[i].active && cc_find(ctx, i) == i && is_empty_interval(ctx->term_map[i].interval)) return 1;
+
+    return 0; // No empty interval found
+}
+
+int propagate_to_fixpoint(SolverContext* ctx, const AtomConstraint* cons, int count) {
+    if (!NLOG_ON(ctx)) return fixpoint_loop(ctx, cons, count);
+    narrow_log_begin_run(ctx->narrow_log);
+    int res = fixpoint_loop(ctx, cons, count);
+    narrow_log_end_run(ctx->narrow_log, ctx, cons, count, NULL);
+    return res;
+}
+
+int check_constraints(SolverContext* ctx, const AtomConstraint* cons, int count) {
+    init_maps(ctx);
+    for (int c = 0; c < count; ++c) {
+        collect_terms_and_vars(ctx, cons[c].term1);
+        collect_terms_and_vars(ctx, cons[c].term2);
+    }
+    return propagate_to_fixpoint(ctx, cons, count);
+}
+
+
+// --- Main interval_solver Function ---
+int interval_solver(SolverContext* ctx) {
+    SmtProplist* list = ctx->props;
+    if (list == NULL) return 0; // No propositions, no conflict.
+
+    // Boolean structure (AND/OR/IMPLY/IFF/NOT/TT/FF) is searched by the CDCL(T) engine,
+    // which calls back into the propagation above as its theory solver.
+    int count = 0;
+    for (SmtProplist* current = list; current != NULL; current = current->next) {
+        if (!is_interval_atom(current->prop)) return cdcl_solve(ctx, list);
+        count++;
+    }
+
+    populate_maps_from_proplist(ctx, list);
+
+    AtomConstraint* cons = (AtomConstraint*)malloc(sizeof(AtomConstraint) * count);
+    int c = 0;
+    for (SmtProplist* current = list; current != NULL; current = current->next) {
+        cons[c++] = make_atom_constraint(current->prop, true);
+    }
+    // Unrelated subsystems are solved apart, so a slow one does not keep the others sweeping
+    int* comp = (int*)malloc(sizeof(int) * count);
+    int num_comps = split_components(ctx, cons, count, comp);
+    int res = num_comps > 1 ? solve_components(ctx, cons, count, comp, num_comps) : propagate_to_fixpoint(ctx, cons, count);
+    free(comp);
+    free(cons);
+    return res;
+}
@@ -0,0 +1,214 @@
+#ifndef INTERVAL_SOLVER_H
+#define INTERVAL_SOLVER_H 1
+#include "smt_lang.h"
+#include <limits.h> // For LLONG_MIN, LLONG_MAX
+#include <stdatomic.h>
+
+// --- Interval Structure ---
+typedef struct {
+    long long lower;
+    long long upper;
+} Interval;
+
+// Global constants for intervals
+extern const Interval INF_INTERVAL;
+extern const Interval EMPTY_INTERVAL; // Canonical empty: lower > upper
+
+// --- Map Structures (Simplified Array-Based) ---
+// For SMT_VarName -> Interval mapping
+typedef struct {
+    char* name;
+    Interval interval;
+    bool active; // Indicates if this slot is used
+    int term_index; // First term map entry for this variable, -1 if none yet
+} VarIntervalEntry;
+
+// For SmtTerm* -> Interval mapping
+typedef struct {
+    SmtTerm* term_ptr;
+    Interval interval; // Only meaningful on a class representative
+    bool active; // Indicates if this slot is used
+    int parent;  // Congruence class link, the entry's own index for a representative
+    int owner;   // Index of the constraint that introduced the term, -1 if none
+} TermIntervalEntry;
+
+
+// --- Relational Constraints ---
+// One relation `term1 op term2` as seen by the propagation engine.
+// `distinct` marks a negated equality (term1 != term2); `op` is then SMT_EQ.
+typedef struct {
+    SmtTerm* term1;
+    SmtTerm* term2;
+    SmtBinPred op;
+    bool distinct;
+} AtomConstraint;
+
+// --- Undo Trail ---
+// While a scope is open (scope_depth > 0) every write to an interval or to the
+// congruence structures is recorded, so that a pop restores the state in time
+// proportional to the writes undone.
+typedef enum {
+    TRAIL_VAR_INTERVAL,
+    TRAIL_TERM_INTERVAL,
+    TRAIL_VAR_TERM_INDEX,
+    TRAIL_TERM_PARENT,
+    TRAIL_CC_SIZE,
+    TRAIL_USE_HEAD,
+    TRAIL_USE_TAIL,
+    TRAIL_USE_NEXT,
+    TRAIL_CLASS_NEXT,
+    TRAIL_CLASS_TAIL
+} TrailKind;
+
+typedef struct {
+    TrailKind kind;
+    int idx;
+    Interval old_interval; // For the interval kinds
+    int old_value;         // For the others
+} TrailEntry;
+
+// --- Solver Strategy ---
+// Knobs that change how propagation proceeds but not what it can prove. The zero value is
+// the default strategy; portfolio mode (see portfolio.h) races differently configured ones.
+typedef enum {
+    PHASES_FORWARD_FIRST,  // Forward evaluation, relations, backward refinement
+    PHASES_RELATION_FIRST  // Relations, backward refinement, forward evaluation
+} PhaseOrder;
+
+typedef struct {
+    bool reverse_order;     // Visit the constraints last to first
+    PhaseOrder phase_order;
+    int iteration_scale;    // Multiplies the propagation iteration limit, 0 or 1 for the default
+} SolverStrategy;
+
+// --- Solver Context ---
+// All state of one problem. Contexts share nothing, so separate contexts can be
+// solved concurrently from different threads without locking.
+typedef struct CcState CcState;   // Congruence closure, see congruence.h
+typedef struct IncState IncState; // Incremental solving, see incremental.h
+typedef struct SolverStats SolverStats; // Counters and phase timers, see stats.h
+typedef struct NarrowLog NarrowLog;     // Record of interval writes, see narrowlog.h
+typedef struct TermFrame TermFrame;     // Pending work of a term walk, see interval_solver.c
+typedef struct SolverBudget SolverBudget; // Time, propagation and memory limits, see budget.h
+
+typedef struct SolverContext {
+    SmtProplist* props; // The problem, freed with the context
+
+    // Maps grow on demand. Entries are only added while terms are collected, so
+    // pointers into the maps stay valid during propagation.
+    VarIntervalEntry* var_map;
+    int var_map_count;
+    int var_map_cap;
+    TermIntervalEntry* term_map;
+    int term_map_count;
+    int term_map_cap;
+    // Hash indexes into the maps, by variable name and by term pointer (see interval_solver.c)
+    int* var_slots;
+    int var_slots_cap;
+    int* term_slots;
+    int term_slots_cap;
+
+    int scope_depth;
+    TrailEntry* trail;
+    int trail_size;
+    int trail_cap;
+
+    // Classes whose interval moved since the last take_dirty_classes, recorded only while tracking is on
+    bool dirty_tracking;
+    int* dirty;
+    bool* dirty_flag;
+    int dirty_count;
+
+    CcState* cc;
+    IncState* inc;
+
+    // Workers for independent components (see components.h): 0 = one per core, 1 = in turn
+    int threads;
+    // Raised by another thread to abandon this solve, whose result is then meaningless; NULL if none
+    atomic_bool* stop;
+    // Solve this one is part of (as a component or a portfolio instance), whose stop flags apply too; NULL if none
+    const struct SolverContext* stop_parent;
+    // Limits of the solve, shared with its component and portfolio sub-contexts; NULL if unbounded
+    SolverBudget* budget;
+
+    SolverStrategy strategy;
+    // Some propagation gave up at the iteration limit, so a consistent result is not definitive
+    bool truncated;
+    // Propagation rounds run, including those of component and portfolio sub-contexts
+    long rounds;
+    // Collected only when not NULL, including the work of component and portfolio sub-contexts
+    SolverStats* stats;
+    // Every interval write is recorded here when not NULL; owned by the caller
+    NarrowLog* narrow_log;
+    // Explicit stack of the term walks, kept between them so that propagation does not allocate
+    TermFrame* walk;
+    int walk_size;
+    int walk_cap;
+} SolverContext;
+
+SolverContext* solver_context_new(void);
+// Frees the context and the proplist it holds
+void solver_context_free(SolverContext* ctx);
+// Frees the proplist and empties the context for the next problem, keeping the capacity of its maps
+void solver_context_reset(SolverContext* ctx);
+// Bytes held by the context's maps, trail, walk stack and congruence tables
+size_t solver_context_bytes(const SolverContext* ctx);
+
+void trail_int(SolverContext* ctx, TrailKind kind, int idx, int old_value);
+void undo_trail(SolverContext* ctx, int size);
+// All interval writes go through these so that they can be undone and observed
+void set_term_interval(SolverContext* ctx, TermIntervalEntry* entry, Interval iv);
+void set_var_interval(SolverContext* ctx, VarIntervalEntry* entry, Interval iv);
+// Whether the stop flag of ctx or of a solve it is part of has been raised
+bool solver_stopped(const SolverContext* ctx);
+void mark_class_dirty(SolverContext* ctx, int root);
+int take_dirty_classes(SolverContext* ctx, int** roots);
+
+// --- Helper Functions for Intervals & Maps ---
+long long safe_multiply(long long a, long long b);
+long long safe_add(long long a, long long b);
+long long safe_subtract(long long a, long long b);
+long long safe_divide(long long a, long long b);
+void init_maps(SolverContext* ctx);
+// Drops the newest map entries, keeping the first var_count variables and term_count terms
+void truncate_maps(SolverContext* ctx, int var_count, int term_count);
+Interval intersect_intervals(Interval i1, Interval i2);
+bool is_empty_interval(Interval i);
+bool interval_equals(Interval i1, Interval i2);
+VarIntervalEntry* get_or_add_var_entry(SolverContext* ctx, const char* name);
+int get_or_add_term_index(SolverContext* ctx, SmtTerm* term);
+// Entry of the term's congruence class representative, which holds the shared interval
+TermIntervalEntry* get_or_add_term_entry(SolverContext* ctx, SmtTerm* term);
+// Adds term and its subterms to the maps, in pre-order
+void collect_terms_and_vars(SolverContext* ctx, SmtTerm* term);
+void populate_maps_from_proplist(SolverContext* ctx, SmtProplist* list);
+
+// --- Propagation ---
+Interval calculate_forward_op_interval(SmtTermBop op, Interval i1, Interval i2);
+// Bounds parent = t1 op t2 implies for t1 and t2, INF_INTERVAL where there is no rule
+void calculate_backward_op_intervals(SmtTermBop op, Interval parent, Interval i1, Interval i2, Interval* r1, Interval* r2);
+// -i, saturating at the infinite bounds
+Interval negate_interval(Interval i);
+// Both walk the term on ctx->walk rather than the C stack, so depth is bounded only by
+// memory; true as soon as an interval becomes empty
+bool eval_and_update_term_interval(SolverContext* ctx, SmtTerm* term, bool* changed_overall);
+bool refine_children_intervals(SolverContext* ctx, SmtTerm* term, bool* changed_overall);
+
+// Atomic propositions are the only ones the interval engine understands directly
+bool is_interval_atom(SmtProp* prop);
+// Builds the constraint for an atom asserted with the given polarity (false = negated)
+AtomConstraint make_atom_constraint(SmtProp* atom, bool polarity);
+// Bounds of t1 and t2 after applying t1 op t2 (t1 != t2 when distinct), each only narrowed
+void relate_intervals(SmtBinPred op, bool distinct, Interval i1_current, Interval i2_current, Interval* out1, Interval* out2);
+// One pass of the three phases, in the strategy's order, over cons[ids[0..n)] (all of cons[0..n) when ids is NULL); 1 if an empty interval was found
+int propagate_round(SolverContext* ctx, const AtomConstraint* cons, const int* ids, int n, bool* changed_overall);
+// Iteration limit of one propagation loop under ctx's strategy, from the current map sizes
+int strategy_iteration_limit(const SolverContext* ctx);
+// Runs the three propagation phases over already populated maps; 1 if an empty interval was found
+int propagate_to_fixpoint(SolverContext* ctx, const AtomConstraint* cons, int count);
+// Resets the maps and propagates a standalone constraint set; 1 if an empty interval was found
+int check_constraints(SolverContext* ctx, const AtomConstraint* cons, int count);
+
+// Solves ctx->props. Returns 1 if the propositions are inconsistent (an empty interval was found), 0 otherwise
+int interval_solver(SolverContext* ctx);
+#endif
@@ -1,639 +1,519 @@
 #include "smt_lang.h"
 #include "smt_lang.tab.h"
-#include "smt_lang_flex.h"
-
-// Added for interval_solver
-#include <limits.h> // For LLONG_MIN, LLONG_MAX
-#include <stdbool.h>
+#include "interval_solver.h"
+#include "batch.h"
+#include "budget.h"
+#include "narrowlog.h"
+#include "output.h"
+#include "portfolio.h"
+#include "server.h"
+#include "smtbin.h"
+#include "smtlib.h"
+#include "stats.h"
+#include "stream.h"
+#include "template.h"
+#include "trace.h"
+
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-// --- Interval Structure ---
-typedef struct {
-    long long lower;
-    long long upper;
-} Interval;
-
-// Global constants for intervals
-const Interval INF_INTERVAL = {LLONG_MIN, LLONG_MAX};
-const Interval EMPTY_INTERVAL = {1, 0}; // Canonical empty: lower > upper
-
-// --- Map Structures (Simplified Array-Based) ---
-// For SMT_VarName -> Interval mapping
-typedef struct {
-    char* name;
-    Interval interval;
-    bool active; // Indicates if this slot is used
-} VarIntervalEntry;
-
-// For SmtTerm* -> Interval mapping
-typedef struct {
-    SmtTerm* term_ptr;
-    Interval interval;
-    bool active; // Indicates if this slot is used
-} TermIntervalEntry;
-
-#define MAX_VARS_MAP 100
-#define MAX_TERMS_MAP 500
-VarIntervalEntry g_var_map[MAX_VARS_MAP];
-int g_var_map_count = 0;
-TermIntervalEntry g_term_map[MAX_TERMS_MAP];
-int g_term_map_count = 0;
-
-// --- Helper Functions for Intervals & Maps ---
-
-long long safe_multiply(long long a, long long b) {
-    if (a == 0 || b == 0) return 0;
-    if (a == 1) return b;
-    if (b == 1) return a;
-
-    // Handing case -1
-    if (a == -1) {
-        if (b == LLONG_MIN) return LLONG_MAX; // -1 * LLONG_MIN --> LLONG_MAX
-        return -b;
-    }
-    if (b == -1) {
-        if (a == LLONG_MIN) return LLONG_MAX; // -1 * LLONG_MIN --> LLONG_MAX
-        return -a;
-    }
-
-    // Handling cases where an operand is an extreme value
-    if (a == LLONG_MAX) {
-        if (b > 0) return LLONG_MAX;
-        if (b < 0) return LLONG_MIN; // LLONG_MAX * negative
-    }
-    if (a == LLONG_MIN) {
-        if (b > 0) return LLONG_MIN; // LLONG_MIN * positive (b!=1, b!=-1)
-        if (b < 0) return LLONG_MAX; // LLONG_MIN * negative
-    }
-    // Symmetric treatment b is the extreme value
-    if (b == LLONG_MAX) {
-        if (a > 0) return LLONG_MAX;
-        if (a < 0) return LLONG_MIN;
-    }
-    if (b == LLONG_MIN) {
-        if (a > 0) return LLONG_MIN;
-        if (a < 0) return LLONG_MAX;
-    }
-
-    // Overflow checking in normal circumstances
-    // a > 0, b > 0:  a * b > LLONG_MAX  iff  a > LLONG_MAX / b
-    if (a > 0 && b > 0) {
-        if (a > LLONG_MAX / b) return LLONG_MAX;
-    }
-    // a < 0, b < 0:  a * b > LLONG_MAX  iff  (-a) * (-b) > LLONG_MAX
-    // Need to be careful as a or b could be LLONG_MIN, then -a or -b overflows.
-    else if (a < 0 && b < 0) {
-        if (a == LLONG_MIN || b == LLONG_MIN) { // If one is LLONG_MIN, the other negative non -1
-             // LLONG_MIN * (negative other than -1) => results in value > LLONG_MAX
-            return LLONG_MAX;
-        }
-        // Now a and b are negative, but not LLONG_MIN
-        if ((-a) > LLONG_MAX / (-b)) return LLONG_MAX;
-    }
-    // a > 0, b < 0 (or vice versa): a * b < LLONG_MIN
-    // a > 0, b < 0: a * b < LLONG_MIN iff b < LLONG_MIN / a
-    else if (a > 0 && b < 0) { // mixed signs, result negative
-        if (b < LLONG_MIN / a) return LLONG_MIN;
-    }
-    // a < 0, b > 0: a * b < LLONG_MIN iff a < LLONG_MIN / b
-    else if (a < 0 && b > 0) { // mixed signs, result negative
-        if (a < LLONG_MIN / b) return LLONG_MIN;
-    }
-    
-    return a * b;
+#include <time.h>
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [--portfolio N | --stream] [--format F] [--stats] [--narrow-log F [--narrow-ring N]] [--trace level] [budget] [file]\n", prog);
+    fprintf(stderr, "       %s --save <image> <file> (a saved image is recognised as input by its header)\n", prog);
+    fprintf(stderr, "       %s [--trace level] --smt2 <file> (also chosen by a .smt2 suffix)\n", prog);
+    fprintf(stderr, "       %s --batch <dir|@list|glob> [-j threads] [--ordered] [--portfolio N | --stream] [--cache N] [--cache-file F] [--format F] [--stats] [--trace level] [budget]\n", prog);
+    fprintf(stderr, "       %s --template <file> --param name[,name...] [--lanes | --codegen <dir>] [--format F] [--stats] [--trace level] (one row of values per stdin line)\n", prog);
+    fprintf(stderr, "       %s --serve [socket] [--cache N] [--cache-file F] (stdin / stdout without a socket path)\n", prog);
+    fprintf(stderr, "       %s --compact-cache <file> [keep]\n", prog);
+    fprintf(stderr, "       %s --client <socket> <file>...\n", prog);
+    fprintf(stderr, "       %s --replay <narrowing log> [--creep N] [--chain N]\n", prog);
+    fprintf(stderr, "Budget (per file, unknown once one runs out): [--timeout ms] [--max-propagations N] [--max-memory MB]\n");
+    fprintf(stderr, "Formats: text (default), jsonl, csv\n");
+    fprintf(stderr, "Trace levels: off, info (default for one file), props, parse, tokens\n");
+    exit(1);
 }
 
-void init_maps() {
-    g_var_map_count = 0;
-    for (int i = 0; i < MAX_VARS_MAP; ++i) g_var_map[i].active = false;
-    g_term_map_count = 0;
-    for (int i = 0; i < MAX_TERMS_MAP; ++i) g_term_map[i].active = false;
+static void set_trace_level(const char* prog, const char* name) {
+    int level = trace_parse_level(name);
+    if (level < 0) usage(prog);
+    trace_level = (TraceLevel)level;
 }
 
-Interval intersect_intervals(Interval i1, Interval i2) {
-    Interval res;
-    res.lower = (i1.lower > i2.lower) ? i1.lower : i2.lower;
-    res.upper = (i1.upper < i2.upper) ? i1.upper : i2.upper;
-    if (res.lower > res.upper) return EMPTY_INTERVAL;
-    return res;
+static OutputFormat output_format = OUTPUT_TEXT;
+static struct timespec solve_start; // Reading the input starts the clock
+static bool collect_stats = false;
+static NarrowLog* narrow_log = NULL; // Attached to the solved context, closed after the solve
+static double budget_ms = 0;           // The solve budget, each limit 0 for none
+static long long budget_propagations = 0;
+static size_t budget_memory = 0;
+static SolverBudget solve_budget;      // Started with the clock in single-file mode
+
+// Parses --timeout, --max-propagations or --max-memory at argv[*i]; false if it is none of them
+static bool parse_budget_option(int argc, char** argv, int* i) {
+    if (*i + 1 >= argc) return false;
+    if (strcmp(argv[*i], "--timeout") == 0) budget_ms = atof(argv[++*i]);
+    else if (strcmp(argv[*i], "--max-propagations") == 0) budget_propagations = atoll(argv[++*i]);
+    else if (strcmp(argv[*i], "--max-memory") == 0) budget_memory = (size_t)(atof(argv[++*i]) * 1024 * 1024);
+    else return false;
+    return true;
 }
 
-bool is_empty_interval(Interval i) {
-    return i.lower > i.upper;
+static bool budgeted(void) {
+    return budget_ms > 0 || budget_propagations > 0 || budget_memory > 0;
 }
 
-bool interval_equals(Interval i1, Interval i2) {
-    return i1.lower == i2.lower && i1.upper == i2.upper;
+static void request_stats(void) {
+#ifdef SMT_NO_STATS
+    fprintf(stderr, "Warning: solver statistics were compiled out (-DSMT_NO_STATS).\n");
+#endif
+    collect_stats = true;
 }
 
-// --- Map Access Functions (Simplified Array-Based) ---
-
-// Get or Add for Variables
-VarIntervalEntry* get_or_add_var_entry(const char* name) {
-    for (int i = 0; i < g_var_map_count; ++i) {
-        if (g_var_map[i].active && strcmp(g_var_map[i].name, name) == 0) {
-            return &g_var_map[i];
-        }
-    }
-    if (g_var_map_count < MAX_VARS_MAP) {
-        VarIntervalEntry* new_entry = &g_var_map[g_var_map_count++];
-        new_entry->name = (char*)name; // Assumes parser manages string lifetime
-        new_entry->interval = INF_INTERVAL;
-        new_entry->active = true;
-        return new_entry;
-    }
-    fprintf(stderr, "Error: Variable map full.\n");
-    exit(1); // Or handle error more gracefully
+static void set_output_format(const char* prog, const char* name) {
+    int format = output_parse_format(name);
+    if (format < 0) usage(prog);
+    output_format = (OutputFormat)format;
 }
 
-// Get or Add for Terms
-TermIntervalEntry* get_or_add_term_entry(SmtTerm* term) {
-    if (term == NULL) return NULL;
-    for (int i = 0; i < g_term_map_count; ++i) {
-        if (g_term_map[i].active && g_term_map[i].term_ptr == term) {
-            return &g_term_map[i];
-        }
+// Solves many files on a thread pool, printing one result line per file
+static int batch_main(int argc, char **argv) {
+    const char* spec = NULL;
+    BatchOptions opts = { 0, false, 1, false, 0, NULL, OUTPUT_TEXT, false, 0, 0, 0 };
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) spec = argv[++i];
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) opts.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ordered") == 0) opts.ordered = true;
+        else if (strcmp(argv[i], "--portfolio") == 0 && i + 1 < argc) opts.portfolio = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--stream") == 0) opts.stream = true;
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) opts.cache = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cache-file") == 0 && i + 1 < argc) opts.cache_file = argv[++i];
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) set_output_format(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--stats") == 0) request_stats();
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) set_trace_level(argv[0], argv[++i]);
+        else if (!parse_budget_option(argc, argv, &i)) usage(argv[0]);
     }
-    if (g_term_map_count < MAX_TERMS_MAP) {
-        TermIntervalEntry* new_entry = &g_term_map[g_term_map_count++];
-        new_entry->term_ptr = term;
-        if (term->type == SMT_ConstNum) {
-            new_entry->interval = (Interval){term->term.ConstNum, term->term.ConstNum};
-        } else {
-            new_entry->interval = INF_INTERVAL;
-        }
-        new_entry->active = true;
-        return new_entry;
-    }
-    fprintf(stderr, "Error: Term map full for term type %d.\n", term->type);
-    exit(1); // Or handle error more gracefully
+    if (spec == NULL) usage(argv[0]);
+    opts.format = output_format;
+    opts.stats = collect_stats;
+    opts.timeout_ms = budget_ms;
+    opts.max_propagations = budget_propagations;
+    opts.max_memory = budget_memory;
+
+    char** paths;
+    int count = batch_collect_inputs(spec, &paths);
+    if (count < 0) return 1;
+    int failed = batch_solve(paths, count, &opts, stdout);
+    batch_free_inputs(paths, count);
+    return failed > 0 ? 1 : 0;
 }
 
-// Recursive function to collect all terms and variables
-void collect_terms_and_vars_recursive(SmtTerm* term) {
-    if (term == NULL) return;
-    get_or_add_term_entry(term); // Ensure this term is in the map
-
-    if (term->type == SMT_VarName) {
-        get_or_add_var_entry(term->term.Variable);
-    } else if (term->type == SMT_LiaBTerm || term->type == SMT_NiaBTerm) {
-        collect_terms_and_vars_recursive(term->term.BTerm.t1);
-        collect_terms_and_vars_recursive(term->term.BTerm.t2);
-    } else if (term->type == SMT_LiaUTerm) {
-        collect_terms_and_vars_recursive(term->term.UTerm.t);
-    } else if (term->type == SMT_UFTerm) {
-        if (term->term.UFTerm) {
-            for (int i = 0; i < term->term.UFTerm->numArgs; ++i) {
-                collect_terms_and_vars_recursive(term->term.UFTerm->args[i]);
-            }
-        }
+static void print_verdict(int res, const SolverContext* ctx) {
+    BudgetLimit limit = budget_exhausted(ctx);
+    if (res == 1) {
+        printf("Result: An empty interval was found (inconsistency detected).\n");
+    } else if (limit != BUDGET_NONE && ctx->truncated) {
+        printf("Result: Unknown, the %s budget ran out (the intervals reached so far enclose every solution).\n", budget_limit_name(limit));
+    } else {
+        printf("Result: No empty interval found (consistent within interval arithmetic limits).\n");
     }
 }
 
-void populate_maps_from_proplist(SmtProplist* list) {
-    init_maps();
-    for (SmtProplist* current = list; current != NULL; current = current->next) {
-        SmtProp* prop = current->prop;
-        // We are interested in atomic propositions for interval solving
-        if (prop->type == SMTAT_PROP_EQ || prop->type == SMTAT_PROP_LIA) {
-            collect_terms_and_vars_recursive(prop->prop.Atomic_prop.term1);
-            collect_terms_and_vars_recursive(prop->prop.Atomic_prop.term2);
+// The verdict in the chosen format; res is -1 when the input could not be parsed (ctx may be NULL).
+// Statistics go into jsonl records, after the verdict in text and to stderr alongside csv.
+static void report_result(const char* path, int res, const SolverContext* ctx) {
+    if (output_format == OUTPUT_TEXT) {
+        if (res >= 0) print_verdict(res, ctx);
+        if (res >= 0 && ctx->stats != NULL) {
+            printf("\n--- Solver Statistics ---\n");
+            solver_stats_print(ctx->stats, stdout);
         }
-        // Extend if other prop types become relevant for interval constraints
+        return;
     }
+    if (output_format == OUTPUT_CSV && res >= 0 && ctx->stats != NULL) solver_stats_print(ctx->stats, stderr);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double ms = (now.tv_sec - solve_start.tv_sec) * 1e3 + (now.tv_nsec - solve_start.tv_nsec) / 1e6;
+    OutBuf out;
+    outbuf_init(&out, stdout);
+    output_header(&out, output_format);
+    output_record(&out, output_format, path, res, res < 0 ? NULL : ctx, ms);
+    outbuf_free(&out);
 }
 
 
-// --- Forward Interval Calculation for Expressions f(e1, e2) ---
-Interval calculate_forward_op_interval(SmtTermBop op, Interval i1, Interval i2) {
-    if (is_empty_interval(i1) || is_empty_interval(i2)) return EMPTY_INTERVAL;
-
-    // Handle cases where one operand is fully infinite (can lead to INF_INTERVAL for many ops)
-    bool i1_inf = (i1.lower == LLONG_MIN && i1.upper == LLONG_MAX);
-    bool i2_inf = (i2.lower == LLONG_MIN && i2.upper == LLONG_MAX);
-
-    Interval res = INF_INTERVAL; // Default
-    long long v[4]; // For multiplication/division products
-
-    switch (op) {
-        case LIA_ADD:
-            if (i1.lower == LLONG_MIN || i2.lower == LLONG_MIN) res.lower = LLONG_MIN;
-            else res.lower = i1.lower + i2.lower; // Check for underflow if not LLONG_MIN
-            if (i1.upper == LLONG_MAX || i2.upper == LLONG_MAX) res.upper = LLONG_MAX;
-            else res.upper = i1.upper + i2.upper; // Check for overflow if not LLONG_MAX
-            // Basic overflow/underflow checks (could be more robust)
-            if (i1.lower > 0 && i2.lower > 0 && res.lower < 0 && i1.lower != LLONG_MIN && i2.lower != LLONG_MIN) res.lower = LLONG_MAX;
-            if (i1.upper > 0 && i2.upper > 0 && res.upper < 0 && i1.upper != LLONG_MAX && i2.upper != LLONG_MAX) res.upper = LLONG_MAX;
-            if (i1.lower < 0 && i2.lower < 0 && res.lower > 0 && i1.lower != LLONG_MIN && i2.lower != LLONG_MIN) res.lower = LLONG_MIN;
-            if (i1.upper < 0 && i2.upper < 0 && res.upper > 0 && i1.upper != LLONG_MAX && i2.upper != LLONG_MAX) res.upper = LLONG_MIN;
-            break;
-        case LIA_MINUS:
-            if (i1.lower == LLONG_MIN || i2.upper == LLONG_MAX) res.lower = LLONG_MIN;
-            else res.lower = i1.lower - i2.upper;
-            if (i1.upper == LLONG_MAX || i2.lower == LLONG_MIN) res.upper = LLONG_MAX;
-            else res.upper = i1.upper - i2.lower;
-            // Similar overflow/underflow checks
-            break;
-        case LIA_MULT:
-            // bool i1_inf and i2_inf are defined before the switch
-            if ((i1.lower == 0 && i1.upper == 0) || (i2.lower == 0 && i2.upper == 0)) {
-                res = (Interval){0,0};
-                break;
-            }
+// Solves while parsing and stops reading at the first empty interval
+static int stream_main(const char* s) {
+    TRACE(TRACE_INFO, "\nSTARTING STREAMING SOLVE...\n");
+    SolverContext* ctx = solver_context_new();
+    if (collect_stats) solver_stats_enable(ctx);
+    ctx->narrow_log = narrow_log;
+    if (budgeted()) ctx->budget = &solve_budget;
+    int res;
+    int parse_result = stream_solve_path(ctx, s, &res);
+    if (narrow_log_close(narrow_log) != 0) exit(1);
+    if (parse_result < 0) {
+        perror("Error opening file");
+        printf("File %s can't be opened.\n", s);
+        exit(1);
+    }
+    if (parse_result != 0) {
+        if (output_format == OUTPUT_TEXT) printf("\nPARSING FAILED with code: %d.\n", parse_result);
+        report_result(s, -1, NULL);
+        solver_context_free(ctx);
+        return 1;
+    }
+    TRACE(TRACE_INFO, "\nSTREAMING SOLVE FINISHED.\n");
+    report_result(s, res, ctx);
 
-            // Handling cases where at least one operand is (-inf, +inf)
-    		if (i1_inf && i2_inf) { // (-inf,+inf) * (-inf,+inf)
-        		res = INF_INTERVAL;
-        		break;
-    		}
-    		if (i1_inf) { // i1 is (-inf,+inf), i2 is not [0,0] and not (-inf,+inf)
-        		if (i2.lower > 0 || i2.upper < 0) {
-            		res = INF_INTERVAL; // e.g. [-inf, +inf] * [2,3] -> [-inf, +inf]
-        		} else {
-            		res = INF_INTERVAL; // [-inf, +inf] * [-2,3] is still [-inf, +inf]
-        		}
-        		break;
-    		}
-    		if (i2_inf) { // i2 is (-inf,+inf), i1 is not [0,0] and not (-inf,+inf)
-         		if (i1.lower > 0 || i1.upper < 0) {
-            		res = INF_INTERVAL;
-        		} else {
-            		res = INF_INTERVAL;
-        		}
-        		break;
-    		}
-
-    		// Neither operand is (-inf, +inf) nor [0,0]
-    		v[0] = safe_multiply(i1.lower, i2.lower);
-    		v[1] = safe_multiply(i1.lower, i2.upper);
-    		v[2] = safe_multiply(i1.upper, i2.lower);
-    		v[3] = safe_multiply(i1.upper, i2.upper);
-
-    		res.lower = v[0];
-    		res.upper = v[0];
-    		for (int i = 1; i < 4; ++i) {
-        		if (v[i] < res.lower) res.lower = v[i];
-        		if (v[i] > res.upper) res.upper = v[i];
-    		}
-			break;
-        case LIA_DIV:
-            if (i2.lower == 0 && i2.upper == 0) return EMPTY_INTERVAL; // Division by exactly zero
-            if (i2.lower <= 0 && i2.upper >= 0) return INF_INTERVAL; // Divisor interval contains 0 (but isn't [0,0])
-            if (i1.lower == 0 && i1.upper == 0) return (Interval){0,0}; // 0 / x = 0 (if x!=0)
-            if (i1_inf && !i2_inf) return INF_INTERVAL; // INF / finite_non_zero = INF
-            if (i1_inf && i2_inf) return INF_INTERVAL; // INF/INF indeterminate, for intervals often wide
-
-            // Assuming i2 does not contain 0 and is not [0,0]
-            v[0] = i1.lower / i2.lower; v[1] = i1.lower / i2.upper;
-            v[2] = i1.upper / i2.lower; v[3] = i1.upper / i2.upper;
-            res.lower = v[0]; res.upper = v[0];
-            for (int i = 1; i < 4; ++i) { // Min/max of the four resulting points
-                if (v[i] < res.lower) res.lower = v[i];
-                if (v[i] > res.upper) res.upper = v[i];
-            }
-            break;
-        case LIA_LSHIFT:
-        case LIA_RSHIFT:
-            if (i2.lower != i2.upper || i2.lower < 0 || i2.lower >= 63) { // Treat as complex/undefined if shift is not a small positive constant
-                return (i1_inf || i2_inf) ? INF_INTERVAL : EMPTY_INTERVAL; // Or wide interval
-            }
-            long long shift_val = i2.lower;
-            if (i1_inf) return INF_INTERVAL; // Shifting full infinity results in full infinity
-
-            if (op == LIA_LSHIFT) {
-                // Check for overflow before shifting
-                if (i1.lower > (LLONG_MIN >> shift_val) && i1.lower < (LLONG_MAX >> shift_val)) res.lower = i1.lower << shift_val; else res.lower = (i1.lower > 0) ? LLONG_MAX : LLONG_MIN;
-                if (i1.upper > (LLONG_MIN >> shift_val) && i1.upper < (LLONG_MAX >> shift_val)) res.upper = i1.upper << shift_val; else res.upper = (i1.upper > 0) ? LLONG_MAX : LLONG_MIN;
-                 if (i1.lower > 0 && (LLONG_MAX >> shift_val) < i1.lower ) res.lower = LLONG_MAX;
-                 if (i1.upper > 0 && (LLONG_MAX >> shift_val) < i1.upper ) res.upper = LLONG_MAX;
-            } else { // LIA_RSHIFT
-                res.lower = i1.lower >> shift_val;
-                res.upper = i1.upper >> shift_val;
-            }
-            break;
-        default:
-            return INF_INTERVAL;
+    TRACE(TRACE_INFO, "\nCleaning up AST...\n");
+    solver_context_free(ctx);
+    return 0;
+}
+
+// Runs an SMT-LIB v2 script, printing one response per check-sat
+static int smtlib_main(const char* s) {
+    int res = smtlib_run_path(s, stdout);
+    if (res < 0) {
+        perror(s);
+        exit(1);
     }
-    if (res.lower > res.upper && !(res.lower == 1 && res.upper ==0)) return EMPTY_INTERVAL;
     return res;
 }
 
-// --- Core Recursive Evaluation & Refinement Functions ---
-
-bool eval_and_update_term_interval_recursive(SmtTerm* term, bool* changed_overall);
-
-// Backward propagation: term_val = t1 op t2. Refine t1 and t2.
-bool refine_children_intervals_recursive(SmtTerm* term, bool* changed_overall) {
-    if (term == NULL) return false;
-
-    TermIntervalEntry* parent_entry = get_or_add_term_entry(term);
-    Interval parent_interval = parent_entry->interval;
-    if (is_empty_interval(parent_interval)) return false; // Cannot refine from empty
-
-    if (term->type == SMT_LiaBTerm || term->type == SMT_NiaBTerm) {
-        SmtTerm* t1 = term->term.BTerm.t1;
-        SmtTerm* t2 = term->term.BTerm.t2;
-        SmtTermBop op = term->term.BTerm.op;
-
-        TermIntervalEntry* t1_entry = get_or_add_term_entry(t1);
-        TermIntervalEntry* t2_entry = get_or_add_term_entry(t2);
-        Interval i1_current = t1_entry->interval;
-        Interval i2_current = t2_entry->interval;
-
-        Interval i1_refined_by_t2 = INF_INTERVAL;
-        Interval i2_refined_by_t1 = INF_INTERVAL;
+static bool has_suffix(const char* s, const char* suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
 
-        // Example: parent = t1 + t2  => t1 = parent - t2, t2 = parent - t1
-        if (op == LIA_ADD) {
-            i1_refined_by_t2 = calculate_forward_op_interval(LIA_MINUS, parent_interval, i2_current);
-            i2_refined_by_t1 = calculate_forward_op_interval(LIA_MINUS, parent_interval, i1_current);
-        } else if (op == LIA_MINUS) { // parent = t1 - t2 => t1 = parent + t2, t2 = t1 - parent
-            i1_refined_by_t2 = calculate_forward_op_interval(LIA_ADD, parent_interval, i2_current);
-            i2_refined_by_t1 = calculate_forward_op_interval(LIA_MINUS, i1_current, parent_interval);
-        }
-        // TODO: Add backward rules for MULT, DIV, SHIFT (these are more complex)
-        // For MULT: If parent = t1 * t2, then t1 = parent / t2. Division rules apply.
-        // For DIV: If parent = t1 / t2, then t1 = parent * t2.
-
-        Interval final_i1 = intersect_intervals(i1_current, i1_refined_by_t2);
-        if (is_empty_interval(final_i1)) { t1_entry->interval = EMPTY_INTERVAL; *changed_overall = true; return true; }
-        if (!interval_equals(i1_current, final_i1)) { t1_entry->interval = final_i1; *changed_overall = true; }
-        if (refine_children_intervals_recursive(t1, changed_overall)) return true;
-        if (eval_and_update_term_interval_recursive(t1, changed_overall)) return true; // Re-evaluate t1 if its children changed
-
-        Interval final_i2 = intersect_intervals(i2_current, i2_refined_by_t1);
-        if (is_empty_interval(final_i2)) { t2_entry->interval = EMPTY_INTERVAL; *changed_overall = true; return true; }
-        if (!interval_equals(i2_current, final_i2)) { t2_entry->interval = final_i2; *changed_overall = true; }
-        if (refine_children_intervals_recursive(t2, changed_overall)) return true;
-        if (eval_and_update_term_interval_recursive(t2, changed_overall)) return true;
-
-
-    } else if (term->type == SMT_LiaUTerm) {
-        SmtTerm* child_u = term->term.UTerm.t;
-        TermIntervalEntry* child_u_entry = get_or_add_term_entry(child_u);
-        Interval child_u_current = child_u_entry->interval;
-        Interval child_u_refined = INF_INTERVAL;
-
-        if (term->term.UTerm.op == LIA_NEG) { // parent = -child => child = -parent
-             child_u_refined.lower = (parent_interval.upper == LLONG_MAX) ? LLONG_MIN : -parent_interval.upper;
-             child_u_refined.upper = (parent_interval.lower == LLONG_MIN) ? LLONG_MAX : -parent_interval.lower;
-        }
-        Interval final_child_u = intersect_intervals(child_u_current, child_u_refined);
-        if (is_empty_interval(final_child_u)) { child_u_entry->interval = EMPTY_INTERVAL; *changed_overall = true; return true;}
-        if (!interval_equals(child_u_current, final_child_u)) { child_u_entry->interval = final_child_u; *changed_overall = true;}
-        if (refine_children_intervals_recursive(child_u, changed_overall)) return true;
-        if (eval_and_update_term_interval_recursive(child_u, changed_overall)) return true;
-
-
-    } else if (term->type == SMT_VarName) { // If a term is a variable, its interval is directly updated by map_update_var_interval
-        VarIntervalEntry* var_entry = get_or_add_var_entry(term->term.Variable);
-        Interval old_var_interval = var_entry->interval;
-        Interval new_var_interval = intersect_intervals(old_var_interval, parent_interval); // parent_interval is I(term)
-        if(is_empty_interval(new_var_interval)) { var_entry->interval = EMPTY_INTERVAL; *changed_overall = true; return true; }
-        if(!interval_equals(old_var_interval, new_var_interval)) { var_entry->interval = new_var_interval; *changed_overall = true; }
+// Answers framed submissions until stdin ends or, on a socket, until killed
+static int serve_main(int argc, char **argv) {
+    const char* socket_path = NULL;
+    int cache_size = 0;
+    const char* cache_file = NULL;
+    trace_sink = stderr; // stdout carries the responses
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--serve") == 0) continue;
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) cache_size = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cache-file") == 0 && i + 1 < argc) cache_file = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) set_trace_level(argv[0], argv[++i]);
+        else if (socket_path == NULL && argv[i][0] != '-') socket_path = argv[i];
+        else usage(argv[0]);
+    }
+    ResultCache* cache = NULL;
+    if (cache_size > 0 || cache_file != NULL) cache = result_cache_new(cache_size > 0 ? cache_size : RESULT_CACHE_DEFAULT);
+    if (cache_file != NULL) {
+        DiskCache* disk = disk_cache_open(cache_file);
+        if (disk == NULL) exit(1);
+        result_cache_attach(cache, disk);
     }
-    return false; // No empty interval found in this path
+    int res = socket_path != NULL ? server_run_socket(socket_path, cache) : server_run_stdio(cache);
+    result_cache_free(cache);
+    return res;
 }
 
+// Reads count integers separated by blanks or commas; false if the line holds anything else
+static bool parse_row(char* line, int* values, int count) {
+    char* p = line;
+    for (int i = 0; i < count; ++i) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        char* end;
+        long long v = strtoll(p, &end, 10);
+        if (end == p || v < INT_MIN || v > INT_MAX) return false;
+        values[i] = (int)v;
+        p = end;
+    }
+    while (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r' || *p == '\n') p++;
+    return *p == '\0';
+}
 
-// Forward evaluation
-bool eval_and_update_term_interval_recursive(SmtTerm* term, bool* changed_overall) {
-    if (term == NULL) return false;
-
-    TermIntervalEntry* current_term_entry = get_or_add_term_entry(term);
-    Interval old_interval_for_this_term = current_term_entry->interval;
-    Interval computed_interval = INF_INTERVAL;
+// Rows read but not yet solved in lane mode
+typedef struct {
+    int rows[TAPE_LANES]; // Input line numbers
+    bool ok[TAPE_LANES];  // The line held a valid row
+    int count;
+    int* values;          // The valid rows, packed
+    int solved;
+} RowGroup;
+
+static double ms_since(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
 
-    switch (term->type) {
-        case SMT_ConstNum:
-            computed_interval = (Interval){term->term.ConstNum, term->term.ConstNum};
-            break;
-        case SMT_VarName: {
-            VarIntervalEntry* var_entry = get_or_add_var_entry(term->term.Variable);
-            computed_interval = var_entry->interval; // A variable's interval is taken directly
-            break;
-        }
-        case SMT_LiaUTerm: {
-            if (eval_and_update_term_interval_recursive(term->term.UTerm.t, changed_overall)) return true; // Child became empty
-            TermIntervalEntry* child_u_entry = get_or_add_term_entry(term->term.UTerm.t);
-            if (term->term.UTerm.op == LIA_NEG) {
-                Interval child_i = child_u_entry->interval;
-                if (is_empty_interval(child_i)) { computed_interval = EMPTY_INTERVAL; break; }
-                computed_interval.lower = (child_i.upper == LLONG_MAX) ? LLONG_MIN : -child_i.upper;
-                computed_interval.upper = (child_i.lower == LLONG_MIN) ? LLONG_MAX : -child_i.lower;
-            } else { // Unknown Unary Op
-                computed_interval = INF_INTERVAL;
+// Solves a group in lockstep, or row by row without --lanes or when the skeleton has no tape, and writes its records in input order
+static void flush_rows(SmtTemplate* t, RowGroup* g, bool use_lanes, const char* path, char* source, OutBuf* out) {
+    int n = template_param_count(t);
+    int results[TAPE_LANES];
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool lanes = use_lanes && g->solved > 0 && template_solve_lanes(t, g->values, g->solved, results);
+    double ms = g->solved > 0 ? ms_since(&start) / g->solved : 0;
+    for (int i = 0, k = 0; i < g->count; ++i) {
+        sprintf(source, "%s:%d", path, g->rows[i]);
+        int res = -1;
+        if (g->ok[i]) {
+            if (lanes) {
+                template_load_lane(t, k);
+                res = results[k];
+            } else {
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                res = template_solve(t, g->values + k * n);
+                ms = ms_since(&start);
             }
-            break;
+            k++;
         }
-        case SMT_LiaBTerm:
-        case SMT_NiaBTerm: { // NiaBTerm covers MULT, DIV, SHIFT here as per problem description on f(e1,e2)
-            if (eval_and_update_term_interval_recursive(term->term.BTerm.t1, changed_overall)) return true;
-            if (eval_and_update_term_interval_recursive(term->term.BTerm.t2, changed_overall)) return true;
-
-            TermIntervalEntry* t1_entry = get_or_add_term_entry(term->term.BTerm.t1);
-            TermIntervalEntry* t2_entry = get_or_add_term_entry(term->term.BTerm.t2);
-            computed_interval = calculate_forward_op_interval(term->term.BTerm.op, t1_entry->interval, t2_entry->interval);
-            break;
-        }
-        case SMT_UFTerm: // Uninterpreted functions - interval is INF unless special handling (not in scope)
-            computed_interval = INF_INTERVAL;
-            // Could try to propagate children if args changed, but result is still INF
-            if(term->term.UFTerm) {
-                for(int i=0; i < term->term.UFTerm->numArgs; ++i) {
-                     if (eval_and_update_term_interval_recursive(term->term.UFTerm->args[i], changed_overall)) return true;
-                }
-            }
-            break;
-        default: // SMT_VarNum etc.
-            computed_interval = INF_INTERVAL;
-    }
-
-    Interval final_new_interval = intersect_intervals(old_interval_for_this_term, computed_interval);
-    if (is_empty_interval(final_new_interval)) {
-        current_term_entry->interval = EMPTY_INTERVAL;
-        *changed_overall = true; // Emptiness is a change
-        return true; // Empty interval detected for this term
-    }
-    if (!interval_equals(old_interval_for_this_term, final_new_interval)) {
-        *changed_overall = true;
+        output_record(out, output_format, source, res, res < 0 ? NULL : template_context(t), ms);
     }
-    current_term_entry->interval = final_new_interval;
-    return false; // Not empty at this node
+    g->count = 0;
+    g->solved = 0;
 }
 
-
-// --- Main interval_solver Function ---
-int interval_solver(SmtProplist* list) {
-    if (list == NULL) return 0; // No propositions, no conflict.
-
-    populate_maps_from_proplist(list);
-
-    bool changed_in_iteration;
-    int iterations = 0;
-    const int MAX_ITERATIONS = 2 * (g_var_map_count + g_term_map_count) + 10; // Heuristic limit, at most #vars * range_size updates
-
-    do {
-        changed_in_iteration = false;
-        iterations++;
-
-        // Phase 1: Forward evaluation for all terms involved in propositions
-        for (SmtProplist* current_p = list; current_p != NULL; current_p = current_p->next) {
-            SmtProp* prop = current_p->prop;
-            if (prop->type == SMTAT_PROP_EQ || prop->type == SMTAT_PROP_LIA) {
-                if (eval_and_update_term_interval_recursive(prop->prop.Atomic_prop.term1, &changed_in_iteration)) return 1;
-                if (eval_and_update_term_interval_recursive(prop->prop.Atomic_prop.term2, &changed_in_iteration)) return 1;
-            }
+// Compiles one skeleton and solves it once per line of parameter values read from stdin
+static int template_main(int argc, char **argv) {
+    const char* path = NULL;
+    char* names_buf = NULL;
+    const char** names = NULL;
+    int count = 0;
+    bool lanes = false;
+    const char* codegen_dir = NULL;
+    trace_level = TRACE_OFF;
+    trace_sink = stderr; // stdout carries the records
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--template") == 0 && i + 1 < argc) path = argv[++i];
+        else if (strcmp(argv[i], "--param") == 0 && i + 1 < argc) {
+            // Comma-separated, and repeatable
+            const char* list = argv[++i];
+            size_t old_len = names_buf != NULL ? strlen(names_buf) : 0;
+            names_buf = (char*)realloc(names_buf, old_len + strlen(list) + 2);
+            if (old_len > 0) names_buf[old_len++] = ',';
+            strcpy(names_buf + old_len, list);
         }
+        else if (strcmp(argv[i], "--lanes") == 0) lanes = true;
+        else if (strcmp(argv[i], "--codegen") == 0 && i + 1 < argc) codegen_dir = argv[++i];
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) set_output_format(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--stats") == 0) request_stats();
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) set_trace_level(argv[0], argv[++i]);
+        else usage(argv[0]);
+    }
+    if (path == NULL || names_buf == NULL) usage(argv[0]);
+    for (char* name = strtok(names_buf, ","); name != NULL; name = strtok(NULL, ",")) {
+        names = (const char**)realloc(names, sizeof(const char*) * (count + 1));
+        names[count++] = name;
+    }
+    if (count == 0 || (lanes && codegen_dir != NULL)) usage(argv[0]);
+    if ((lanes || codegen_dir != NULL) && collect_stats) {
+        fprintf(stderr, "Warning: solver statistics are not collected for %s solves.\n", lanes ? "lane" : "generated");
+        collect_stats = false;
+    }
 
-        // Phase 2: Apply relational constraints from propositions
-        for (SmtProplist* current_p = list; current_p != NULL; current_p = current_p->next) {
-            SmtProp* prop = current_p->prop;
-            if (!(prop->type == SMTAT_PROP_EQ || prop->type == SMTAT_PROP_LIA)) continue;
-
-            SmtTerm* t1_term = prop->prop.Atomic_prop.term1;
-            SmtTerm* t2_term = prop->prop.Atomic_prop.term2;
-            SmtBinPred rel_op = prop->prop.Atomic_prop.op;
-
-            TermIntervalEntry* t1_entry = get_or_add_term_entry(t1_term);
-            TermIntervalEntry* t2_entry = get_or_add_term_entry(t2_term);
-
-            Interval i1_current = t1_entry->interval;
-            Interval i2_current = t2_entry->interval;
-
-            Interval i1_after_relation = i1_current;
-            Interval i2_after_relation = i2_current;
-
-            switch (rel_op) {
-                case SMT_EQ:
-                    Interval common = intersect_intervals(i1_current, i2_current);
-                    i1_after_relation = common;
-                    i2_after_relation = common;
-                    break;
-                case SMT_LT: // t1 < t2  => t1.upper <= t2.upper-1, t2.lower >= t1.lower+1
-                    if (i2_current.upper != LLONG_MAX) i1_after_relation.upper = (i1_after_relation.upper < i2_current.upper - 1) ? i1_after_relation.upper : i2_current.upper - 1;
-                    if (i1_current.lower != LLONG_MIN) i2_after_relation.lower = (i2_after_relation.lower > i1_current.lower + 1) ? i2_after_relation.lower : i1_current.lower + 1;
-                    break;
-                case SMT_LE: // t1 <= t2 => t1.upper <= t2.upper, t2.lower >= t1.lower
-                    if (i2_current.upper != LLONG_MAX) i1_after_relation.upper = (i1_after_relation.upper < i2_current.upper) ? i1_after_relation.upper : i2_current.upper;
-                    if (i1_current.lower != LLONG_MIN) i2_after_relation.lower = (i2_after_relation.lower > i1_current.lower) ? i2_after_relation.lower : i1_current.lower;
-                    break;
-                case SMT_GT: // t1 > t2 (equiv. t2 < t1)
-                    if (i1_current.upper != LLONG_MAX) i2_after_relation.upper = (i2_after_relation.upper < i1_current.upper - 1) ? i2_after_relation.upper : i1_current.upper - 1;
-                    if (i2_current.lower != LLONG_MIN) i1_after_relation.lower = (i1_after_relation.lower > i2_current.lower + 1) ? i1_after_relation.lower : i2_current.lower + 1;
-                    break;
-                case SMT_GE: // t1 >= t2 (equiv. t2 <= t1)
-                    if (i1_current.upper != LLONG_MAX) i2_after_relation.upper = (i2_after_relation.upper < i1_current.upper) ? i2_after_relation.upper : i1_current.upper;
-                    if (i2_current.lower != LLONG_MIN) i1_after_relation.lower = (i1_after_relation.lower > i2_current.lower) ? i1_after_relation.lower : i2_current.lower;
-                    break;
-                default: break;
-            }
-
-            i1_after_relation = intersect_intervals(i1_current, i1_after_relation); // Ensure it only narrows
-            i2_after_relation = intersect_intervals(i2_current, i2_after_relation); // Ensure it only narrows
+    SmtParseContext pctx = { NULL };
+    int parse_result = parseSmtPath(path, &pctx);
+    if (parse_result != 0) {
+        if (parse_result < 0) perror(path);
+        else fprintf(stderr, "Error: %s: parsing failed with code %d.\n", path, parse_result);
+        freeSmtProplist(pctx.root);
+        exit(1);
+    }
+    SmtTemplate* t = template_compile(reverseList(pctx.root), names, count);
+    if (t == NULL) exit(1);
+    if (collect_stats) solver_stats_enable(template_context(t));
+    TRACE(TRACE_INFO, "Compiled template %s with %d parameters.\n", path, count);
+    if (codegen_dir != NULL && !template_use_codegen(t, codegen_dir)) {
+        fprintf(stderr, "Warning: no generated propagator for %s, solving with the engine.\n", path);
+    }
 
-            if (is_empty_interval(i1_after_relation)) { t1_entry->interval = EMPTY_INTERVAL; changed_in_iteration = true; return 1; }
-            if (!interval_equals(i1_current, i1_after_relation)) { t1_entry->interval = i1_after_relation; changed_in_iteration = true; }
+    RowGroup group = { .count = 0, .solved = 0 };
+    int group_size = lanes ? TAPE_LANES : 1;
+    group.values = (int*)malloc(sizeof(int) * count * group_size);
+    char* source = (char*)malloc(strlen(path) + 32);
+    char* line = NULL;
+    size_t line_cap = 0;
+    int row = 0, failed = 0;
+    OutBuf out;
+    outbuf_init(&out, stdout);
+    output_header(&out, output_format);
+    while (getline(&line, &line_cap, stdin) >= 0) {
+        row++;
+        if (line[strspn(line, " \t\r\n")] == '\0') continue;
+        bool ok = parse_row(line, group.values + group.solved * count, count);
+        if (!ok) failed++;
+        group.rows[group.count] = row;
+        group.ok[group.count++] = ok;
+        group.solved += ok;
+        if (group.solved == group_size || group.count == TAPE_LANES) flush_rows(t, &group, lanes, path, source, &out);
+    }
+    flush_rows(t, &group, lanes, path, source, &out);
+    outbuf_free(&out);
+    free(line);
+    free(source);
+    free(group.values);
+    free(names);
+    free(names_buf);
+    template_free(t);
+    return failed > 0 ? 1 : 0;
+}
 
-            if (is_empty_interval(i2_after_relation)) { t2_entry->interval = EMPTY_INTERVAL; changed_in_iteration = true; return 1; }
-            if (!interval_equals(i2_current, i2_after_relation)) { t2_entry->interval = i2_after_relation; changed_in_iteration = true; }
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--batch") == 0) return batch_main(argc, argv);
+        if (strcmp(argv[i], "--template") == 0) return template_main(argc, argv);
+        if (strcmp(argv[i], "--serve") == 0) return serve_main(argc, argv);
+        if (strcmp(argv[i], "--compact-cache") == 0) {
+            if (i != 1 || argc < 3 || argc > 4) usage(argv[0]);
+            DiskCache* disk = disk_cache_open(argv[2]);
+            if (disk == NULL) return 1;
+            int kept = disk_cache_compact(disk, argc == 4 ? atoi(argv[3]) : 0);
+            disk_cache_close(disk);
+            if (kept >= 0) printf("%d records kept\n", kept);
+            return kept < 0 ? 1 : 0;
         }
-
-        // Phase 3: Backward propagation from terms to their children/variables
-        for (SmtProplist* current_p = list; current_p != NULL; current_p = current_p->next) {
-            SmtProp* prop = current_p->prop;
-            if (prop->type == SMTAT_PROP_EQ || prop->type == SMTAT_PROP_LIA) {
-                if (refine_children_intervals_recursive(prop->prop.Atomic_prop.term1, &changed_in_iteration)) return 1;
-                if (refine_children_intervals_recursive(prop->prop.Atomic_prop.term2, &changed_in_iteration)) return 1;
+        if (strcmp(argv[i], "--replay") == 0) {
+            if (i != 1 || argc < 3) usage(argv[0]);
+            int creep = 8, chain = 12;
+            for (int j = 3; j < argc; ++j) {
+                if (strcmp(argv[j], "--creep") == 0 && j + 1 < argc) creep = atoi(argv[++j]);
+                else if (strcmp(argv[j], "--chain") == 0 && j + 1 < argc) chain = atoi(argv[++j]);
+                else usage(argv[0]);
             }
+            return narrow_log_replay(argv[2], creep > 1 ? creep : 2, chain, stdout) != 0 ? 1 : 0;
         }
-        // After backward propagation, variables might have changed, which could affect terms containing them.
-        // So, one more forward pass can be beneficial or simply rely on the next full iteration.
-        // For simplicity, the next iteration's Phase 1 will handle this.
-
-        if (iterations >= MAX_ITERATIONS) {
-            printf("Warning: Max iterations reached, potential non-convergence or slow convergence.\n");
-            break;
+        if (strcmp(argv[i], "--client") == 0) {
+            if (i != 1 || argc < 4) usage(argv[0]);
+            return server_client(argv[2], argv + 3, argc - 3, stdout) > 0 ? 1 : 0;
         }
+    }
+    const char* input = NULL;
+    int portfolio = 1;
+    bool stream = false;
+    bool smt2 = false;
+    const char* save = NULL;
+    const char* narrow_path = NULL;
+    int narrow_ring = 0;
+    trace_level = TRACE_INFO;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--portfolio") == 0 && i + 1 < argc) portfolio = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--stream") == 0) stream = true;
+        else if (strcmp(argv[i], "--smt2") == 0) smt2 = true;
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) save = argv[++i];
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) set_output_format(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--stats") == 0) request_stats();
+        else if (strcmp(argv[i], "--narrow-log") == 0 && i + 1 < argc) narrow_path = argv[++i];
+        else if (strcmp(argv[i], "--narrow-ring") == 0 && i + 1 < argc) narrow_ring = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) set_trace_level(argv[0], argv[++i]);
+        else if (parse_budget_option(argc, argv, &i)) continue;
+        else if (input == NULL && argv[i][0] != '-') input = argv[i];
+        else usage(argv[0]);
+    }
 
-    } while (changed_in_iteration);
-
-    // One final check on all known variables and terms
-    for(int i=0; i < g_var_map_count; ++i) if(g_var_map[i].active && is_empty_interval(g_var_map[i].interval)) return 1;
-    for(int i=0; i < g_term_map_count; ++i) if(g_term_map[i].active && is_empty_interval(g_term_map[i].interval)) return 1;
-
-    return 0; // No empty interval found
-}
-
-int main(int argc, char **argv) {
-    char s[80] = "../test_example/test1.txt"; // Default input
-    if (argc == 2) {
-        printf("Manual decided input file: %s\n", argv[1]);
-        strncpy(s, argv[1], sizeof(s) - 1);
-        s[sizeof(s)-1] = '\0'; // Ensure null termination
+    if (input != NULL && (smt2 || has_suffix(input, ".smt2"))) return smtlib_main(input);
+    if (smt2) usage(argv[0]);
+    if (narrow_ring > 0 && narrow_path == NULL) usage(argv[0]);
+#ifdef SMT_NO_TRACE
+    if (narrow_path != NULL) fprintf(stderr, "Warning: the narrowing log was compiled out (-DSMT_NO_TRACE).\n");
+#endif
+    if (narrow_path != NULL && portfolio > 1) fprintf(stderr, "Warning: portfolio instances are not recorded in the narrowing log.\n");
+    if (narrow_path != NULL && save == NULL) {
+        narrow_log = narrow_log_open(narrow_path, narrow_ring, narrow_ring > 0);
+        if (narrow_log == NULL) exit(1);
+    }
+    if (output_format != OUTPUT_TEXT) trace_sink = stderr; // stdout carries the records
+    clock_gettime(CLOCK_MONOTONIC, &solve_start);
+    budget_init(&solve_budget, budget_ms, budget_propagations, budget_memory);
+
+    const char* s = "../test_example/test1.txt"; // Default input
+    if (input != NULL) {
+        TRACE(TRACE_INFO, "Manual decided input file: %s\n", input);
+        s = input;
     } else {
-        printf("Using default input file: %s\n", s);
+        TRACE(TRACE_INFO, "Using default input file: %s\n", s);
+    }
+    SmtBinImage image;
+    bool from_image = save == NULL && smtbin_is_image(s);
+    if (from_image) {
+        if (smtbin_load(s, &image) != 0) exit(1);
+        TRACE(TRACE_INFO, "Loaded problem image: %d symbols, %zu bytes.\n", image.symbol_count, image.size);
+    } else if (stream) {
+        return stream_main(s);
     }
 
-    FILE *fp;
-    fp = fopen(s, "rb"); // "rb" is unusual for text files, "r" is more common.
-    if (fp == NULL) {
+    // yydebug = 1; // Uncomment for bison debug output if compiled with debug support
+    SmtParseContext pctx = { NULL };
+    int parse_result = 0;
+    if (!from_image) {
+        TRACE(TRACE_INFO, "\nSTARTING PARSING...\n");
+        parse_result = parseSmtPath(s, &pctx); // The file is mapped and scanned in place
+    }
+    if (parse_result < 0) {
         perror("Error opening file");
         printf("File %s can't be opened.\n", s);
         exit(1);
-    } else {
-        yyin = fp;
     }
 
-    // yydebug = 1; // Uncomment for bison debug output if compiled with debug support
-    printf("\nSTARTING PARSING...\n");
-    int parse_result = yyparse(); // Store result for checking
-    extern struct SmtProplist* root;
-
-    if (parse_result == 0) {
-        printf("\nPARSING FINISHED SUCCESSFULLY.\n");
-        if (root) {
-            printf("Original Proplist:\n");
-            printSmtProplist(root); // Assuming this prints original order
-            root = reverseList(root); // As per original main
-            printf("\nReversed Proplist for Solver:\n");
-            printSmtProplist(root);
+    SolverContext* ctx = solver_context_new();
+    ctx->props = pctx.root;
+
+    if (from_image) {
+        ctx->props = image.list; // Already in solver order
+    } else if (parse_result == 0) {
+        TRACE(TRACE_INFO, "\nPARSING FINISHED SUCCESSFULLY.\n");
+        if (ctx->props) {
+            TRACE(TRACE_PROPS, "Original Proplist:\n");
+            if (TRACE_ON(TRACE_PROPS)) printSmtProplistToFile(ctx->props, trace_file()); // Assuming this prints original order
+            ctx->props = reverseList(ctx->props); // As per original main
+            TRACE(TRACE_PROPS, "\nReversed Proplist for Solver:\n");
+            if (TRACE_ON(TRACE_PROPS)) printSmtProplistToFile(ctx->props, trace_file());
         } else {
-            printf("Parsing successful, but root SmtProplist is NULL.\n");
+            TRACE(TRACE_INFO, "Parsing successful, but root SmtProplist is NULL.\n");
         }
     } else {
-        printf("\nPARSING FAILED with code: %d.\n", parse_result);
-        fclose(fp);
+        if (output_format == OUTPUT_TEXT) printf("\nPARSING FAILED with code: %d.\n", parse_result);
+        report_result(s, -1, NULL);
+        solver_context_free(ctx);
+        narrow_log_close(narrow_log);
         return 1; // Exit if parsing failed
     }
 
-    printf("\nSTARTING INTERVAL SOLVER...\n");
-    int res = interval_solver(root);
-    printf("\nINTERVAL SOLVER FINISHED.\n");
+    if (save != NULL) {
+        int saved = smtbin_write(ctx->props, save);
+        if (saved != 0) perror(save);
+        else TRACE(TRACE_INFO, "Saved problem image to %s.\n", save);
+        solver_context_free(ctx);
+        return saved != 0 ? 1 : 0;
+    }
 
-    if (res == 1) {
-        printf("Result: An empty interval was found (inconsistency detected).\n");
+    TRACE(TRACE_INFO, "\nSTARTING INTERVAL SOLVER...\n");
+    if (collect_stats) solver_stats_enable(ctx);
+    ctx->narrow_log = narrow_log;
+    if (budgeted()) ctx->budget = &solve_budget;
+    int res;
+    if (portfolio > 1) {
+        int winner;
+        res = portfolio_solve(ctx, portfolio, &winner);
+        if (winner >= 0) TRACE(TRACE_INFO, "Portfolio: strategy %d of %d answered first.\n", winner, portfolio);
+        else TRACE(TRACE_INFO, "Portfolio: no strategy converged within its iteration limit.\n");
     } else {
-        printf("Result: No empty interval found (consistent within interval arithmetic limits).\n");
+        res = interval_solver(ctx);
     }
-    
-    // Print final intervals for debugging
-    // printf("\n--- Final Variable Intervals ---\n");
-    // for(int i=0; i < g_var_map_count; ++i) {
-    //     if(g_var_map[i].active) {
-    //         printf("Var '%s': [%lld, %lld]\n", g_var_map[i].name, g_var_map[i].interval.lower, g_var_map[i].interval.upper);
-    //     }
-    // }
-
-    fclose(fp);
-
-    printf("\nCleaning up AST...\n");
-    if (root) {
-        freeSmtProplist(root);
-        root = NULL;
-}
+    TRACE(TRACE_INFO, "\nINTERVAL SOLVER FINISHED.\n");
+    if (narrow_log_close(narrow_log) != 0) exit(1);
+
+    report_result(s, res, ctx);
+
+    TRACE(TRACE_PROPS, "\n--- Final Variable Intervals ---\n");
+    for (int i = 0; TRACE_ON(TRACE_PROPS) && i < ctx->var_map_count; ++i) {
+        if (ctx->var_map[i].active) {
+            trace_printf("Var '%s': [%lld, %lld]\n", ctx->var_map[i].name, ctx->var_map[i].interval.lower, ctx->var_map[i].interval.upper);
+        }
+    }
+
+    TRACE(TRACE_INFO, "\nCleaning up AST...\n");
+    if (from_image) ctx->props = NULL; // Owned by the mapping
+    solver_context_free(ctx); // Frees the proplist as well
+    if (from_image) smtbin_unload(&image);
 
     return 0;
 }
\ No newline at end of file
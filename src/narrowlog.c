@@ -0,0 +1,512 @@
+#include "narrowlog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TERM_TEXT_MAX 72 // Longer terms are cut short in the descriptions
+#define TERM_TEXT_DEPTH 24
+#define CREEP_FRACTION 16
+
+struct NarrowLog {
+    int fd;
+    char* path;
+    bool ring;
+    NarrowEvent* events;
+    int capacity;
+    int count;     // Events held
+    int start;     // Oldest held event, ring mode only
+    uint64_t seq;
+    uint64_t written;
+    uint64_t dropped;
+    bool failed;   // A write failed; reported once at close
+
+    uint32_t run;
+    uint8_t phase;
+    int32_t constraint;
+
+    // Descriptions of the finished runs, in file layout
+    char* desc;
+    size_t desc_len;
+    size_t desc_cap;
+};
+
+static bool write_all(int fd, const void* data, size_t n) {
+    const char* p = (const char*)data;
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+static void write_events(NarrowLog* log, const NarrowEvent* ev, int n) {
+    if (n == 0 || log->failed) return;
+    if (!write_all(log->fd, ev, sizeof(NarrowEvent) * n)) log->failed = true;
+    else log->written += n;
+}
+
+NarrowLog* narrow_log_open(const char* path, int capacity, bool ring) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    NarrowLog* log = (NarrowLog*)calloc(1, sizeof(NarrowLog));
+    log->fd = fd;
+    log->path = strdup(path);
+    log->ring = ring;
+    log->capacity = capacity > 0 ? capacity : NARROW_LOG_DEFAULT;
+    log->events = (NarrowEvent*)malloc(sizeof(NarrowEvent) * log->capacity);
+    log->phase = PHASE_OTHER;
+    log->constraint = -1;
+    NarrowLogHeader h = { .magic = { 0 }, .version = 0, .event_size = 0, .ring = 0, .events = 0, .dropped = 0, .desc_offset = 0 }; // Rewritten at close with the counts
+    if (!write_all(fd, &h, sizeof(h))) log->failed = true;
+    return log;
+}
+
+// --- Recording ---
+
+void narrow_log_record(NarrowLog* log, NarrowKind kind, int slot, Interval old_iv, Interval new_iv) {
+    int at;
+    if (log->count < log->capacity) {
+        at = (log->start + log->count++) % log->capacity;
+    } else if (log->ring) {
+        at = log->start; // Overwrite the oldest
+        log->start = (log->start + 1) % log->capacity;
+        log->dropped++;
+    } else {
+        write_events(log, log->events, log->count);
+        log->count = 1;
+        at = 0;
+    }
+    NarrowEvent* e = &log->events[at];
+    e->old_lower = old_iv.lower;
+    e->old_upper = old_iv.upper;
+    e->new_lower = new_iv.lower;
+    e->new_upper = new_iv.upper;
+    e->seq = log->seq++;
+    e->constraint = log->constraint;
+    e->slot = slot;
+    e->run = log->run;
+    e->phase = log->phase;
+    e->kind = (uint8_t)kind;
+    e->reserved = 0;
+}
+
+void narrow_log_set_phase(NarrowLog* log, SolverPhase phase) {
+    log->phase = (uint8_t)phase;
+    log->constraint = -1;
+}
+
+void narrow_log_set_constraint(NarrowLog* log, int constraint) {
+    log->constraint = constraint;
+}
+
+// --- Descriptions ---
+
+typedef struct {
+    char buf[TERM_TEXT_MAX + 4];
+    int len;
+    bool cut;
+} TermText;
+
+static void text_put(TermText* t, const char* s) {
+    for (; *s && !t->cut; ++s) {
+        if (t->len == TERM_TEXT_MAX) {
+            memcpy(t->buf + t->len, "...", 3);
+            t->len += 3;
+            t->cut = true;
+        } else {
+            t->buf[t->len++] = *s;
+        }
+    }
+}
+
+static void text_term(TermText* t, const SmtTerm* term, int depth) {
+    if (t->cut) return;
+    if (term == NULL || depth == TERM_TEXT_DEPTH) {
+        text_put(t, "...");
+        return;
+    }
+    char num[16];
+    switch (term->type) {
+        case SMT_LiaBTerm:
+        case SMT_NiaBTerm: {
+            static const char* ops[] = { "?", " + ", " - ", " << ", " >> ", " * ", " / " };
+            int op = term->term.BTerm.op;
+            text_put(t, "(");
+            text_term(t, term->term.BTerm.t1, depth + 1);
+            text_put(t, op >= LIA_ADD && op <= LIA_DIV ? ops[op] : ops[0]);
+            text_term(t, term->term.BTerm.t2, depth + 1);
+            text_put(t, ")");
+            break;
+        }
+        case SMT_LiaUTerm:
+            text_put(t, "(-");
+            text_term(t, term->term.UTerm.t, depth + 1);
+            text_put(t, ")");
+            break;
+        case SMT_UFTerm:
+            text_put(t, term->term.UFTerm->name);
+            text_put(t, "(");
+            for (int i = 0; i < term->term.UFTerm->numArgs; ++i) {
+                if (i > 0) text_put(t, ",");
+                text_term(t, term->term.UFTerm->args[i], depth + 1);
+            }
+            text_put(t, ")");
+            break;
+        case SMT_ConstNum:
+            snprintf(num, sizeof(num), "%d", term->term.ConstNum);
+            text_put(t, num);
+            break;
+        case SMT_VarNum:
+            snprintf(num, sizeof(num), "VAR_%d", term->term.ConstNum);
+            text_put(t, num);
+            break;
+        case SMT_VarName:
+            text_put(t, term->term.Variable);
+            break;
+        default:
+            text_put(t, "?");
+            break;
+    }
+}
+
+static void add_desc(NarrowLog* log, NarrowDescType type, int index, const char* text, int len) {
+    if (len > UINT16_MAX) len = UINT16_MAX;
+    size_t need = sizeof(NarrowDesc) + (size_t)len;
+    if (log->desc_len + need > log->desc_cap) {
+        log->desc_cap = log->desc_cap ? log->desc_cap * 2 : 4096;
+        while (log->desc_len + need > log->desc_cap) log->desc_cap *= 2;
+        log->desc = (char*)realloc(log->desc, log->desc_cap);
+    }
+    NarrowDesc d = { log->run, index, (uint8_t)type, 0, (uint16_t)len };
+    memcpy(log->desc + log->desc_len, &d, sizeof(d));
+    memcpy(log->desc + log->desc_len + sizeof(d), text, len);
+    log->desc_len += need;
+}
+
+void narrow_log_begin_run(NarrowLog* log) {
+    log->run++;
+    log->phase = PHASE_OTHER;
+    log->constraint = -1;
+}
+
+void narrow_log_end_run(NarrowLog* log, const SolverContext* ctx, const AtomConstraint* cons, int count, NarrowMarks* marks) {
+    static const char* rels[] = { " <= ", " < ", " >= ", " > ", " = " };
+    NarrowMarks from = marks != NULL ? *marks : (NarrowMarks){ 0, 0, 0 };
+    for (int c = from.cons; c < count; ++c) {
+        TermText t = { { 0 }, 0, false };
+        text_term(&t, cons[c].term1, 0);
+        TermText t2 = { { 0 }, 0, false };
+        text_term(&t2, cons[c].term2, 0);
+        char line[2 * sizeof(t.buf) + 8];
+        int op = cons[c].op - SMT_LE;
+        const char* rel = cons[c].distinct ? " != " : op >= 0 && op < 5 ? rels[op] : " ? ";
+        int len = snprintf(line, sizeof(line), "%.*s%s%.*s", t.len, t.buf, rel, t2.len, t2.buf);
+        add_desc(log, NARROW_DESC_CONSTRAINT, c, line, len);
+    }
+    for (int i = from.vars; i < ctx->var_map_count; ++i) {
+        if (ctx->var_map[i].active) add_desc(log, NARROW_DESC_VAR, i, ctx->var_map[i].name, (int)strlen(ctx->var_map[i].name));
+    }
+    for (int i = from.terms; i < ctx->term_map_count; ++i) {
+        if (!ctx->term_map[i].active) continue;
+        TermText t = { { 0 }, 0, false };
+        text_term(&t, ctx->term_map[i].term_ptr, 0);
+        add_desc(log, NARROW_DESC_TERM, i, t.buf, t.len);
+    }
+    if (marks != NULL) *marks = (NarrowMarks){ ctx->var_map_count, ctx->term_map_count, count };
+    log->phase = PHASE_OTHER;
+    log->constraint = -1;
+}
+
+// --- Closing ---
+
+int narrow_log_close(NarrowLog* log) {
+    if (log == NULL) return 0;
+    // Oldest first: a ring that wrapped holds its tail before its head
+    int first = log->ring ? log->capacity - log->start : log->count;
+    if (first > log->count) first = log->count;
+    write_events(log, log->events + log->start, first);
+    write_events(log, log->events, log->count - first);
+
+    NarrowLogHeader h;
+    memcpy(h.magic, NARROW_LOG_MAGIC, 4);
+    h.version = NARROW_LOG_VERSION;
+    h.event_size = sizeof(NarrowEvent);
+    h.ring = log->ring ? 1 : 0;
+    h.events = log->written;
+    h.dropped = log->dropped;
+    h.desc_offset = sizeof(NarrowLogHeader) + log->written * sizeof(NarrowEvent);
+    if (!log->failed && !write_all(log->fd, log->desc, log->desc_len)) log->failed = true;
+    if (!log->failed && pwrite(log->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) log->failed = true;
+    if (close(log->fd) != 0) log->failed = true;
+    int res = 0;
+    if (log->failed) {
+        fprintf(stderr, "Error: %s: narrowing log could not be written\n", log->path);
+        res = -1;
+    }
+    free(log->events);
+    free(log->desc);
+    free(log->path);
+    free(log);
+    return res;
+}
+
+// --- Replay ---
+
+typedef struct {
+    const NarrowDesc* d;
+    const char* text;
+} DescRef;
+
+typedef struct {
+    const NarrowEvent* events;
+    DescRef* descs;
+    int desc_count;
+} ReplayLog;
+
+static int compare_desc_key(const NarrowDesc* x, const NarrowDesc* y) {
+    if (x->type != y->type) return x->type < y->type ? -1 : 1;
+    if (x->index != y->index) return x->index < y->index ? -1 : 1;
+    return x->run < y->run ? -1 : x->run > y->run;
+}
+
+static int compare_desc(const void* a, const void* b) {
+    return compare_desc_key(((const DescRef*)a)->d, ((const DescRef*)b)->d);
+}
+
+// Latest description of an index up to a run, "?" if there is none
+static void print_desc(const ReplayLog* r, uint32_t run, NarrowDescType type, int32_t index, FILE* out) {
+    NarrowDesc key = { run, index, (uint8_t)type, 0, 0 };
+    int lo = 0, hi = r->desc_count; // First entry after key
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (compare_desc_key(r->descs[mid].d, &key) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    const NarrowDesc* d = lo > 0 ? r->descs[lo - 1].d : NULL;
+    if (d == NULL || d->type != type || d->index != index) fputc('?', out);
+    else fprintf(out, "%.*s", (int)d->len, r->descs[lo - 1].text);
+}
+
+// Events grouped by run and slot, in log order within a slot
+static int compare_event(const void* a, const void* b) {
+    const NarrowEvent* x = *(const NarrowEvent* const*)a;
+    const NarrowEvent* y = *(const NarrowEvent* const*)b;
+    if (x->run != y->run) return x->run < y->run ? -1 : 1;
+    if (x->kind != y->kind) return x->kind < y->kind ? -1 : 1;
+    if (x->slot != y->slot) return x->slot < y->slot ? -1 : 1;
+    return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+static void print_bound(long long v, FILE* out) {
+    if (v == LLONG_MIN) fputs("-inf", out);
+    else if (v == LLONG_MAX) fputs("+inf", out);
+    else fprintf(out, "%lld", v);
+}
+
+static void print_interval(long long lo, long long hi, FILE* out) {
+    if (lo > hi) {
+        fputs("empty", out);
+        return;
+    }
+    fputc('[', out);
+    print_bound(lo, out);
+    fputs(", ", out);
+    print_bound(hi, out);
+    fputc(']', out);
+}
+
+static void print_event(const ReplayLog* r, const NarrowEvent* e, FILE* out) {
+    static const char* phases[PHASE_COUNT] = { "forward", "relation", "backward", "other" };
+    fprintf(out, "      #%-8llu %-8s ", (unsigned long long)e->seq, e->phase < PHASE_COUNT ? phases[e->phase] : "?");
+    print_interval(e->old_lower, e->old_upper, out);
+    fputs(" -> ", out);
+    print_interval(e->new_lower, e->new_upper, out);
+    if (e->constraint >= 0) {
+        fprintf(out, "  by c%d: ", e->constraint);
+        print_desc(r, e->run, NARROW_DESC_CONSTRAINT, e->constraint, out);
+    }
+    fputc('\n', out);
+}
+
+// Width an event removed from a finite interval; false unless the event is a creeping
+// step, one that leaves a finite interval with all but at most 1/CREEP_FRACTION of its width
+static bool creep_step(const NarrowEvent* e, unsigned long long* removed) {
+    if (e->old_lower == LLONG_MIN || e->old_upper == LLONG_MAX || e->new_lower > e->new_upper) return false;
+    unsigned long long before = (unsigned long long)e->old_upper - (unsigned long long)e->old_lower;
+    unsigned long long after = (unsigned long long)e->new_upper - (unsigned long long)e->new_lower;
+    *removed = before - after;
+    return *removed <= before / CREEP_FRACTION;
+}
+
+typedef struct {
+    int first; // Index into the sorted order
+    int length;
+    unsigned long long min_removed;
+    unsigned long long max_removed;
+} Creep;
+
+static int compare_creep(const void* a, const void* b) {
+    const Creep* x = (const Creep*)a;
+    const Creep* y = (const Creep*)b;
+    if (x->length != y->length) return x->length > y->length ? -1 : 1;
+    return x->first - y->first;
+}
+
+static void print_slot(const ReplayLog* r, const NarrowEvent* e, FILE* out) {
+    fputs(e->kind == NARROW_VAR ? "var " : "term ", out);
+    print_desc(r, e->run, e->kind == NARROW_VAR ? NARROW_DESC_VAR : NARROW_DESC_TERM, e->slot, out);
+}
+
+int narrow_log_replay(const char* path, int creep, int chain_max, FILE* out) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* data = (char*)malloc(size > 0 ? size : 1);
+    size_t got = size > 0 ? fread(data, 1, size, fp) : 0;
+    fclose(fp);
+
+    NarrowLogHeader h;
+    const char* problem = NULL;
+    if (size < 0 || got != (size_t)size || (size_t)size < sizeof(h)) problem = "not a narrowing log";
+    else {
+        memcpy(&h, data, sizeof(h));
+        if (memcmp(h.magic, NARROW_LOG_MAGIC, 4) != 0) problem = "not a narrowing log";
+        else if (h.version != NARROW_LOG_VERSION || h.event_size != sizeof(NarrowEvent)) problem = "unsupported narrowing log version";
+        else if (h.events > ((uint64_t)size - sizeof(h)) / sizeof(NarrowEvent) || h.desc_offset != sizeof(h) + h.events * sizeof(NarrowEvent)) problem = "truncated narrowing log";
+    }
+    if (problem != NULL) {
+        fprintf(stderr, "Error: %s: %s\n", path, problem);
+        free(data);
+        return -1;
+    }
+
+    ReplayLog r = { (const NarrowEvent*)(data + sizeof(h)), NULL, 0 };
+    int desc_cap = 0;
+    uint32_t runs = 0;
+    for (size_t at = h.desc_offset; at + sizeof(NarrowDesc) <= (size_t)size;) {
+        const NarrowDesc* d = (const NarrowDesc*)(data + at);
+        if (at + sizeof(NarrowDesc) + d->len > (size_t)size) break;
+        if (r.desc_count == desc_cap) {
+            desc_cap = desc_cap ? desc_cap * 2 : 256;
+            r.descs = (DescRef*)realloc(r.descs, sizeof(DescRef) * desc_cap);
+        }
+        r.descs[r.desc_count++] = (DescRef){ d, data + at + sizeof(NarrowDesc) };
+        if (d->run > runs) runs = d->run;
+        at += sizeof(NarrowDesc) + d->len;
+    }
+    qsort(r.descs, r.desc_count, sizeof(DescRef), compare_desc);
+
+    if (chain_max <= 0) chain_max = INT_MAX;
+    int n = (int)h.events;
+    const NarrowEvent** order = (const NarrowEvent**)malloc(sizeof(NarrowEvent*) * (n > 0 ? n : 1));
+    for (int i = 0; i < n; ++i) order[i] = &r.events[i];
+    qsort(order, n, sizeof(NarrowEvent*), compare_event);
+
+    fprintf(out, "Narrowing log %s: %d events", path, n);
+    if (h.ring) fprintf(out, " (the last of %llu)", (unsigned long long)(h.events + h.dropped));
+    fprintf(out, ", %u runs\n", runs);
+
+    Creep* creeps = NULL;
+    int creep_count = 0, creep_cap = 0;
+    uint32_t run = UINT32_MAX;
+    for (int i = 0; i < n;) {
+        const NarrowEvent* head = order[i];
+        int j = i;
+        while (j < n && order[j]->run == head->run && order[j]->kind == head->kind && order[j]->slot == head->slot) j++;
+        if (head->run != run) {
+            run = head->run;
+            fprintf(out, "\nRun %u\n", run);
+        }
+        fputs("  ", out);
+        print_slot(&r, head, out);
+        fprintf(out, ": %d narrowing%s\n", j - i, j - i == 1 ? "" : "s");
+        int shown_head = j - i <= chain_max ? j - i : chain_max - chain_max / 3;
+        for (int k = i; k < j; ++k) {
+            if (k == i + shown_head && j - k > chain_max / 3) {
+                int skip = j - i - shown_head - chain_max / 3;
+                fprintf(out, "      ... %d more\n", skip);
+                k += skip - 1;
+                continue;
+            }
+            print_event(&r, order[k], out);
+        }
+
+        // Runs of creeping steps within the chain
+        for (int k = i; k < j;) {
+            unsigned long long removed, lo, hi;
+            if (!creep_step(order[k], &removed)) {
+                k++;
+                continue;
+            }
+            lo = hi = removed;
+            int m = k + 1;
+            for (; m < j && creep_step(order[m], &removed); ++m) {
+                if (removed < lo) lo = removed;
+                if (removed > hi) hi = removed;
+            }
+            if (m - k >= creep) {
+                if (creep_count == creep_cap) {
+                    creep_cap = creep_cap ? creep_cap * 2 : 16;
+                    creeps = (Creep*)realloc(creeps, sizeof(Creep) * creep_cap);
+                }
+                creeps[creep_count++] = (Creep){ k, m - k, lo, hi };
+            }
+            k = m;
+        }
+        i = j;
+    }
+
+    fprintf(out, "\nCreeping sequences (%d or more steps each removing at most 1/%d of the width): %d\n", creep, CREEP_FRACTION, creep_count);
+    qsort(creeps, creep_count, sizeof(Creep), compare_creep);
+    for (int c = 0; c < creep_count; ++c) {
+        const NarrowEvent* first = order[creeps[c].first];
+        const NarrowEvent* last = order[creeps[c].first + creeps[c].length - 1];
+        fprintf(out, "  run %u ", first->run);
+        print_slot(&r, first, out);
+        fprintf(out, ": %d narrowings removing %llu", creeps[c].length, creeps[c].min_removed);
+        if (creeps[c].max_removed != creeps[c].min_removed) fprintf(out, " to %llu", creeps[c].max_removed);
+        fprintf(out, " each, #%llu to #%llu, ", (unsigned long long)first->seq, (unsigned long long)last->seq);
+        print_interval(first->old_lower, first->old_upper, out);
+        fputs(" -> ", out);
+        print_interval(last->new_lower, last->new_upper, out);
+        fputs(", constraints", out);
+        // The distinct constraints driving it, in order of first appearance
+        int32_t listed[8];
+        int listed_count = 0;
+        for (int k = 0; k < creeps[c].length && listed_count < 8; ++k) {
+            int32_t id = order[creeps[c].first + k]->constraint;
+            bool seen = false;
+            for (int q = 0; q < listed_count && !seen; ++q) seen = listed[q] == id;
+            if (seen) continue;
+            fprintf(out, listed_count ? ", " : " ");
+            listed[listed_count++] = id;
+            if (id < 0) fputs("(none)", out);
+            else fprintf(out, "c%d", id);
+        }
+        fputc('\n', out);
+    }
+
+    free(creeps);
+    free(order);
+    free(r.descs);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#ifndef NARROWLOG_H
+#define NARROWLOG_H 1
+#include "interval_solver.h"
+#include "stats.h"
+#include <stdint.h>
+
+// --- Narrowing Log ---
+// An opt-in binary record of every interval write during propagation: which constraint
+// narrowed which slot, from what bounds to what bounds, in which phase. Events go into a
+// fixed array allocated when the log is opened, so recording never allocates; a full
+// array is written to the file with write(2) and reused. In ring mode it is never
+// written early: the oldest events are overwritten and only the last `capacity` reach
+// the file when the log is closed. narrow_log_replay prints the chains of a file.
+//
+// Each propagate_to_fixpoint or solver_check call is a run. Events carry their run
+// number, and at the end of a run the slot and constraint descriptions it needs are kept
+// aside (this allocates, outside the hot path) and written after the events. An event
+// is described by the latest description of its slot or constraint up to its run, so
+// incremental checks only describe what was added since the previous one. Components are solved in turn
+// while a log is attached, so events stay in order; portfolio instances are not logged.
+// Like the other traces the recording sites compile out with -DSMT_NO_TRACE.
+//
+// File: NarrowLogHeader, `events` NarrowEvents oldest first, then at desc_offset the
+// descriptions, each a NarrowDesc followed by `len` bytes of text.
+
+#define NARROW_LOG_MAGIC "SMTN"
+#define NARROW_LOG_VERSION 1
+#define NARROW_LOG_DEFAULT 65536 // Events held in memory
+
+typedef enum {
+    NARROW_VAR,  // slot is a var_map index
+    NARROW_TERM  // slot is a term_map index (a congruence class representative)
+} NarrowKind;
+
+typedef struct {
+    int64_t old_lower;
+    int64_t old_upper;
+    int64_t new_lower;
+    int64_t new_upper;
+    uint64_t seq;       // Position in the whole log, so gaps show overwritten events
+    int32_t constraint; // Index in the run's constraint array, -1 outside a revision
+    int32_t slot;
+    uint32_t run;       // 0 before the first run
+    uint8_t phase;      // SolverPhase
+    uint8_t kind;       // NarrowKind
+    uint16_t reserved;
+} NarrowEvent;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t event_size; // sizeof(NarrowEvent), checked by the reader
+    uint32_t ring;       // 1 if older events may have been overwritten
+    uint64_t events;     // Events in the file
+    uint64_t dropped;    // Events overwritten in ring mode
+    uint64_t desc_offset;
+} NarrowLogHeader;
+
+typedef enum {
+    NARROW_DESC_CONSTRAINT, // index is a constraint index
+    NARROW_DESC_VAR,        // index is a var_map slot, text its name
+    NARROW_DESC_TERM        // index is a term_map slot, text the term (shortened)
+} NarrowDescType;
+
+typedef struct {
+    uint32_t run;
+    int32_t index;
+    uint8_t type; // NarrowDescType
+    uint8_t reserved;
+    uint16_t len;
+} NarrowDesc;
+
+typedef struct NarrowLog NarrowLog;
+
+// Creates path and holds capacity events in memory (NARROW_LOG_DEFAULT if <= 0); ring
+// keeps only the last capacity events. NULL, with the error printed, if path cannot be created.
+NarrowLog* narrow_log_open(const char* path, int capacity, bool ring);
+// Writes the remaining events and the descriptions; 0 on success
+int narrow_log_close(NarrowLog* log);
+void narrow_log_record(NarrowLog* log, NarrowKind kind, int slot, Interval old_iv, Interval new_iv);
+void narrow_log_set_phase(NarrowLog* log, SolverPhase phase);
+void narrow_log_set_constraint(NarrowLog* log, int constraint);
+// Slots and constraints described so far by a context whose maps only grow between runs
+typedef struct {
+    int vars;
+    int terms;
+    int cons;
+} NarrowMarks;
+
+// Bracket one propagation over cons[0..count) on ctx. With marks, only what lies past
+// them is described and they are advanced; without, everything is.
+void narrow_log_begin_run(NarrowLog* log);
+void narrow_log_end_run(NarrowLog* log, const SolverContext* ctx, const AtomConstraint* cons, int count, NarrowMarks* marks);
+
+// Prints the narrowing chain of every slot, run by run, followed by the creeping
+// sequences: creep or more consecutive narrowings of one finite slot that each remove
+// only a small part of its width. Chains longer than chain_max events are shown by their ends. 0 on
+// success, -1 with the error printed if path is not a readable log.
+int narrow_log_replay(const char* path, int creep, int chain_max, FILE* out);
+
+#ifdef SMT_NO_TRACE
+#define NLOG_ON(ctx) 0
+#else
+#define NLOG_ON(ctx) ((ctx)->narrow_log != NULL)
+#endif
+#define NLOG_CONSTRAINT(ctx, c) do { if (NLOG_ON(ctx)) narrow_log_set_constraint((ctx)->narrow_log, (c)); } while (0)
+#endif
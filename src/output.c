@@ -0,0 +1,242 @@
+#include "output.h"
+#include "budget.h"
+#include "stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int output_parse_format(const char* s) {
+    if (strcmp(s, "text") == 0) return OUTPUT_TEXT;
+    if (strcmp(s, "jsonl") == 0) return OUTPUT_JSONL;
+    if (strcmp(s, "csv") == 0) return OUTPUT_CSV;
+    return -1;
+}
+
+// --- Buffer ---
+
+void outbuf_init(OutBuf* b, FILE* sink) {
+    b->cap = sink != NULL ? OUTPUT_BUFFER : 4096;
+    b->data = (char*)malloc(b->cap);
+    b->len = 0;
+    b->sink = sink;
+}
+
+void outbuf_free(OutBuf* b) {
+    outbuf_flush(b);
+    free(b->data);
+    b->data = NULL;
+    b->cap = 0;
+}
+
+void outbuf_flush(OutBuf* b) {
+    if (b->sink == NULL || b->len == 0) return;
+    fwrite(b->data, 1, b->len, b->sink);
+    fflush(b->sink);
+    b->len = 0;
+}
+
+// Room for n more bytes
+static void reserve(OutBuf* b, size_t n) {
+    if (b->len + n <= b->cap) return;
+    if (b->sink != NULL) {
+        outbuf_flush(b);
+        if (n <= b->cap) return;
+    }
+    while (b->len + n > b->cap) b->cap *= 2;
+    b->data = (char*)realloc(b->data, b->cap);
+}
+
+void out_bytes(OutBuf* b, const char* s, size_t n) {
+    reserve(b, n);
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+}
+
+void out_str(OutBuf* b, const char* s) {
+    out_bytes(b, s, strlen(s));
+}
+
+void out_char(OutBuf* b, char c) {
+    reserve(b, 1);
+    b->data[b->len++] = c;
+}
+
+void out_ll(OutBuf* b, long long v) {
+    char tmp[24];
+    int n = 0;
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v; // LLONG_MIN too
+    do {
+        tmp[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    reserve(b, n + 1);
+    if (v < 0) b->data[b->len++] = '-';
+    while (n > 0) b->data[b->len++] = tmp[--n];
+}
+
+// Milliseconds with microsecond resolution
+static void out_ms(OutBuf* b, double ms) {
+    long long us = (long long)(ms * 1000.0 + 0.5);
+    out_ll(b, us / 1000);
+    char frac[5] = { '.', (char)('0' + us / 100 % 10), (char)('0' + us / 10 % 10), (char)('0' + us % 10), 0 };
+    out_bytes(b, frac, 4);
+}
+
+static void out_json_str(OutBuf* b, const char* s) {
+    out_char(b, '"');
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            out_char(b, '\\');
+            out_char(b, (char)c);
+        } else if (c < 0x20) {
+            char esc[7];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out_bytes(b, esc, 6);
+        } else {
+            out_char(b, (char)c);
+        }
+    }
+    out_char(b, '"');
+}
+
+// Quoted only when needed, with quotes doubled
+static void out_csv_str(OutBuf* b, const char* s) {
+    if (strpbrk(s, ",\"\n\r") == NULL) {
+        out_str(b, s);
+        return;
+    }
+    out_char(b, '"');
+    for (; *s; ++s) {
+        if (*s == '"') out_char(b, '"');
+        out_char(b, *s);
+    }
+    out_char(b, '"');
+}
+
+// --- Records ---
+
+static void out_phase_stats(OutBuf* b, const SolverStats* s, SolverPhase p, const char* name) {
+    out_char(b, '"');
+    out_str(b, name);
+    out_str(b, "\":{\"revisions\":");
+    out_ll(b, s->revisions[p]);
+    out_str(b, ",\"noops\":");
+    out_ll(b, s->noops[p]);
+    out_str(b, ",\"narrowings\":");
+    out_ll(b, s->narrowings[p]);
+    out_str(b, ",\"ms\":");
+    out_ms(b, s->phase_ns[p] / 1e6);
+    out_str(b, "},");
+}
+
+static void out_stats(OutBuf* b, const SolverStats* s) {
+    out_str(b, ",\"stats\":{");
+    out_phase_stats(b, s, PHASE_FORWARD, "forward");
+    out_phase_stats(b, s, PHASE_RELATION, "relation");
+    out_phase_stats(b, s, PHASE_BACKWARD, "backward");
+    out_str(b, "\"other_narrowings\":");
+    out_ll(b, s->narrowings[PHASE_OTHER]);
+    out_str(b, ",\"empties\":");
+    out_ll(b, s->empties);
+    out_str(b, ",\"var_lookups\":");
+    out_ll(b, s->var_lookups);
+    out_str(b, ",\"term_lookups\":");
+    out_ll(b, s->term_lookups);
+    out_str(b, ",\"probes\":");
+    out_ll(b, s->lookup_probes);
+    out_char(b, '}');
+}
+
+// A consistent answer cut short by the solve budget rather than the iteration limit
+static bool out_of_budget(int status, const SolverContext* ctx) {
+    return status == 0 && ctx != NULL && ctx->truncated && budget_exhausted(ctx) != BUDGET_NONE;
+}
+
+static const char* status_name(int status, const SolverContext* ctx) {
+    if (status < 0) return "error";
+    if (status == 1) return "unsat";
+    return ctx != NULL && ctx->truncated ? "unknown" : "sat";
+}
+
+void output_header(OutBuf* b, OutputFormat format) {
+    if (format == OUTPUT_CSV) out_str(b, "file,result,truncated,rounds,ms,var,lower,upper\n");
+}
+
+static void csv_prefix(OutBuf* b, const char* source, const char* result, const SolverContext* ctx, double ms) {
+    out_csv_str(b, source);
+    out_char(b, ',');
+    out_str(b, result);
+    out_str(b, ctx != NULL && ctx->truncated ? ",1," : ",0,");
+    out_ll(b, ctx != NULL ? ctx->rounds : 0);
+    out_char(b, ',');
+    out_ms(b, ms);
+    out_char(b, ',');
+}
+
+void output_record(OutBuf* b, OutputFormat format, const char* source, int status, const SolverContext* ctx, double ms) {
+    const char* result = status_name(status, ctx);
+    int vars = ctx != NULL ? ctx->var_map_count : 0;
+    switch (format) {
+        case OUTPUT_TEXT:
+            out_str(b, source);
+            out_char(b, '\t');
+            out_str(b, status < 0 ? "error" : status == 1 ? "inconsistent" : out_of_budget(status, ctx) ? "unknown" : "consistent");
+            out_char(b, '\n');
+            break;
+        case OUTPUT_JSONL: {
+            out_str(b, "{\"file\":");
+            out_json_str(b, source);
+            out_str(b, ",\"result\":\"");
+            out_str(b, result);
+            out_str(b, ctx != NULL && ctx->truncated ? "\",\"truncated\":true" : "\",\"truncated\":false");
+            if (out_of_budget(status, ctx)) {
+                out_str(b, ",\"budget\":\"");
+                out_str(b, budget_limit_name(budget_exhausted(ctx)));
+                out_char(b, '"');
+            }
+            out_str(b, ",\"rounds\":");
+            out_ll(b, ctx != NULL ? ctx->rounds : 0);
+            out_str(b, ",\"ms\":");
+            out_ms(b, ms);
+            out_str(b, ",\"vars\":{");
+            bool first = true;
+            for (int i = 0; i < vars; ++i) {
+                const VarIntervalEntry* v = &ctx->var_map[i];
+                if (!v->active) continue;
+                if (!first) out_char(b, ',');
+                first = false;
+                out_json_str(b, v->name);
+                out_str(b, ":[");
+                out_ll(b, v->interval.lower);
+                out_char(b, ',');
+                out_ll(b, v->interval.upper);
+                out_char(b, ']');
+            }
+            out_char(b, '}');
+            if (ctx != NULL && ctx->stats != NULL) out_stats(b, ctx->stats);
+            out_str(b, "}\n");
+            break;
+        }
+        case OUTPUT_CSV: {
+            bool any = false;
+            for (int i = 0; i < vars; ++i) {
+                const VarIntervalEntry* v = &ctx->var_map[i];
+                if (!v->active) continue;
+                any = true;
+                csv_prefix(b, source, result, ctx, ms);
+                out_csv_str(b, v->name);
+                out_char(b, ',');
+                out_ll(b, v->interval.lower);
+                out_char(b, ',');
+                out_ll(b, v->interval.upper);
+                out_char(b, '\n');
+            }
+            if (!any) {
+                csv_prefix(b, source, result, ctx, ms);
+                out_str(b, ",,\n");
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H 1
+#include "interval_solver.h"
+#include <stdio.h>
+
+// --- Result Output ---
+// Machine-readable results written through one large buffer: fields are appended with
+// memcpy and hand-rolled integer formatting, and the buffer reaches its FILE in
+// OUTPUT_BUFFER-sized writes instead of one printf per field.
+//
+//   jsonl: {"file":"a.txt","result":"unsat","truncated":false,"rounds":12,"ms":0.041,
+//           "vars":{"x":[1,0],"y":[2,9223372036854775807]}}
+//          followed by a "stats" object when the context collected statistics (stats.h)
+//   csv:   file,result,truncated,rounds,ms,var,lower,upper, one row per variable (a row
+//          with empty var fields for a problem without variables)
+//
+// Results are unsat, sat, unknown (consistent but cut off at an iteration limit or by
+// the solve budget) or error; infinite bounds are the saturated LLONG_MIN / LLONG_MAX.
+// A jsonl record cut off by the budget names the limit reached after "truncated", as
+// "budget":"time", "propagations" or "memory"; text lines then say unknown.
+
+#define OUTPUT_BUFFER (1 << 20)
+
+typedef enum {
+    OUTPUT_TEXT,  // The driver's own prose, or `path<TAB>verdict` in batch mode
+    OUTPUT_JSONL,
+    OUTPUT_CSV
+} OutputFormat;
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+    FILE* sink; // Written to whenever the buffer fills; NULL to only collect in memory
+} OutBuf;
+
+// Format from its name (text, jsonl, csv); -1 if unknown
+int output_parse_format(const char* s);
+
+void outbuf_init(OutBuf* b, FILE* sink);
+// Flushes and frees the buffer
+void outbuf_free(OutBuf* b);
+void outbuf_flush(OutBuf* b);
+void out_bytes(OutBuf* b, const char* s, size_t n);
+void out_str(OutBuf* b, const char* s);
+void out_char(OutBuf* b, char c);
+void out_ll(OutBuf* b, long long v);
+
+// Column line for csv, nothing for the other formats
+void output_header(OutBuf* b, OutputFormat format);
+// One problem's result: status is interval_solver's convention or -1 for an error, in
+// which case ctx may be NULL. Variables are taken from ctx's map.
+void output_record(OutBuf* b, OutputFormat format, const char* source, int status, const SolverContext* ctx, double ms);
+#endif
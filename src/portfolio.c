@@ -0,0 +1,113 @@
+#include "portfolio.h"
+#include "interval_solver.h"
+#include "budget.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// --- Strategies ---
+
+SolverStrategy portfolio_strategy(int instance) {
+    // Instances 0-3 cover every constraint and phase order; later ones repeat them
+    // with an iteration limit four times larger per cycle, up to 64 times the default
+    SolverStrategy s;
+    s.reverse_order = (instance & 1) != 0;
+    s.phase_order = (instance & 2) ? PHASES_RELATION_FIRST : PHASES_FORWARD_FIRST;
+    int cycle = instance / 4;
+    s.iteration_scale = 1 << (2 * (cycle < 3 ? cycle : 3));
+    return s;
+}
+
+// --- Race ---
+
+typedef struct {
+    SolverContext** insts;
+    int* results;
+    atomic_int next;     // Next instance to start
+    int count;
+    atomic_int winner;   // First instance with a definitive answer, -1 until then
+    atomic_bool stop;    // Shared by every instance context
+} PortfolioJob;
+
+static void* portfolio_worker(void* arg) {
+    PortfolioJob* job = (PortfolioJob*)arg;
+    int i;
+    while (!atomic_load(&job->stop) && (i = atomic_fetch_add(&job->next, 1)) < job->count) {
+        SolverContext* inst = job->insts[i];
+        if (budget_exhausted(inst) && i > 0) break; // Only the first instance's answer is still wanted
+        int res = interval_solver(inst);
+        if (atomic_load(&job->stop)) break; // Lost the race, the answer may be cut short
+        job->results[i] = res;
+        if (res == 1 || !inst->truncated) {
+            int expected = -1;
+            if (atomic_compare_exchange_strong(&job->winner, &expected, i)) atomic_store(&job->stop, true);
+        }
+    }
+    return NULL;
+}
+
+int portfolio_solve(SolverContext* ctx, int instances, int* winner) {
+    if (instances <= 0) instances = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (instances <= 0) instances = 1;
+
+    PortfolioJob job;
+    job.insts = (SolverContext**)malloc(sizeof(SolverContext*) * instances);
+    job.results = (int*)malloc(sizeof(int) * instances);
+    job.count = instances;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.winner, -1);
+    atomic_init(&job.stop, false);
+    for (int i = 0; i < instances; ++i) {
+        SolverContext* inst = solver_context_new();
+        inst->props = ctx->props; // Read-only, owned by ctx
+        inst->threads = 1;        // The instances already keep the cores busy
+        inst->stop = &job.stop;
+        inst->stop_parent = ctx;
+        inst->budget = ctx->budget;
+        inst->strategy = portfolio_strategy(i);
+        if (ctx->stats) solver_stats_enable(inst);
+        job.insts[i] = inst;
+        job.results[i] = -1;
+    }
+
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * instances);
+    int started = 0;
+    if (instances > 1) {
+        for (; started < instances; ++started) {
+            if (pthread_create(&workers[started], NULL, portfolio_worker, &job) != 0) break;
+        }
+    }
+    if (started == 0) portfolio_worker(&job); // Instances then run in turn until one is definitive
+    for (int t = 0; t < started; ++t) pthread_join(workers[t], NULL);
+    free(workers);
+
+    // Without a definitive answer, fall back to the default strategy's consistent verdict
+    int w = atomic_load(&job.winner);
+    int from = w >= 0 ? w : 0;
+    int res = w >= 0 ? job.results[w] : 0;
+    if (w < 0) ctx->truncated = true;
+
+    SolverContext* best = job.insts[from];
+    NarrowLog* log = ctx->narrow_log; // The instances are not logged, nor is copying their answer
+    ctx->narrow_log = NULL;
+    for (int i = 0; i < best->var_map_count; ++i) {
+        if (!best->var_map[i].active) continue;
+        set_var_interval(ctx, get_or_add_var_entry(ctx, best->var_map[i].name), best->var_map[i].interval);
+    }
+    ctx->narrow_log = log;
+
+    for (int i = 0; i < instances; ++i) {
+        ctx->rounds += job.insts[i]->rounds; // Work done by every instance, not only the winner
+        if (ctx->stats) solver_stats_merge(ctx->stats, job.insts[i]->stats);
+        job.insts[i]->props = NULL;
+        solver_context_free(job.insts[i]);
+    }
+    free(job.insts);
+    free(job.results);
+    if (winner != NULL) *winner = w;
+    return res;
+}
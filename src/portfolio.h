@@ -0,0 +1,17 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H 1
+#include "interval_solver.h"
+
+// --- Portfolio Solving ---
+// Races several solver instances with different strategies over one parsed problem.
+// Each instance has its own context and only reads the shared proplist. The first
+// definitive answer (inconsistent, or consistent without hitting an iteration limit)
+// wins and raises the shared stop flag, which the others poll between rounds.
+
+// Strategy of the given instance; instance 0 is the default strategy
+SolverStrategy portfolio_strategy(int instance);
+// Solves ctx->props with the given number of instances (<= 0 for one per online core).
+// Same result convention as interval_solver; the winner's variable intervals are copied
+// to ctx and its index is stored in *winner (-1 if no instance was definitive).
+int portfolio_solve(SolverContext* ctx, int instances, int* winner);
+#endif
@@ -0,0 +1,269 @@
+#include "server.h"
+#include "smt_lang.h"
+#include "interval_solver.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SERVER_MAX_FRAME ((size_t)1 << 30)
+
+// --- Session ---
+// Per-connection state kept across submissions: the request buffer only ever grows and
+// the context is reset, so a steady stream of small problems stops allocating maps.
+
+typedef struct {
+    char* buf;   // Problem text plus the scanner's two end-of-buffer NULs
+    size_t cap;
+    char* line;  // Frame header
+    size_t line_cap;
+    SolverContext* ctx;
+    ResultCache* cache; // Shared by all connections, NULL if none
+} Session;
+
+static void reply_error(FILE* out, const char* reason) {
+    fprintf(out, "error %s\nend\n", reason);
+    fflush(out);
+}
+
+static void reply_verdict(FILE* out, int res, bool truncated) {
+    fprintf(out, "%s\n", res == 1 ? "unsat" : truncated ? "unknown" : "sat");
+}
+
+static void reply_result(FILE* out, SolverContext* ctx, int res) {
+    reply_verdict(out, res, ctx->truncated);
+    for (int i = 0; i < ctx->var_map_count; ++i) {
+        VarIntervalEntry* v = &ctx->var_map[i];
+        if (!v->active) continue;
+        fprintf(out, "%s %lld %lld\n", v->name, v->interval.lower, v->interval.upper);
+    }
+    fprintf(out, "end\n");
+    fflush(out);
+}
+
+static void reply_canonical(FILE* out, const CanonForm* form, int res, bool truncated) {
+    reply_verdict(out, res, truncated);
+    for (int i = 0; i < form->count; ++i) {
+        fprintf(out, "%s %lld %lld\n", form->names[i], form->intervals[i].lower, form->intervals[i].upper);
+    }
+    fprintf(out, "end\n");
+    fflush(out);
+}
+
+// Answers from the shared cache, or solves and records the answer there
+static void solve_cached(Session* s, FILE* out) {
+    CanonForm form;
+    canonicalize(s->ctx->props, &form);
+    int res;
+    bool truncated;
+    if (!result_cache_lookup(s->cache, &form, &res, &truncated)) {
+        res = interval_solver(s->ctx);
+        truncated = s->ctx->truncated;
+        canon_capture_intervals(&form, s->ctx);
+        result_cache_store(s->cache, &form, res, truncated);
+    }
+    reply_canonical(out, &form, res, truncated);
+    canon_form_free(&form);
+}
+
+// Solves the len bytes now in s->buf; the context is reset for the next frame afterwards
+static void solve_frame(Session* s, size_t len, FILE* out) {
+    s->buf[len] = '\0';
+    s->buf[len + 1] = '\0';
+    SmtParseContext pctx = { NULL };
+    int parse_result = parseSmtBuffer(s->buf, len, &pctx);
+    if (parse_result != 0 || pctx.root == NULL) {
+        freeSmtProplist(pctx.root);
+        reply_error(out, "parse");
+        return;
+    }
+    s->ctx->threads = 1; // Connections already run side by side
+    s->ctx->props = reverseList(pctx.root);
+    if (s->cache != NULL) {
+        solve_cached(s, out);
+    } else {
+        int res = interval_solver(s->ctx);
+        reply_result(out, s->ctx, res);
+    }
+    solver_context_reset(s->ctx);
+}
+
+void server_serve(FILE* in, FILE* out, ResultCache* cache) {
+    Session s = { NULL, 0, NULL, 0, solver_context_new(), cache };
+    while (getline(&s.line, &s.line_cap, in) > 0) {
+        size_t len;
+        char extra;
+        if (strcmp(s.line, "quit\n") == 0) break;
+        if (sscanf(s.line, "solve %zu %c", &len, &extra) != 1) {
+            reply_error(out, "bad frame header"); // The stream cannot be resynchronised
+            break;
+        }
+        if (len > SERVER_MAX_FRAME) {
+            reply_error(out, "frame too large");
+            break;
+        }
+        if (len + 2 > s.cap) {
+            s.cap = len + 2 > 2 * s.cap ? len + 2 : 2 * s.cap;
+            s.buf = (char*)realloc(s.buf, s.cap);
+        }
+        if (fread(s.buf, 1, len, in) != len) {
+            reply_error(out, "truncated frame");
+            break;
+        }
+        solve_frame(&s, len, out);
+    }
+    solver_context_free(s.ctx);
+    free(s.buf);
+    free(s.line);
+}
+
+int server_run_stdio(ResultCache* cache) {
+    server_serve(stdin, stdout, cache);
+    return 0;
+}
+
+// --- Unix Socket ---
+
+typedef struct {
+    int fd;
+    ResultCache* cache;
+} Connection;
+
+static void* connection_worker(void* arg) {
+    Connection conn = *(Connection*)arg;
+    free(arg);
+    int fd = conn.fd;
+    FILE* in = fdopen(fd, "r");
+    int out_fd = dup(fd);
+    FILE* out = out_fd >= 0 ? fdopen(out_fd, "w") : NULL;
+    if (in != NULL && out != NULL) server_serve(in, out, conn.cache);
+    if (out != NULL) fclose(out);
+    else if (out_fd >= 0) close(out_fd);
+    if (in != NULL) fclose(in);
+    else close(fd);
+    return NULL;
+}
+
+static int socket_address(const char* path, struct sockaddr_un* addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Error: socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+int server_run_socket(const char* path, ResultCache* cache) {
+    struct sockaddr_un addr;
+    if (socket_address(path, &addr) != 0) return 1;
+    signal(SIGPIPE, SIG_IGN); // A client that hangs up only ends its own connection
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        perror("socket");
+        return 1;
+    }
+    unlink(path); // A stale socket from an earlier run
+    if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 64) != 0) {
+        perror(path);
+        close(listener);
+        return 1;
+    }
+
+    for (;;) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("accept");
+            break;
+        }
+        Connection* arg = (Connection*)malloc(sizeof(Connection));
+        arg->fd = fd;
+        arg->cache = cache;
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, connection_worker, arg) != 0) {
+            close(fd);
+            free(arg);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    close(listener);
+    return 1;
+}
+
+// --- Client ---
+
+static char* read_file(const char* path, size_t* len) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) return NULL;
+    size_t cap = 4096, n = 0, got;
+    char* buf = (char*)malloc(cap);
+    while ((got = fread(buf + n, 1, cap - n, fp)) > 0) {
+        n += got;
+        if (n == cap) buf = (char*)realloc(buf, cap *= 2);
+    }
+    fclose(fp);
+    *len = n;
+    return buf;
+}
+
+int server_client(const char* path, char** files, int count, FILE* out) {
+    struct sockaddr_un addr;
+    if (socket_address(path, &addr) != 0) return count;
+    signal(SIGPIPE, SIG_IGN);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return count;
+    }
+    FILE* to_server = fdopen(dup(fd), "w");
+    FILE* from_server = fdopen(fd, "r");
+
+    int failed = 0;
+    char* line = NULL;
+    size_t line_cap = 0;
+    for (int i = 0; i < count; ++i) {
+        size_t len;
+        char* text = read_file(files[i], &len);
+        if (text == NULL) {
+            perror(files[i]);
+            fprintf(out, "%s\terror\n", files[i]);
+            failed++;
+            continue;
+        }
+        fprintf(to_server, "solve %zu\n", len);
+        fwrite(text, 1, len, to_server);
+        fflush(to_server);
+        free(text);
+
+        bool first = true;
+        ssize_t n;
+        while ((n = getline(&line, &line_cap, from_server)) > 0) {
+            if (strcmp(line, "end\n") == 0) break;
+            if (first && strncmp(line, "error", 5) == 0) failed++;
+            if (first) fprintf(out, "%s\t%s", files[i], line);
+            else fprintf(out, "\t%s", line);
+            first = false;
+        }
+        if (n <= 0) {
+            fprintf(stderr, "Error: %s: connection closed\n", path);
+            failed += count - i;
+            break;
+        }
+    }
+    fprintf(to_server, "quit\n");
+    fclose(to_server);
+    fclose(from_server);
+    free(line);
+    return failed;
+}
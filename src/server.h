@@ -0,0 +1,32 @@
+#ifndef SERVER_H
+#define SERVER_H 1
+#include "cache.h"
+#include <stdio.h>
+
+// --- Solver Server ---
+// A long-running process that answers problem submissions, so that startup and memory
+// growth are paid once instead of per query. Each submission is one frame:
+//
+//   solve <length>\n<length bytes of problem text>
+//
+// answered with the verdict (unsat, unknown when propagation stopped at an iteration
+// limit, sat otherwise), one `<name> <lower> <upper>` line per variable with its final
+// interval, and a closing `end` line. A frame that does not parse is answered with
+// `error <reason>` and `end`; `quit` closes the connection. Every connection keeps one
+// request buffer and one SolverContext, reset rather than freed between submissions.
+// With a result cache (cache.h) shared by all connections, a problem equivalent to one
+// answered before is not solved again; variables are then listed in canonical order.
+
+// Serves one connection reading frames from in and answering on out, until EOF or quit.
+// cache may be NULL.
+void server_serve(FILE* in, FILE* out, ResultCache* cache);
+// Serves stdin / stdout; returns 0
+int server_run_stdio(ResultCache* cache);
+// Listens on a Unix domain socket at path and serves every connection on a thread of its
+// own until the process is killed; returns 1 if the socket cannot be set up
+int server_run_socket(const char* path, ResultCache* cache);
+
+// Submits each file to the server at socket path, printing `path<TAB>verdict` followed
+// by the interval lines indented by a tab; returns the number of files that failed
+int server_client(const char* path, char** files, int count, FILE* out);
+#endif
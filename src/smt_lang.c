@@ -86,59 +86,156 @@ SmtProp* newSmtProp(int nodetype, int op, SmtProp* prop1, SmtProp* prop2, SmtTer
     return res;
 }
 
-void printUFunctionToFile(UFunction* uf, FILE * fp) {
+// --- 显式栈 ---
+
+void smt_walk_init(SmtWalk* w){
+    w->items = w->inline_items;
+    w->size = 0;
+    w->cap = SMT_WALK_INLINE;
+}
+
+void smt_walk_free(SmtWalk* w){
+    if(w->items != w->inline_items) free(w->items);
+    smt_walk_init(w);
+}
+
+SmtWalkItem* smt_walk_push(SmtWalk* w, int tag, void* node, void* aux){
+    if(w->size == w->cap){
+        int cap = w->cap * 2;
+        if(w->items == w->inline_items){
+            w->items = (SmtWalkItem*)malloc(sizeof(SmtWalkItem)*cap);
+            memcpy(w->items, w->inline_items, sizeof(SmtWalkItem)*w->size);
+        }
+        else w->items = (SmtWalkItem*)realloc(w->items, sizeof(SmtWalkItem)*cap);
+        w->cap = cap;
+    }
+    SmtWalkItem* it = &w->items[w->size++];
+    it->node = node;
+    it->aux = aux;
+    it->h = 0;
+    it->tag = tag;
+    it->next = 0;
+    return it;
+}
+
+int SmtTerm_arity(SmtTerm* t){
+    switch(t->type){
+        case SMT_LiaBTerm:
+        case SMT_NiaBTerm:
+            return 2;
+        case SMT_LiaUTerm:
+            return 1;
+        case SMT_UFTerm:
+            return t->term.UFTerm ? t->term.UFTerm->numArgs : 0;
+        default:
+            return 0;
+    }
+}
+
+SmtTerm* SmtTerm_child(SmtTerm* t, int i){
+    switch(t->type){
+        case SMT_LiaBTerm:
+        case SMT_NiaBTerm:
+            return i == 0 ? t->term.BTerm.t1 : t->term.BTerm.t2;
+        case SMT_LiaUTerm:
+            return t->term.UTerm.t;
+        case SMT_UFTerm:
+            return t->term.UFTerm->args[i];
+        default:
+            return NULL;
+    }
+}
+
+int SmtProp_arity(SmtProp* p){
+    switch(p->type){
+        case SMTB_PROP:
+            return 2;
+        case SMTU_PROP:
+        case SMT_QUANT_PROP:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+SmtProp* SmtProp_child(SmtProp* p, int i){
+    switch(p->type){
+        case SMTB_PROP:
+            return i == 0 ? p->prop.Binary_prop.prop1 : p->prop.Binary_prop.prop2;
+        case SMTU_PROP:
+            return p->prop.Unary_prop.prop1;
+        case SMT_QUANT_PROP:
+            return p->prop.Quant_prop.body;
+        default:
+            return NULL;
+    }
+}
+
+//遍历中栈元素的种类
+enum {
+    WALK_TERM,
+    WALK_PROP,
+    WALK_UF,
+    WALK_TEXT,      //node 为要原样输出的字符串
+    WALK_PROP_BOP,  //node 为二元命题，输出其联结词
+    WALK_PRED       //node 为原子命题，输出其谓词
+};
+
+// --- 打印 ---
+//每个节点先输出开头部分，再把其余部分（子节点与其间的符号）逆序压栈，输出顺序与递归写法相同
+
+static void push_text(SmtWalk* w, const char* s){
+    smt_walk_push(w, WALK_TEXT, (void*)s, NULL);
+}
+
+static void print_uf_node(SmtWalk* w, UFunction* uf, FILE * fp){
     if(uf->numArgs == 0) fprintf(fp, "%s",uf->name);
     else{
         fprintf(fp, "%s(", uf->name);
-        for(int i = 0; i < uf->numArgs - 1; i++){
-            printSmtTermToFile(uf->args[i], fp);
-            fprintf(fp, ",");
+        push_text(w, ")");
+        for(int i = uf->numArgs - 1; i >= 0; i--){
+            smt_walk_push(w, WALK_TERM, uf->args[i], NULL);
+            if(i > 0) push_text(w, ",");
         }
-        printSmtTermToFile(uf->args[uf->numArgs-1], fp);
-        fprintf(fp, ")");
     }
 }
 
-void printUFunction(UFunction* uf){
-    printUFunctionToFile(uf, stdout);
-}
-
-void printSmtTermToFile(SmtTerm* t, FILE * fp) {
+static void print_term_node(SmtWalk* w, SmtTerm* t, FILE * fp){
     switch(t->type){
         case SMT_LiaBTerm:
             if(t->term.BTerm.op == LIA_ADD || t->term.BTerm.op == LIA_MINUS){
                 fprintf(fp, "(");
-                printSmtTermToFile(t->term.BTerm.t1, fp);
-                if(t->term.BTerm.op == LIA_ADD) fprintf(fp, " + ");
-                else fprintf(fp, " - ");
-                printSmtTermToFile(t->term.BTerm.t2, fp);
-                fprintf(fp, ")");
+                push_text(w, ")");
+                smt_walk_push(w, WALK_TERM, t->term.BTerm.t2, NULL);
+                if(t->term.BTerm.op == LIA_ADD) push_text(w, " + ");
+                else push_text(w, " - ");
+                smt_walk_push(w, WALK_TERM, t->term.BTerm.t1, NULL);
             }
             else {
-                printSmtTermToFile(t->term.BTerm.t1, fp);
-                fprintf(fp, "*");
-                printSmtTermToFile(t->term.BTerm.t2, fp);
+                smt_walk_push(w, WALK_TERM, t->term.BTerm.t2, NULL);
+                push_text(w, "*");
+                smt_walk_push(w, WALK_TERM, t->term.BTerm.t1, NULL);
             }
             break;
         case SMT_NiaBTerm:
             if(t->term.BTerm.op == LIA_MULT || t->term.BTerm.op == LIA_DIV || t->term.BTerm.op == LIA_LSHIFT || t->term.BTerm.op == LIA_RSHIFT){
                 fprintf(fp, "(");
-                printSmtTermToFile(t->term.BTerm.t1, fp);
-                if(t->term.BTerm.op == LIA_MULT) fprintf(fp, " * ");
-                else if(t->term.BTerm.op == LIA_DIV) fprintf(fp, " / ");
-                else if(t->term.BTerm.op == LIA_RSHIFT) fprintf(fp,  ">> ");
-                else fprintf(fp, " << ");
-                printSmtTermToFile(t->term.BTerm.t2, fp);
-                fprintf(fp, ")");
+                push_text(w, ")");
+                smt_walk_push(w, WALK_TERM, t->term.BTerm.t2, NULL);
+                if(t->term.BTerm.op == LIA_MULT) push_text(w, " * ");
+                else if(t->term.BTerm.op == LIA_DIV) push_text(w, " / ");
+                else if(t->term.BTerm.op == LIA_RSHIFT) push_text(w, ">> ");
+                else push_text(w, " << ");
+                smt_walk_push(w, WALK_TERM, t->term.BTerm.t1, NULL);
             }
             break;
         case SMT_LiaUTerm:
             if(t->term.UTerm.op == LIA_NEG) fprintf(fp, "(-");
-            printSmtTermToFile(t->term.UTerm.t, fp);
-            fprintf(fp, ")");
+            push_text(w, ")");
+            smt_walk_push(w, WALK_TERM, t->term.UTerm.t, NULL);
             break;
         case SMT_UFTerm:
-            printUFunctionToFile(t->term.UFTerm, fp);
+            print_uf_node(w, t->term.UFTerm, fp);
             break;
         case SMT_ConstNum:
             fprintf(fp, "%d",t->term.ConstNum);
@@ -157,35 +254,60 @@ void printSmtTermToFile(SmtTerm* t, FILE * fp) {
     }
 }
 
-void printSmtTerm(SmtTerm* t){
-    printSmtTermToFile(t, stdout);
+static void print_prop_bop(SmtProp* p, FILE * fp){
+    switch(p->prop.Binary_prop.op){
+        case SMTPROP_AND:
+            fprintf(fp, " /\\ ");
+            break;
+        case SMTPROP_OR:
+            fprintf(fp, " \\/ ");
+            break;
+        case SMTPROP_IFF:
+            fprintf(fp, " <-> ");
+            break;
+        case SMTPROP_IMPLY:
+            fprintf(fp, " -> ");
+            break;
+        default: 
+            fprintf(fp, "invalid type of SmtPropBop\n");
+            exit(-1);
+            break;
+    }
 }
 
-void printSmtPropToFile(SmtProp* p, FILE * fp) {
+static void print_pred(SmtProp* p, FILE * fp){
+    switch(p->prop.Atomic_prop.op){
+        case SMT_LE:
+            fprintf(fp, " <= ");
+            break;
+        case SMT_LT:
+            fprintf(fp, " < ");
+            break;
+        case SMT_GE:
+            fprintf(fp, " >= ");
+            break;
+        case SMT_GT:
+            fprintf(fp, " > ");
+            break;
+        case SMT_EQ:
+            fprintf(fp, " = ");
+            break;
+        default:
+            fprintf(fp, "invalid type of SmtBinPred\n");
+            fprintf(fp, "error id : %d", p->prop.Atomic_prop.op);
+            exit(-1);
+            break;
+    }
+}
+
+static void print_prop_node(SmtWalk* w, SmtProp* p, FILE * fp){
     switch(p->type){
         case SMTB_PROP:
             fprintf(fp, "(");
-            printSmtPropToFile(p->prop.Binary_prop.prop1, fp);
-            switch(p->prop.Binary_prop.op){
-                case SMTPROP_AND:
-                    fprintf(fp, " /\\ ");
-                    break;
-                case SMTPROP_OR:
-                    fprintf(fp, " \\/ ");
-                    break;
-                case SMTPROP_IFF:
-                    fprintf(fp, " <-> ");
-                    break;
-                case SMTPROP_IMPLY:
-                    fprintf(fp, " -> ");
-                    break;
-                default: 
-                    fprintf(fp, "invalid type of SmtPropBop\n");
-                    exit(-1);
-                    break;
-            }
-            printSmtPropToFile(p->prop.Binary_prop.prop2, fp);
-            fprintf(fp, ")");
+            push_text(w, ")");
+            smt_walk_push(w, WALK_PROP, p->prop.Binary_prop.prop2, NULL);
+            smt_walk_push(w, WALK_PROP_BOP, p, NULL);
+            smt_walk_push(w, WALK_PROP, p->prop.Binary_prop.prop1, NULL);
             break;
         case SMTU_PROP:
             fprintf(fp, "(");
@@ -195,8 +317,8 @@ void printSmtPropToFile(SmtProp* p, FILE * fp) {
                 fprintf(fp, "invalid type of SmtPropUop\n");
                 exit(-1);
             }
-            printSmtPropToFile(p->prop.Unary_prop.prop1, fp);
-            fprintf(fp, ")");
+            push_text(w, ")");
+            smt_walk_push(w, WALK_PROP, p->prop.Unary_prop.prop1, NULL);
             break;
         case SMT_QUANT_PROP:{
             fprintf(fp, "(");
@@ -205,8 +327,8 @@ void printSmtPropToFile(SmtProp* p, FILE * fp) {
             }
             else fprintf(fp, "exists ");
             fprintf(fp, "%s, ", p->prop.Quant_prop.quant_var);
-            printSmtPropToFile(p->prop.Quant_prop.body, fp);
-            fprintf(fp, ")");
+            push_text(w, ")");
+            smt_walk_push(w, WALK_PROP, p->prop.Quant_prop.body, NULL);
             break;
         }
         case SMTAT_PROP_EQ:
@@ -214,30 +336,9 @@ void printSmtPropToFile(SmtProp* p, FILE * fp) {
         case SMTAT_PROP_UF_EQ:
         case SMTAT_PROP_LIA_EQ:
         case SMTAT_PROP_NIA_EQ:
-            printSmtTermToFile(p->prop.Atomic_prop.term1, fp);
-            switch(p->prop.Atomic_prop.op){
-                case SMT_LE:
-                    fprintf(fp, " <= ");
-                    break;
-                case SMT_LT:
-                    fprintf(fp, " < ");
-                    break;
-                case SMT_GE:
-                    fprintf(fp, " >= ");
-                    break;
-                case SMT_GT:
-                    fprintf(fp, " > ");
-                    break;
-                case SMT_EQ:
-                    fprintf(fp, " = ");
-                    break;
-                default:
-                    fprintf(fp, "invalid type of SmtBinPred\n");
-                    fprintf(fp, "error id : %d", p->prop.Atomic_prop.op);
-                    exit(-1);
-                    break;
-            }
-            printSmtTermToFile(p->prop.Atomic_prop.term2, fp);
+            smt_walk_push(w, WALK_TERM, p->prop.Atomic_prop.term2, NULL);
+            smt_walk_push(w, WALK_PRED, p, NULL);
+            smt_walk_push(w, WALK_TERM, p->prop.Atomic_prop.term1, NULL);
             break;
         case SMT_PROPVAR:
             fprintf(fp, "P%d", p->prop.Propvar);
@@ -253,6 +354,57 @@ void printSmtPropToFile(SmtProp* p, FILE * fp) {
     }
 }
 
+//从 tag 类型的 node 开始打印，直到栈空
+static void print_walk(int tag, void* node, FILE * fp){
+    SmtWalk w;
+    smt_walk_init(&w);
+    smt_walk_push(&w, tag, node, NULL);
+    while(w.size > 0){
+        SmtWalkItem it = smt_walk_pop(&w);
+        switch(it.tag){
+            case WALK_TERM:
+                print_term_node(&w, (SmtTerm*)it.node, fp);
+                break;
+            case WALK_PROP:
+                print_prop_node(&w, (SmtProp*)it.node, fp);
+                break;
+            case WALK_UF:
+                print_uf_node(&w, (UFunction*)it.node, fp);
+                break;
+            case WALK_TEXT:
+                fputs((const char*)it.node, fp);
+                break;
+            case WALK_PROP_BOP:
+                print_prop_bop((SmtProp*)it.node, fp);
+                break;
+            case WALK_PRED:
+                print_pred((SmtProp*)it.node, fp);
+                break;
+        }
+    }
+    smt_walk_free(&w);
+}
+
+void printUFunctionToFile(UFunction* uf, FILE * fp) {
+    print_walk(WALK_UF, uf, fp);
+}
+
+void printUFunction(UFunction* uf){
+    printUFunctionToFile(uf, stdout);
+}
+
+void printSmtTermToFile(SmtTerm* t, FILE * fp) {
+    print_walk(WALK_TERM, t, fp);
+}
+
+void printSmtTerm(SmtTerm* t){
+    printSmtTermToFile(t, stdout);
+}
+
+void printSmtPropToFile(SmtProp* p, FILE * fp) {
+    print_walk(WALK_PROP, p, fp);
+}
+
 void printSmtProp(SmtProp* p){
     printSmtPropToFile(p, stdout);
 }
@@ -270,14 +422,21 @@ void printSmtProplist(SmtProplist* p){
     printSmtProplistToFile(p, stdout);
 }
 
-UFunction* copy_UFunction(UFunction* uf){
+// --- 复制 ---
+//栈元素为 (源节点, 结果写入位置)：分配节点写入位置后，再压入各子节点及其在新节点中的位置
+
+//复制函数名与参数个数，参数暂为 NULL
+static UFunction* copy_UFunction_shell(UFunction* uf){
     UFunction* res = (UFunction*)malloc(sizeof(UFunction));
-    res->name = (char*)malloc(sizeof(char)*64);
-    memset(res->name, 0, sizeof(char)*64);
-    strcpy(res->name, uf->name);
+    res->name = strdup(uf->name);
     res->numArgs = uf->numArgs;
     res->args = (SmtTerm**)malloc(sizeof(SmtTerm*)*res->numArgs);
     memset(res->args, 0, sizeof(SmtTerm*)*res->numArgs);
+    return res;
+}
+
+UFunction* copy_UFunction(UFunction* uf){
+    UFunction* res = copy_UFunction_shell(uf);
     for(int i = 0; i < res->numArgs; i++){
         res->args[i] = copy_SmtTerm(uf->args[i]);
     }
@@ -285,199 +444,412 @@ UFunction* copy_UFunction(UFunction* uf){
 }
 
 SmtTerm* copy_SmtTerm(SmtTerm* t){
-    SmtTerm* res = (SmtTerm*)malloc(sizeof(SmtTerm));
-    memset(res, 0, sizeof(SmtTerm));
-    res->type = t->type;
-    switch(t->type){
-        case SMT_LiaBTerm:
-        case SMT_NiaBTerm:
-            res->term.BTerm.t1 = copy_SmtTerm(t->term.BTerm.t1);
-            res->term.BTerm.t2 = copy_SmtTerm(t->term.BTerm.t2);
-            res->term.BTerm.op = t->term.BTerm.op;
-            break;
-        case SMT_LiaUTerm:
-            res->term.UTerm.t = copy_SmtTerm(t->term.UTerm.t);
-            res->term.UTerm.op = t->term.UTerm.op;
-            break;
-        case SMT_UFTerm:
-            res->term.UFTerm = copy_UFunction(t->term.UFTerm);
-            break;
-        case SMT_ConstNum:
-        case SMT_VarNum:
-            res->term.ConstNum = t->term.ConstNum;
-            break;
-        case SMT_VarName:
-            res->term.Variable = (char*)malloc(sizeof(char)*64);
-            memset(res->term.Variable, 0, sizeof(char)*64);
-            strcpy(res->term.Variable, t->term.Variable);
-            break;
-        default:
-            break;
+    SmtTerm* root = NULL;
+    SmtWalk w;
+    smt_walk_init(&w);
+    smt_walk_push(&w, WALK_TERM, t, &root);
+    while(w.size > 0){
+        SmtWalkItem it = smt_walk_pop(&w);
+        t = (SmtTerm*)it.node;
+        SmtTerm* res = (SmtTerm*)malloc(sizeof(SmtTerm));
+        memset(res, 0, sizeof(SmtTerm));
+        res->type = t->type;
+        *(SmtTerm**)it.aux = res;
+        switch(t->type){
+            case SMT_LiaBTerm:
+            case SMT_NiaBTerm:
+                smt_walk_push(&w, WALK_TERM, t->term.BTerm.t2, &res->term.BTerm.t2);
+                smt_walk_push(&w, WALK_TERM, t->term.BTerm.t1, &res->term.BTerm.t1);
+                res->term.BTerm.op = t->term.BTerm.op;
+                break;
+            case SMT_LiaUTerm:
+                smt_walk_push(&w, WALK_TERM, t->term.UTerm.t, &res->term.UTerm.t);
+                res->term.UTerm.op = t->term.UTerm.op;
+                break;
+            case SMT_UFTerm:
+                res->term.UFTerm = copy_UFunction_shell(t->term.UFTerm);
+                for(int i = res->term.UFTerm->numArgs - 1; i >= 0; i--){
+                    smt_walk_push(&w, WALK_TERM, t->term.UFTerm->args[i], &res->term.UFTerm->args[i]);
+                }
+                break;
+            case SMT_ConstNum:
+            case SMT_VarNum:
+                res->term.ConstNum = t->term.ConstNum;
+                break;
+            case SMT_VarName:
+                res->term.Variable = strdup(t->term.Variable);
+                break;
+            default:
+                break;
+        }
     }
-    return res;
+    smt_walk_free(&w);
+    return root;
 } 
 
 SmtProp* copy_SmtProp(SmtProp* p){
-    SmtProp* res = (SmtProp*)malloc(sizeof(SmtProp));
-    res->type = p->type;
-    switch(p->type){
-        case SMTB_PROP:
-            res->prop.Binary_prop.prop1 = copy_SmtProp(p->prop.Binary_prop.prop1);
-            res->prop.Binary_prop.prop2 = copy_SmtProp(p->prop.Binary_prop.prop2);
-            res->prop.Binary_prop.op = p->prop.Binary_prop.op;
-            break;
-        case SMTU_PROP:
-            res->prop.Unary_prop.prop1 = copy_SmtProp(p->prop.Unary_prop.prop1);
-            res->prop.Unary_prop.op = p->prop.Unary_prop.op;
-            break;
-        case SMTAT_PROP_EQ:
-        case SMTAT_PROP_LIA:
-        case SMTAT_PROP_UF_EQ: 
-        case SMTAT_PROP_LIA_EQ:
-        case SMTAT_PROP_NIA_EQ:
-            res->prop.Atomic_prop.term1 = copy_SmtTerm(p->prop.Atomic_prop.term1);
-            res->prop.Atomic_prop.term2 = copy_SmtTerm(p->prop.Atomic_prop.term2);
-            res->prop.Atomic_prop.op = p->prop.Atomic_prop.op;
-            break;
-        case SMT_PROPVAR:
-            res->prop.Propvar = p->prop.Propvar;
-            break;
-        case SMTTF_PROP:
-            res->prop.TF = p->prop.TF;
-            break;
-        default:
-            break;
+    SmtProp* root = NULL;
+    SmtWalk w;
+    smt_walk_init(&w);
+    smt_walk_push(&w, WALK_PROP, p, &root);
+    while(w.size > 0){
+        SmtWalkItem it = smt_walk_pop(&w);
+        p = (SmtProp*)it.node;
+        SmtProp* res = (SmtProp*)malloc(sizeof(SmtProp));
+        res->type = p->type;
+        *(SmtProp**)it.aux = res;
+        switch(p->type){
+            case SMTB_PROP:
+                smt_walk_push(&w, WALK_PROP, p->prop.Binary_prop.prop2, &res->prop.Binary_prop.prop2);
+                smt_walk_push(&w, WALK_PROP, p->prop.Binary_prop.prop1, &res->prop.Binary_prop.prop1);
+                res->prop.Binary_prop.op = p->prop.Binary_prop.op;
+                break;
+            case SMTU_PROP:
+                smt_walk_push(&w, WALK_PROP, p->prop.Unary_prop.prop1, &res->prop.Unary_prop.prop1);
+                res->prop.Unary_prop.op = p->prop.Unary_prop.op;
+                break;
+            case SMTAT_PROP_EQ:
+            case SMTAT_PROP_LIA:
+            case SMTAT_PROP_UF_EQ: 
+            case SMTAT_PROP_LIA_EQ:
+            case SMTAT_PROP_NIA_EQ:
+                res->prop.Atomic_prop.term1 = copy_SmtTerm(p->prop.Atomic_prop.term1);
+                res->prop.Atomic_prop.term2 = copy_SmtTerm(p->prop.Atomic_prop.term2);
+                res->prop.Atomic_prop.op = p->prop.Atomic_prop.op;
+                break;
+            case SMT_PROPVAR:
+                res->prop.Propvar = p->prop.Propvar;
+                break;
+            case SMTTF_PROP:
+                res->prop.TF = p->prop.TF;
+                break;
+            default:
+                break;
+        }
     }
-    return res;
+    smt_walk_free(&w);
+    return root;
 }
 
+// --- 释放 ---
+
 void freeSmtTerm(SmtTerm* t){
     if(t == NULL) return;
-    switch(t->type){
+    SmtWalk w;
+    smt_walk_init(&w);
+    smt_walk_push(&w, WALK_TERM, t, NULL);
+    while(w.size > 0){
+        t = (SmtTerm*)smt_walk_pop(&w).node;
+        if(t == NULL) continue;
+        switch(t->type){
+            case SMT_LiaBTerm:
+            case SMT_NiaBTerm:
+                smt_walk_push(&w, WALK_TERM, t->term.BTerm.t1, NULL);
+                smt_walk_push(&w, WALK_TERM, t->term.BTerm.t2, NULL);
+                break;
+            case SMT_LiaUTerm:
+                smt_walk_push(&w, WALK_TERM, t->term.UTerm.t, NULL);
+                break;
+            case SMT_UFTerm:
+                for(int i = 0; i < t->term.UFTerm->numArgs; i++){
+                    smt_walk_push(&w, WALK_TERM, t->term.UFTerm->args[i], NULL);
+                }
+                free(t->term.UFTerm->args);
+                free(t->term.UFTerm->name);
+                free(t->term.UFTerm);
+                break;
+            case SMT_VarName:
+                free(t->term.Variable);
+                break;
+            case SMT_ConstNum:
+            case SMT_VarNum:
+            default: break;
+        }
+        free(t);
+    }
+    smt_walk_free(&w);
+}
+
+void freeSmtProp(SmtProp* p){
+    if(p == NULL) return;
+    SmtWalk w;
+    smt_walk_init(&w);
+    smt_walk_push(&w, WALK_PROP, p, NULL);
+    while(w.size > 0){
+        p = (SmtProp*)smt_walk_pop(&w).node;
+        if(p == NULL) continue;
+        switch(p->type){
+            case SMTB_PROP:
+                smt_walk_push(&w, WALK_PROP, p->prop.Binary_prop.prop1, NULL);
+                smt_walk_push(&w, WALK_PROP, p->prop.Binary_prop.prop2, NULL);
+                break;
+            case SMTU_PROP:
+                smt_walk_push(&w, WALK_PROP, p->prop.Unary_prop.prop1, NULL);
+                break;
+            case SMTAT_PROP_EQ:
+            case SMTAT_PROP_LIA:
+            case SMTAT_PROP_UF_EQ:
+            case SMTAT_PROP_LIA_EQ:
+                freeSmtTerm(p->prop.Atomic_prop.term1);
+                freeSmtTerm(p->prop.Atomic_prop.term2);
+                break;
+            case SMT_PROPVAR:
+            case SMTTF_PROP:
+            default:
+                break;
+        }
+        free(p);
+    }
+    smt_walk_free(&w);
+}
+
+void freeSmtProplist(SmtProplist* p){
+    while(p != NULL){
+        freeSmtProp(p->prop);
+        SmtProplist* tmp = p->next;
+        free(p);
+        p = tmp;
+    }
+}
+
+// --- 比较 ---
+//栈元素为待比较的一对节点 (node, aux)，按递归写法的顺序比较，遇到第一处不同即返回
+
+bool SmtTerm_eqb(SmtTerm* t1, SmtTerm* t2){
+    bool eq = true;
+    SmtWalk w;
+    smt_walk_init(&w);
+    smt_walk_push(&w, WALK_TERM, t1, t2);
+    while(eq && w.size > 0){
+        SmtWalkItem it = smt_walk_pop(&w);
+        t1 = (SmtTerm*)it.node;
+        t2 = (SmtTerm*)it.aux;
+        if(t1 == NULL || t2 == NULL){
+            printf("error in SmtTerm_eqb, null pointer\n");
+            exit(-1);
+        }
+        if(t1->type != t2->type){
+            eq = false;
+            break;
+        }
+        switch (t1->type)
+        {
         case SMT_LiaBTerm:
-            freeSmtTerm(t->term.BTerm.t1);
-            freeSmtTerm(t->term.BTerm.t2);
+        case SMT_NiaBTerm:
+            eq = t1->term.BTerm.op == t2->term.BTerm.op;
+            smt_walk_push(&w, WALK_TERM, t1->term.BTerm.t2, t2->term.BTerm.t2);
+            smt_walk_push(&w, WALK_TERM, t1->term.BTerm.t1, t2->term.BTerm.t1);
             break;
         case SMT_LiaUTerm:
-            freeSmtTerm(t->term.UTerm.t);
-            break;
-        case SMT_UFTerm:
-            for(int i = 0; i < t->term.UFTerm->numArgs; i++){
-                freeSmtTerm(t->term.UFTerm->args[i]);
+            eq = t1->term.UTerm.op == t2->term.UTerm.op;
+            smt_walk_push(&w, WALK_TERM, t1->term.UTerm.t, t2->term.UTerm.t);
+            break;
+        case SMT_UFTerm:{
+            UFunction* f1 = t1->term.UFTerm;
+            UFunction* f2 = t2->term.UFTerm;
+            if(f1->numArgs != f2->numArgs || strcmp(f1->name, f2->name)){
+                eq = false;
+                break;
+            }
+            for(int i = f1->numArgs - 1; i >= 0; i--){
+                smt_walk_push(&w, WALK_TERM, f1->args[i], f2->args[i]);
             }
-            free(t->term.UFTerm->args);
-            free(t->term.UFTerm);
-            break;
-        case SMT_VarName:
-            free(t->term.Variable);
             break;
+        }
         case SMT_ConstNum:
         case SMT_VarNum:
-        default: break;
+            eq = t1->term.ConstNum == t2->term.ConstNum;
+            break;
+        case SMT_VarName:
+            eq = !strcmp(t1->term.Variable, t2->term.Variable);
+            break;
+        default:
+            printf("error in SmtTerm_eqb, invalid type\n");
+            exit(-1);
+        }
     }
-    free(t);
+    smt_walk_free(&w);
+    return eq;
 }
 
-void freeSmtProp(SmtProp* p){
-    if(p == NULL) return;
-    switch(p->type){
+bool SmtProp_eqb(SmtProp* p1, SmtProp* p2){
+    bool eq = true;
+    SmtWalk w;
+    smt_walk_init(&w);
+    smt_walk_push(&w, WALK_PROP, p1, p2);
+    while(eq && w.size > 0){
+        SmtWalkItem it = smt_walk_pop(&w);
+        p1 = (SmtProp*)it.node;
+        p2 = (SmtProp*)it.aux;
+        if(p1 == NULL || p2 == NULL){
+            printf("error in SmtProp_eqb, null pointer\n");
+            exit(-1);
+        }
+        if(p1->type != p2->type){
+            eq = false;
+            break;
+        }
+        switch (p1->type)
+        {
         case SMTB_PROP:
-            freeSmtProp(p->prop.Binary_prop.prop1);
-            freeSmtProp(p->prop.Binary_prop.prop2);
+            eq = p1->prop.Binary_prop.op == p2->prop.Binary_prop.op;
+            smt_walk_push(&w, WALK_PROP, p1->prop.Binary_prop.prop2, p2->prop.Binary_prop.prop2);
+            smt_walk_push(&w, WALK_PROP, p1->prop.Binary_prop.prop1, p2->prop.Binary_prop.prop1);
             break;
         case SMTU_PROP:
-            freeSmtProp(p->prop.Unary_prop.prop1);
+            smt_walk_push(&w, WALK_PROP, p1->prop.Unary_prop.prop1, p2->prop.Unary_prop.prop1);
+            break;
+        case SMT_QUANT_PROP:
+            eq = (p1->prop.Quant_prop.type == p2->prop.Quant_prop.type)
+                    && !strcmp(p1->prop.Quant_prop.quant_var, p2->prop.Quant_prop.quant_var);
+            smt_walk_push(&w, WALK_PROP, p1->prop.Quant_prop.body, p2->prop.Quant_prop.body);
             break;
-        case SMTAT_PROP_EQ:
         case SMTAT_PROP_LIA:
+            if(p1->prop.Atomic_prop.op != p2->prop.Atomic_prop.op){
+                eq = false;
+                break;
+            }
+            /* fall through */
+        case SMTAT_PROP_EQ:
         case SMTAT_PROP_UF_EQ:
         case SMTAT_PROP_LIA_EQ:
-            freeSmtTerm(p->prop.Atomic_prop.term1);
-            freeSmtTerm(p->prop.Atomic_prop.term2);
+        case SMTAT_PROP_NIA_EQ:
+            eq = SmtTerm_eqb(p1->prop.Atomic_prop.term1, p2->prop.Atomic_prop.term1) 
+                   && SmtTerm_eqb(p1->prop.Atomic_prop.term2, p2->prop.Atomic_prop.term2);
             break;
         case SMT_PROPVAR:
+            eq = p1->prop.Propvar == p2->prop.Propvar;
+            break;
         case SMTTF_PROP:
+            eq = p1->prop.TF == p2->prop.TF;
+            break;
         default:
+            eq = false;
             break;
+        }
     }
-    free(p);
+    smt_walk_free(&w);
+    return eq;
 }
 
-void freeSmtProplist(SmtProplist* p){
-    if(p == NULL) return;
-    freeSmtProp(p->prop);
-    SmtProplist* tmp = p->next;
-    free(p);
-    freeSmtProplist(tmp);
+// --- 哈希 ---
+//后序遍历：节点入栈时先混入自身的部分，子节点的哈希值算完后依次混入父节点的 h
+
+static unsigned long long hash_mix(unsigned long long h, unsigned long long v){
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
 }
 
-bool SmtTerm_eqb(SmtTerm* t1, SmtTerm* t2){
-    if(t1 == NULL || t2 == NULL){
-        printf("error in SmtTerm_eqb, null pointer\n");
-        exit(-1);
+static unsigned long long hash_string(const char* s){
+    unsigned long long h = 1469598103934665603ULL; // FNV-1a
+    while(*s){
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
     }
-    if(t1->type != t2->type) return false;
-    switch (t1->type)
+    return h;
+}
+
+static void push_term_hash(SmtWalk* w, SmtTerm* t){
+    SmtWalkItem* it = smt_walk_push(w, WALK_TERM, t, NULL);
+    unsigned long long h = hash_mix(0, t->type);
+    switch (t->type)
     {
     case SMT_LiaBTerm:
     case SMT_NiaBTerm:
-        return (t1->term.BTerm.op == t2->term.BTerm.op)
-                && (SmtTerm_eqb(t1->term.BTerm.t1, t2->term.BTerm.t1) 
-                && SmtTerm_eqb(t1->term.BTerm.t2, t2->term.BTerm.t2));
+        h = hash_mix(h, t->term.BTerm.op);
+        break;
     case SMT_LiaUTerm:
-        return (t1->term.UTerm.op == t2->term.UTerm.op)
-                && SmtTerm_eqb(t1->term.UTerm.t, t2->term.UTerm.t);
-    case SMT_UFTerm:{
-        UFunction* f1 = t1->term.UFTerm;
-        UFunction* f2 = t2->term.UFTerm;
-        if(f1->numArgs != f2->numArgs || (!strcmp(f1->name, f2->name))) return false;
-        for(int i = 0; i < f1->numArgs; i++){
-            if(!SmtTerm_eqb(f1->args[i], f2->args[i])) return false;
-        }
-        return true;
-    }
+        h = hash_mix(h, t->term.UTerm.op);
+        break;
+    case SMT_UFTerm:
+        h = hash_mix(h, hash_string(t->term.UFTerm->name));
+        break;
     case SMT_ConstNum:
     case SMT_VarNum:
-        return t1->term.ConstNum == t2->term.ConstNum;
+        h = hash_mix(h, (unsigned long long)(long long)t->term.ConstNum);
+        break;
     case SMT_VarName:
-        if(!strcmp(t1->term.Variable, t2->term.Variable)) return true;
-        else return false;
+        h = hash_mix(h, hash_string(t->term.Variable));
+        break;
     default:
-        printf("error in SmtTerm_eqb, invalid type\n");
-        exit(-1);
+        break;
     }
+    it->h = h;
 }
 
-bool SmtProp_eqb(SmtProp* p1, SmtProp* p2){
-    if(p1 == NULL || p2 == NULL){
-        printf("error in SmtProp_eqb, null pointer\n");
-        exit(-1);
+unsigned long long SmtTerm_hash(SmtTerm* t){
+    unsigned long long h = 0;
+    SmtWalk w;
+    smt_walk_init(&w);
+    push_term_hash(&w, t);
+    while(w.size > 0){
+        SmtWalkItem* it = &w.items[w.size - 1];
+        t = (SmtTerm*)it->node;
+        if(it->next < SmtTerm_arity(t)){
+            push_term_hash(&w, SmtTerm_child(t, it->next++));
+            continue;
+        }
+        h = it->h;
+        w.size--;
+        if(w.size > 0) w.items[w.size - 1].h = hash_mix(w.items[w.size - 1].h, h);
     }
-    if(p1->type != p2->type) return false;
-    switch (p1->type)
+    smt_walk_free(&w);
+    return h;
+}
+
+//原子命题的两个项在入栈时就混入，命题节点的子节点只有命题
+static void push_prop_hash(SmtWalk* w, SmtProp* p){
+    SmtWalkItem* it = smt_walk_push(w, WALK_PROP, p, NULL);
+    unsigned long long h = hash_mix(0, p->type);
+    switch (p->type)
     {
     case SMTB_PROP:
-        return (p1->prop.Binary_prop.op == p2->prop.Binary_prop.op) 
-                && SmtProp_eqb(p1->prop.Binary_prop.prop1, p2->prop.Binary_prop.prop1)
-                && SmtProp_eqb(p1->prop.Binary_prop.prop2, p2->prop.Binary_prop.prop2);
-    case SMTU_PROP:
-        return SmtProp_eqb(p1->prop.Unary_prop.prop1, p2->prop.Unary_prop.prop1);
+        h = hash_mix(h, p->prop.Binary_prop.op);
+        break;
+    case SMT_QUANT_PROP:
+        h = hash_mix(h, p->prop.Quant_prop.type);
+        h = hash_mix(h, hash_string(p->prop.Quant_prop.quant_var));
+        break;
     case SMTAT_PROP_LIA:
-        if(p1->prop.Atomic_prop.op != p2->prop.Atomic_prop.op)
-            return false;
+        h = hash_mix(h, p->prop.Atomic_prop.op);
+        /* fall through */
     case SMTAT_PROP_EQ:
     case SMTAT_PROP_UF_EQ:
     case SMTAT_PROP_LIA_EQ:
     case SMTAT_PROP_NIA_EQ:
-        return SmtTerm_eqb(p1->prop.Atomic_prop.term1, p2->prop.Atomic_prop.term1) 
-               && SmtTerm_eqb(p1->prop.Atomic_prop.term2, p2->prop.Atomic_prop.term2);
+        h = hash_mix(h, SmtTerm_hash(p->prop.Atomic_prop.term1));
+        h = hash_mix(h, SmtTerm_hash(p->prop.Atomic_prop.term2));
+        break;
     case SMT_PROPVAR:
-        return p1->prop.Propvar == p2->prop.Propvar;
+        h = hash_mix(h, (unsigned long long)(long long)p->prop.Propvar);
+        break;
     case SMTTF_PROP:
-        return p1->prop.TF == p2->prop.TF;
+        h = hash_mix(h, p->prop.TF);
+        break;
     default:
         break;
     }
+    it->h = h;
+}
+
+unsigned long long SmtProp_hash(SmtProp* p){
+    unsigned long long h = 0;
+    SmtWalk w;
+    smt_walk_init(&w);
+    push_prop_hash(&w, p);
+    while(w.size > 0){
+        SmtWalkItem* it = &w.items[w.size - 1];
+        p = (SmtProp*)it->node;
+        if(it->next < SmtProp_arity(p)){
+            push_prop_hash(&w, SmtProp_child(p, it->next++));
+            continue;
+        }
+        h = it->h;
+        w.size--;
+        if(w.size > 0) w.items[w.size - 1].h = hash_mix(w.items[w.size - 1].h, h);
+    }
+    smt_walk_free(&w);
+    return h;
 }
 
 SmtProplist* reverseList(SmtProplist* head) {
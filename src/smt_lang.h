@@ -155,12 +155,66 @@ void freeSmtTerm(SmtTerm* t);
 void freeSmtProp(SmtProp* p);
 void freeSmtProplist(SmtProplist* p);
 
+//子项个数与第 i 个子项（二元项为 t1、t2，一元项为 t，函数项为各参数）
+int SmtTerm_arity(SmtTerm* t);
+SmtTerm* SmtTerm_child(SmtTerm* t, int i);
+//子命题个数与第 i 个子命题（二元命题为 prop1、prop2，一元命题为 prop1，量词命题为 body）；原子命题的项不算在内
+int SmtProp_arity(SmtProp* p);
+SmtProp* SmtProp_child(SmtProp* p, int i);
+
+//显式栈：遍历项与命题时代替 C 调用栈，使输入深度只受内存限制（x1 + x2 + ... 会解析成与其长度同深的链）。
+//前 SMT_WALK_INLINE 项放在结构体内，浅的遍历不分配内存；用前 smt_walk_init，用后 smt_walk_free
+#define SMT_WALK_INLINE 16
+typedef struct {
+    void* node;             //SmtTerm*、SmtProp* 或 UFunction*，由 tag 区分
+    void* aux;              //遍历自用，如复制时结果要写入的位置
+    unsigned long long h;   //后序遍历中已累积的值
+    int tag;
+    int next;               //下一个要访问的子节点
+} SmtWalkItem;
+
+typedef struct {
+    SmtWalkItem* items;
+    int size;
+    int cap;
+    SmtWalkItem inline_items[SMT_WALK_INLINE];
+} SmtWalk;
+
+void smt_walk_init(SmtWalk* w);
+void smt_walk_free(SmtWalk* w);
+//返回新栈顶，指针在下一次压栈前有效
+SmtWalkItem* smt_walk_push(SmtWalk* w, int tag, void* node, void* aux);
+static inline SmtWalkItem smt_walk_pop(SmtWalk* w) { return w->items[--w->size]; }
+
 //proof生成相关：
 
 //相等返回1，否则返回0
 bool SmtTerm_eqb(SmtTerm* t1, SmtTerm* t2);
 bool SmtProp_eqb(SmtProp* p1, SmtProp* p2);
-
-void yyerror (char *msg);
-int yyparse (void);
+//结构哈希，与 eqb 一致：eqb 相等的两项哈希值相同
+unsigned long long SmtTerm_hash(SmtTerm* t);
+unsigned long long SmtProp_hash(SmtProp* p);
+
+//解析上下文：一次解析的全部状态，由解析器与词法分析器共享；各线程使用各自的上下文即可并行解析
+typedef struct {
+    SmtProplist* root; //解析结果，顺序与输入相反；归约过程的打印见 trace.h
+    //可选：每归约出一个顶层命题即以 (命题, on_prop_arg) 回调；返回非零则停止读取输入，
+    //解析返回 0，root 中只有已读到的命题
+    int (*on_prop)(SmtProp* prop, void* arg);
+    void* on_prop_arg;
+} SmtParseContext;
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+void yyerror (yyscan_t scanner, SmtParseContext* pctx, char *msg);
+int yyparse (yyscan_t scanner, SmtParseContext* pctx);
+//从 fp 解析命题列表到 pctx->root，成功返回 0
+int parseSmtFile (FILE* fp, SmtParseContext* pctx);
+//原地扫描内存中的输入，不经 stdio 与 flex 缓冲区复制：buf 需有 len + 2 字节且末两字节为 '\0'，扫描期间会被临时改写
+int parseSmtBuffer (char* buf, size_t len, SmtParseContext* pctx);
+//以 mmap 映射文件后原地解析，成功返回 0；文件无法打开或映射时返回 -1 并设置 errno
+int parseSmtPath (const char* path, SmtParseContext* pctx);
 #endif
\ No newline at end of file
@@ -55,7 +55,7 @@
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -72,12 +72,17 @@
 	// this part is copied to the beginning of the parser 
 	#include "smt_lang.h"
 	#include <stdio.h>
-	#include "smt_lang_flex.h"
-	void yyerror(char*);
-	int yylex(void);
-	SmtProplist *root;
-
-#line 81 "smt_lang.tab.c"
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <stdint.h>
+	#include <unistd.h>
+	// The parser stack lives on the heap and doubles as it fills; the default cap of
+	// 10000 would reject inputs nested deeper than that (long right-nested chains, deep
+	// parentheses), so it is only bounded by memory
+	#define YYMAXDEPTH (PTRDIFF_MAX / 64)
+
+#line 86 "smt_lang.tab.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -142,6 +147,14 @@ typedef enum yysymbol_kind_t yysymbol_kind_t;
 
 
 
+/* Unqualified %code blocks.  */
+#line 20 "smt_lang.y"
+
+	// Needs YYSTYPE, so it comes after the union
+	#include "smt_lang_flex.h"
+	#include "trace.h"
+
+#line 158 "smt_lang.tab.c"
 
 #ifdef short
 # undef short
@@ -525,10 +538,10 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    44,    44,    53,    64,    68,    72,    76,    80,    84,
-      88,    92,    96,   106,   116,   120,   124,   128,   132,   139,
-     143,   147,   151,   155,   159,   163,   167,   171,   175,   179,
-     184,   189
+       0,    65,    65,    75,    87,    91,    95,    99,   103,   107,
+     111,   115,   119,   129,   139,   143,   147,   151,   155,   162,
+     166,   170,   174,   178,   182,   186,   190,   194,   198,   202,
+     207,   212
 };
 #endif
 
@@ -710,7 +723,7 @@ enum { YYENOMEM = -2 };
       }                                                           \
     else                                                          \
       {                                                           \
-        yyerror (YY_("syntax error: cannot back up")); \
+        yyerror (scanner, pctx, YY_("syntax error: cannot back up")); \
         YYERROR;                                                  \
       }                                                           \
   while (0)
@@ -743,7 +756,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Kind, Value); \
+                  Kind, Value, scanner, pctx); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -755,10 +768,12 @@ do {                                                                      \
 
 static void
 yy_symbol_value_print (FILE *yyo,
-                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, SmtParseContext* pctx)
 {
   FILE *yyoutput = yyo;
   YY_USE (yyoutput);
+  YY_USE (scanner);
+  YY_USE (pctx);
   if (!yyvaluep)
     return;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
@@ -773,12 +788,12 @@ yy_symbol_value_print (FILE *yyo,
 
 static void
 yy_symbol_print (FILE *yyo,
-                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, SmtParseContext* pctx)
 {
   YYFPRINTF (yyo, "%s %s (",
              yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyo, yykind, yyvaluep);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, scanner, pctx);
   YYFPRINTF (yyo, ")");
 }
 
@@ -812,7 +827,7 @@ do {                                                            \
 
 static void
 yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
-                 int yyrule)
+                 int yyrule, yyscan_t scanner, SmtParseContext* pctx)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -825,7 +840,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
                        YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
-                       &yyvsp[(yyi + 1) - (yynrhs)]);
+                       &yyvsp[(yyi + 1) - (yynrhs)], scanner, pctx);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -833,7 +848,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, Rule); \
+    yy_reduce_print (yyssp, yyvsp, Rule, scanner, pctx); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -874,9 +889,11 @@ int yydebug;
 
 static void
 yydestruct (const char *yymsg,
-            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, yyscan_t scanner, SmtParseContext* pctx)
 {
   YY_USE (yyvaluep);
+  YY_USE (scanner);
+  YY_USE (pctx);
   if (!yymsg)
     yymsg = "Deleting";
   YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
@@ -887,13 +904,6 @@ yydestruct (const char *yymsg,
 }
 
 
-/* Lookahead token kind.  */
-int yychar;
-
-/* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval;
-/* Number of syntax errors so far.  */
-int yynerrs;
 
 
 
@@ -903,8 +913,21 @@ int yynerrs;
 `----------*/
 
 int
-yyparse (void)
+yyparse (yyscan_t scanner, SmtParseContext* pctx)
 {
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
+
     yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
     int yyerrstatus = 0;
@@ -1057,7 +1080,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token\n"));
-      yychar = yylex ();
+      yychar = yylex (&yylval, scanner);
     }
 
   if (yychar <= YYEOF)
@@ -1145,109 +1168,111 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* PROP_LIST: PROP  */
-#line 44 "smt_lang.y"
+#line 65 "smt_lang.y"
                 {
-        printf("->PROP_LIST\n");
+        TRACE(TRACE_PARSE, "->PROP_LIST\n");
         SmtProplist* list = (SmtProplist*)malloc(sizeof(SmtProplist));
-        printSmtProp((yyvsp[0].b));
+        if (TRACE_ON(TRACE_PARSE)) printSmtPropToFile((yyvsp[0].b), trace_file());
         list->prop = (yyvsp[0].b);
         list->next = NULL;
         (yyval.c) = list;
-        root = (yyval.c);
+        pctx->root = (yyval.c);
+        if (pctx->on_prop && pctx->on_prop((yyvsp[0].b), pctx->on_prop_arg)) YYACCEPT;
     }
-#line 1159 "smt_lang.tab.c"
+#line 1183 "smt_lang.tab.c"
     break;
 
   case 3: /* PROP_LIST: PROP_LIST COMMA PROP  */
-#line 53 "smt_lang.y"
+#line 75 "smt_lang.y"
                            {
-        printf("->PROP_LIST\n");
+        TRACE(TRACE_PARSE, "->PROP_LIST\n");
         SmtProplist* list = (SmtProplist*)malloc(sizeof(SmtProplist));
-        printSmtProp((yyvsp[0].b));
+        if (TRACE_ON(TRACE_PARSE)) printSmtPropToFile((yyvsp[0].b), trace_file());
         list->prop = (yyvsp[0].b);
         list->next = (yyvsp[-2].c);
         (yyval.c) = list;
-        root = (yyval.c);
+        pctx->root = (yyval.c);
+        if (pctx->on_prop && pctx->on_prop((yyvsp[0].b), pctx->on_prop_arg)) YYACCEPT;
     }
-#line 1173 "smt_lang.tab.c"
+#line 1198 "smt_lang.tab.c"
     break;
 
   case 4: /* PROP: PTT  */
-#line 64 "smt_lang.y"
+#line 87 "smt_lang.y"
           {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = (yyvsp[0].b);
     }
-#line 1182 "smt_lang.tab.c"
+#line 1207 "smt_lang.tab.c"
     break;
 
   case 5: /* PROP: PFF  */
-#line 68 "smt_lang.y"
+#line 91 "smt_lang.y"
           {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = (yyvsp[0].b);
     }
-#line 1191 "smt_lang.tab.c"
+#line 1216 "smt_lang.tab.c"
     break;
 
   case 6: /* PROP: LB1L PROP LB1R  */
-#line 72 "smt_lang.y"
+#line 95 "smt_lang.y"
                      {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = (yyvsp[-1].b);
     }
-#line 1200 "smt_lang.tab.c"
+#line 1225 "smt_lang.tab.c"
     break;
 
   case 7: /* PROP: PNOT PROP  */
-#line 76 "smt_lang.y"
+#line 99 "smt_lang.y"
                 {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTU_PROP, SMTPROP_NOT, (yyvsp[0].b), NULL, NULL, NULL, true);
     }
-#line 1209 "smt_lang.tab.c"
+#line 1234 "smt_lang.tab.c"
     break;
 
   case 8: /* PROP: PROP PAND PROP  */
-#line 80 "smt_lang.y"
+#line 103 "smt_lang.y"
                      {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTB_PROP, SMTPROP_AND, (yyvsp[-2].b), (yyvsp[0].b), NULL, NULL, true);
     }
-#line 1218 "smt_lang.tab.c"
+#line 1243 "smt_lang.tab.c"
     break;
 
   case 9: /* PROP: PROP POR PROP  */
-#line 84 "smt_lang.y"
+#line 107 "smt_lang.y"
                     {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTB_PROP, SMTPROP_OR, (yyvsp[-2].b), (yyvsp[0].b), NULL, NULL, true);
     }
-#line 1227 "smt_lang.tab.c"
+#line 1252 "smt_lang.tab.c"
     break;
 
   case 10: /* PROP: PROP PIFF PROP  */
-#line 88 "smt_lang.y"
+#line 111 "smt_lang.y"
                      {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTB_PROP, SMTPROP_IFF, (yyvsp[-2].b), (yyvsp[0].b), NULL, NULL, true);
     }
-#line 1236 "smt_lang.tab.c"
+#line 1261 "smt_lang.tab.c"
     break;
 
   case 11: /* PROP: PROP PIMPLY PROP  */
-#line 92 "smt_lang.y"
+#line 115 "smt_lang.y"
                        {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTB_PROP, SMTPROP_IMPLY, (yyvsp[-2].b), (yyvsp[0].b), NULL, NULL, true);
     }
-#line 1245 "smt_lang.tab.c"
+#line 1270 "smt_lang.tab.c"
     break;
 
   case 12: /* PROP: LB1L FORALL TVAR COMMA PROP LB1R  */
-#line 96 "smt_lang.y"
+#line 119 "smt_lang.y"
                                       {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         SmtProp* res = (SmtProp*)malloc(sizeof(SmtProp));
         memset(res, 0, sizeof(SmtProp));
         res->type = SMT_QUANT_PROP;
@@ -1256,13 +1281,13 @@ yyreduce:
         res->prop.Quant_prop.quant_var = strdup((yyvsp[-3].s));
         (yyval.b) = res;
     }
-#line 1260 "smt_lang.tab.c"
+#line 1285 "smt_lang.tab.c"
     break;
 
   case 13: /* PROP: LB1L EXISTS TVAR COMMA PROP LB1R  */
-#line 106 "smt_lang.y"
+#line 129 "smt_lang.y"
                                       {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         SmtProp* res = (SmtProp*)malloc(sizeof(SmtProp));
         memset(res, 0, sizeof(SmtProp));
         res->type = SMT_QUANT_PROP;
@@ -1271,176 +1296,176 @@ yyreduce:
         res->prop.Quant_prop.quant_var = strdup((yyvsp[-3].s));
         (yyval.b) = res;
     }
-#line 1275 "smt_lang.tab.c"
+#line 1300 "smt_lang.tab.c"
     break;
 
   case 14: /* PROP: EXPR REQ EXPR  */
-#line 116 "smt_lang.y"
+#line 139 "smt_lang.y"
                     {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTAT_PROP_EQ, SMT_EQ, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a), true);
     }
-#line 1284 "smt_lang.tab.c"
+#line 1309 "smt_lang.tab.c"
     break;
 
   case 15: /* PROP: EXPR RGE EXPR  */
-#line 120 "smt_lang.y"
+#line 143 "smt_lang.y"
                     {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTAT_PROP_LIA, SMT_GE, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a), true);
     }
-#line 1293 "smt_lang.tab.c"
+#line 1318 "smt_lang.tab.c"
     break;
 
   case 16: /* PROP: EXPR RGT EXPR  */
-#line 124 "smt_lang.y"
+#line 147 "smt_lang.y"
                     {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTAT_PROP_LIA, SMT_GT, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a), true);
     }
-#line 1302 "smt_lang.tab.c"
+#line 1327 "smt_lang.tab.c"
     break;
 
   case 17: /* PROP: EXPR RLE EXPR  */
-#line 128 "smt_lang.y"
+#line 151 "smt_lang.y"
                     {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTAT_PROP_LIA, SMT_LE, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a), true);
     }
-#line 1311 "smt_lang.tab.c"
+#line 1336 "smt_lang.tab.c"
     break;
 
   case 18: /* PROP: EXPR RLT EXPR  */
-#line 132 "smt_lang.y"
+#line 155 "smt_lang.y"
                     {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         (yyval.b) = newSmtProp(SMTAT_PROP_LIA, SMT_LT, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a), true);
     }
-#line 1320 "smt_lang.tab.c"
+#line 1345 "smt_lang.tab.c"
     break;
 
   case 19: /* EXPR: TVAR  */
-#line 139 "smt_lang.y"
+#line 162 "smt_lang.y"
          {
-        printf("->EXPR TVAR\n");
+        TRACE(TRACE_PARSE, "->EXPR TVAR\n");
         (yyval.a) = newSmtTerm(SMT_VarName, 0, 0, (yyvsp[0].s), NULL, NULL, NULL);
     }
-#line 1329 "smt_lang.tab.c"
+#line 1354 "smt_lang.tab.c"
     break;
 
   case 20: /* EXPR: TNUM  */
-#line 143 "smt_lang.y"
+#line 166 "smt_lang.y"
           {
-        printf("->EXPR TNUM\n");
+        TRACE(TRACE_PARSE, "->EXPR TNUM\n");
         (yyval.a) = newSmtTerm(SMT_ConstNum, 0, (yyvsp[0].n), NULL, NULL, NULL, NULL);
     }
-#line 1338 "smt_lang.tab.c"
+#line 1363 "smt_lang.tab.c"
     break;
 
   case 21: /* EXPR: LB1L EXPR LB1R  */
-#line 147 "smt_lang.y"
+#line 170 "smt_lang.y"
                     {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         (yyval.a) = (yyvsp[-1].a);
     }
-#line 1347 "smt_lang.tab.c"
+#line 1372 "smt_lang.tab.c"
     break;
 
   case 22: /* EXPR: EXPR TADD EXPR  */
-#line 151 "smt_lang.y"
+#line 174 "smt_lang.y"
                     {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         (yyval.a) = newSmtTerm(SMT_LiaBTerm, LIA_ADD, 0, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a));
     }
-#line 1356 "smt_lang.tab.c"
+#line 1381 "smt_lang.tab.c"
     break;
 
   case 23: /* EXPR: EXPR TMINUS EXPR  */
-#line 155 "smt_lang.y"
+#line 178 "smt_lang.y"
                       {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         (yyval.a) = newSmtTerm(SMT_LiaBTerm, LIA_MINUS, 0, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a));
     }
-#line 1365 "smt_lang.tab.c"
+#line 1390 "smt_lang.tab.c"
     break;
 
   case 24: /* EXPR: TMINUS EXPR  */
-#line 159 "smt_lang.y"
+#line 182 "smt_lang.y"
                  {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         (yyval.a) = newSmtTerm(SMT_LiaUTerm, LIA_NEG, 0, NULL, NULL, (yyvsp[0].a), NULL);
     }
-#line 1374 "smt_lang.tab.c"
+#line 1399 "smt_lang.tab.c"
     break;
 
   case 25: /* EXPR: EXPR TMULT EXPR  */
-#line 163 "smt_lang.y"
+#line 186 "smt_lang.y"
                      {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         (yyval.a) = newSmtTerm(SMT_NiaBTerm, LIA_MULT, 0, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a));
     }
-#line 1383 "smt_lang.tab.c"
+#line 1408 "smt_lang.tab.c"
     break;
 
   case 26: /* EXPR: EXPR TDIV EXPR  */
-#line 167 "smt_lang.y"
+#line 190 "smt_lang.y"
                     {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         (yyval.a) = newSmtTerm(SMT_NiaBTerm, LIA_DIV, 0, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a));
     }
-#line 1392 "smt_lang.tab.c"
+#line 1417 "smt_lang.tab.c"
     break;
 
   case 27: /* EXPR: EXPR LSHIFT EXPR  */
-#line 171 "smt_lang.y"
+#line 194 "smt_lang.y"
                       {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         (yyval.a) = newSmtTerm(SMT_NiaBTerm, LIA_LSHIFT, 0, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a));
     }
-#line 1401 "smt_lang.tab.c"
+#line 1426 "smt_lang.tab.c"
     break;
 
   case 28: /* EXPR: EXPR RSHIFT EXPR  */
-#line 175 "smt_lang.y"
+#line 198 "smt_lang.y"
                       {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         (yyval.a) = newSmtTerm(SMT_NiaBTerm, LIA_RSHIFT, 0, NULL, NULL, (yyvsp[-2].a), (yyvsp[0].a));
     }
-#line 1410 "smt_lang.tab.c"
+#line 1435 "smt_lang.tab.c"
     break;
 
   case 29: /* EXPR: TVAR LB1L EXPR LB1R  */
-#line 179 "smt_lang.y"
+#line 202 "smt_lang.y"
                          {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         UFunction* tmp = newUFunction((yyvsp[-3].s), 1, (yyvsp[-1].a), NULL, NULL);
         (yyval.a) = newSmtTerm(SMT_UFTerm, 0, 0, NULL, tmp, NULL, NULL);
     }
-#line 1420 "smt_lang.tab.c"
+#line 1445 "smt_lang.tab.c"
     break;
 
   case 30: /* EXPR: TVAR LB1L EXPR COMMA EXPR LB1R  */
-#line 184 "smt_lang.y"
+#line 207 "smt_lang.y"
                                     {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         UFunction* tmp = newUFunction((yyvsp[-5].s), 2, (yyvsp[-3].a), (yyvsp[-1].a), NULL);
          (yyval.a) = newSmtTerm(SMT_UFTerm, 0, 0, NULL, tmp, NULL, NULL);
     }
-#line 1430 "smt_lang.tab.c"
+#line 1455 "smt_lang.tab.c"
     break;
 
   case 31: /* EXPR: TVAR LB1L EXPR COMMA EXPR COMMA EXPR LB1R  */
-#line 189 "smt_lang.y"
+#line 212 "smt_lang.y"
                                                {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         UFunction* tmp = newUFunction((yyvsp[-7].s), 3, (yyvsp[-5].a), (yyvsp[-3].a), (yyvsp[-1].a));
          (yyval.a) = newSmtTerm(SMT_UFTerm, 0, 0, NULL, tmp, NULL, NULL);
     }
-#line 1440 "smt_lang.tab.c"
+#line 1465 "smt_lang.tab.c"
     break;
 
 
-#line 1444 "smt_lang.tab.c"
+#line 1469 "smt_lang.tab.c"
 
       default: break;
     }
@@ -1487,7 +1512,7 @@ yyerrlab:
   if (!yyerrstatus)
     {
       ++yynerrs;
-      yyerror (YY_("syntax error"));
+      yyerror (scanner, pctx, YY_("syntax error"));
     }
 
   if (yyerrstatus == 3)
@@ -1504,7 +1529,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval);
+                      yytoken, &yylval, scanner, pctx);
           yychar = YYEMPTY;
         }
     }
@@ -1560,7 +1585,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, scanner, pctx);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1598,7 +1623,7 @@ yyabortlab:
 | yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
 `-----------------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (YY_("memory exhausted"));
+  yyerror (scanner, pctx, YY_("memory exhausted"));
   yyresult = 2;
   goto yyreturnlab;
 
@@ -1613,7 +1638,7 @@ yyreturnlab:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval);
+                  yytoken, &yylval, scanner, pctx);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1622,7 +1647,7 @@ yyreturnlab:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, scanner, pctx);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -1633,10 +1658,79 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 196 "smt_lang.y"
+#line 219 "smt_lang.y"
 
 
-void yyerror(char* s)
+void yyerror(yyscan_t scanner, SmtParseContext* pctx, char* s)
 {
+    (void)scanner;
+    (void)pctx;
     fprintf(stderr , "%s\n",s);
 }
+
+int parseSmtFile(FILE* fp, SmtParseContext* pctx)
+{
+    yyscan_t scanner;
+    pctx->root = NULL;
+    if (yylex_init_extra(pctx, &scanner) != 0) return 1;
+    yyset_in(fp, scanner);
+    int res = yyparse(scanner, pctx);
+    yylex_destroy(scanner);
+    return res;
+}
+
+int parseSmtBuffer(char* buf, size_t len, SmtParseContext* pctx)
+{
+    yyscan_t scanner;
+    pctx->root = NULL;
+    if (yylex_init_extra(pctx, &scanner) != 0) return 1;
+    // Scanned in place: no stdio copy and no copy into a flex buffer
+    YY_BUFFER_STATE b = yy_scan_buffer(buf, len + 2, scanner);
+    if (b == NULL) {
+        yylex_destroy(scanner);
+        return 1;
+    }
+    int res = yyparse(scanner, pctx);
+    yy_delete_buffer(b, scanner);
+    yylex_destroy(scanner);
+    return res;
+}
+
+int parseSmtPath(const char* path, SmtParseContext* pctx)
+{
+    pctx->root = NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    if (len == 0) {
+        close(fd);
+        char empty[2] = { 0, 0 };
+        return parseSmtBuffer(empty, 0, pctx);
+    }
+
+    // Reserve zeroed pages for the file plus flex's two end-of-buffer NULs, then map the
+    // file over the front, so the NULs exist even when the file ends on a page boundary.
+    // The mapping is private: the scanner's temporary writes never reach the file.
+    size_t span = len + 2;
+    char* base = (char*)mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    if (mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, span);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    madvise(base, len, MADV_SEQUENTIAL);
+
+    int res = parseSmtBuffer(base, len, pctx);
+    munmap(base, span);
+    return res;
+}
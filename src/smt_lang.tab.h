@@ -44,6 +44,12 @@
 #if YYDEBUG
 extern int yydebug;
 #endif
+/* "%code requires" blocks.  */
+#line 16 "smt_lang.y"
+
+	#include "smt_lang.h"
+
+#line 53 "smt_lang.tab.h"
 
 /* Token kinds.  */
 #ifndef YYTOKENTYPE
@@ -87,7 +93,7 @@ extern int yydebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 11 "smt_lang.y"
+#line 32 "smt_lang.y"
 
     int n;
     char* s;
@@ -96,7 +102,7 @@ union YYSTYPE
     struct SmtProplist* c;
     void * none;
 
-#line 100 "smt_lang.tab.h"
+#line 106 "smt_lang.tab.h"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -105,10 +111,9 @@ typedef union YYSTYPE YYSTYPE;
 #endif
 
 
-extern YYSTYPE yylval;
 
 
-int yyparse (void);
+int yyparse (yyscan_t scanner, SmtParseContext* pctx);
 
 
 #endif /* !YY_YY_SMT_LANG_TAB_H_INCLUDED  */
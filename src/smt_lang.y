@@ -2,12 +2,33 @@
 	// this part is copied to the beginning of the parser 
 	#include "smt_lang.h"
 	#include <stdio.h>
-	#include "smt_lang_flex.h"
-	void yyerror(char*);
-	int yylex(void);
-	SmtProplist *root;
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <stdint.h>
+	#include <unistd.h>
+	// The parser stack lives on the heap and doubles as it fills; the default cap of
+	// 10000 would reject inputs nested deeper than that (long right-nested chains, deep
+	// parentheses), so it is only bounded by memory
+	#define YYMAXDEPTH (PTRDIFF_MAX / 64)
 %}
 
+%code requires {
+	#include "smt_lang.h"
+}
+
+%code {
+	// Needs YYSTYPE, so it comes after the union
+	#include "smt_lang_flex.h"
+	#include "trace.h"
+}
+
+// Pure parser over a reentrant scanner: all parse state lives in the scanner
+// and the parse context, so independent parses can run on different threads
+%define api.pure full
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner} {SmtParseContext* pctx}
+
 %union {
     int n;
     char* s;
@@ -42,59 +63,61 @@
 %%
 
 PROP_LIST: PROP {
-        printf("->PROP_LIST\n");
+        TRACE(TRACE_PARSE, "->PROP_LIST\n");
         SmtProplist* list = (SmtProplist*)malloc(sizeof(SmtProplist));
-        printSmtProp($1);
+        if (TRACE_ON(TRACE_PARSE)) printSmtPropToFile($1, trace_file());
         list->prop = $1;
         list->next = NULL;
         $$ = list;
-        root = $$;
+        pctx->root = $$;
+        if (pctx->on_prop && pctx->on_prop($1, pctx->on_prop_arg)) YYACCEPT;
     }
     | PROP_LIST COMMA PROP {
-        printf("->PROP_LIST\n");
+        TRACE(TRACE_PARSE, "->PROP_LIST\n");
         SmtProplist* list = (SmtProplist*)malloc(sizeof(SmtProplist));
-        printSmtProp($3);
+        if (TRACE_ON(TRACE_PARSE)) printSmtPropToFile($3, trace_file());
         list->prop = $3;
         list->next = $1;
         $$ = list;
-        root = $$;
+        pctx->root = $$;
+        if (pctx->on_prop && pctx->on_prop($3, pctx->on_prop_arg)) YYACCEPT;
     }
 ;
 
 PROP: PTT {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = $1;
     }
     | PFF {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = $1;
     }
     | LB1L PROP LB1R {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = $2;
     }
     | PNOT PROP {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTU_PROP, SMTPROP_NOT, $2, NULL, NULL, NULL, true);
     }
     | PROP PAND PROP {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTB_PROP, SMTPROP_AND, $1, $3, NULL, NULL, true);
     }
     | PROP POR PROP {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTB_PROP, SMTPROP_OR, $1, $3, NULL, NULL, true);
     }
     | PROP PIFF PROP {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTB_PROP, SMTPROP_IFF, $1, $3, NULL, NULL, true);
     }
     | PROP PIMPLY PROP {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTB_PROP, SMTPROP_IMPLY, $1, $3, NULL, NULL, true);
     }
     | LB1L FORALL TVAR COMMA PROP LB1R{
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         SmtProp* res = (SmtProp*)malloc(sizeof(SmtProp));
         memset(res, 0, sizeof(SmtProp));
         res->type = SMT_QUANT_PROP;
@@ -104,7 +127,7 @@ PROP: PTT {
         $$ = res;
     }
     | LB1L EXISTS TVAR COMMA PROP LB1R{
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         SmtProp* res = (SmtProp*)malloc(sizeof(SmtProp));
         memset(res, 0, sizeof(SmtProp));
         res->type = SMT_QUANT_PROP;
@@ -114,80 +137,80 @@ PROP: PTT {
         $$ = res;
     }
     | EXPR REQ EXPR {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTAT_PROP_EQ, SMT_EQ, NULL, NULL, $1, $3, true);
     }
     | EXPR RGE EXPR {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTAT_PROP_LIA, SMT_GE, NULL, NULL, $1, $3, true);
     }
     | EXPR RGT EXPR {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTAT_PROP_LIA, SMT_GT, NULL, NULL, $1, $3, true);
     }
     | EXPR RLE EXPR {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTAT_PROP_LIA, SMT_LE, NULL, NULL, $1, $3, true);
     }
     | EXPR RLT EXPR {
-        printf("->PROP\n");
+        TRACE(TRACE_PARSE, "->PROP\n");
         $$ = newSmtProp(SMTAT_PROP_LIA, SMT_LT, NULL, NULL, $1, $3, true);
     }
 ;
 
 EXPR: 
     TVAR {
-        printf("->EXPR TVAR\n");
+        TRACE(TRACE_PARSE, "->EXPR TVAR\n");
         $$ = newSmtTerm(SMT_VarName, 0, 0, $1, NULL, NULL, NULL);
     }
     |TNUM {
-        printf("->EXPR TNUM\n");
+        TRACE(TRACE_PARSE, "->EXPR TNUM\n");
         $$ = newSmtTerm(SMT_ConstNum, 0, $1, NULL, NULL, NULL, NULL);
     }
     |LB1L EXPR LB1R {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         $$ = $2;
     }
     |EXPR TADD EXPR {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         $$ = newSmtTerm(SMT_LiaBTerm, LIA_ADD, 0, NULL, NULL, $1, $3);
     }
     |EXPR TMINUS EXPR {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         $$ = newSmtTerm(SMT_LiaBTerm, LIA_MINUS, 0, NULL, NULL, $1, $3);
     }
     |TMINUS EXPR {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         $$ = newSmtTerm(SMT_LiaUTerm, LIA_NEG, 0, NULL, NULL, $2, NULL);
     }
     |EXPR TMULT EXPR {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         $$ = newSmtTerm(SMT_NiaBTerm, LIA_MULT, 0, NULL, NULL, $1, $3);
     }
     |EXPR TDIV EXPR {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         $$ = newSmtTerm(SMT_NiaBTerm, LIA_DIV, 0, NULL, NULL, $1, $3);
     }
     |EXPR LSHIFT EXPR {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         $$ = newSmtTerm(SMT_NiaBTerm, LIA_LSHIFT, 0, NULL, NULL, $1, $3);
     }
     |EXPR RSHIFT EXPR {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         $$ = newSmtTerm(SMT_NiaBTerm, LIA_RSHIFT, 0, NULL, NULL, $1, $3);
     }
     |TVAR LB1L EXPR LB1R {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         UFunction* tmp = newUFunction($1, 1, $3, NULL, NULL);
         $$ = newSmtTerm(SMT_UFTerm, 0, 0, NULL, tmp, NULL, NULL);
     }
     |TVAR LB1L EXPR COMMA EXPR LB1R {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         UFunction* tmp = newUFunction($1, 2, $3, $5, NULL);
          $$ = newSmtTerm(SMT_UFTerm, 0, 0, NULL, tmp, NULL, NULL);
     }
     |TVAR LB1L EXPR COMMA EXPR COMMA EXPR LB1R {
-        printf("->EXPR\n");
+        TRACE(TRACE_PARSE, "->EXPR\n");
         UFunction* tmp = newUFunction($1, 3, $3, $5, $7);
          $$ = newSmtTerm(SMT_UFTerm, 0, 0, NULL, tmp, NULL, NULL);
     }
@@ -195,7 +218,76 @@ EXPR:
 
 %%
 
-void yyerror(char* s)
+void yyerror(yyscan_t scanner, SmtParseContext* pctx, char* s)
 {
+    (void)scanner;
+    (void)pctx;
     fprintf(stderr , "%s\n",s);
-}
\ No newline at end of file
+}
+
+int parseSmtFile(FILE* fp, SmtParseContext* pctx)
+{
+    yyscan_t scanner;
+    pctx->root = NULL;
+    if (yylex_init_extra(pctx, &scanner) != 0) return 1;
+    yyset_in(fp, scanner);
+    int res = yyparse(scanner, pctx);
+    yylex_destroy(scanner);
+    return res;
+}
+
+int parseSmtBuffer(char* buf, size_t len, SmtParseContext* pctx)
+{
+    yyscan_t scanner;
+    pctx->root = NULL;
+    if (yylex_init_extra(pctx, &scanner) != 0) return 1;
+    // Scanned in place: no stdio copy and no copy into a flex buffer
+    YY_BUFFER_STATE b = yy_scan_buffer(buf, len + 2, scanner);
+    if (b == NULL) {
+        yylex_destroy(scanner);
+        return 1;
+    }
+    int res = yyparse(scanner, pctx);
+    yy_delete_buffer(b, scanner);
+    yylex_destroy(scanner);
+    return res;
+}
+
+int parseSmtPath(const char* path, SmtParseContext* pctx)
+{
+    pctx->root = NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    if (len == 0) {
+        close(fd);
+        char empty[2] = { 0, 0 };
+        return parseSmtBuffer(empty, 0, pctx);
+    }
+
+    // Reserve zeroed pages for the file plus flex's two end-of-buffer NULs, then map the
+    // file over the front, so the NULs exist even when the file ends on a page boundary.
+    // The mapping is private: the scanner's temporary writes never reach the file.
+    size_t span = len + 2;
+    char* base = (char*)mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    if (mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, span);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    madvise(base, len, MADV_SEQUENTIAL);
+
+    int res = parseSmtBuffer(base, len, pctx);
+    munmap(base, span);
+    return res;
+}
@@ -0,0 +1,437 @@
+#include "smtbin.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SMTBIN_MAGIC "SMTB"
+#define SMTBIN_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;    // SMTBIN_BYTE_ORDER as the writer stored it
+    uint16_t pointer_size;  // Record layout of the writer
+    uint16_t term_size;
+    uint16_t prop_size;
+    uint16_t uf_size;
+    uint64_t size;          // Whole file
+    uint64_t list;          // First SmtProplist node, 0 if the list is empty
+    uint64_t symbols;       // char* array of symbol_count names
+    uint64_t symbol_count;
+    uint64_t relocs;        // uint64_t offsets of every pointer field in the file
+    uint64_t reloc_count;
+} SmtBinHeader;
+
+// --- Writer ---
+// Records are appended to one growable buffer at 8-byte alignment. Offset 0 is the
+// header, so a zero pointer field still means NULL.
+
+typedef struct {
+    char* buf;
+    size_t size;
+    size_t cap;
+    uint64_t* relocs;
+    size_t reloc_count;
+    size_t reloc_cap;
+
+    // Interned names: open addressing over string offsets, 0 for an empty slot
+    uint64_t* names;
+    size_t name_count;
+    size_t name_cap;
+} Writer;
+
+static size_t emit(Writer* w, const void* rec, size_t size) {
+    size_t off = (w->size + 7) & ~(size_t)7;
+    if (off + size > w->cap) {
+        while (off + size > w->cap) w->cap = w->cap ? w->cap * 2 : 4096;
+        w->buf = (char*)realloc(w->buf, w->cap);
+    }
+    memset(w->buf + w->size, 0, off - w->size);
+    memcpy(w->buf + off, rec, size);
+    w->size = off + size;
+    return off;
+}
+
+// Stores target's offset in the pointer field at field_off and records it for relocation
+static void set_pointer(Writer* w, size_t field_off, size_t target) {
+    uintptr_t value = (uintptr_t)target;
+    memcpy(w->buf + field_off, &value, sizeof(value));
+    if (target == 0) return;
+    if (w->reloc_count == w->reloc_cap) {
+        w->reloc_cap = w->reloc_cap ? w->reloc_cap * 2 : 1024;
+        w->relocs = (uint64_t*)realloc(w->relocs, sizeof(uint64_t) * w->reloc_cap);
+    }
+    w->relocs[w->reloc_count++] = field_off;
+}
+
+static unsigned long long hash_string(const char* s) {
+    unsigned long long h = 1469598103934665603ULL; // FNV-1a
+    for (; *s; ++s) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void names_grow(Writer* w) {
+    size_t old_cap = w->name_cap;
+    uint64_t* old = w->names;
+    w->name_cap = old_cap ? old_cap * 2 : 256;
+    w->names = (uint64_t*)calloc(w->name_cap, sizeof(uint64_t));
+    for (size_t i = 0; i < old_cap; ++i) {
+        if (old[i] == 0) continue;
+        size_t slot = hash_string(w->buf + old[i]) & (w->name_cap - 1);
+        while (w->names[slot] != 0) slot = (slot + 1) & (w->name_cap - 1);
+        w->names[slot] = old[i];
+    }
+    free(old);
+}
+
+// Offset of the interned copy of s
+static size_t write_name(Writer* w, const char* s) {
+    if (s == NULL) return 0;
+    if (2 * (w->name_count + 1) > w->name_cap) names_grow(w);
+    size_t slot = hash_string(s) & (w->name_cap - 1);
+    while (w->names[slot] != 0) {
+        if (strcmp(w->buf + w->names[slot], s) == 0) return w->names[slot];
+        slot = (slot + 1) & (w->name_cap - 1);
+    }
+    size_t off = emit(w, s, strlen(s) + 1);
+    w->names[slot] = off;
+    w->name_count++;
+    return off;
+}
+
+// --- Term and Proposition Records ---
+// Children are written before their parent, which then points at them. Terms and
+// propositions may nest deeper than the C stack allows, so both are walked post-order on
+// an explicit stack: a finished record leaves its offset on an OffsetStack, where its
+// parent finds those of its children, left to right.
+
+typedef struct {
+    size_t* v;
+    size_t size;
+    size_t cap;
+} OffsetStack;
+
+static void offset_push(OffsetStack* s, size_t off) {
+    if (s->size == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 64;
+        s->v = (size_t*)realloc(s->v, sizeof(size_t) * s->cap);
+    }
+    s->v[s->size++] = off;
+}
+
+// Writes the record of t, whose children were written at kids[0..arity)
+static size_t write_term_node(Writer* w, SmtTerm* t, const size_t* kids) {
+    SmtTerm rec = *t;
+    size_t a = 0, b = 0;
+    switch (t->type) {
+        case SMT_LiaBTerm:
+        case SMT_NiaBTerm:
+            a = kids[0];
+            b = kids[1];
+            break;
+        case SMT_LiaUTerm:
+            a = kids[0];
+            break;
+        case SMT_UFTerm: {
+            UFunction* uf = t->term.UFTerm;
+            size_t name = write_name(w, uf->name);
+            size_t arr = 0;
+            if (uf->numArgs > 0) {
+                arr = emit(w, uf->args, sizeof(SmtTerm*) * uf->numArgs);
+                for (int i = 0; i < uf->numArgs; ++i) set_pointer(w, arr + sizeof(SmtTerm*) * i, kids[i]);
+            }
+            UFunction uf_rec = *uf;
+            size_t uf_off = emit(w, &uf_rec, sizeof(UFunction));
+            set_pointer(w, uf_off + offsetof(UFunction, name), name);
+            set_pointer(w, uf_off + offsetof(UFunction, args), arr);
+            a = uf_off;
+            break;
+        }
+        case SMT_VarName:
+            a = write_name(w, t->term.Variable);
+            break;
+        default:
+            break;
+    }
+
+    size_t off = emit(w, &rec, sizeof(SmtTerm));
+    switch (t->type) {
+        case SMT_LiaBTerm:
+        case SMT_NiaBTerm:
+            set_pointer(w, off + offsetof(SmtTerm, term.BTerm.t1), a);
+            set_pointer(w, off + offsetof(SmtTerm, term.BTerm.t2), b);
+            break;
+        case SMT_LiaUTerm:
+            set_pointer(w, off + offsetof(SmtTerm, term.UTerm.t), a);
+            break;
+        case SMT_UFTerm:
+            set_pointer(w, off + offsetof(SmtTerm, term.UFTerm), a);
+            break;
+        case SMT_VarName:
+            set_pointer(w, off + offsetof(SmtTerm, term.Variable), a);
+            break;
+        default:
+            break;
+    }
+    return off;
+}
+
+static size_t write_term(Writer* w, SmtTerm* t) {
+    if (t == NULL) return 0;
+    OffsetStack done = { NULL, 0, 0 };
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, t, NULL);
+    while (walk.size > 0) {
+        SmtWalkItem* it = &walk.items[walk.size - 1];
+        t = (SmtTerm*)it->node;
+        int n = SmtTerm_arity(t);
+        if (it->next < n) {
+            SmtTerm* child = SmtTerm_child(t, it->next++);
+            if (child != NULL) smt_walk_push(&walk, 0, child, NULL);
+            else offset_push(&done, 0);
+            continue;
+        }
+        walk.size--;
+        done.size -= n;
+        size_t off = write_term_node(w, t, done.v + done.size);
+        offset_push(&done, off);
+    }
+    size_t off = done.v[0];
+    free(done.v);
+    smt_walk_free(&walk);
+    return off;
+}
+
+// Writes the record of p, whose subpropositions were written at kids[0..arity); the name
+// of a quantified proposition was written at name_off before its body
+static size_t write_prop_node(Writer* w, SmtProp* p, const size_t* kids, size_t name_off) {
+    SmtProp rec = *p;
+    size_t a = 0, b = 0;
+    switch (p->type) {
+        case SMTB_PROP:
+            a = kids[0];
+            b = kids[1];
+            break;
+        case SMTU_PROP:
+            a = kids[0];
+            break;
+        case SMT_QUANT_PROP:
+            a = name_off;
+            b = kids[0];
+            break;
+        case SMTAT_PROP_EQ:
+        case SMTAT_PROP_LIA:
+        case SMTAT_PROP_UF_EQ:
+        case SMTAT_PROP_LIA_EQ:
+        case SMTAT_PROP_NIA_EQ:
+            a = write_term(w, p->prop.Atomic_prop.term1);
+            b = write_term(w, p->prop.Atomic_prop.term2);
+            break;
+        default:
+            break;
+    }
+
+    size_t off = emit(w, &rec, sizeof(SmtProp));
+    switch (p->type) {
+        case SMTB_PROP:
+            set_pointer(w, off + offsetof(SmtProp, prop.Binary_prop.prop1), a);
+            set_pointer(w, off + offsetof(SmtProp, prop.Binary_prop.prop2), b);
+            break;
+        case SMTU_PROP:
+            set_pointer(w, off + offsetof(SmtProp, prop.Unary_prop.prop1), a);
+            break;
+        case SMT_QUANT_PROP:
+            set_pointer(w, off + offsetof(SmtProp, prop.Quant_prop.quant_var), a);
+            set_pointer(w, off + offsetof(SmtProp, prop.Quant_prop.body), b);
+            break;
+        case SMTAT_PROP_EQ:
+        case SMTAT_PROP_LIA:
+        case SMTAT_PROP_UF_EQ:
+        case SMTAT_PROP_LIA_EQ:
+        case SMTAT_PROP_NIA_EQ:
+            set_pointer(w, off + offsetof(SmtProp, prop.Atomic_prop.term1), a);
+            set_pointer(w, off + offsetof(SmtProp, prop.Atomic_prop.term2), b);
+            break;
+        default:
+            break;
+    }
+    return off;
+}
+
+static size_t write_prop(Writer* w, SmtProp* p) {
+    if (p == NULL) return 0;
+    OffsetStack done = { NULL, 0, 0 };
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, p, NULL);
+    while (walk.size > 0) {
+        SmtWalkItem* it = &walk.items[walk.size - 1];
+        p = (SmtProp*)it->node;
+        int n = SmtProp_arity(p);
+        if (it->next == 0 && p->type == SMT_QUANT_PROP) it->h = write_name(w, p->prop.Quant_prop.quant_var);
+        if (it->next < n) {
+            SmtProp* child = SmtProp_child(p, it->next++);
+            if (child != NULL) smt_walk_push(&walk, 0, child, NULL);
+            else offset_push(&done, 0);
+            continue;
+        }
+        walk.size--;
+        done.size -= n;
+        size_t off = write_prop_node(w, p, done.v + done.size, (size_t)it->h);
+        offset_push(&done, off);
+    }
+    size_t off = done.v[0];
+    free(done.v);
+    smt_walk_free(&walk);
+    return off;
+}
+
+int smtbin_write(SmtProplist* list, const char* path) {
+    Writer w;
+    memset(&w, 0, sizeof(w));
+    SmtBinHeader header;
+    memset(&header, 0, sizeof(header));
+    emit(&w, &header, sizeof(header)); // Filled in last
+
+    // Nodes are written back to front so that each one can point at its successor
+    int count = 0;
+    for (SmtProplist* cur = list; cur != NULL; cur = cur->next) count++;
+    SmtProplist** nodes = (SmtProplist**)malloc(sizeof(SmtProplist*) * (count > 0 ? count : 1));
+    int i = 0;
+    for (SmtProplist* cur = list; cur != NULL; cur = cur->next) nodes[i++] = cur;
+    size_t next = 0;
+    for (i = count - 1; i >= 0; --i) {
+        size_t prop = write_prop(&w, nodes[i]->prop);
+        SmtProplist rec = { NULL, NULL };
+        size_t off = emit(&w, &rec, sizeof(SmtProplist));
+        set_pointer(&w, off + offsetof(SmtProplist, prop), prop);
+        set_pointer(&w, off + offsetof(SmtProplist, next), next);
+        next = off;
+    }
+    free(nodes);
+
+    // Symbol table: every interned name, in table order
+    size_t symbols = 0;
+    if (w.name_count > 0) {
+        char** zero = (char**)calloc(w.name_count, sizeof(char*));
+        symbols = emit(&w, zero, sizeof(char*) * w.name_count);
+        free(zero);
+        size_t k = 0;
+        for (size_t s = 0; s < w.name_cap; ++s) {
+            if (w.names[s] != 0) set_pointer(&w, symbols + sizeof(char*) * k++, w.names[s]);
+        }
+    }
+    size_t relocs = w.reloc_count > 0 ? emit(&w, w.relocs, sizeof(uint64_t) * w.reloc_count) : 0;
+
+    memcpy(header.magic, SMTBIN_MAGIC, 4);
+    header.version = SMTBIN_VERSION;
+    header.byte_order = SMTBIN_BYTE_ORDER;
+    header.pointer_size = sizeof(void*);
+    header.term_size = sizeof(SmtTerm);
+    header.prop_size = sizeof(SmtProp);
+    header.uf_size = sizeof(UFunction);
+    header.size = w.size;
+    header.list = next;
+    header.symbols = symbols;
+    header.symbol_count = w.name_count;
+    header.relocs = relocs;
+    header.reloc_count = w.reloc_count;
+    memcpy(w.buf, &header, sizeof(header));
+
+    int res = 0;
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL || fwrite(w.buf, 1, w.size, fp) != w.size) res = -1;
+    if (fp != NULL && fclose(fp) != 0) res = -1;
+    free(w.buf);
+    free(w.relocs);
+    free(w.names);
+    return res;
+}
+
+// --- Loader ---
+
+bool smtbin_is_image(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) return false;
+    char magic[4];
+    bool res = fread(magic, 1, 4, fp) == 4 && memcmp(magic, SMTBIN_MAGIC, 4) == 0;
+    fclose(fp);
+    return res;
+}
+
+static int load_error(const char* path, const char* msg) {
+    fprintf(stderr, "Error: %s: %s\n", path, msg);
+    return -1;
+}
+
+int smtbin_load(const char* path, SmtBinImage* image) {
+    memset(image, 0, sizeof(*image));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return load_error(path, strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return load_error(path, strerror(err));
+    }
+    size_t size = (size_t)st.st_size;
+    if (size < sizeof(SmtBinHeader)) {
+        close(fd);
+        return load_error(path, "not a problem image");
+    }
+    // Private and writable: relocation writes addresses into the pages it touches only
+    char* base = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    close(fd);
+    if (base == MAP_FAILED) return load_error(path, strerror(err));
+
+    const SmtBinHeader* h = (const SmtBinHeader*)base;
+    const char* msg = NULL;
+    if (memcmp(h->magic, SMTBIN_MAGIC, 4) != 0) msg = "not a problem image";
+    else if (h->version != SMTBIN_VERSION) msg = "unsupported image version";
+    else if (h->byte_order != SMTBIN_BYTE_ORDER || h->pointer_size != sizeof(void*) || h->term_size != sizeof(SmtTerm) ||
+             h->prop_size != sizeof(SmtProp) || h->uf_size != sizeof(UFunction)) msg = "image written for another record layout";
+    else if (h->size != size || h->relocs > size || h->reloc_count > (size - h->relocs) / sizeof(uint64_t)) msg = "truncated image";
+    if (msg != NULL) {
+        munmap(base, size);
+        return load_error(path, msg);
+    }
+
+    const uint64_t* relocs = (const uint64_t*)(base + h->relocs);
+    for (uint64_t i = 0; i < h->reloc_count; ++i) {
+        uint64_t field = relocs[i];
+        uintptr_t target;
+        if (field > size - sizeof(uintptr_t)) target = size;
+        else memcpy(&target, base + field, sizeof(target));
+        if (target >= size) {
+            munmap(base, size);
+            return load_error(path, "corrupt relocation");
+        }
+        char* addr = base + target;
+        memcpy(base + field, &addr, sizeof(addr));
+    }
+
+    image->base = base;
+    image->size = size;
+    image->list = h->list ? (SmtProplist*)(base + h->list) : NULL;
+    image->symbols = h->symbol_count ? (char**)(base + h->symbols) : NULL;
+    image->symbol_count = (int)h->symbol_count;
+    return 0;
+}
+
+void smtbin_unload(SmtBinImage* image) {
+    if (image->base != NULL) munmap(image->base, image->size);
+    memset(image, 0, sizeof(*image));
+}
@@ -0,0 +1,32 @@
+#ifndef SMTBIN_H
+#define SMTBIN_H 1
+#include "smt_lang.h"
+#include <stddef.h>
+
+// --- Binary Problem Images ---
+// A parsed proplist saved as an image of the AST itself: SmtProplist, SmtProp, SmtTerm
+// and UFunction records in their in-memory layout, plus a symbol table of interned
+// names. Pointer fields hold file offsets and a relocation table lists where they are,
+// so loading is one private mmap and one pass turning offsets into addresses, without
+// any per-node allocation. Images are tied to the record layout and byte order that
+// wrote them; the header records both and a mismatch is rejected.
+
+#define SMTBIN_VERSION 1
+
+typedef struct {
+    void* base;          // The mapping
+    size_t size;
+    SmtProplist* list;   // In the order written; read-only, owned by the mapping
+    char** symbols;      // Variable and function names, each stored once
+    int symbol_count;
+} SmtBinImage;
+
+// Writes list (in solver order) to path; 0 on success, -1 with errno set otherwise
+int smtbin_write(SmtProplist* list, const char* path);
+// Whether path starts with an image header
+bool smtbin_is_image(const char* path);
+// Maps an image; 0 on success, -1 (reported on stderr) if it cannot be read or was written for another layout
+int smtbin_load(const char* path, SmtBinImage* image);
+// Unmaps the image; its list must no longer be in use (set ctx->props to NULL before freeing a context)
+void smtbin_unload(SmtBinImage* image);
+#endif
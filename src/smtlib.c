@@ -0,0 +1,999 @@
+#include "smtlib.h"
+#include "smt_lang.h"
+#include "interval_solver.h"
+#include "incremental.h"
+#include "trace.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// --- Tokenizer ---
+
+typedef enum {
+    TOK_LPAREN,
+    TOK_RPAREN,
+    TOK_SYMBOL,
+    TOK_NUMERAL,
+    TOK_KEYWORD,
+    TOK_STRING,
+    TOK_EOF,
+    TOK_ERROR
+} TokenKind;
+
+typedef struct {
+    TokenKind kind;
+    const char* text; // Into the input, without the bars of |quoted| symbols, the quotes of strings or the keyword's colon
+    size_t len;
+    int line;
+} Token;
+
+typedef struct {
+    const char* p;
+    const char* end;
+    int line;
+    int depth; // Parentheses open up to and including the current token
+    int closed; // Depth-0 closing parentheses read past, one per finished command
+    Token tok; // Current token
+} Lexer;
+
+static bool is_symbol_char(char c) {
+    return c != '\0' && (isalnum((unsigned char)c) || strchr("~!@$%^&*_-+=<>.?/#", c) != NULL);
+}
+
+static void next_token(Lexer* lx) {
+    if (lx->tok.kind == TOK_RPAREN && lx->depth == 0) lx->closed++;
+    for (;;) {
+        while (lx->p < lx->end && isspace((unsigned char)*lx->p)) {
+            if (*lx->p == '\n') lx->line++;
+            lx->p++;
+        }
+        if (lx->p < lx->end && *lx->p == ';') {
+            while (lx->p < lx->end && *lx->p != '\n') lx->p++;
+            continue;
+        }
+        break;
+    }
+
+    Token* t = &lx->tok;
+    t->line = lx->line;
+    t->text = lx->p;
+    t->len = 0;
+    if (lx->p >= lx->end) {
+        t->kind = TOK_EOF;
+        return;
+    }
+
+    const char* s = lx->p;
+    if (*s == '(') {
+        t->kind = TOK_LPAREN;
+        t->len = 1;
+        lx->p++;
+        lx->depth++;
+    } else if (*s == ')') {
+        t->kind = TOK_RPAREN;
+        t->len = 1;
+        lx->p++;
+        lx->depth--;
+    } else if (*s == '|') {
+        const char* q = s + 1;
+        while (q < lx->end && *q != '|') {
+            if (*q == '\n') lx->line++;
+            q++;
+        }
+        if (q >= lx->end) {
+            t->kind = TOK_ERROR;
+            return;
+        }
+        t->kind = TOK_SYMBOL;
+        t->text = s + 1;
+        t->len = (size_t)(q - s - 1);
+        lx->p = q + 1;
+    } else if (*s == '"') {
+        const char* q = s + 1;
+        for (;;) {
+            if (q >= lx->end) {
+                t->kind = TOK_ERROR;
+                return;
+            }
+            if (*q == '"') {
+                if (q + 1 < lx->end && q[1] == '"') { q += 2; continue; } // "" is an escaped quote
+                break;
+            }
+            if (*q == '\n') lx->line++;
+            q++;
+        }
+        t->kind = TOK_STRING;
+        t->text = s + 1;
+        t->len = (size_t)(q - s - 1);
+        lx->p = q + 1;
+    } else if (*s == ':') {
+        const char* q = s + 1;
+        while (q < lx->end && is_symbol_char(*q)) q++;
+        t->kind = TOK_KEYWORD;
+        t->text = s + 1;
+        t->len = (size_t)(q - s - 1);
+        lx->p = q;
+    } else if (is_symbol_char(*s)) {
+        // Numerals are digits only; decimals and #x / #b literals come out as symbols and are rejected on use
+        const char* q = s;
+        bool digits = true;
+        while (q < lx->end && is_symbol_char(*q)) {
+            if (!isdigit((unsigned char)*q)) digits = false;
+            q++;
+        }
+        t->kind = digits ? TOK_NUMERAL : TOK_SYMBOL;
+        t->len = (size_t)(q - s);
+        lx->p = q;
+    } else {
+        t->kind = TOK_ERROR;
+        t->len = 1;
+    }
+}
+
+static bool tok_is(const Token* t, const char* s) {
+    return t->kind == TOK_SYMBOL && t->len == strlen(s) && memcmp(t->text, s, t->len) == 0;
+}
+
+static char* tok_strdup(const Token* t) {
+    return strndup(t->text, t->len);
+}
+
+// --- Script State ---
+
+typedef struct {
+    SmtTerm* term; // Exactly one of the two is set
+    SmtProp* prop;
+} Expr;
+
+typedef enum { SORT_INT, SORT_BOOL } Sort;
+
+typedef struct {
+    const char* name; // Into the input
+    size_t len;
+    Sort sort;        // Result sort
+    int arity;        // Argument count, every argument is an Int
+    int propvar;      // Bool constants: the SMT_PROPVAR number
+    bool is_macro;    // define-fun: every use is a copy of value
+    Expr value;
+    int next;         // Next declaration in the same hash bucket, -1 at the end
+    SmtProp* side;    // define-fun: the bounds of the quotients in value, asserted with every use
+} Decl;
+
+typedef struct {
+    const char* name; // Into the input
+    size_t len;
+    Expr value;
+} Binding;
+
+typedef struct {
+    int assert_count;
+    int decl_count;
+    int unsupported;
+} Scope;
+
+typedef struct {
+    Lexer lx;
+    FILE* out;
+    char error[256]; // First error of the current command, empty if none
+    int command_line; // Where the current command starts
+
+    // Declarations in order; buckets index them by name for constant-time lookups
+    Decl* decls;
+    int decl_count;
+    int decl_cap;
+    int* buckets;
+    int bucket_cap;
+    int next_propvar;
+
+    Binding* binds; // Open let bindings, innermost last
+    int bind_count;
+    int bind_cap;
+
+    SmtProp** asserts; // Owned, in assertion order
+    int assert_count;
+    int assert_cap;
+    int unsupported;   // Assertions in scope the incremental solver cannot take
+    Scope* scopes;
+    int scope_count;
+    int scope_cap;
+    SolverContext* inc; // Holds every supported assertion, pushed and popped with the script
+    SmtProp* side;      // Bounds of the quotients in the command being read, see quotient
+    int fresh_count;    // Quotient and remainder variables made so far
+    bool exited;
+} Script;
+
+static bool fail(Script* sc, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static bool fail(Script* sc, const char* fmt, ...) {
+    if (sc->error[0] != '\0') return false; // Keep the first, innermost message
+    int n = snprintf(sc->error, sizeof(sc->error), "line %d: ", sc->command_line);
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(sc->error + n, sizeof(sc->error) - n, fmt, ap);
+    va_end(ap);
+    return false;
+}
+
+static void expr_free(Expr e) {
+    freeSmtTerm(e.term);
+    freeSmtProp(e.prop);
+}
+
+static Expr expr_copy(Expr e) {
+    Expr c = { e.term ? copy_SmtTerm(e.term) : NULL, e.prop ? copy_SmtProp(e.prop) : NULL };
+    return c;
+}
+
+static Expr term_expr(SmtTerm* t) {
+    Expr e = { t, NULL };
+    return e;
+}
+
+static Expr prop_expr(SmtProp* p) {
+    Expr e = { NULL, p };
+    return e;
+}
+
+// --- Declarations ---
+
+static unsigned long long hash_name(const char* s, size_t len) {
+    unsigned long long h = 1469598103934665603ULL; // FNV-1a
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int decl_find(Script* sc, const char* name, size_t len) {
+    if (sc->bucket_cap == 0) return -1;
+    int b = (int)(hash_name(name, len) & (unsigned long long)(sc->bucket_cap - 1));
+    for (int i = sc->buckets[b]; i >= 0; i = sc->decls[i].next) {
+        if (sc->decls[i].len == len && memcmp(sc->decls[i].name, name, len) == 0) return i;
+    }
+    return -1;
+}
+
+static void decl_add(Script* sc, Decl d) {
+    if (sc->decl_count == sc->decl_cap) {
+        sc->decl_cap = sc->decl_cap ? sc->decl_cap * 2 : 64;
+        sc->decls = (Decl*)realloc(sc->decls, sizeof(Decl) * sc->decl_cap);
+    }
+    if (sc->decl_count + 1 > sc->bucket_cap / 2) {
+        // Rehash in declaration order, so the newest declaration stays first in its bucket
+        sc->bucket_cap = sc->bucket_cap ? sc->bucket_cap * 2 : 128;
+        sc->buckets = (int*)realloc(sc->buckets, sizeof(int) * sc->bucket_cap);
+        for (int b = 0; b < sc->bucket_cap; ++b) sc->buckets[b] = -1;
+        for (int i = 0; i < sc->decl_count; ++i) {
+            int b = (int)(hash_name(sc->decls[i].name, sc->decls[i].len) & (unsigned long long)(sc->bucket_cap - 1));
+            sc->decls[i].next = sc->buckets[b];
+            sc->buckets[b] = i;
+        }
+    }
+    int i = sc->decl_count++;
+    int b = (int)(hash_name(d.name, d.len) & (unsigned long long)(sc->bucket_cap - 1));
+    d.next = sc->buckets[b];
+    sc->decls[i] = d;
+    sc->buckets[b] = i;
+}
+
+// Drops the newest declarations; each one is still first in its bucket
+static void decl_pop_to(Script* sc, int count) {
+    while (sc->decl_count > count) {
+        Decl* d = &sc->decls[sc->decl_count - 1];
+        int b = (int)(hash_name(d->name, d->len) & (unsigned long long)(sc->bucket_cap - 1));
+        sc->buckets[b] = d->next;
+        if (d->is_macro) {
+            expr_free(d->value);
+            freeSmtProp(d->side);
+        }
+        sc->decl_count--;
+    }
+}
+
+static bool check_fresh(Script* sc, const Token* name) {
+    if (tok_is(name, "true") || tok_is(name, "false") || decl_find(sc, name->text, name->len) >= 0) {
+        return fail(sc, "symbol %.*s is already declared", (int)name->len, name->text);
+    }
+    return true;
+}
+
+// --- Expressions ---
+
+static bool expect(Script* sc, TokenKind kind, const char* what) {
+    if (sc->lx.tok.kind != kind) return fail(sc, "expected %s", what);
+    next_token(&sc->lx);
+    return true;
+}
+
+static SmtProp* make_and(SmtProp* acc, SmtProp* p) {
+    return acc ? newSmtProp(SMTB_PROP, SMTPROP_AND, acc, p, NULL, NULL, true) : p;
+}
+
+static SmtProp* make_not(SmtProp* p) {
+    return newSmtProp(SMTU_PROP, SMTPROP_NOT, p, NULL, NULL, NULL, true);
+}
+
+// a op b for terms, a <-> b for propositions compared with =
+static SmtProp* make_relation(SmtBinPred op, Expr a, Expr b) {
+    if (a.prop) return newSmtProp(SMTB_PROP, SMTPROP_IFF, a.prop, b.prop, NULL, NULL, true);
+    return newSmtProp(op == SMT_EQ ? SMTAT_PROP_EQ : SMTAT_PROP_LIA, op, NULL, NULL, a.term, b.term, true);
+}
+
+static bool parse_constant(Script* sc, const Token* name, Expr* out) {
+    if (tok_is(name, "true") || tok_is(name, "false")) {
+        *out = prop_expr(newSmtProp(SMTTF_PROP, 0, NULL, NULL, NULL, NULL, tok_is(name, "true")));
+        return true;
+    }
+    for (int i = sc->bind_count - 1; i >= 0; --i) {
+        if (sc->binds[i].len == name->len && memcmp(sc->binds[i].name, name->text, name->len) == 0) {
+            *out = expr_copy(sc->binds[i].value);
+            return true;
+        }
+    }
+    int d = decl_find(sc, name->text, name->len);
+    if (d < 0) return fail(sc, "unknown constant %.*s", (int)name->len, name->text);
+    Decl* decl = &sc->decls[d];
+    if (decl->is_macro) {
+        *out = expr_copy(decl->value);
+        if (decl->side != NULL) sc->side = make_and(sc->side, copy_SmtProp(decl->side));
+    } else if (decl->arity > 0) {
+        return fail(sc, "%.*s expects %d arguments", (int)name->len, name->text, decl->arity);
+    } else if (decl->sort == SORT_BOOL) {
+        *out = prop_expr(newSmtProp(SMT_PROPVAR, decl->propvar, NULL, NULL, NULL, NULL, true));
+    } else {
+        *out = term_expr(newSmtTerm(SMT_VarName, 0, 0, tok_strdup(name), NULL, NULL, NULL));
+    }
+    return true;
+}
+
+static SmtTerm* make_const(long long v) {
+    if (v < 0) return newSmtTerm(SMT_LiaUTerm, LIA_NEG, 0, NULL, NULL, make_const(-v), NULL);
+    return newSmtTerm(SMT_ConstNum, 0, (int)v, NULL, NULL, NULL, NULL);
+}
+
+static SmtTerm* make_bop(SmtTermBop op, SmtTerm* a, SmtTerm* b) {
+    return newSmtTerm(op == LIA_ADD || op == LIA_MINUS ? SMT_LiaBTerm : SMT_NiaBTerm, op, 0, NULL, NULL, a, b);
+}
+
+static SmtProp* make_atom(SmtBinPred op, SmtTerm* a, SmtTerm* b) {
+    return make_relation(op, term_expr(a), term_expr(b));
+}
+
+// The value of a numeral or a negated numeral
+static bool const_value(const SmtTerm* t, long long* v) {
+    if (t->type == SMT_ConstNum) {
+        *v = t->term.ConstNum;
+        return true;
+    }
+    if (t->type == SMT_LiaUTerm && t->term.UTerm.op == LIA_NEG && const_value(t->term.UTerm.t, v)) {
+        *v = -*v;
+        return true;
+    }
+    return false;
+}
+
+// Names starting with @ are reserved for solvers, so these cannot clash with a declared symbol
+static SmtTerm* fresh_var(Script* sc, const char* prefix) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s%d", prefix, ++sc->fresh_count);
+    return newSmtTerm(SMT_VarName, 0, 0, strdup(name), NULL, NULL, NULL);
+}
+
+// SMT-LIB div is Euclidean, the remainder a - b * q lying in [0, |b| - 1], while the engine's
+// LIA_DIV rounds towards zero. So a quotient is a fresh variable q with the bounds
+// b * q <= a <= b * q + |b| - 1, which are collected in sc->side and asserted along with the
+// command that uses q. Division by zero is unspecified and leaves q free.
+static SmtTerm* quotient(Script* sc, SmtTerm* a, SmtTerm* b) {
+    SmtTerm* q = fresh_var(sc, "@div");
+    long long k;
+    if (const_value(b, &k)) {
+        if (k == 0) return q;
+        SmtTerm* kq = make_bop(LIA_MULT, make_const(k), copy_SmtTerm(q));
+        SmtProp* low = make_atom(SMT_LE, copy_SmtTerm(kq), copy_SmtTerm(a));
+        SmtProp* high = make_atom(SMT_LE, copy_SmtTerm(a), make_bop(LIA_ADD, kq, make_const((k < 0 ? -k : k) - 1)));
+        sc->side = make_and(sc->side, make_and(low, high));
+        return q;
+    }
+    // |b| is b or -b depending on the sign of b, so each sign gets its own implication
+    for (int sign = 0; sign < 2; ++sign) {
+        SmtTerm* bq = make_bop(LIA_MULT, copy_SmtTerm(b), copy_SmtTerm(q));
+        SmtTerm* abs_b = sign == 0 ? copy_SmtTerm(b) : newSmtTerm(SMT_LiaUTerm, LIA_NEG, 0, NULL, NULL, copy_SmtTerm(b), NULL);
+        SmtProp* low = make_atom(SMT_LE, copy_SmtTerm(bq), copy_SmtTerm(a));
+        SmtProp* high = make_atom(SMT_LE, copy_SmtTerm(a), make_bop(LIA_MINUS, make_bop(LIA_ADD, bq, abs_b), make_const(1)));
+        SmtProp* guard = make_atom(sign == 0 ? SMT_GT : SMT_LT, copy_SmtTerm(b), make_const(0));
+        sc->side = make_and(sc->side, newSmtProp(SMTB_PROP, SMTPROP_IMPLY, guard, make_and(low, high), NULL, NULL, true));
+    }
+    return q;
+}
+
+static bool all_terms(const Expr* args, int n) {
+    for (int i = 0; i < n; ++i) if (args[i].term == NULL) return false;
+    return true;
+}
+
+static bool all_props(const Expr* args, int n) {
+    for (int i = 0; i < n; ++i) if (args[i].prop == NULL) return false;
+    return true;
+}
+
+static const struct { const char* name; SmtBinPred op; } relations[] = {
+    { "=", SMT_EQ }, { "<", SMT_LT }, { "<=", SMT_LE }, { ">", SMT_GT }, { ">=", SMT_GE }
+};
+
+// Builds head(args) and takes ownership of the arguments, also on failure
+static bool build_application(Script* sc, const Token* head, Expr* args, int n, Expr* out) {
+    #define HEAD_FAIL(...) do { for (int i_ = 0; i_ < n; ++i_) expr_free(args[i_]); return fail(sc, __VA_ARGS__); } while (0)
+    int hl = (int)head->len;
+    const char* ht = head->text;
+
+    if (tok_is(head, "div") || tok_is(head, "mod")) {
+        bool is_div = tok_is(head, "div");
+        if (n < 2 || (!is_div && n != 2) || !all_terms(args, n)) HEAD_FAIL("%.*s expects %s Int arguments", hl, ht, is_div ? "at least 2" : "2");
+        // div is left associative
+        SmtTerm* acc = args[0].term;
+        for (int i = 1; i < n; ++i) {
+            SmtTerm* q = quotient(sc, acc, args[i].term);
+            if (is_div) {
+                freeSmtTerm(acc);
+                freeSmtTerm(args[i].term);
+                acc = q;
+                continue;
+            }
+            // a mod b is a fresh r = a - b * q, so every use of it shares one interval; like
+            // the quotient it is left free when b is 0
+            long long k;
+            bool is_const = const_value(args[i].term, &k);
+            SmtTerm* r = fresh_var(sc, "@mod");
+            if (is_const && k == 0) {
+                freeSmtTerm(acc);
+                freeSmtTerm(args[i].term);
+                freeSmtTerm(q);
+            } else {
+                SmtTerm* b = copy_SmtTerm(args[i].term);
+                SmtProp* def = make_atom(SMT_EQ, copy_SmtTerm(r), make_bop(LIA_MINUS, acc, make_bop(LIA_MULT, args[i].term, q)));
+                if (is_const) {
+                    def = make_and(def, make_and(make_atom(SMT_LE, make_const(0), copy_SmtTerm(r)), make_atom(SMT_LE, copy_SmtTerm(r), make_const((k < 0 ? -k : k) - 1))));
+                    freeSmtTerm(b);
+                } else {
+                    def = newSmtProp(SMTB_PROP, SMTPROP_IMPLY, make_not(make_atom(SMT_EQ, b, make_const(0))), def, NULL, NULL, true);
+                }
+                sc->side = make_and(sc->side, def);
+            }
+            acc = r;
+        }
+        *out = term_expr(acc);
+        return true;
+    }
+    if (tok_is(head, "+") || tok_is(head, "*") || tok_is(head, "-")) {
+        if (n < 1 || !all_terms(args, n)) HEAD_FAIL("%.*s expects Int arguments", hl, ht);
+        if (tok_is(head, "-") && n == 1) {
+            *out = term_expr(newSmtTerm(SMT_LiaUTerm, LIA_NEG, 0, NULL, NULL, args[0].term, NULL));
+            return true;
+        }
+        SmtTermBop op = tok_is(head, "+") ? LIA_ADD : tok_is(head, "-") ? LIA_MINUS : LIA_MULT;
+        SmtTerm* acc = args[0].term;
+        for (int i = 1; i < n; ++i) acc = make_bop(op, acc, args[i].term);
+        *out = term_expr(acc);
+        return true;
+    }
+
+    if (tok_is(head, "and") || tok_is(head, "or")) {
+        if (!all_props(args, n)) HEAD_FAIL("%.*s expects Bool arguments", hl, ht);
+        bool is_and = tok_is(head, "and");
+        if (n == 0) {
+            *out = prop_expr(newSmtProp(SMTTF_PROP, 0, NULL, NULL, NULL, NULL, is_and));
+            return true;
+        }
+        SmtProp* acc = args[0].prop;
+        for (int i = 1; i < n; ++i) acc = newSmtProp(SMTB_PROP, is_and ? SMTPROP_AND : SMTPROP_OR, acc, args[i].prop, NULL, NULL, true);
+        *out = prop_expr(acc);
+        return true;
+    }
+    if (tok_is(head, "not")) {
+        if (n != 1 || !all_props(args, n)) HEAD_FAIL("not expects one Bool argument");
+        *out = prop_expr(make_not(args[0].prop));
+        return true;
+    }
+    if (tok_is(head, "=>")) {
+        if (n < 2 || !all_props(args, n)) HEAD_FAIL("=> expects at least 2 Bool arguments");
+        SmtProp* acc = args[n - 1].prop; // Right associative
+        for (int i = n - 2; i >= 0; --i) acc = newSmtProp(SMTB_PROP, SMTPROP_IMPLY, args[i].prop, acc, NULL, NULL, true);
+        *out = prop_expr(acc);
+        return true;
+    }
+    if (tok_is(head, "xor")) {
+        if (n < 2 || !all_props(args, n)) HEAD_FAIL("xor expects at least 2 Bool arguments");
+        SmtProp* acc = args[0].prop;
+        for (int i = 1; i < n; ++i) acc = make_not(newSmtProp(SMTB_PROP, SMTPROP_IFF, acc, args[i].prop, NULL, NULL, true));
+        *out = prop_expr(acc);
+        return true;
+    }
+    if (tok_is(head, "ite")) {
+        if (n != 3 || args[0].prop == NULL) HEAD_FAIL("ite expects a Bool condition and two branches");
+        if (!all_props(args + 1, 2)) HEAD_FAIL("ite over Int terms is not supported");
+        // (c => a) and (not c => b)
+        SmtProp* c2 = copy_SmtProp(args[0].prop);
+        SmtProp* then_part = newSmtProp(SMTB_PROP, SMTPROP_IMPLY, args[0].prop, args[1].prop, NULL, NULL, true);
+        SmtProp* else_part = newSmtProp(SMTB_PROP, SMTPROP_IMPLY, make_not(c2), args[2].prop, NULL, NULL, true);
+        *out = prop_expr(make_and(then_part, else_part));
+        return true;
+    }
+
+    if (tok_is(head, "distinct")) {
+        if (n < 2 || !(all_terms(args, n) || all_props(args, n))) HEAD_FAIL("distinct expects at least 2 arguments of one sort");
+        SmtProp* acc = NULL;
+        for (int i = 0; i < n; ++i) {
+            for (int j = i + 1; j < n; ++j) acc = make_and(acc, make_not(make_relation(SMT_EQ, expr_copy(args[i]), expr_copy(args[j]))));
+        }
+        for (int i = 0; i < n; ++i) expr_free(args[i]);
+        *out = prop_expr(acc);
+        return true;
+    }
+    for (size_t r = 0; r < sizeof(relations) / sizeof(relations[0]); ++r) {
+        if (!tok_is(head, relations[r].name)) continue;
+        bool ok = n >= 2 && (all_terms(args, n) || (relations[r].op == SMT_EQ && all_props(args, n)));
+        if (!ok) HEAD_FAIL("%.*s expects at least 2 arguments of one sort", hl, ht);
+        // a op b op c is (a op b) and (b op c); middle arguments are copied for their second use
+        SmtProp* acc = NULL;
+        for (int i = 0; i + 1 < n; ++i) {
+            Expr left = i == 0 ? args[0] : expr_copy(args[i]);
+            acc = make_and(acc, make_relation(relations[r].op, left, args[i + 1]));
+        }
+        *out = prop_expr(acc);
+        return true;
+    }
+
+    int d = decl_find(sc, ht, head->len);
+    if (d < 0 || sc->decls[d].is_macro) HEAD_FAIL("unknown function %.*s", hl, ht);
+    Decl* decl = &sc->decls[d];
+    if (decl->arity != n) HEAD_FAIL("%.*s expects %d arguments", hl, ht, decl->arity);
+    if (decl->sort != SORT_INT) HEAD_FAIL("Bool-valued function %.*s is not supported", hl, ht);
+    if (!all_terms(args, n)) HEAD_FAIL("%.*s expects Int arguments", hl, ht);
+    UFunction* uf = (UFunction*)malloc(sizeof(UFunction));
+    uf->name = tok_strdup(head);
+    uf->numArgs = n;
+    uf->args = (SmtTerm**)malloc(sizeof(SmtTerm*) * n);
+    for (int i = 0; i < n; ++i) uf->args[i] = args[i].term;
+    *out = term_expr(newSmtTerm(SMT_UFTerm, 0, 0, NULL, uf, NULL, NULL));
+    return true;
+    #undef HEAD_FAIL
+}
+
+static void push_binding(Script* sc, Binding b) {
+    if (sc->bind_count == sc->bind_cap) {
+        sc->bind_cap = sc->bind_cap ? sc->bind_cap * 2 : 16;
+        sc->binds = (Binding*)realloc(sc->binds, sizeof(Binding) * sc->bind_cap);
+    }
+    sc->binds[sc->bind_count++] = b;
+}
+
+// Skips tokens up to and including the ) closing the list whose contents are being read
+static bool skip_to_close(Script* sc) {
+    int depth = sc->lx.depth; // Depth of the list being read, not counting the current token
+    if (sc->lx.tok.kind == TOK_LPAREN) depth--;
+    else if (sc->lx.tok.kind == TOK_RPAREN) depth++;
+    while (!(sc->lx.tok.kind == TOK_RPAREN && sc->lx.depth == depth - 1)) {
+        if (sc->lx.tok.kind == TOK_EOF || sc->lx.tok.kind == TOK_ERROR) return fail(sc, "unbalanced parentheses");
+        next_token(&sc->lx);
+    }
+    next_token(&sc->lx);
+    return true;
+}
+
+// A numeral or a symbol
+static bool parse_atom(Script* sc, Expr* out) {
+    Token t = sc->lx.tok;
+    out->term = NULL;
+    out->prop = NULL;
+    switch (t.kind) {
+        case TOK_NUMERAL: {
+            long long v = 0;
+            for (size_t i = 0; i < t.len; ++i) {
+                v = v * 10 + (t.text[i] - '0');
+                if (v > INT_MAX) return fail(sc, "numeral %.*s is out of range", (int)t.len, t.text);
+            }
+            next_token(&sc->lx);
+            *out = term_expr(newSmtTerm(SMT_ConstNum, 0, (int)v, NULL, NULL, NULL, NULL));
+            return true;
+        }
+        case TOK_SYMBOL:
+            next_token(&sc->lx);
+            return parse_constant(sc, &t, out);
+        default:
+            return fail(sc, "expected an expression");
+    }
+}
+
+// Applications are read on an explicit stack of pending frames, one per open parenthesis,
+// since a term such as (+ x (+ x ... x)) nests as deep as it is long
+enum { FRAME_APPLY, FRAME_LET, FRAME_ANNOTATION };
+
+typedef struct {
+    Token head;       // Function symbol
+    Expr* args;       // Arguments read so far
+    int n, cap;
+    Binding* pending; // let: bindings read so far; they are parallel, so each value is
+    int count;        // parsed in the enclosing scope and all are opened before the body
+    int pending_cap;
+    Token name;       // let: variable of the binding being read
+    int first;        // let: bind_count before its bindings were opened, -1 while reading them
+} ExprFrame;
+
+static void frame_free(Script* sc, ExprFrame* f) {
+    for (int i = 0; i < f->n; ++i) expr_free(f->args[i]);
+    for (int i = 0; i < f->count; ++i) expr_free(f->pending[i].value);
+    if (f->first >= 0) {
+        while (sc->bind_count > f->first) expr_free(sc->binds[--sc->bind_count].value);
+    }
+    free(f->args);
+    free(f->pending);
+    free(f);
+}
+
+typedef enum {
+    WANT_EXPR,  // An expression starts at the current token
+    WANT_STEP,  // The top frame reads its next element or its closing parenthesis
+    HAVE_VALUE  // value is complete and goes to the top frame, or out when there is none
+} ParseState;
+
+static bool parse_expr(Script* sc, Expr* out) {
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    Expr value = { NULL, NULL };
+    ParseState state = WANT_EXPR;
+    bool ok = true;
+    while (ok) {
+        if (state == WANT_EXPR) {
+            if (sc->lx.tok.kind != TOK_LPAREN) {
+                ok = parse_atom(sc, &value);
+                state = HAVE_VALUE;
+                continue;
+            }
+            next_token(&sc->lx);
+            Token head = sc->lx.tok;
+            if (head.kind != TOK_SYMBOL) { ok = fail(sc, "expected a function symbol"); break; }
+            next_token(&sc->lx);
+            ExprFrame* f = (ExprFrame*)calloc(1, sizeof(ExprFrame));
+            f->head = head;
+            f->first = -1;
+            if (tok_is(&head, "let")) {
+                smt_walk_push(&walk, FRAME_LET, f, NULL);
+                ok = expect(sc, TOK_LPAREN, "( after let");
+                state = WANT_STEP;
+            } else if (tok_is(&head, "!")) {
+                // Annotations such as :named do not change the meaning
+                smt_walk_push(&walk, FRAME_ANNOTATION, f, NULL);
+            } else {
+                smt_walk_push(&walk, FRAME_APPLY, f, NULL);
+                state = WANT_STEP;
+            }
+
+        } else if (state == WANT_STEP) {
+            SmtWalkItem* it = &walk.items[walk.size - 1];
+            ExprFrame* f = (ExprFrame*)it->node;
+            if (it->tag == FRAME_APPLY) {
+                if (sc->lx.tok.kind != TOK_RPAREN) { state = WANT_EXPR; continue; }
+                next_token(&sc->lx);
+                walk.size--;
+                ok = build_application(sc, &f->head, f->args, f->n, &value); // Owns the arguments now
+                f->n = 0;
+                frame_free(sc, f);
+                state = HAVE_VALUE;
+            } else if (sc->lx.tok.kind == TOK_LPAREN) { // let, the next binding
+                next_token(&sc->lx);
+                f->name = sc->lx.tok;
+                ok = expect(sc, TOK_SYMBOL, "a let variable");
+                state = WANT_EXPR;
+            } else { // let, the body
+                ok = expect(sc, TOK_RPAREN, ") after the let bindings");
+                if (!ok) break;
+                f->first = sc->bind_count;
+                for (int i = 0; i < f->count; ++i) push_binding(sc, f->pending[i]);
+                f->count = 0;
+                state = WANT_EXPR;
+            }
+
+        } else {
+            if (walk.size == 0) {
+                *out = value;
+                break;
+            }
+            SmtWalkItem* it = &walk.items[walk.size - 1];
+            ExprFrame* f = (ExprFrame*)it->node;
+            if (it->tag == FRAME_APPLY) {
+                if (f->n == f->cap) {
+                    f->cap = f->cap ? f->cap * 2 : 4;
+                    f->args = (Expr*)realloc(f->args, sizeof(Expr) * f->cap);
+                }
+                f->args[f->n++] = value;
+                state = WANT_STEP;
+            } else if (it->tag == FRAME_LET && f->first < 0) {
+                if (f->count == f->pending_cap) {
+                    f->pending_cap = f->pending_cap ? f->pending_cap * 2 : 4;
+                    f->pending = (Binding*)realloc(f->pending, sizeof(Binding) * f->pending_cap);
+                }
+                f->pending[f->count++] = (Binding){ f->name.text, f->name.len, value };
+                ok = expect(sc, TOK_RPAREN, ") after a let binding");
+                state = WANT_STEP;
+            } else {
+                // The body of a let, closed along with its bindings, or an annotated expression
+                walk.size--;
+                ok = it->tag == FRAME_LET ? expect(sc, TOK_RPAREN, ") after the let body") : skip_to_close(sc);
+                frame_free(sc, f);
+                if (!ok) expr_free(value);
+            }
+        }
+    }
+    while (walk.size > 0) frame_free(sc, (ExprFrame*)smt_walk_pop(&walk).node); // Innermost first
+    smt_walk_free(&walk);
+    return ok;
+}
+
+// --- Commands ---
+
+static bool parse_sort(Script* sc, Sort* sort) {
+    if (tok_is(&sc->lx.tok, "Int")) *sort = SORT_INT;
+    else if (tok_is(&sc->lx.tok, "Bool")) *sort = SORT_BOOL;
+    else return fail(sc, "unsupported sort %.*s", (int)sc->lx.tok.len, sc->lx.tok.text);
+    next_token(&sc->lx);
+    return true;
+}
+
+static bool cmd_declare(Script* sc, bool is_fun) {
+    Token name = sc->lx.tok;
+    if (!expect(sc, TOK_SYMBOL, "a symbol") || !check_fresh(sc, &name)) return false;
+    Decl d = { name.text, name.len, SORT_INT, 0, 0, false, { NULL, NULL }, -1, NULL };
+    if (is_fun) {
+        if (!expect(sc, TOK_LPAREN, "( before the argument sorts")) return false;
+        while (sc->lx.tok.kind != TOK_RPAREN) {
+            Sort arg = SORT_INT;
+            if (!parse_sort(sc, &arg)) return false;
+            if (arg != SORT_INT) return fail(sc, "only Int arguments are supported");
+            d.arity++;
+        }
+        next_token(&sc->lx);
+    }
+    if (!parse_sort(sc, &d.sort) || !expect(sc, TOK_RPAREN, ")")) return false;
+    if (d.sort == SORT_BOOL && d.arity == 0) d.propvar = ++sc->next_propvar;
+    decl_add(sc, d);
+    return true;
+}
+
+static bool cmd_define(Script* sc) {
+    Token name = sc->lx.tok;
+    if (!expect(sc, TOK_SYMBOL, "a symbol") || !check_fresh(sc, &name)) return false;
+    if (!expect(sc, TOK_LPAREN, "( before the parameters")) return false;
+    if (sc->lx.tok.kind != TOK_RPAREN) return fail(sc, "define-fun with parameters is not supported");
+    next_token(&sc->lx);
+    Decl d = { name.text, name.len, SORT_INT, 0, 0, true, { NULL, NULL }, -1, NULL };
+    if (!parse_sort(sc, &d.sort) || !parse_expr(sc, &d.value)) return false;
+    if ((d.sort == SORT_BOOL) != (d.value.prop != NULL)) {
+        expr_free(d.value);
+        return fail(sc, "body of %.*s does not match its sort", (int)name.len, name.text);
+    }
+    if (!expect(sc, TOK_RPAREN, ")")) {
+        expr_free(d.value);
+        return false;
+    }
+    d.side = sc->side; // Asserted with each use of the macro
+    sc->side = NULL;
+    decl_add(sc, d);
+    return true;
+}
+
+static bool cmd_assert(Script* sc) {
+    Expr e;
+    if (!parse_expr(sc, &e)) return false;
+    if (e.prop == NULL) {
+        expr_free(e);
+        return fail(sc, "assert expects a Bool expression");
+    }
+    if (!expect(sc, TOK_RPAREN, ")")) {
+        expr_free(e);
+        return false;
+    }
+    if (sc->side != NULL) e.prop = make_and(e.prop, sc->side); // With the bounds of its quotients
+    sc->side = NULL;
+    if (sc->assert_count == sc->assert_cap) {
+        sc->assert_cap = sc->assert_cap ? sc->assert_cap * 2 : 64;
+        sc->asserts = (SmtProp**)realloc(sc->asserts, sizeof(SmtProp*) * sc->assert_cap);
+    }
+    sc->asserts[sc->assert_count++] = e.prop;
+    if (solver_supports(e.prop)) solver_assert(sc->inc, e.prop);
+    else sc->unsupported++;
+    return true;
+}
+
+// The optional count of push and pop, leaving their ) to be read once the count is checked
+static bool parse_level_count(Script* sc, int* count) {
+    *count = 1;
+    if (sc->lx.tok.kind == TOK_NUMERAL) {
+        long long v = 0;
+        for (size_t i = 0; i < sc->lx.tok.len && v <= INT_MAX; ++i) v = v * 10 + (sc->lx.tok.text[i] - '0');
+        if (v > INT_MAX) return fail(sc, "level count is out of range");
+        *count = (int)v;
+        next_token(&sc->lx);
+    }
+    return true;
+}
+
+static void push_scope(Script* sc) {
+    if (sc->scope_count == sc->scope_cap) {
+        sc->scope_cap = sc->scope_cap ? sc->scope_cap * 2 : 16;
+        sc->scopes = (Scope*)realloc(sc->scopes, sizeof(Scope) * sc->scope_cap);
+    }
+    Scope s = { sc->assert_count, sc->decl_count, sc->unsupported };
+    sc->scopes[sc->scope_count++] = s;
+    solver_push(sc->inc);
+}
+
+static void pop_scope(Script* sc) {
+    Scope s = sc->scopes[--sc->scope_count];
+    solver_pop(sc->inc); // Drops its references to the assertions freed below
+    while (sc->assert_count > s.assert_count) freeSmtProp(sc->asserts[--sc->assert_count]);
+    decl_pop_to(sc, s.decl_count);
+    sc->unsupported = s.unsupported;
+}
+
+static void check_sat(Script* sc) {
+    int res;
+    bool truncated;
+    if (sc->unsupported == 0) {
+        sc->inc->truncated = false;
+        res = solver_check(sc->inc);
+        truncated = sc->inc->truncated;
+    } else {
+        // Boolean structure in scope: solve every assertion from scratch
+        SmtProplist* list = NULL;
+        for (int i = sc->assert_count - 1; i >= 0; --i) {
+            SmtProplist* node = (SmtProplist*)malloc(sizeof(SmtProplist));
+            node->prop = sc->asserts[i];
+            node->next = list;
+            list = node;
+        }
+        SolverContext* ctx = solver_context_new();
+        ctx->props = list;
+        res = interval_solver(ctx);
+        truncated = ctx->truncated;
+        ctx->props = NULL; // The assertions stay with the script
+        solver_context_free(ctx);
+        while (list != NULL) {
+            SmtProplist* next = list->next;
+            free(list);
+            list = next;
+        }
+    }
+    fprintf(sc->out, "%s\n", res == 1 ? "unsat" : truncated ? "unknown" : "sat");
+    fflush(sc->out);
+}
+
+static void echo(Script* sc, const Token* s) {
+    for (size_t i = 0; i < s->len; ++i) {
+        fputc(s->text[i], sc->out);
+        if (s->text[i] == '"') i++; // "" stands for one quote
+    }
+    fputc('\n', sc->out);
+}
+
+// After the opening parenthesis of a command
+static bool run_command(Script* sc) {
+    Token head = sc->lx.tok;
+    if (!expect(sc, TOK_SYMBOL, "a command")) return false;
+    TRACE(TRACE_PARSE, "->COMMAND %.*s\n", (int)head.len, head.text);
+
+    if (tok_is(&head, "set-logic") || tok_is(&head, "set-info") || tok_is(&head, "set-option")) return skip_to_close(sc);
+    if (tok_is(&head, "declare-const")) return cmd_declare(sc, false);
+    if (tok_is(&head, "declare-fun")) return cmd_declare(sc, true);
+    if (tok_is(&head, "define-fun")) return cmd_define(sc);
+    if (tok_is(&head, "assert")) return cmd_assert(sc);
+    if (tok_is(&head, "check-sat")) {
+        if (!expect(sc, TOK_RPAREN, ")")) return false;
+        check_sat(sc);
+        return true;
+    }
+    if (tok_is(&head, "push") || tok_is(&head, "pop")) {
+        int count;
+        if (!parse_level_count(sc, &count)) return false;
+        bool push = tok_is(&head, "push");
+        if (!push && count > sc->scope_count) return fail(sc, "pop %d with only %d open scopes", count, sc->scope_count);
+        if (!expect(sc, TOK_RPAREN, ")")) return false;
+        if (push) {
+            for (int i = 0; i < count; ++i) push_scope(sc);
+        } else {
+            for (int i = 0; i < count; ++i) pop_scope(sc);
+        }
+        return true;
+    }
+    if (tok_is(&head, "echo")) {
+        Token s = sc->lx.tok;
+        if (!expect(sc, TOK_STRING, "a string") || !expect(sc, TOK_RPAREN, ")")) return false;
+        echo(sc, &s);
+        return true;
+    }
+    if (tok_is(&head, "exit")) {
+        sc->exited = true;
+        return expect(sc, TOK_RPAREN, ")");
+    }
+    return fail(sc, "unsupported command %.*s", (int)head.len, head.text);
+}
+
+int smtlib_run_buffer(const char* buf, size_t len, FILE* out) {
+    Script sc;
+    memset(&sc, 0, sizeof(sc));
+    sc.lx.p = buf;
+    sc.lx.end = buf + len;
+    sc.lx.line = 1;
+    sc.out = out;
+    sc.inc = solver_context_new();
+    solver_init(sc.inc);
+
+    int res = 0;
+    next_token(&sc.lx);
+    while (!sc.exited && sc.lx.tok.kind != TOK_EOF) {
+        sc.error[0] = '\0';
+        sc.command_line = sc.lx.tok.line;
+        freeSmtProp(sc.side); // Left over from a failed command
+        sc.side = NULL;
+        if (sc.lx.tok.kind != TOK_LPAREN) {
+            fail(&sc, sc.lx.tok.kind == TOK_ERROR ? "invalid token" : "expected ( before a command");
+            fprintf(out, "(error \"%s\")\n", sc.error);
+            res = 1;
+            break;
+        }
+        next_token(&sc.lx);
+        int closed = sc.lx.closed;
+        if (run_command(&sc)) continue;
+
+        fprintf(out, "(error \"%s\")\n", sc.error);
+        res = 1;
+        if (sc.lx.closed != closed) continue; // The command failed after its closing parenthesis
+        // Resume after the command's closing parenthesis
+        while (sc.lx.tok.kind != TOK_EOF && sc.lx.tok.kind != TOK_ERROR && !(sc.lx.tok.kind == TOK_RPAREN && sc.lx.depth == 0)) {
+            next_token(&sc.lx);
+        }
+        if (sc.lx.tok.kind == TOK_RPAREN) next_token(&sc.lx);
+    }
+    fflush(out);
+
+    freeSmtProp(sc.side);
+    while (sc.scope_count > 0) pop_scope(&sc);
+    for (int i = 0; i < sc.assert_count; ++i) freeSmtProp(sc.asserts[i]);
+    decl_pop_to(&sc, 0);
+    solver_context_free(sc.inc);
+    free(sc.asserts);
+    free(sc.scopes);
+    free(sc.decls);
+    free(sc.buckets);
+    free(sc.binds);
+    return res;
+}
+
+int smtlib_run_path(const char* path, FILE* out) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    if (len == 0) {
+        close(fd);
+        return smtlib_run_buffer("", 0, out);
+    }
+    // The tokenizer never writes and stops at len, so a read-only mapping is enough
+    char* base = (char*)mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return -1;
+    madvise(base, len, MADV_SEQUENTIAL);
+    int res = smtlib_run_buffer(base, len, out);
+    munmap(base, len);
+    return res;
+}
@@ -0,0 +1,26 @@
+#ifndef SMTLIB_H
+#define SMTLIB_H 1
+#include <stdio.h>
+#include <stddef.h>
+
+// --- SMT-LIB v2 Front-End ---
+// Runs SMT-LIB v2 scripts over the QF_LIA / QF_NIA / QF_UF subset the solver understands:
+// Int and Bool constants, uninterpreted Int functions, + - * div mod (Euclidean), the comparisons, =,
+// distinct, the Boolean connectives, Boolean ite, let and zero-argument define-fun.
+// A hand-written S-expression tokenizer builds the SmtTerm / SmtProp AST directly.
+//
+// Commands are processed in order: set-logic, set-info, set-option, declare-fun,
+// declare-const, define-fun, assert, push, pop, check-sat, echo and exit. check-sat
+// prints unsat when interval propagation finds an empty interval, unknown when it gave
+// up at an iteration limit and sat otherwise. Other commands answer (error "...").
+// While every assertion in scope is a conjunction of atoms, check-sat runs on the
+// incremental solver (incremental.h), mirroring push and pop.
+
+// Runs the script in buf[0..len), writing responses to out. Returns 0, or 1 if any command
+// failed or the script could not be tokenized (responses up to that point are still
+// written). A failed command is reported with the line it starts on and skipped; the
+// commands after it still run.
+int smtlib_run_buffer(const char* buf, size_t len, FILE* out);
+// Maps the file and runs it; -1 if it cannot be opened (errno is set)
+int smtlib_run_path(const char* path, FILE* out);
+#endif
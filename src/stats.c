@@ -0,0 +1,49 @@
+#include "stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+bool solver_stats_enable(SolverContext* ctx) {
+#ifdef SMT_NO_STATS
+    (void)ctx;
+    return false;
+#else
+    if (ctx->stats == NULL) ctx->stats = (SolverStats*)malloc(sizeof(SolverStats));
+    solver_stats_clear(ctx->stats);
+    return true;
+#endif
+}
+
+void solver_stats_clear(SolverStats* s) {
+    memset(s, 0, sizeof(SolverStats));
+    s->phase = PHASE_OTHER;
+}
+
+void solver_stats_merge(SolverStats* into, const SolverStats* from) {
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        into->revisions[p] += from->revisions[p];
+        into->noops[p] += from->noops[p];
+        into->narrowings[p] += from->narrowings[p];
+        into->phase_ns[p] += from->phase_ns[p];
+    }
+    into->empties += from->empties;
+    into->var_lookups += from->var_lookups;
+    into->term_lookups += from->term_lookups;
+    into->lookup_probes += from->lookup_probes;
+}
+
+void solver_stats_print(const SolverStats* s, FILE* out) {
+    static const char* names[PHASE_COUNT] = { "forward", "relation", "backward", "other" };
+    fprintf(out, "%-9s %12s %12s %12s %12s\n", "phase", "revisions", "no-ops", "narrowings", "ms");
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        fprintf(out, "%-9s %12ld %12ld %12ld %12.3f\n", names[p], s->revisions[p], s->noops[p], s->narrowings[p], s->phase_ns[p] / 1e6);
+    }
+    fprintf(out, "empty intervals %ld, var lookups %ld, term lookups %ld, probes %ld\n", s->empties, s->var_lookups, s->term_lookups, s->lookup_probes);
+}
+
+long long stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
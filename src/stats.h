@@ -0,0 +1,63 @@
+#ifndef STATS_H
+#define STATS_H 1
+#include "interval_solver.h"
+#include <stdio.h>
+
+// --- Solver Statistics ---
+// Counters and timers of the propagation engine, kept per context once
+// solver_stats_enable has been called. A context without statistics pays one NULL test
+// per counting site, and building with -DSMT_NO_STATS compiles every site out.
+//
+// A revision is one constraint visited by a phase; it is a no-op when it narrowed
+// nothing. Narrowings are interval writes that changed a bound, attributed to the phase
+// making them: PHASE_OTHER holds those made between rounds (congruence merges, results
+// copied back from component and portfolio contexts). Lookups count calls of the map
+// get_or_add functions and probes the entries they scanned. Phase times come from the
+// monotonic clock; sub-contexts solved on other threads add their own times, so with
+// threads the totals are CPU time rather than wall time.
+typedef enum {
+    PHASE_FORWARD,
+    PHASE_RELATION,
+    PHASE_BACKWARD,
+    PHASE_OTHER,
+    PHASE_COUNT
+} SolverPhase;
+
+struct SolverStats {
+    SolverPhase phase; // Phase running now, PHASE_OTHER between phases
+    long revisions[PHASE_COUNT];
+    long noops[PHASE_COUNT];
+    long narrowings[PHASE_COUNT];
+    long long phase_ns[PHASE_COUNT];
+    long empties; // Propagations stopped by an empty interval
+    long var_lookups;
+    long term_lookups;
+    long lookup_probes;
+};
+
+#ifdef SMT_NO_STATS
+#define STATS_ON(ctx) 0
+#else
+#define STATS_ON(ctx) ((ctx)->stats != NULL)
+#endif
+#define STAT_ADD(ctx, field, n) do { if (STATS_ON(ctx)) (ctx)->stats->field += (n); } while (0)
+// Counts a revision of the running phase and yields its narrowings so far, to be handed
+// to STAT_NOOP once the revision is done; one cut short by an empty interval is no no-op
+#define STAT_REVISION(ctx) (STATS_ON(ctx) ? stats_revision((ctx)->stats) : 0)
+#define STAT_NOOP(ctx, mark) do { if (STATS_ON(ctx) && (ctx)->stats->narrowings[(ctx)->stats->phase] == (mark)) (ctx)->stats->noops[(ctx)->stats->phase]++; } while (0)
+
+static inline long stats_revision(SolverStats* s) {
+    s->revisions[s->phase]++;
+    return s->narrowings[s->phase];
+}
+
+// Starts collecting statistics on ctx, from zero; false if they were compiled out
+bool solver_stats_enable(SolverContext* ctx);
+void solver_stats_clear(SolverStats* s);
+// Adds the counters and times of from to into
+void solver_stats_merge(SolverStats* into, const SolverStats* from);
+// Human-readable table, one line per phase and one for the lookups
+void solver_stats_print(const SolverStats* s, FILE* out);
+// Monotonic clock in nanoseconds
+long long stats_now_ns(void);
+#endif
@@ -0,0 +1,48 @@
+#include "stream.h"
+#include "incremental.h"
+#include "smt_lang.h"
+#include "trace.h"
+
+typedef struct {
+    SolverContext* ctx;
+    bool streaming;    // Still asserting propositions as they arrive
+    bool inconsistent; // Stopped reading at an empty interval
+    long props;        // Propositions asserted
+} StreamState;
+
+static int stream_prop(SmtProp* prop, void* arg) {
+    StreamState* st = (StreamState*)arg;
+    if (!st->streaming) return 0;
+    if (!solver_supports(prop)) {
+        TRACE(TRACE_INFO, "Streaming stopped at proposition %ld, solving the whole file instead.\n", st->props + 1);
+        st->streaming = false;
+        return 0;
+    }
+    solver_assert(st->ctx, prop);
+    st->props++;
+    if (solver_check(st->ctx)) {
+        st->inconsistent = true;
+        return 1; // Nothing read later can undo an empty interval
+    }
+    return 0;
+}
+
+int stream_solve_path(SolverContext* ctx, const char* path, int* result) {
+    StreamState st = { ctx, true, false, 0 };
+    solver_init(ctx);
+    SmtParseContext pctx = { NULL, stream_prop, &st };
+    int parse_result = parseSmtPath(path, &pctx);
+    ctx->props = reverseList(pctx.root);
+    *result = 0;
+    if (parse_result != 0) return parse_result;
+
+    if (st.inconsistent) {
+        TRACE(TRACE_INFO, "Inconsistent after %ld propositions, rest of the input skipped.\n", st.props);
+        *result = 1;
+    } else if (!st.streaming) {
+        // The incremental state only covers a prefix; start over on the full list
+        solver_release(ctx);
+        *result = interval_solver(ctx);
+    }
+    return 0;
+}
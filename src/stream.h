@@ -0,0 +1,16 @@
+#ifndef STREAM_H
+#define STREAM_H 1
+#include "interval_solver.h"
+
+// --- Streaming Solve ---
+// Solves while parsing: each top-level proposition is asserted on the incremental
+// solver (incremental.h) as soon as the parser reduces it, and reading stops at the
+// first empty interval. A proposition the incremental solver cannot take (Boolean
+// structure other than AND) ends streaming; the rest of the file is then parsed and
+// the whole list is solved by interval_solver as usual.
+
+// Parses path into ctx->props (in input order, only the propositions read when the solve
+// stopped early) and stores the interval_solver result convention in *result.
+// Returns like parseSmtPath: 0 on success, -1 if the file cannot be opened, else a parse error.
+int stream_solve_path(SolverContext* ctx, const char* path, int* result);
+#endif
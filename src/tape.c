@@ -0,0 +1,495 @@
+#include "tape.h"
+#include "congruence.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- Compilation ---
+// The emitters follow the engine's walks step by step, emitting the operation each step
+// performs instead of performing it; slots are the class representatives at that point.
+
+static TapeOp* emit(Tape* t, TapeOpKind kind, int a, int d) {
+    if (t->count == t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 256;
+        t->ops = (TapeOp*)realloc(t->ops, sizeof(TapeOp) * t->cap);
+    }
+    TapeOp* op = &t->ops[t->count++];
+    memset(op, 0, sizeof(TapeOp));
+    op->kind = kind;
+    op->a = a;
+    op->d = d;
+    if (d + 1 > t->depth) t->depth = d + 1;
+    return op;
+}
+
+static int slot_of(SolverContext* ctx, SmtTerm* term) {
+    return cc_find(ctx, get_or_add_term_index(ctx, term));
+}
+
+static int var_of(SolverContext* ctx, SmtTerm* term) {
+    return (int)(get_or_add_var_entry(ctx, term->term.Variable) - ctx->var_map);
+}
+
+static int param_at(const Tape* t, int slot) {
+    for (int i = 0; i < t->param_leaves; ++i) {
+        if (t->params[i].slot == slot) return t->params[i].param;
+    }
+    return -1;
+}
+
+// The evaluation finishing term, whose bounds were saved in scratch[d] (d < 0: a leaf)
+static void emit_eval_node(Tape* t, SolverContext* ctx, SmtTerm* term, int d) {
+    int idx = get_or_add_term_index(ctx, term);
+    int slot = cc_find(ctx, idx);
+    TapeOp* op;
+    switch (term->type) {
+        case SMT_ConstNum: {
+            int param = param_at(t, idx);
+            op = emit(t, param >= 0 ? TAPE_EVAL_PARAM : TAPE_EVAL_CONST, slot, d);
+            op->b = param;
+            op->imm = term->term.ConstNum;
+            break;
+        }
+        case SMT_VarName:
+            op = emit(t, TAPE_EVAL_VAR, slot, d);
+            op->b = var_of(ctx, term);
+            break;
+        case SMT_LiaUTerm:
+            if (term->term.UTerm.op == LIA_NEG) emit(t, TAPE_EVAL_NEG, slot, d)->b = slot_of(ctx, term->term.UTerm.t);
+            else emit(t, TAPE_EVAL_INF, slot, d);
+            break;
+        case SMT_LiaBTerm:
+        case SMT_NiaBTerm:
+            op = emit(t, TAPE_EVAL_BOP, slot, d);
+            op->op = term->term.BTerm.op;
+            op->b = slot_of(ctx, term->term.BTerm.t1);
+            op->c = slot_of(ctx, term->term.BTerm.t2);
+            break;
+        default:
+            emit(t, TAPE_EVAL_INF, slot, d);
+    }
+}
+
+// eval_and_update_term_interval, children first; a frame's bounds are saved when it is pushed
+static void emit_eval(Tape* t, SolverContext* ctx, SmtTerm* term, int depth) {
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    if (SmtTerm_arity(term) > 0) emit(t, TAPE_SAVE, slot_of(ctx, term), depth);
+    smt_walk_push(&walk, depth, term, NULL);
+    while (walk.size > 0) {
+        SmtWalkItem* it = &walk.items[walk.size - 1];
+        SmtTerm* node = (SmtTerm*)it->node;
+        int arity = SmtTerm_arity(node);
+        if (it->next < arity) {
+            SmtTerm* child = SmtTerm_child(node, it->next++);
+            int d = it->tag + 1;
+            if (child == NULL) continue;
+            if (SmtTerm_arity(child) > 0) emit(t, TAPE_SAVE, slot_of(ctx, child), d);
+            smt_walk_push(&walk, d, child, NULL);
+            continue;
+        }
+        emit_eval_node(t, ctx, node, arity > 0 ? it->tag : -1);
+        walk.size--;
+    }
+    smt_walk_free(&walk);
+}
+
+// refine_children_intervals: stage 0 narrows the first child, stage 1 re-evaluates it and
+// narrows the second, stage 2 re-evaluates the second
+static void emit_refine(Tape* t, SolverContext* ctx, SmtTerm* term, int depth) {
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, term, NULL)->next = depth;
+    while (walk.size > 0) {
+        SmtWalkItem* it = &walk.items[walk.size - 1];
+        SmtTerm* node = (SmtTerm*)it->node;
+        int d = it->next;
+        SmtTerm* next = NULL;
+        if (it->tag == 0) {
+            if (node->type == SMT_LiaBTerm || node->type == SMT_NiaBTerm) {
+                TapeOp* op = emit(t, TAPE_REFINE_BOP, slot_of(ctx, node), d);
+                op->op = node->term.BTerm.op;
+                op->b = slot_of(ctx, node->term.BTerm.t1);
+                op->c = slot_of(ctx, node->term.BTerm.t2);
+                next = node->term.BTerm.t1;
+            } else if (node->type == SMT_LiaUTerm) {
+                TapeOp* op = emit(t, TAPE_REFINE_NEG, slot_of(ctx, node), d);
+                op->b = slot_of(ctx, node->term.UTerm.t);
+                op->imm = node->term.UTerm.op;
+                next = node->term.UTerm.t;
+            } else if (node->type == SMT_VarName) {
+                emit(t, TAPE_REFINE_VAR, slot_of(ctx, node), d)->b = var_of(ctx, node);
+            }
+            if (next == NULL) { walk.size--; continue; }
+            it->tag = 1;
+        } else if (it->tag == 1) {
+            if (node->type == SMT_LiaUTerm) {
+                emit_eval(t, ctx, node->term.UTerm.t, d + 1);
+                walk.size--;
+                continue;
+            }
+            emit_eval(t, ctx, node->term.BTerm.t1, d + 1);
+            emit(t, TAPE_REFINE_T2, 0, d)->c = slot_of(ctx, node->term.BTerm.t2);
+            next = node->term.BTerm.t2;
+            it->tag = 2;
+        } else {
+            emit_eval(t, ctx, node->term.BTerm.t2, d + 1);
+            walk.size--;
+            continue;
+        }
+        smt_walk_push(&walk, 0, next, NULL)->next = d + 1;
+    }
+    smt_walk_free(&walk);
+}
+
+// relation_phase: equalities merge the two classes first, on ctx as well, so that
+// everything emitted after them sees the merged class
+static void emit_relate(Tape* t, SolverContext* ctx, const AtomConstraint* con) {
+    int i1 = get_or_add_term_index(ctx, con->term1);
+    int i2 = get_or_add_term_index(ctx, con->term2);
+    int r1 = cc_find(ctx, i1), r2 = cc_find(ctx, i2);
+    if (con->distinct) {
+        if (r1 == r2) emit(t, TAPE_FAIL, 0, -1);
+    } else if (con->op == SMT_EQ && r1 != r2) {
+        bool ignored = false;
+        cc_merge(ctx, i1, i2, &ignored);
+        int root = cc_find(ctx, i1);
+        emit(t, TAPE_MERGE, root == r1 ? r2 : r1, -1)->b = root;
+    }
+    TapeOp* op = emit(t, TAPE_RELATE, cc_find(ctx, i1), -1);
+    op->b = cc_find(ctx, i2);
+    op->op = con->op;
+    op->imm = con->distinct;
+}
+
+static void emit_round(Tape* t, SolverContext* ctx, const AtomConstraint* cons, int count) {
+    bool reverse = ctx->strategy.reverse_order;
+    for (int phase = 0; phase < 3; ++phase) {
+        // Forward, relation, backward; relation, backward, forward when relations go first
+        int kind = ctx->strategy.phase_order == PHASES_RELATION_FIRST ? (phase + 1) % 3 : phase;
+        for (int k = 0; k < count; ++k) {
+            const AtomConstraint* con = &cons[reverse ? count - 1 - k : k];
+            if (kind == 0) {
+                emit_eval(t, ctx, con->term1, 0);
+                emit_eval(t, ctx, con->term2, 0);
+            } else if (kind == 1) {
+                emit_relate(t, ctx, con);
+            } else {
+                emit_refine(t, ctx, con->term1, 0);
+                emit_refine(t, ctx, con->term2, 0);
+            }
+        }
+    }
+}
+
+Tape* tape_compile(SolverContext* ctx, const AtomConstraint* cons, int count, const TapeParam* params, int param_leaves, int param_count) {
+    if (cc_has_uf(ctx)) return NULL;
+    Tape* t = (Tape*)calloc(1, sizeof(Tape));
+    t->term_slots = ctx->term_map_count;
+    t->var_slots = ctx->var_map_count;
+    t->term_base = (Interval*)malloc(sizeof(Interval) * (t->term_slots > 0 ? t->term_slots : 1));
+    t->var_base = (Interval*)malloc(sizeof(Interval) * (t->var_slots > 0 ? t->var_slots : 1));
+    for (int i = 0; i < t->term_slots; ++i) t->term_base[i] = ctx->term_map[i].interval;
+    for (int i = 0; i < t->var_slots; ++i) t->var_base[i] = ctx->var_map[i].interval;
+    t->params = (TapeParam*)malloc(sizeof(TapeParam) * (param_leaves > 0 ? param_leaves : 1));
+    memcpy(t->params, params, sizeof(TapeParam) * param_leaves);
+    t->param_leaves = param_leaves;
+    t->param_count = param_count;
+    t->iteration_limit = strategy_iteration_limit(ctx);
+
+    int trail_size = ctx->trail_size;
+    CcMark mark;
+    cc_mark(ctx, &mark);
+    emit_round(t, ctx, cons, count);
+    t->first_count = t->count;
+    emit_round(t, ctx, cons, count); // Every merge is done: the steady round
+    t->roots = (int*)malloc(sizeof(int) * (t->term_slots > 0 ? t->term_slots : 1));
+    for (int i = 0; i < t->term_slots; ++i) {
+        if (ctx->term_map[i].active && cc_find(ctx, i) == i) t->roots[t->root_count++] = i;
+    }
+    undo_trail(ctx, trail_size);
+    cc_restore(ctx, &mark);
+    return t;
+}
+
+void tape_free(Tape* t) {
+    if (t == NULL) return;
+    free(t->ops);
+    free(t->term_base);
+    free(t->var_base);
+    free(t->params);
+    free(t->roots);
+    free(t);
+}
+
+// --- Lanes ---
+// Every operation loops over all lanes and tests the mask per lane, so a dead or finished
+// lane keeps the bounds it ended with. A live lane never holds an empty interval (the
+// write that empties one kills it), which is why the runner skips the engine's test for
+// refining from an empty parent.
+
+TapeLanes* tape_lanes_new(const Tape* t) {
+    TapeLanes* lanes = (TapeLanes*)calloc(1, sizeof(TapeLanes));
+    lanes->terms = (LaneInterval*)malloc(sizeof(LaneInterval) * (t->term_slots > 0 ? t->term_slots : 1));
+    lanes->vars = (LaneInterval*)malloc(sizeof(LaneInterval) * (t->var_slots > 0 ? t->var_slots : 1));
+    lanes->saved = (LaneInterval*)malloc(sizeof(LaneInterval) * (t->depth > 0 ? t->depth : 1));
+    lanes->refined = (LaneInterval*)malloc(sizeof(LaneInterval) * (t->depth > 0 ? t->depth : 1));
+    lanes->values = (long long*)malloc(sizeof(long long) * TAPE_LANES * (t->param_count > 0 ? t->param_count : 1));
+    return lanes;
+}
+
+void tape_lanes_free(TapeLanes* lanes) {
+    if (lanes == NULL) return;
+    free(lanes->terms);
+    free(lanes->vars);
+    free(lanes->saved);
+    free(lanes->refined);
+    free(lanes->values);
+    free(lanes);
+}
+
+static inline Interval lane_get(const LaneInterval* iv, int l) {
+    return (Interval){ iv->lower[l], iv->upper[l] };
+}
+
+static inline void lane_set(LaneInterval* iv, int l, Interval v) {
+    iv->lower[l] = v.lower;
+    iv->upper[l] = v.upper;
+}
+
+static inline void lane_kill(TapeLanes* L, LaneInterval* iv, int l) {
+    lane_set(iv, l, EMPTY_INTERVAL);
+    L->alive[l] = false;
+    L->result[l] = 1;
+}
+
+// An evaluation always writes its result; it changed something if that differs from the saved bounds
+static inline void lane_eval(TapeLanes* L, LaneInterval* slot, int l, long long saved_lo, long long saved_hi, long long lo, long long hi) {
+    if (lo < saved_lo) lo = saved_lo;
+    if (hi > saved_hi) hi = saved_hi;
+    if (lo > hi) { lane_kill(L, slot, l); return; }
+    L->changed[l] |= lo != saved_lo || hi != saved_hi;
+    slot->lower[l] = lo;
+    slot->upper[l] = hi;
+}
+
+// A refinement writes only when its result differs from the bounds it started from
+static inline void lane_refine(TapeLanes* L, LaneInterval* slot, int l, Interval current, Interval narrowed) {
+    if (is_empty_interval(narrowed)) { lane_kill(L, slot, l); return; }
+    if (interval_equals(current, narrowed)) return;
+    lane_set(slot, l, narrowed);
+    L->changed[l] = true;
+}
+
+// calculate_forward_op_interval for the operators written out for lanes
+static inline void lane_add(long long a_lo, long long a_hi, long long b_lo, long long b_hi, long long* lo, long long* hi) {
+    *lo = (a_lo == LLONG_MIN || b_lo == LLONG_MIN) ? LLONG_MIN : safe_add(a_lo, b_lo);
+    *hi = (a_hi == LLONG_MAX || b_hi == LLONG_MAX) ? LLONG_MAX : safe_add(a_hi, b_hi);
+}
+
+static inline void lane_minus(long long a_lo, long long a_hi, long long b_lo, long long b_hi, long long* lo, long long* hi) {
+    *lo = (a_lo == LLONG_MIN || b_hi == LLONG_MAX) ? LLONG_MIN : safe_subtract(a_lo, b_hi);
+    *hi = (a_hi == LLONG_MAX || b_lo == LLONG_MIN) ? LLONG_MAX : safe_subtract(a_hi, b_lo);
+}
+
+static void run_eval(TapeLanes* L, const TapeOp* op) {
+    LaneInterval* slot = &L->terms[op->a];
+    const LaneInterval* saved = op->d < 0 ? slot : &L->saved[op->d];
+    long long saved_lo[TAPE_LANES], saved_hi[TAPE_LANES];
+    memcpy(saved_lo, saved->lower, sizeof(saved_lo));
+    memcpy(saved_hi, saved->upper, sizeof(saved_hi));
+    long long lo[TAPE_LANES], hi[TAPE_LANES];
+    switch (op->kind) {
+        case TAPE_EVAL_CONST:
+            for (int l = 0; l < TAPE_LANES; ++l) lo[l] = hi[l] = op->imm;
+            break;
+        case TAPE_EVAL_PARAM:
+            for (int l = 0; l < TAPE_LANES; ++l) lo[l] = hi[l] = L->values[op->b * TAPE_LANES + l];
+            break;
+        case TAPE_EVAL_VAR:
+            memcpy(lo, L->vars[op->b].lower, sizeof(lo));
+            memcpy(hi, L->vars[op->b].upper, sizeof(hi));
+            break;
+        case TAPE_EVAL_NEG: {
+            const LaneInterval* c = &L->terms[op->b];
+            for (int l = 0; l < TAPE_LANES; ++l) {
+                Interval n = negate_interval(lane_get(c, l));
+                lo[l] = n.lower;
+                hi[l] = n.upper;
+            }
+            break;
+        }
+        case TAPE_EVAL_BOP: {
+            const LaneInterval* x = &L->terms[op->b];
+            const LaneInterval* y = &L->terms[op->c];
+            if (op->op == LIA_ADD) {
+                for (int l = 0; l < TAPE_LANES; ++l) lane_add(x->lower[l], x->upper[l], y->lower[l], y->upper[l], &lo[l], &hi[l]);
+            } else if (op->op == LIA_MINUS) {
+                for (int l = 0; l < TAPE_LANES; ++l) lane_minus(x->lower[l], x->upper[l], y->lower[l], y->upper[l], &lo[l], &hi[l]);
+            } else {
+                for (int l = 0; l < TAPE_LANES; ++l) {
+                    Interval r = L->alive[l] ? calculate_forward_op_interval((SmtTermBop)op->op, lane_get(x, l), lane_get(y, l)) : INF_INTERVAL;
+                    lo[l] = r.lower;
+                    hi[l] = r.upper;
+                }
+            }
+            break;
+        }
+        default:
+            for (int l = 0; l < TAPE_LANES; ++l) {
+                lo[l] = LLONG_MIN;
+                hi[l] = LLONG_MAX;
+            }
+    }
+    for (int l = 0; l < TAPE_LANES; ++l) {
+        if (L->alive[l]) lane_eval(L, slot, l, saved_lo[l], saved_hi[l], lo[l], hi[l]);
+    }
+}
+
+static void run_ops(TapeLanes* L, const TapeOp* ops, int n) {
+    for (int i = 0; i < n; ++i) {
+        const TapeOp* op = &ops[i];
+        switch (op->kind) {
+            case TAPE_SAVE:
+                L->saved[op->d] = L->terms[op->a];
+                break;
+            case TAPE_EVAL_CONST:
+            case TAPE_EVAL_PARAM:
+            case TAPE_EVAL_VAR:
+            case TAPE_EVAL_NEG:
+            case TAPE_EVAL_BOP:
+            case TAPE_EVAL_INF:
+                run_eval(L, op);
+                break;
+            case TAPE_REFINE_BOP: {
+                LaneInterval* t1 = &L->terms[op->b];
+                const LaneInterval* t2 = &L->terms[op->c];
+                for (int l = 0; l < TAPE_LANES; ++l) {
+                    if (!L->alive[l]) continue;
+                    Interval i1 = lane_get(t1, l), i2 = lane_get(t2, l), r1, r2;
+                    calculate_backward_op_intervals((SmtTermBop)op->op, lane_get(&L->terms[op->a], l), i1, i2, &r1, &r2);
+                    lane_set(&L->saved[op->d], l, i2);
+                    lane_set(&L->refined[op->d], l, r2);
+                    lane_refine(L, t1, l, i1, intersect_intervals(i1, r1));
+                }
+                break;
+            }
+            case TAPE_REFINE_T2: {
+                LaneInterval* t2 = &L->terms[op->c];
+                for (int l = 0; l < TAPE_LANES; ++l) {
+                    if (!L->alive[l]) continue;
+                    Interval saved = lane_get(&L->saved[op->d], l);
+                    lane_refine(L, t2, l, saved, intersect_intervals(saved, lane_get(&L->refined[op->d], l)));
+                }
+                break;
+            }
+            case TAPE_REFINE_NEG: {
+                LaneInterval* child = &L->terms[op->b];
+                for (int l = 0; l < TAPE_LANES; ++l) {
+                    if (!L->alive[l]) continue;
+                    Interval current = lane_get(child, l);
+                    Interval refined = op->imm == LIA_NEG ? negate_interval(lane_get(&L->terms[op->a], l)) : INF_INTERVAL;
+                    lane_refine(L, child, l, current, intersect_intervals(current, refined));
+                }
+                break;
+            }
+            case TAPE_REFINE_VAR: {
+                LaneInterval* var = &L->vars[op->b];
+                for (int l = 0; l < TAPE_LANES; ++l) {
+                    if (!L->alive[l]) continue;
+                    Interval current = lane_get(var, l);
+                    lane_refine(L, var, l, current, intersect_intervals(current, lane_get(&L->terms[op->a], l)));
+                }
+                break;
+            }
+            case TAPE_MERGE: {
+                LaneInterval* root = &L->terms[op->b];
+                for (int l = 0; l < TAPE_LANES; ++l) {
+                    if (!L->alive[l]) continue;
+                    Interval merged = intersect_intervals(lane_get(&L->terms[op->a], l), lane_get(root, l));
+                    L->changed[l] = true; // A merge is progress, as in the engine
+                    if (is_empty_interval(merged)) lane_kill(L, root, l);
+                    else lane_set(root, l, merged);
+                }
+                break;
+            }
+            case TAPE_RELATE: {
+                LaneInterval* t1 = &L->terms[op->a];
+                LaneInterval* t2 = &L->terms[op->b];
+                for (int l = 0; l < TAPE_LANES; ++l) {
+                    if (!L->alive[l]) continue;
+                    Interval i1 = lane_get(t1, l), i2 = lane_get(t2, l), n1, n2;
+                    relate_intervals((SmtBinPred)op->op, op->imm != 0, i1, i2, &n1, &n2);
+                    lane_refine(L, t1, l, i1, n1);
+                    if (L->alive[l]) lane_refine(L, t2, l, i2, n2);
+                }
+                break;
+            }
+            case TAPE_FAIL:
+                for (int l = 0; l < TAPE_LANES; ++l) {
+                    if (L->alive[l]) {
+                        L->alive[l] = false;
+                        L->result[l] = 1;
+                    }
+                }
+                break;
+        }
+    }
+}
+
+// The engine's closing check over every variable and class of a lane that stopped propagating
+static int lane_final_check(const TapeLanes* L, const Tape* t, int l) {
+    for (int i = 0; i < t->var_slots; ++i) if (is_empty_interval(lane_get(&L->vars[i], l))) return 1;
+    for (int i = 0; i < t->root_count; ++i) if (is_empty_interval(lane_get(&L->terms[t->roots[i]], l))) return 1;
+    return 0;
+}
+
+void tape_lanes_run(TapeLanes* L, const Tape* t, const int* values, int count) {
+    for (int i = 0; i < t->term_slots; ++i) {
+        for (int l = 0; l < TAPE_LANES; ++l) lane_set(&L->terms[i], l, t->term_base[i]);
+    }
+    for (int i = 0; i < t->var_slots; ++i) {
+        for (int l = 0; l < TAPE_LANES; ++l) lane_set(&L->vars[i], l, t->var_base[i]);
+    }
+    for (int p = 0; p < t->param_count; ++p) {
+        for (int l = 0; l < TAPE_LANES; ++l) L->values[p * TAPE_LANES + l] = l < count ? values[l * t->param_count + p] : 0;
+    }
+    for (int i = 0; i < t->param_leaves; ++i) {
+        for (int l = 0; l < count; ++l) {
+            long long v = L->values[t->params[i].param * TAPE_LANES + l];
+            lane_set(&L->terms[t->params[i].slot], l, (Interval){ v, v });
+        }
+    }
+    int live = 0;
+    for (int l = 0; l < TAPE_LANES; ++l) {
+        L->alive[l] = l < count;
+        L->result[l] = 0;
+        L->truncated[l] = false;
+        L->rounds[l] = 0;
+        live += L->alive[l];
+    }
+
+    // fixpoint_loop for every lane at once
+    for (int iterations = 1; live > 0; ++iterations) {
+        for (int l = 0; l < TAPE_LANES; ++l) {
+            L->changed[l] = false;
+            if (L->alive[l]) L->rounds[l] = iterations;
+        }
+        if (iterations == 1) run_ops(L, t->ops, t->first_count);
+        else run_ops(L, t->ops + t->first_count, t->count - t->first_count);
+        live = 0;
+        for (int l = 0; l < TAPE_LANES; ++l) {
+            if (!L->alive[l]) continue;
+            if (iterations >= t->iteration_limit) {
+                fprintf(stderr, "Warning: Max iterations reached, potential non-convergence or slow convergence.\n");
+                L->truncated[l] = true;
+            } else if (L->changed[l]) {
+                live++;
+                continue;
+            }
+            L->alive[l] = false;
+            L->result[l] = lane_final_check(L, t, l);
+        }
+    }
+}
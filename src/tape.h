@@ -0,0 +1,107 @@
+#ifndef TAPE_H
+#define TAPE_H 1
+#include "interval_solver.h"
+
+// --- Propagation Tapes ---
+// A conjunction of atoms compiled into the straight-line sequence of interval operations
+// one propagation round performs: the forward evaluations, relations and backward
+// refinements of every constraint, in the engine's order, each with its congruence class
+// slots resolved. Equalities merge classes during the first round's relation phase and
+// nowhere else, so the first round has a tape of its own and every later round runs the
+// same second tape. Evaluation and refinement frames keep their saved bounds in scratch
+// rows indexed by walk depth, as ctx->walk does. Running the tape narrows exactly as
+// propagate_to_fixpoint does on the compiled context; skeletons whose classes depend on
+// the values (UF applications, merged when they become congruent or equal singletons)
+// are not compiled.
+//
+// The lane runner solves TAPE_LANES instances of one skeleton in lockstep, each lane
+// holding one instance's bounds: every operation is decoded once and applied to all
+// lanes in a fixed-width loop the compiler vectorizes, and a lane that found an empty
+// interval or converged stops being written through its mask.
+
+#ifndef TAPE_LANES
+#define TAPE_LANES 8
+#endif
+
+typedef enum {
+    TAPE_SAVE,        // scratch[d] = slot a, as a frame pushed for evaluation
+    // Evaluations set slot a to its saved bounds (scratch[d], or slot a itself when d < 0,
+    // a leaf) intersected with:
+    TAPE_EVAL_CONST,  // [imm, imm]
+    TAPE_EVAL_PARAM,  // [v, v] for the value v of parameter b
+    TAPE_EVAL_VAR,    // var b
+    TAPE_EVAL_NEG,    // -slot b
+    TAPE_EVAL_BOP,    // slot b op slot c
+    TAPE_EVAL_INF,    // nothing
+    TAPE_REFINE_BOP,  // Narrows slot b from parent slot a and slot c, keeps c's bounds in scratch[d]
+    TAPE_REFINE_T2,   // Narrows slot c with the bounds kept in scratch[d]
+    TAPE_REFINE_NEG,  // Narrows slot b from parent slot a (imm is the unary operator)
+    TAPE_REFINE_VAR,  // Narrows var b to parent slot a
+    TAPE_MERGE,       // Class slot a joins slot b, which keeps the intersection
+    TAPE_RELATE,      // slot a op slot b, distinct when imm is 1
+    TAPE_FAIL         // A negated equality over one class
+} TapeOpKind;
+
+typedef struct {
+    TapeOpKind kind;
+    int op;  // SmtTermBop or SmtBinPred
+    int a, b, c;
+    int d;
+    long long imm;
+} TapeOp;
+
+// A parameter leaf: the term map slot of a constant whose value changes per instance
+typedef struct {
+    int slot;
+    int param;
+} TapeParam;
+
+typedef struct {
+    TapeOp* ops;      // ops[0..first_count) is the first round, the rest every later one
+    int count;
+    int cap;
+    int first_count;
+    int term_slots;
+    int var_slots;
+    int depth;        // Scratch rows
+    Interval* term_base; // Bounds every solve starts from
+    Interval* var_base;
+    TapeParam* params;
+    int param_leaves;
+    int param_count;
+    int* roots;       // Class representatives once every merge is done
+    int root_count;
+    int iteration_limit;
+} Tape;
+
+// Compiles cons[0..count) over ctx's populated maps, which must have a scope open; the
+// merges compiled into the first round are made on ctx and undone again. NULL if the
+// maps hold UF applications.
+Tape* tape_compile(SolverContext* ctx, const AtomConstraint* cons, int count, const TapeParam* params, int param_leaves, int param_count);
+void tape_free(Tape* tape);
+
+typedef struct {
+    long long lower[TAPE_LANES];
+    long long upper[TAPE_LANES];
+} LaneInterval;
+
+// Lane state of one tape, allocated once and reused by every run
+typedef struct {
+    LaneInterval* terms;
+    LaneInterval* vars;
+    LaneInterval* saved;
+    LaneInterval* refined;
+    long long* values;        // param_count rows of TAPE_LANES parameter values
+    bool alive[TAPE_LANES];   // Still propagating
+    bool changed[TAPE_LANES]; // Narrowed something in the current round
+    int result[TAPE_LANES];   // interval_solver's convention
+    bool truncated[TAPE_LANES];
+    long rounds[TAPE_LANES];
+} TapeLanes;
+
+TapeLanes* tape_lanes_new(const Tape* tape);
+void tape_lanes_free(TapeLanes* lanes);
+// Solves count <= TAPE_LANES instances, values holding param_count values per instance;
+// lane i's verdict lands in lanes->result[i] and its variables in lanes->vars
+void tape_lanes_run(TapeLanes* lanes, const Tape* tape, const int* values, int count);
+#endif
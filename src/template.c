@@ -0,0 +1,205 @@
+#include "template.h"
+#include "cdcl.h"
+#include "congruence.h"
+#include "stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// An occurrence of a parameter in the skeleton
+typedef struct {
+    SmtTerm* term;  // The SMT_ConstNum leaf, rewritten on every solve
+    int param;
+    int index;      // Its term map slot, -1 for a skeleton solved by CDCL(T)
+} TemplateLeaf;
+
+struct SmtTemplate {
+    SolverContext* ctx; // Holds the skeleton as ctx->props
+    int param_count;
+    TemplateLeaf* leaves;
+    int leaf_count;
+    AtomConstraint* cons; // NULL when the skeleton has Boolean structure
+    int cons_count;
+    int trail_base;       // Trail size of the compiled state
+    CcMark cc;
+    bool tape_tried;      // The tape is compiled on first use
+    Tape* tape;
+    TapeLanes* lanes;
+    CompiledTape* compiled; // Runs template_solve when set
+};
+
+enum { WALK_PROP, WALK_TERM };
+
+static int param_of(const char* name, const char* const* names, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static void add_leaf(SmtTemplate* t, SmtTerm* term, int param, int* cap) {
+    if (t->leaf_count == *cap) {
+        *cap = *cap ? *cap * 2 : 16;
+        t->leaves = (TemplateLeaf*)realloc(t->leaves, sizeof(TemplateLeaf) * *cap);
+    }
+    t->leaves[t->leaf_count++] = (TemplateLeaf){ term, param, -1 };
+}
+
+// Turns every occurrence of a parameter into a constant leaf and records it
+static void mark_params(SmtTemplate* t, const char* const* names, int count) {
+    int cap = 0;
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    for (SmtProplist* current = t->ctx->props; current != NULL; current = current->next) {
+        smt_walk_push(&walk, WALK_PROP, current->prop, NULL);
+        while (walk.size > 0) {
+            SmtWalkItem it = smt_walk_pop(&walk);
+            if (it.node == NULL) continue;
+            if (it.tag == WALK_PROP) {
+                SmtProp* p = (SmtProp*)it.node;
+                if (p->type >= SMTAT_PROP_EQ && p->type <= SMTAT_PROP_NIA_EQ) {
+                    smt_walk_push(&walk, WALK_TERM, p->prop.Atomic_prop.term2, NULL);
+                    smt_walk_push(&walk, WALK_TERM, p->prop.Atomic_prop.term1, NULL);
+                }
+                for (int i = SmtProp_arity(p) - 1; i >= 0; --i) smt_walk_push(&walk, WALK_PROP, SmtProp_child(p, i), NULL);
+                continue;
+            }
+            SmtTerm* term = (SmtTerm*)it.node;
+            if (term->type == SMT_VarName) {
+                int param = param_of(term->term.Variable, names, count);
+                if (param < 0) continue;
+                free(term->term.Variable);
+                term->type = SMT_ConstNum;
+                term->term.ConstNum = 0; // Overwritten by every solve
+                add_leaf(t, term, param, &cap);
+                continue;
+            }
+            for (int i = SmtTerm_arity(term) - 1; i >= 0; --i) smt_walk_push(&walk, WALK_TERM, SmtTerm_child(term, i), NULL);
+        }
+    }
+    smt_walk_free(&walk);
+}
+
+SmtTemplate* template_compile(SmtProplist* props, const char* const* names, int count) {
+    SmtTemplate* t = (SmtTemplate*)calloc(1, sizeof(SmtTemplate));
+    t->ctx = solver_context_new();
+    t->ctx->props = props;
+    t->param_count = count;
+    for (int i = 0; i < count; ++i) {
+        if (param_of(names[i], names, i) >= 0) {
+            fprintf(stderr, "Error: parameter '%s' is named twice.\n", names[i]);
+            template_free(t);
+            return NULL;
+        }
+    }
+    mark_params(t, names, count);
+    for (int i = 0; i < count; ++i) {
+        int used = 0;
+        for (int j = 0; j < t->leaf_count && !used; ++j) used = t->leaves[j].param == i;
+        if (!used) {
+            fprintf(stderr, "Error: parameter '%s' does not occur in the skeleton.\n", names[i]);
+            template_free(t);
+            return NULL;
+        }
+    }
+
+    SolverContext* ctx = t->ctx;
+    for (SmtProplist* current = props; current != NULL; current = current->next) {
+        if (!is_interval_atom(current->prop)) return t; // Solved by CDCL(T), which populates its own maps
+        t->cons_count++;
+    }
+    populate_maps_from_proplist(ctx, props);
+    t->cons = (AtomConstraint*)malloc(sizeof(AtomConstraint) * (t->cons_count > 0 ? t->cons_count : 1));
+    int c = 0;
+    for (SmtProplist* current = props; current != NULL; current = current->next) {
+        t->cons[c++] = make_atom_constraint(current->prop, true);
+    }
+    for (int i = 0; i < t->leaf_count; ++i) t->leaves[i].index = get_or_add_term_index(ctx, t->leaves[i].term);
+    // Every write of a solve is trailed from here on, so the next one starts by undoing it
+    ctx->scope_depth = 1;
+    t->trail_base = ctx->trail_size;
+    cc_mark(ctx, &t->cc);
+    return t;
+}
+
+void template_free(SmtTemplate* t) {
+    if (t == NULL) return;
+    solver_context_free(t->ctx);
+    tape_lanes_free(t->lanes);
+    codegen_free(t->compiled);
+    tape_free(t->tape);
+    free(t->leaves);
+    free(t->cons);
+    free(t);
+}
+
+int template_param_count(const SmtTemplate* t) {
+    return t->param_count;
+}
+
+SolverContext* template_context(SmtTemplate* t) {
+    return t->ctx;
+}
+
+// Back to the compiled state
+static void template_rewind(SmtTemplate* t) {
+    undo_trail(t->ctx, t->trail_base);
+    cc_restore(t->ctx, &t->cc);
+}
+
+int template_solve(SmtTemplate* t, const int* values) {
+    SolverContext* ctx = t->ctx;
+    ctx->truncated = false;
+    ctx->rounds = 0;
+    if (ctx->stats) solver_stats_clear(ctx->stats);
+    for (int i = 0; i < t->leaf_count; ++i) t->leaves[i].term->term.ConstNum = values[t->leaves[i].param];
+    if (t->cons == NULL) return cdcl_solve(ctx, ctx->props);
+
+    template_rewind(t);
+    if (t->compiled != NULL) {
+        int res = codegen_run(t->compiled, t->tape, values, &ctx->rounds, &ctx->truncated);
+        for (int v = 0; v < ctx->var_map_count; ++v) set_var_interval(ctx, &ctx->var_map[v], t->compiled->vars[v]);
+        return res;
+    }
+    for (int i = 0; i < t->leaf_count; ++i) {
+        long long v = t->leaves[i].term->term.ConstNum;
+        set_term_interval(ctx, &ctx->term_map[t->leaves[i].index], (Interval){ v, v });
+    }
+    return propagate_to_fixpoint(ctx, t->cons, t->cons_count);
+}
+
+// The skeleton's tape, compiled on first use; NULL if it has none
+static Tape* template_tape(SmtTemplate* t) {
+    if (t->cons == NULL || t->tape_tried) return t->tape;
+    t->tape_tried = true;
+    template_rewind(t);
+    TapeParam* params = (TapeParam*)malloc(sizeof(TapeParam) * (t->leaf_count > 0 ? t->leaf_count : 1));
+    for (int i = 0; i < t->leaf_count; ++i) params[i] = (TapeParam){ t->leaves[i].index, t->leaves[i].param };
+    t->tape = tape_compile(t->ctx, t->cons, t->cons_count, params, t->leaf_count, t->param_count);
+    free(params);
+    return t->tape;
+}
+
+bool template_solve_lanes(SmtTemplate* t, const int* values, int count, int* results) {
+    if (template_tape(t) == NULL) return false;
+    if (t->lanes == NULL) t->lanes = tape_lanes_new(t->tape);
+    tape_lanes_run(t->lanes, t->tape, values, count);
+    for (int i = 0; i < count; ++i) results[i] = t->lanes->result[i];
+    return true;
+}
+
+void template_load_lane(SmtTemplate* t, int i) {
+    SolverContext* ctx = t->ctx;
+    template_rewind(t);
+    for (int v = 0; v < ctx->var_map_count; ++v) {
+        set_var_interval(ctx, &ctx->var_map[v], (Interval){ t->lanes->vars[v].lower[i], t->lanes->vars[v].upper[i] });
+    }
+    ctx->truncated = t->lanes->truncated[i];
+    ctx->rounds = t->lanes->rounds[i];
+}
+
+bool template_use_codegen(SmtTemplate* t, const char* cache_dir) {
+    if (t->compiled == NULL && template_tape(t) != NULL) t->compiled = codegen_load(t->tape, cache_dir);
+    return t->compiled != NULL;
+}
@@ -0,0 +1,49 @@
+#ifndef TEMPLATE_H
+#define TEMPLATE_H 1
+#include "interval_solver.h"
+#include "codegen.h"
+
+// --- Parametric Templates ---
+// One constraint skeleton solved many times with different constants. The variables
+// named as parameters become SMT_ConstNum leaves, and template_compile populates the
+// maps, builds the constraint array and opens a scope on a context of its own, all once.
+// template_solve then undoes the previous solve's writes from the undo trail, writes the
+// values into the leaves and propagates: no parsing, no map population, and after the
+// first few calls no allocation. Intervals stay readable in the context until the next
+// call. A conjunction of atoms is propagated as one constraint set rather than split
+// into components. Skeletons with Boolean structure go through the CDCL(T) engine on
+// every call, which skips parsing but rebuilds its maps.
+//
+// template_solve_lanes solves up to TAPE_LANES rows at once on the skeleton's propagation
+// tape (tape.h), compiled on first use: the rows advance through the rounds in lockstep,
+// with the verdicts and variable intervals template_solve would give.
+//
+// template_use_codegen swaps the engine under template_solve for that tape compiled to
+// native code (codegen.h), with the same verdicts and variable intervals.
+
+typedef struct SmtTemplate SmtTemplate;
+
+// Takes ownership of props, in solver order. names[0..count) are the parameters, each of
+// which must occur in the skeleton as a variable. NULL, with the error printed, otherwise.
+SmtTemplate* template_compile(SmtProplist* props, const char* const* names, int count);
+// Frees the template, its context and the skeleton
+void template_free(SmtTemplate* t);
+int template_param_count(const SmtTemplate* t);
+// Solves the skeleton with values[i] for parameter i. Same result convention as
+// interval_solver: 1 if inconsistent, 0 otherwise (ctx->truncated if cut off).
+int template_solve(SmtTemplate* t, const int* values);
+// The context holding the intervals of the last solve
+SolverContext* template_context(SmtTemplate* t);
+// Solves count <= TAPE_LANES rows, values holding template_param_count values per row,
+// with results[i] as template_solve would return it for row i. False, with nothing
+// solved, if the skeleton has no tape (Boolean structure or UF applications).
+bool template_solve_lanes(SmtTemplate* t, const int* values, int count, int* results);
+// Makes row i of the last template_solve_lanes the context's last solve: its variable
+// intervals, truncated and rounds (the term map stays at the compiled state)
+void template_load_lane(SmtTemplate* t, int i);
+// Makes template_solve run the skeleton's generated propagator, built in or loaded from
+// cache_dir. False, with template_solve left on the engine, if the skeleton has no tape
+// or the propagator could not be built (reported on stderr). The term map stays at the
+// compiled state after such solves.
+bool template_use_codegen(SmtTemplate* t, const char* cache_dir);
+#endif
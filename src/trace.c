@@ -0,0 +1,30 @@
+#include "trace.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+TraceLevel trace_level = TRACE_OFF;
+FILE* trace_sink = NULL;
+
+FILE* trace_file(void) {
+    return trace_sink ? trace_sink : stdout;
+}
+
+void trace_printf(const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(trace_file(), fmt, ap);
+    va_end(ap);
+}
+
+int trace_parse_level(const char* s) {
+    static const char* names[] = { "off", "info", "props", "parse", "tokens" };
+    for (int i = 0; i <= TRACE_TOKENS; ++i) {
+        if (strcmp(s, names[i]) == 0) return i;
+    }
+    char* end;
+    long level = strtol(s, &end, 10);
+    if (*s == '\0' || *end != '\0' || level < TRACE_OFF || level > TRACE_TOKENS) return -1;
+    return (int)level;
+}
@@ -0,0 +1,32 @@
+#ifndef TRACE_H
+#define TRACE_H 1
+#include <stdio.h>
+
+// --- Trace ---
+// Diagnostic output by level. The level is picked at run time, before any worker thread
+// starts, and a disabled call costs one comparison. Building with -DSMT_NO_TRACE compiles
+// every trace call out, so release builds parse and solve without any I/O.
+typedef enum {
+    TRACE_OFF,    // Nothing
+    TRACE_INFO,   // Progress of the driver: parsing, solving, cleanup
+    TRACE_PROPS,  // Parsed proplists
+    TRACE_PARSE,  // Grammar reductions and each proposition as it is reduced
+    TRACE_TOKENS  // Scanner tokens
+} TraceLevel;
+
+extern TraceLevel trace_level; // TRACE_OFF unless changed
+extern FILE* trace_sink;       // NULL for stdout
+
+#ifdef SMT_NO_TRACE
+#define TRACE_ON(level) 0
+#else
+#define TRACE_ON(level) ((level) <= trace_level)
+#endif
+#define TRACE(level, ...) do { if (TRACE_ON(level)) trace_printf(__VA_ARGS__); } while (0)
+
+void trace_printf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+// Where traces go, for printers that take a FILE*
+FILE* trace_file(void);
+// Level from a name (off, info, props, parse, tokens) or its number; -1 if unknown
+int trace_parse_level(const char* s);
+#endif
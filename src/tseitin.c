@@ -0,0 +1,297 @@
+#include "tseitin.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- Memo Table ---
+// Atoms are keyed by SmtProp_hash and compared with SmtProp_eqb. Gates are keyed
+// by their operator and already encoded child literals, so equal subformulas
+// (up to operand order and negation) are defined once.
+typedef struct {
+    unsigned long long hash;
+    int op;        // 0 for atoms, SMTPROP_AND / SMTPROP_OR / SMTPROP_IFF for gates
+    Lit a, b;
+    SmtProp* atom;
+    Lit lit;
+    bool used;
+} MemoEntry;
+
+typedef struct {
+    CnfFormula* cnf;
+    MemoEntry* memo;
+    int memo_count;
+    int memo_cap; // Power of two
+    Lit true_lit; // -1 until a constant is needed
+    // Literals of the encoded operands waiting for their parent, see encode_prop
+    Lit* done;
+    int done_size;
+    int done_cap;
+} Encoder;
+
+static unsigned long long gate_hash(int op, Lit a, Lit b) {
+    unsigned long long h = (unsigned long long)op * 0x9e3779b97f4a7c15ULL;
+    h ^= (unsigned long long)a * 0xbf58476d1ce4e5b9ULL;
+    h ^= (unsigned long long)b * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+static void memo_grow(Encoder* E) {
+    MemoEntry* old = E->memo;
+    int old_cap = E->memo_cap;
+    E->memo_cap = old_cap ? old_cap * 2 : 64;
+    E->memo = (MemoEntry*)calloc(E->memo_cap, sizeof(MemoEntry));
+    for (int i = 0; i < old_cap; ++i) {
+        if (!old[i].used) continue;
+        int j = (int)(old[i].hash & (E->memo_cap - 1));
+        while (E->memo[j].used) j = (j + 1) & (E->memo_cap - 1);
+        E->memo[j] = old[i];
+    }
+    free(old);
+}
+
+// Returns the matching entry, or the free slot where it belongs
+static MemoEntry* memo_find(Encoder* E, unsigned long long hash, int op, Lit a, Lit b, SmtProp* atom) {
+    if (2 * (E->memo_count + 1) > E->memo_cap) memo_grow(E);
+    int j = (int)(hash & (E->memo_cap - 1));
+    while (E->memo[j].used) {
+        MemoEntry* e = &E->memo[j];
+        if (e->hash == hash && e->op == op) {
+            if (op == 0 ? SmtProp_eqb(e->atom, atom) : (e->a == a && e->b == b)) return e;
+        }
+        j = (j + 1) & (E->memo_cap - 1);
+    }
+    return &E->memo[j];
+}
+
+static void memo_insert(Encoder* E, MemoEntry* slot, unsigned long long hash, int op, Lit a, Lit b, SmtProp* atom, Lit lit) {
+    slot->hash = hash;
+    slot->op = op;
+    slot->a = a;
+    slot->b = b;
+    slot->atom = atom;
+    slot->lit = lit;
+    slot->used = true;
+    E->memo_count++;
+}
+
+// --- Clause Storage ---
+
+static int cnf_new_var(CnfFormula* cnf, SmtProp* atom) {
+    if (cnf->num_vars == cnf->cap_vars) {
+        cnf->cap_vars = cnf->cap_vars ? cnf->cap_vars * 2 : 64;
+        cnf->atoms = (SmtProp**)realloc(cnf->atoms, sizeof(SmtProp*) * cnf->cap_vars);
+    }
+    cnf->atoms[cnf->num_vars] = atom;
+    return cnf->num_vars++;
+}
+
+static void cnf_add_clause(CnfFormula* cnf, const Lit* lits, int n) {
+    if (cnf->num_lits + n > cnf->cap_lits) {
+        while (cnf->num_lits + n > cnf->cap_lits) cnf->cap_lits = cnf->cap_lits ? cnf->cap_lits * 2 : 256;
+        cnf->lits = (Lit*)realloc(cnf->lits, sizeof(Lit) * cnf->cap_lits);
+    }
+    if (cnf->num_clauses + 2 > cnf->cap_clauses) {
+        cnf->cap_clauses = cnf->cap_clauses ? cnf->cap_clauses * 2 : 64;
+        cnf->clause_start = (int*)realloc(cnf->clause_start, sizeof(int) * cnf->cap_clauses);
+    }
+    memcpy(cnf->lits + cnf->num_lits, lits, sizeof(Lit) * n);
+    cnf->num_lits += n;
+    cnf->clause_start[++cnf->num_clauses] = cnf->num_lits;
+}
+
+static void add2(CnfFormula* cnf, Lit a, Lit b) { Lit c[2] = {a, b}; cnf_add_clause(cnf, c, 2); }
+static void add3(CnfFormula* cnf, Lit a, Lit b, Lit d) { Lit c[3] = {a, b, d}; cnf_add_clause(cnf, c, 3); }
+
+static Lit true_lit(Encoder* E) {
+    if (E->true_lit < 0) {
+        E->true_lit = MK_LIT(cnf_new_var(E->cnf, NULL), 0);
+        cnf_add_clause(E->cnf, &E->true_lit, 1);
+    }
+    return E->true_lit;
+}
+
+// --- Encoding ---
+
+// Defines x <-> (a op b); a and b are already encoded literals
+static Lit encode_gate(Encoder* E, int op, Lit a, Lit b) {
+    bool flip = false;
+    if (op == SMTPROP_IFF) { // a <-> b with negated inputs is the negation of the positive gate
+        if (LIT_SIGN(a)) { a = LIT_NEG(a); flip = !flip; }
+        if (LIT_SIGN(b)) { b = LIT_NEG(b); flip = !flip; }
+    }
+    if (a > b) { Lit t = a; a = b; b = t; } // Commutative: order the operands
+
+    // Trivial gates need no definition variable
+    if (a == b) {
+        if (op == SMTPROP_IFF) return flip ? LIT_NEG(true_lit(E)) : true_lit(E);
+        return a;
+    }
+    if (a == LIT_NEG(b)) {
+        if (op == SMTPROP_OR) return true_lit(E);
+        return LIT_NEG(true_lit(E)); // a /\ NOT a
+    }
+
+    unsigned long long hash = gate_hash(op, a, b);
+    MemoEntry* slot = memo_find(E, hash, op, a, b, NULL);
+    if (slot->used) return flip ? LIT_NEG(slot->lit) : slot->lit;
+
+    CnfFormula* cnf = E->cnf;
+    Lit x = MK_LIT(cnf_new_var(cnf, NULL), 0);
+    switch (op) {
+        case SMTPROP_AND: // x <-> a /\ b
+            add2(cnf, LIT_NEG(x), a);
+            add2(cnf, LIT_NEG(x), b);
+            add3(cnf, x, LIT_NEG(a), LIT_NEG(b));
+            break;
+        case SMTPROP_OR: // x <-> a \/ b
+            add3(cnf, LIT_NEG(x), a, b);
+            add2(cnf, x, LIT_NEG(a));
+            add2(cnf, x, LIT_NEG(b));
+            break;
+        case SMTPROP_IFF: // x <-> (a <-> b)
+            add3(cnf, LIT_NEG(x), LIT_NEG(a), b);
+            add3(cnf, LIT_NEG(x), a, LIT_NEG(b));
+            add3(cnf, x, a, b);
+            add3(cnf, x, LIT_NEG(a), LIT_NEG(b));
+            break;
+        default:
+            break;
+    }
+    memo_insert(E, slot, hash, op, a, b, NULL, x);
+    return flip ? LIT_NEG(x) : x;
+}
+
+// Operands encoded before p; atoms (and opaque quantified propositions) have none
+static int encode_arity(SmtProp* p) {
+    return p->type == SMTB_PROP ? 2 : p->type == SMTU_PROP ? 1 : 0;
+}
+
+// Literal of p, whose operands are encoded as sub[0..encode_arity(p))
+static Lit encode_node(Encoder* E, SmtProp* p, const Lit* sub) {
+    switch (p->type) {
+        case SMTTF_PROP:
+            return p->prop.TF ? true_lit(E) : LIT_NEG(true_lit(E));
+        case SMTU_PROP: // NOT
+            return LIT_NEG(sub[0]);
+        case SMTB_PROP: {
+            Lit a = sub[0];
+            Lit b = sub[1];
+            switch (p->prop.Binary_prop.op) {
+                case SMTPROP_IMPLY: // a -> b is NOT a \/ b
+                    return encode_gate(E, SMTPROP_OR, LIT_NEG(a), b);
+                default:
+                    return encode_gate(E, p->prop.Binary_prop.op, a, b);
+            }
+        }
+        default: {
+            // Atoms (and opaque quantified propositions) become one Propvar per distinct proposition
+            unsigned long long hash = SmtProp_hash(p);
+            MemoEntry* slot = memo_find(E, hash, 0, 0, 0, p);
+            if (slot->used) return slot->lit;
+            Lit x = MK_LIT(cnf_new_var(E->cnf, p), 0);
+            memo_insert(E, slot, hash, 0, 0, 0, p, x);
+            return x;
+        }
+    }
+}
+
+// Post-order on an explicit stack, as formulas may nest deeper than the C stack allows:
+// a proposition is encoded once the literals of its operands are on top of E->done
+static Lit encode_prop(Encoder* E, SmtProp* p) {
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, p, NULL);
+    while (walk.size > 0) {
+        SmtWalkItem* it = &walk.items[walk.size - 1];
+        p = (SmtProp*)it->node;
+        int n = encode_arity(p);
+        if (it->next < n) {
+            smt_walk_push(&walk, 0, SmtProp_child(p, it->next++), NULL);
+            continue;
+        }
+        walk.size--;
+        E->done_size -= n;
+        Lit x = encode_node(E, p, E->done + E->done_size);
+        if (E->done_size == E->done_cap) {
+            E->done_cap = E->done_cap ? E->done_cap * 2 : 64;
+            E->done = (Lit*)realloc(E->done, sizeof(Lit) * E->done_cap);
+        }
+        E->done[E->done_size++] = x;
+    }
+    smt_walk_free(&walk);
+    return E->done[--E->done_size];
+}
+
+// Collects the literals of a top-level disjunction (OR / IMPLY nests) into one clause,
+// left to right; an item's tag says whether its literal is negated
+static void collect_disjuncts(Encoder* E, SmtProp* p, Lit** lits, int* n, int* cap) {
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, false, p, NULL);
+    while (walk.size > 0) {
+        SmtWalkItem it = smt_walk_pop(&walk);
+        p = (SmtProp*)it.node;
+        bool negated = it.tag;
+        if (!negated && p->type == SMTB_PROP && (p->prop.Binary_prop.op == SMTPROP_OR || p->prop.Binary_prop.op == SMTPROP_IMPLY)) {
+            smt_walk_push(&walk, false, p->prop.Binary_prop.prop2, NULL);
+            smt_walk_push(&walk, p->prop.Binary_prop.op == SMTPROP_IMPLY, p->prop.Binary_prop.prop1, NULL);
+            continue;
+        }
+        if (*n == *cap) {
+            *cap *= 2;
+            *lits = (Lit*)realloc(*lits, sizeof(Lit) * *cap);
+        }
+        Lit l = encode_prop(E, p);
+        (*lits)[(*n)++] = negated ? LIT_NEG(l) : l;
+    }
+    smt_walk_free(&walk);
+}
+
+// Top-level conjunctions become separate clauses, so they need no definition variable
+static void add_top_level(Encoder* E, SmtProp* p) {
+    SmtWalk walk;
+    smt_walk_init(&walk);
+    smt_walk_push(&walk, 0, p, NULL);
+    while (walk.size > 0) {
+        p = (SmtProp*)smt_walk_pop(&walk).node;
+        if (p->type == SMTB_PROP && p->prop.Binary_prop.op == SMTPROP_AND) {
+            smt_walk_push(&walk, 0, p->prop.Binary_prop.prop2, NULL);
+            smt_walk_push(&walk, 0, p->prop.Binary_prop.prop1, NULL);
+            continue;
+        }
+        int n = 0, cap = 8;
+        Lit* lits = (Lit*)malloc(sizeof(Lit) * cap);
+        collect_disjuncts(E, p, &lits, &n, &cap);
+        cnf_add_clause(E->cnf, lits, n);
+        free(lits);
+    }
+    smt_walk_free(&walk);
+}
+
+CnfFormula* tseitin_encode(SmtProplist* list) {
+    CnfFormula* cnf = (CnfFormula*)malloc(sizeof(CnfFormula));
+    memset(cnf, 0, sizeof(CnfFormula));
+    cnf->cap_clauses = 64;
+    cnf->clause_start = (int*)malloc(sizeof(int) * cnf->cap_clauses);
+    cnf->clause_start[0] = 0;
+
+    Encoder E;
+    memset(&E, 0, sizeof(Encoder));
+    E.cnf = cnf;
+    E.true_lit = -1;
+    for (SmtProplist* current = list; current != NULL; current = current->next) {
+        add_top_level(&E, current->prop);
+    }
+    free(E.memo);
+    free(E.done);
+    return cnf;
+}
+
+void freeCnfFormula(CnfFormula* cnf) {
+    if (cnf == NULL) return;
+    free(cnf->atoms);
+    free(cnf->lits);
+    free(cnf->clause_start);
+    free(cnf);
+}
@@ -0,0 +1,29 @@
+#ifndef TSEITIN_H
+#define TSEITIN_H 1
+#include "smt_lang.h"
+#include "cdcl.h"
+
+// --- CNF Formula ---
+// Clauses are stored back to back in one literal array: clause i is
+// lits[clause_start[i] .. clause_start[i + 1]).
+typedef struct {
+    int num_vars;
+    int cap_vars;
+    SmtProp** atoms; // atoms[v]: the atomic proposition abstracted as Propvar v, NULL for definition variables
+
+    Lit* lits;
+    int num_lits;
+    int cap_lits;
+    int* clause_start; // num_clauses + 1 entries
+    int num_clauses;
+    int cap_clauses;
+} CnfFormula;
+
+#define CNF_CLAUSE(cnf, i) ((cnf)->lits + (cnf)->clause_start[i])
+#define CNF_CLAUSE_SIZE(cnf, i) ((cnf)->clause_start[(i) + 1] - (cnf)->clause_start[i])
+
+// Linear-size encoding of the conjunction of the list; structurally equal atoms
+// and subformulas share one variable. Atoms keep pointers into the list.
+CnfFormula* tseitin_encode(SmtProplist* list);
+void freeCnfFormula(CnfFormula* cnf);
+#endif
@@ -0,0 +1,103 @@
+#!/bin/sh
+# Regression check: solves the inputs under regress/ and compares the verdicts with the
+# expected ones. Usage: ./check.sh [solver binary] (default ../src/test.out)
+cd "$(dirname "$0")" || exit 1
+SOLVER=$(cd "$(dirname "${1:-../src/test.out}")" && pwd)/$(basename "${1:-../src/test.out}")
+[ -x "$SOLVER" ] || { echo "Error: no solver binary at $SOLVER" >&2; exit 1; }
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+failed=0
+
+# Reports a failed case with the difference between the expected and the actual output
+check() {
+    if cmp -s "$2" "$3"; then
+        echo "ok    $1"
+    else
+        echo "FAIL  $1"
+        diff "$2" "$3" | sed 's/^/      /'
+        failed=$((failed + 1))
+    fi
+}
+
+# --- Verdicts ---
+"$SOLVER" --batch 'regress/*.txt' --ordered > "$TMP/verdicts" 2>/dev/null
+check "verdicts" regress/verdicts.expected "$TMP/verdicts"
+
+# --- SMT-LIB Scripts ---
+# Each script's responses and exit status are compared with <name>.expected
+for script in regress/*.smt2; do
+    name=${script%.smt2}
+    "$SOLVER" "$script" > "$TMP/out" 2>/dev/null
+    echo "exit $?" >> "$TMP/out"
+    check "$script" "$name.expected" "$TMP/out"
+done
+
+# --- Deep Terms ---
+# x1 + ... + x200000 <= 0 over non-negative variables, with x200000 >= 1 the sum has no room left
+awk 'BEGIN { n = 200000
+    for (i = 1; i < n; i++) printf "x%d + ", i
+    printf "x%d <= 0,\n", n
+    for (i = 1; i <= n; i++) printf "x%d >= 0,\n", i
+    printf "x%d >= 1\n", n }' > "$TMP/sum.txt"
+"$SOLVER" --format jsonl "$TMP/sum.txt" 2>/dev/null | grep -o '"result":"[a-z]*"' > "$TMP/deep"
+echo '"result":"unsat"' > "$TMP/want"
+check "sum of 200000 variables" "$TMP/want" "$TMP/deep"
+# The same depth in SMT-LIB: (+ x (+ x ... x)) nested 200000 deep
+awk 'BEGIN { n = 200000
+    printf "(declare-fun x () Int)\n(assert (<= "
+    for (i = 0; i < n; i++) printf "(+ x "
+    printf "x"
+    for (i = 0; i < n; i++) printf ")"
+    printf " 0))\n(assert (>= x 1))\n(check-sat)\n" }' > "$TMP/nested.smt2"
+"$SOLVER" "$TMP/nested.smt2" > "$TMP/deep" 2>/dev/null
+echo "exit $?" >> "$TMP/deep"
+printf 'unsat\nexit 0\n' > "$TMP/want"
+check "SMT-LIB term nested 200000 deep" "$TMP/want" "$TMP/deep"
+# f(...f(x)...) = 1, x = y and f(...f(y)...) != 1, applications nested 200000 deep
+awk 'BEGIN { n = 200000
+    for (i = 0; i < n; i++) printf "f("
+    printf "x"
+    for (i = 0; i < n; i++) printf ")"
+    printf " = 1,\nx = y,\nNOT ("
+    for (i = 0; i < n; i++) printf "f("
+    printf "y"
+    for (i = 0; i < n; i++) printf ")"
+    printf " = 1)\n" }' > "$TMP/uf.txt"
+"$SOLVER" --format jsonl "$TMP/uf.txt" 2>/dev/null | grep -o '"result":"[a-z]*"' > "$TMP/deep"
+echo '"result":"unsat"' > "$TMP/want"
+check "UF applications nested 200000 deep" "$TMP/want" "$TMP/deep"
+
+# --- Result Cache ---
+# The cache must not change any answer or interval, whether it hits or not
+strip() { sed -e 's/"rounds":[0-9]*,//' -e 's/"ms":[0-9.]*,//'; }
+"$SOLVER" --batch 'regress/*.txt' --ordered --format jsonl 2>/dev/null | strip > "$TMP/plain"
+"$SOLVER" --batch 'regress/*.txt' --ordered --cache 64 --format jsonl 2>/dev/null | strip > "$TMP/cached"
+check "cache on / off" "$TMP/plain" "$TMP/cached"
+# A renamed and reordered copy of test2 is answered from the cache, without a propagation round
+printf 'test2.txt\nregress/test2_renamed.txt\n' > "$TMP/list"
+"$SOLVER" --batch "@$TMP/list" -j 1 --ordered --cache 4 --format jsonl 2>/dev/null | tail -n 1 | grep -q '"rounds":0,' && echo hit > "$TMP/hit" || echo miss > "$TMP/hit"
+echo hit > "$TMP/want"
+check "cache hit on renamed test2" "$TMP/want" "$TMP/hit"
+
+# --- Templates ---
+# Row-by-row, lane and generated solves of one skeleton agree record for record
+T=regress/template
+solve_rows() { "$SOLVER" --template $T/skeleton.txt --param cap,d --format jsonl "$@" < $T/rows.txt 2>/dev/null | sed 's/"ms":[0-9.]*,//'; }
+solve_rows > "$TMP/rows"
+check "template" $T/rows.expected "$TMP/rows"
+solve_rows --lanes > "$TMP/lanes"
+check "template --lanes" "$TMP/rows" "$TMP/lanes"
+if command -v "${CC:-cc}" > /dev/null; then
+    solve_rows --codegen "$TMP/codegen" > "$TMP/generated"
+    check "template --codegen" "$TMP/rows" "$TMP/generated"
+else
+    echo "skip  template --codegen (no C compiler)"
+fi
+
+# --- Budgets ---
+# An exhausted budget answers unknown with sound intervals; a problem that settles within it is unaffected
+"$SOLVER" --batch 'regress/budget/*.txt' --ordered --max-propagations 30 --format jsonl 2>/dev/null | sed 's/"ms":[0-9.]*,//' > "$TMP/budget"
+check "propagation budget" regress/budget/budget.expected "$TMP/budget"
+
+[ "$failed" -eq 0 ] && echo "All checks passed." || echo "$failed check(s) failed."
+[ "$failed" -eq 0 ]
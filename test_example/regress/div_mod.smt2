@@ -0,0 +1,36 @@
+; SMT-LIB div and mod are Euclidean: div(-7, 2) = -4 and mod(-7, 2) = 1
+(set-logic QF_NIA)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(assert (= x (- 7)))
+(push 1)
+(assert (= (div x 2) (- 4)))
+(check-sat)
+(pop 1)
+(push 1)
+(assert (= (div x 2) (- 3)))
+(check-sat)
+(pop 1)
+(push 1)
+(assert (= (mod x 2) 1))
+(check-sat)
+(pop 1)
+(push 1)
+(assert (= (mod x (- 2)) 1))
+(assert (= (div x (- 2)) 4))
+(check-sat)
+(pop 1)
+(push 1)
+(assert (= (div x (- 2)) 3))
+(check-sat)
+(pop 1)
+(push 1)
+(assert (= y (- 2)))
+(assert (= (div x y) 3))
+(check-sat)
+(pop 1)
+(define-fun h () Int (div x 2))
+(assert (= h (- 4)))
+(check-sat)
+(assert (= h (- 3)))
+(check-sat)
@@ -0,0 +1,13 @@
+; A failed command is reported with its first line and does not swallow the next one
+(declare-fun x () Int)
+(assert (> x 5))
+(pop 1)
+(check-sat)
+(assert
+  (< x
+     (foo 1)))
+(check-sat)
+(assert (< x 3))
+(pop 2) (check-sat)
+(assert 5)
+(check-sat)
@@ -0,0 +1,16 @@
+; x < y and y < x close in by a few units per round, more rounds than one check may run.
+; The check before the push stops at the iteration limit; the pop must hand its pending
+; work back, so that the next checks carry on to the empty interval.
+(set-logic QF_LIA)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(assert (>= x 0))
+(assert (<= x 200))
+(assert (>= y 0))
+(assert (<= y 200))
+(assert (< x y))
+(assert (< y x))
+(push 1)
+(pop 1)
+(check-sat)
+(check-sat)